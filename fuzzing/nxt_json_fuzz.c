@@ -14,6 +14,9 @@ extern int LLVMFuzzerInitialize(int *argc, char ***argv);
 extern int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
 
 
+static void nxt_json_fuzz_round_trip(nxt_mp_t *mp, nxt_conf_value_t *conf);
+
+
 extern char  **environ;
 
 
@@ -53,6 +56,8 @@ LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
         goto failed;
     }
 
+    nxt_json_fuzz_round_trip(mp, conf);
+
     nxt_memzero(&vldt, sizeof(nxt_conf_validation_t));
 
     vldt.pool = nxt_mp_create(1024, 128, 256, 32);
@@ -74,3 +79,35 @@ LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
 
     return 0;
 }
+
+
+/* The printed configuration must parse back into the same configuration. */
+
+static void
+nxt_json_fuzz_round_trip(nxt_mp_t *mp, nxt_conf_value_t *conf)
+{
+    u_char            *p;
+    size_t            size;
+    nxt_str_t         str;
+    nxt_conf_value_t  *value;
+
+    size = nxt_conf_json_length(conf, NULL);
+
+    str.start = nxt_mp_nget(mp, size);
+    p = nxt_mp_nget(mp, size);
+
+    if (str.start == NULL || p == NULL) {
+        return;
+    }
+
+    str.length = nxt_conf_json_print(str.start, conf, NULL) - str.start;
+
+    value = nxt_conf_json_parse_str(mp, &str);
+    if (value == NULL || nxt_conf_json_length(value, NULL) != size) {
+        nxt_abort();
+    }
+
+    if (memcmp(p, str.start, nxt_conf_json_print(p, value, NULL) - p) != 0) {
+        nxt_abort();
+    }
+}
@@ -19,9 +19,13 @@
 #include <openssl/err.h>
 
 
+#define NXT_CERT_DIGEST_LEN  64
+
+
 struct nxt_cert_s {
     EVP_PKEY          *key;
     nxt_uint_t        count;
+    u_char            digest[NXT_CERT_DIGEST_LEN];
     X509              *chain[];
 };
 
@@ -30,6 +34,7 @@ typedef struct {
     nxt_str_t         name;
     nxt_conf_value_t  *value;
     nxt_mp_t          *mp;
+    u_char            digest[NXT_CERT_DIGEST_LEN];
 } nxt_cert_info_t;
 
 
@@ -39,8 +44,12 @@ typedef struct {
 } nxt_cert_item_t;
 
 
-static nxt_cert_t *nxt_cert_fd(nxt_task_t *task, nxt_fd_t fd);
 static nxt_cert_t *nxt_cert_bio(nxt_task_t *task, BIO *bio);
+static void nxt_cert_digest(u_char *digest, u_char *start, size_t length);
+static nxt_int_t nxt_cert_info_cached(nxt_str_t *name, u_char *digest,
+    nxt_conf_value_t *cache);
+static nxt_int_t nxt_cert_info_add(nxt_str_t *name, u_char *digest,
+    nxt_cert_t *cert, nxt_conf_value_t *details);
 static int nxt_nxt_cert_pem_suffix(char *pem_str, const char *suffix);
 
 static nxt_conf_value_t *nxt_cert_details(nxt_mp_t *mp, nxt_cert_t *cert);
@@ -70,27 +79,40 @@ nxt_cert_mem(nxt_task_t *task, nxt_buf_mem_t *mbuf)
 
     BIO_free(bio);
 
+    if (cert != NULL) {
+        nxt_cert_digest(cert->digest, mbuf->pos, nxt_buf_mem_used_size(mbuf));
+    }
+
     return cert;
 }
 
 
-static nxt_cert_t *
-nxt_cert_fd(nxt_task_t *task, nxt_fd_t fd)
+static void
+nxt_cert_digest(u_char *digest, u_char *start, size_t length)
 {
-    BIO         *bio;
-    nxt_cert_t  *cert;
+    u_char        *p;
+    unsigned int  n, len;
+    u_char        md[EVP_MAX_MD_SIZE];
 
-    bio = BIO_new_fd(fd, 0);
-    if (nxt_slow_path(bio == NULL)) {
-        nxt_openssl_log_error(task, NXT_LOG_ALERT, "BIO_new_fd() failed");
-        return NULL;
-    }
+    static const u_char  hex[16] = "0123456789abcdef";
 
-    cert = nxt_cert_bio(task, bio);
+    if (nxt_slow_path(EVP_Digest(start, length, md, &len, EVP_sha256(), NULL)
+                      != 1
+                      || len * 2 != NXT_CERT_DIGEST_LEN))
+    {
+        ERR_clear_error();
 
-    BIO_free(bio);
+        /* An empty digest never matches a cached one. */
+        nxt_memzero(digest, NXT_CERT_DIGEST_LEN);
+        return;
+    }
 
-    return cert;
+    p = digest;
+
+    for (n = 0; n < len; n++) {
+        *p++ = hex[md[n] >> 4];
+        *p++ = hex[md[n] & 0x0f];
+    }
 }
 
 
@@ -341,15 +363,67 @@ static const nxt_lvlhsh_proto_t  nxt_cert_info_hash_proto
 };
 
 
+/*
+ * The "cache" object comes from the configuration snapshot and maps
+ * certificate names to the digest of the stored PEM bundle and the details
+ * previously extracted from it.  Bundles whose digest still matches are not
+ * parsed again.
+ */
+
 void
-nxt_cert_info_init(nxt_task_t *task, nxt_array_t *certs)
+nxt_cert_info_init(nxt_task_t *task, nxt_array_t *certs,
+    nxt_conf_value_t *cache)
 {
+    ssize_t          n;
     uint32_t         i;
+    nxt_int_t        ret;
+    nxt_file_t       file;
     nxt_cert_t       *cert;
+    nxt_buf_mem_t    mbuf;
+    nxt_file_info_t  fi;
     nxt_cert_item_t  *items;
+    u_char           digest[NXT_CERT_DIGEST_LEN];
+
+    nxt_memzero(&file, sizeof(nxt_file_t));
 
     for (items = certs->elts, i = 0; i < certs->nelts; i++) {
-        cert = nxt_cert_fd(task, items[i].fd);
+        file.fd = items[i].fd;
+
+        ret = nxt_file_info(&file, &fi);
+        if (nxt_slow_path(ret != NXT_OK || !nxt_is_file(&fi))) {
+            continue;
+        }
+
+        mbuf.start = nxt_malloc(nxt_file_size(&fi));
+        if (nxt_slow_path(mbuf.start == NULL)) {
+            continue;
+        }
+
+        n = nxt_file_read(&file, mbuf.start, nxt_file_size(&fi), 0);
+        if (nxt_slow_path(n != nxt_file_size(&fi))) {
+            nxt_free(mbuf.start);
+            continue;
+        }
+
+        mbuf.pos = mbuf.start;
+        mbuf.free = mbuf.start + n;
+        mbuf.end = mbuf.free;
+
+        if (cache != NULL) {
+            nxt_cert_digest(digest, mbuf.pos, n);
+
+            if (nxt_cert_info_cached(&items[i].name, digest, cache) == NXT_OK) {
+                nxt_debug(task, "certificate \"%V\" details restored",
+                          &items[i].name);
+
+                nxt_free(mbuf.start);
+                continue;
+            }
+        }
+
+        cert = nxt_cert_mem(task, &mbuf);
+
+        nxt_free(mbuf.start);
 
         if (nxt_slow_path(cert == NULL)) {
             continue;
@@ -362,8 +436,52 @@ nxt_cert_info_init(nxt_task_t *task, nxt_array_t *certs)
 }
 
 
+static nxt_int_t
+nxt_cert_info_cached(nxt_str_t *name, u_char *digest, nxt_conf_value_t *cache)
+{
+    nxt_str_t         str;
+    nxt_conf_value_t  *entry, *value;
+
+    static const nxt_str_t  digest_str = nxt_string("digest");
+    static const nxt_str_t  details_str = nxt_string("details");
+
+    entry = nxt_conf_get_object_member(cache, name, NULL);
+    if (entry == NULL) {
+        return NXT_DECLINED;
+    }
+
+    value = nxt_conf_get_object_member(entry, &digest_str, NULL);
+    if (value == NULL || nxt_conf_type(value) != NXT_CONF_STRING) {
+        return NXT_DECLINED;
+    }
+
+    nxt_conf_get_string(value, &str);
+
+    if (str.length != NXT_CERT_DIGEST_LEN
+        || memcmp(str.start, digest, NXT_CERT_DIGEST_LEN) != 0)
+    {
+        return NXT_DECLINED;
+    }
+
+    value = nxt_conf_get_object_member(entry, &details_str, NULL);
+    if (value == NULL || nxt_conf_type(value) != NXT_CONF_OBJECT) {
+        return NXT_DECLINED;
+    }
+
+    return nxt_cert_info_add(name, digest, NULL, value);
+}
+
+
 nxt_int_t
 nxt_cert_info_save(nxt_str_t *name, nxt_cert_t *cert)
+{
+    return nxt_cert_info_add(name, cert->digest, cert, NULL);
+}
+
+
+static nxt_int_t
+nxt_cert_info_add(nxt_str_t *name, u_char *digest, nxt_cert_t *cert,
+    nxt_conf_value_t *details)
 {
     nxt_mp_t            *mp;
     nxt_int_t           ret;
@@ -386,13 +504,20 @@ nxt_cert_info_save(nxt_str_t *name, nxt_cert_t *cert)
         goto fail;
     }
 
-    value = nxt_cert_details(mp, cert);
+    if (cert != NULL) {
+        value = nxt_cert_details(mp, cert);
+
+    } else {
+        value = nxt_conf_clone(mp, NULL, details);
+    }
+
     if (nxt_slow_path(value == NULL)) {
         goto fail;
     }
 
     info->mp = mp;
     info->value = value;
+    nxt_memcpy(info->digest, digest, NXT_CERT_DIGEST_LEN);
 
     lhq.key_hash = nxt_djb_hash(name->start, name->length);
     lhq.replace = 1;
@@ -488,6 +613,74 @@ nxt_cert_info_get_all(nxt_mp_t *mp)
 }
 
 
+nxt_conf_value_t *
+nxt_cert_info_snapshot(nxt_mp_t *mp)
+{
+    uint32_t           i;
+    nxt_str_t          str;
+    nxt_cert_info_t    *info;
+    nxt_conf_value_t   *all, *entry;
+    nxt_lvlhsh_each_t  lhe;
+
+    static const nxt_str_t  digest_str = nxt_string("digest");
+    static const nxt_str_t  details_str = nxt_string("details");
+
+    nxt_lvlhsh_each_init(&lhe, &nxt_cert_info_hash_proto);
+
+    i = 0;
+
+    for ( ;; ) {
+        info = nxt_lvlhsh_each(&nxt_cert_info, &lhe);
+
+        if (info == NULL) {
+            break;
+        }
+
+        if (info->digest[0] != '\0') {
+            i++;
+        }
+    }
+
+    all = nxt_conf_create_object(mp, i);
+    if (nxt_slow_path(all == NULL)) {
+        return NULL;
+    }
+
+    nxt_lvlhsh_each_init(&lhe, &nxt_cert_info_hash_proto);
+
+    i = 0;
+
+    for ( ;; ) {
+        info = nxt_lvlhsh_each(&nxt_cert_info, &lhe);
+
+        if (info == NULL) {
+            break;
+        }
+
+        if (info->digest[0] == '\0') {
+            continue;
+        }
+
+        entry = nxt_conf_create_object(mp, 2);
+        if (nxt_slow_path(entry == NULL)) {
+            return NULL;
+        }
+
+        str.length = NXT_CERT_DIGEST_LEN;
+        str.start = info->digest;
+
+        nxt_conf_set_member_string(entry, &digest_str, &str, 0);
+        nxt_conf_set_member(entry, &details_str, info->value, 1);
+
+        nxt_conf_set_member(all, &info->name, entry, i);
+
+        i++;
+    }
+
+    return all;
+}
+
+
 static nxt_conf_value_t *
 nxt_cert_details(nxt_mp_t *mp, nxt_cert_t *cert)
 {
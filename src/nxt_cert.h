@@ -13,10 +13,12 @@ typedef struct nxt_cert_s  nxt_cert_t;
 nxt_cert_t *nxt_cert_mem(nxt_task_t *task, nxt_buf_mem_t *mbuf);
 void nxt_cert_destroy(nxt_cert_t *cert);
 
-void nxt_cert_info_init(nxt_task_t *task, nxt_array_t *certs);
+void nxt_cert_info_init(nxt_task_t *task, nxt_array_t *certs,
+    nxt_conf_value_t *cache);
 nxt_int_t nxt_cert_info_save(nxt_str_t *name, nxt_cert_t *cert);
 nxt_conf_value_t *nxt_cert_info_get(nxt_str_t *name);
 nxt_conf_value_t *nxt_cert_info_get_all(nxt_mp_t *mp);
+nxt_conf_value_t *nxt_cert_info_snapshot(nxt_mp_t *mp);
 nxt_int_t nxt_cert_info_delete(nxt_str_t *name);
 
 nxt_array_t *nxt_cert_store_load(nxt_task_t *task, nxt_mp_t *mem_pool);
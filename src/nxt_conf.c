@@ -19,6 +19,12 @@
 
 #define NXT_CONF_MAX_TOKEN_LEN     256
 
+/* Objects with fewer members are looked up by a linear scan. */
+#define NXT_CONF_OBJECT_INDEX_MIN  16
+
+#define nxt_conf_object_slots(object)                                         \
+    ((uint32_t *) &(object)->members[(object)->count])
+
 
 typedef enum {
     NXT_CONF_VALUE_NULL = 0,
@@ -79,8 +85,16 @@ typedef struct {
 } nxt_conf_object_member_t;
 
 
+/*
+ * Large objects reserve an open addressing table of member numbers after
+ * the members.  It is filled on the first lookup and after any member
+ * is set, so the objects built member by member are indexed as well.
+ */
+
 struct nxt_conf_object_s {
     nxt_uint_t                count;
+    uint32_t                  index_size;
+    uint32_t                  indexed;  /* 1 bit */
     nxt_conf_object_member_t  members[];
 };
 
@@ -100,6 +114,16 @@ typedef struct {
 } nxt_conf_path_parse_t;
 
 
+static size_t nxt_conf_object_size(nxt_uint_t count);
+static void nxt_conf_object_init(nxt_conf_object_t *object, nxt_uint_t count);
+static uint32_t nxt_conf_object_index_size(nxt_uint_t count);
+static nxt_conf_object_member_t *nxt_conf_object_member(
+    nxt_conf_value_t *object, uint32_t index);
+static nxt_conf_value_t *nxt_conf_object_index_find(nxt_conf_object_t *object,
+    const nxt_str_t *name, uint32_t *index);
+static void nxt_conf_object_index(nxt_conf_object_t *object);
+static uint32_t nxt_conf_object_index_add(nxt_conf_object_member_t *members,
+    uint32_t *slots, uint32_t mask, uint32_t n);
 static nxt_int_t nxt_conf_path_next_token(nxt_conf_path_parse_t *parse,
     nxt_str_t *token);
 
@@ -108,12 +132,8 @@ static u_char *nxt_conf_json_parse_value(nxt_mp_t *mp, nxt_conf_value_t *value,
     u_char *start, u_char *end, nxt_conf_json_error_t *error);
 static u_char *nxt_conf_json_parse_object(nxt_mp_t *mp, nxt_conf_value_t *value,
     u_char *start, u_char *end, nxt_conf_json_error_t *error);
-static nxt_int_t nxt_conf_object_hash_add(nxt_mp_t *mp,
-    nxt_lvlhsh_t *lvlhsh, nxt_conf_object_member_t *member);
-static nxt_int_t nxt_conf_object_hash_test(nxt_lvlhsh_query_t *lhq,
-    void *data);
-static void *nxt_conf_object_hash_alloc(void *data, size_t size);
-static void nxt_conf_object_hash_free(void *data, void *p);
+static nxt_conf_object_member_t *nxt_conf_json_object_grow(
+    nxt_conf_object_member_t *members, nxt_uint_t count, nxt_uint_t size);
 static u_char *nxt_conf_json_parse_array(nxt_mp_t *mp, nxt_conf_value_t *value,
     u_char *start, u_char *end, nxt_conf_json_error_t *error);
 static u_char *nxt_conf_json_parse_string(nxt_mp_t *mp, nxt_conf_value_t *value,
@@ -142,9 +162,17 @@ static size_t nxt_conf_json_object_length(const nxt_conf_value_t *value,
 static u_char *nxt_conf_json_print_object(u_char *p,
     const nxt_conf_value_t *value, nxt_conf_json_pretty_t *pretty);
 
+nxt_inline u_char *nxt_conf_json_string_scan(u_char *p, const u_char *end);
 static size_t nxt_conf_json_escape_length(u_char *p, size_t size);
 static u_char *nxt_conf_json_escape(u_char *dst, u_char *src, size_t size);
 
+static u_char *nxt_conf_bin_print_string(u_char *p,
+    const nxt_conf_value_t *value);
+static u_char *nxt_conf_bin_parse_value(nxt_mp_t *mp, nxt_conf_value_t *value,
+    u_char *p, u_char *end);
+static u_char *nxt_conf_bin_parse_string(nxt_mp_t *mp, nxt_conf_value_t *value,
+    u_char *p, u_char *end);
+
 
 #define nxt_conf_json_newline(p)                                              \
     ((p)[0] = '\r', (p)[1] = '\n', (p) + 2)
@@ -259,9 +287,7 @@ nxt_conf_create_object(nxt_mp_t *mp, nxt_uint_t count)
     size_t            size;
     nxt_conf_value_t  *value;
 
-    size = sizeof(nxt_conf_value_t)
-           + sizeof(nxt_conf_object_t)
-           + count * sizeof(nxt_conf_object_member_t);
+    size = sizeof(nxt_conf_value_t) + nxt_conf_object_size(count);
 
     value = nxt_mp_get(mp, size);
     if (nxt_slow_path(value == NULL)) {
@@ -269,7 +295,7 @@ nxt_conf_create_object(nxt_mp_t *mp, nxt_uint_t count)
     }
 
     value->u.object = nxt_pointer_to(value, sizeof(nxt_conf_value_t));
-    value->u.object->count = count;
+    nxt_conf_object_init(value->u.object, count);
 
     value->type = NXT_CONF_VALUE_OBJECT;
 
@@ -283,7 +309,7 @@ nxt_conf_set_member(nxt_conf_value_t *object, const nxt_str_t *name,
 {
     nxt_conf_object_member_t  *member;
 
-    member = &object->u.object->members[index];
+    member = nxt_conf_object_member(object, index);
 
     nxt_conf_set_string(&member->name, name);
 
@@ -297,7 +323,7 @@ nxt_conf_set_member_dup(nxt_conf_value_t *object, nxt_mp_t *mp,
 {
     nxt_conf_object_member_t  *member;
 
-    member = &object->u.object->members[index];
+    member = nxt_conf_object_member(object, index);
 
     member->value = *value;
 
@@ -311,7 +337,7 @@ nxt_conf_set_member_string(nxt_conf_value_t *object, const nxt_str_t *name,
 {
     nxt_conf_object_member_t  *member;
 
-    member = &object->u.object->members[index];
+    member = nxt_conf_object_member(object, index);
 
     nxt_conf_set_string(&member->name, name);
 
@@ -325,7 +351,7 @@ nxt_conf_set_member_string_dup(nxt_conf_value_t *object, nxt_mp_t *mp,
 {
     nxt_conf_object_member_t  *member;
 
-    member = &object->u.object->members[index];
+    member = nxt_conf_object_member(object, index);
 
     nxt_conf_set_string(&member->name, name);
 
@@ -340,7 +366,7 @@ nxt_conf_set_member_integer(nxt_conf_value_t *object, const nxt_str_t *name,
     u_char                    *p, *end;
     nxt_conf_object_member_t  *member;
 
-    member = &object->u.object->members[index];
+    member = nxt_conf_object_member(object, index);
 
     nxt_conf_set_string(&member->name, name);
 
@@ -360,7 +386,7 @@ nxt_conf_set_member_null(nxt_conf_value_t *object, const nxt_str_t *name,
 {
     nxt_conf_object_member_t  *member;
 
-    member = &object->u.object->members[index];
+    member = nxt_conf_object_member(object, index);
 
     nxt_conf_set_string(&member->name, name);
 
@@ -368,6 +394,57 @@ nxt_conf_set_member_null(nxt_conf_value_t *object, const nxt_str_t *name,
 }
 
 
+static size_t
+nxt_conf_object_size(nxt_uint_t count)
+{
+    size_t  size;
+
+    size = sizeof(nxt_conf_object_t) + count * sizeof(nxt_conf_object_member_t);
+
+    if (count >= NXT_CONF_OBJECT_INDEX_MIN) {
+        size += (size_t) nxt_conf_object_index_size(count) * sizeof(uint32_t);
+    }
+
+    return size;
+}
+
+
+static void
+nxt_conf_object_init(nxt_conf_object_t *object, nxt_uint_t count)
+{
+    object->count = count;
+    object->index_size = (count >= NXT_CONF_OBJECT_INDEX_MIN)
+                         ? nxt_conf_object_index_size(count) : 0;
+    object->indexed = 0;
+}
+
+
+/* The index is at most half full. */
+
+static uint32_t
+nxt_conf_object_index_size(nxt_uint_t count)
+{
+    uint32_t  size;
+
+    size = NXT_CONF_OBJECT_INDEX_MIN;
+
+    while (size < 2 * count) {
+        size *= 2;
+    }
+
+    return size;
+}
+
+
+static nxt_conf_object_member_t *
+nxt_conf_object_member(nxt_conf_value_t *object, uint32_t index)
+{
+    object->u.object->indexed = 0;
+
+    return &object->u.object->members[index];
+}
+
+
 nxt_conf_value_t *
 nxt_conf_create_array(nxt_mp_t *mp, nxt_uint_t count)
 {
@@ -566,6 +643,10 @@ nxt_conf_get_object_member(const nxt_conf_value_t *value, const nxt_str_t *name,
 
     object = value->u.object;
 
+    if (object->index_size != 0) {
+        return nxt_conf_object_index_find(object, name, index);
+    }
+
     for (n = 0; n < object->count; n++) {
         member = &object->members[n];
 
@@ -585,6 +666,92 @@ nxt_conf_get_object_member(const nxt_conf_value_t *value, const nxt_str_t *name,
 }
 
 
+static nxt_conf_value_t *
+nxt_conf_object_index_find(nxt_conf_object_t *object, const nxt_str_t *name,
+    uint32_t *index)
+{
+    uint32_t   i, n, mask, *slots;
+    nxt_str_t  str;
+
+    if (!object->indexed) {
+        nxt_conf_object_index(object);
+    }
+
+    slots = nxt_conf_object_slots(object);
+    mask = object->index_size - 1;
+
+    for (i = nxt_djb_hash(name->start, name->length) & mask;
+         slots[i] != 0;
+         i = (i + 1) & mask)
+    {
+        n = slots[i] - 1;
+
+        nxt_conf_get_string(&object->members[n].name, &str);
+
+        if (nxt_strstr_eq(&str, name)) {
+
+            if (index != NULL) {
+                *index = n;
+            }
+
+            return &object->members[n].value;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void
+nxt_conf_object_index(nxt_conf_object_t *object)
+{
+    uint32_t  n, *slots;
+
+    slots = nxt_conf_object_slots(object);
+
+    nxt_memzero(slots, object->index_size * sizeof(uint32_t));
+
+    for (n = 0; n < object->count; n++) {
+        /* The first of duplicate members is found, as by a scan. */
+        (void) nxt_conf_object_index_add(object->members, slots,
+                                         object->index_size - 1, n);
+    }
+
+    object->indexed = 1;
+}
+
+
+/*
+ * Returns zero if the member has been added, or the number of
+ * a member with the same name plus one.
+ */
+
+static uint32_t
+nxt_conf_object_index_add(nxt_conf_object_member_t *members, uint32_t *slots,
+    uint32_t mask, uint32_t n)
+{
+    uint32_t   i;
+    nxt_str_t  name, str;
+
+    nxt_conf_get_string(&members[n].name, &name);
+
+    for (i = nxt_djb_hash(name.start, name.length) & mask;
+         slots[i] != 0;
+         i = (i + 1) & mask)
+    {
+        nxt_conf_get_string(&members[slots[i] - 1].name, &str);
+
+        if (nxt_strstr_eq(&str, &name)) {
+            return slots[i];
+        }
+    }
+
+    slots[i] = n + 1;
+
+    return 0;
+}
+
+
 nxt_int_t
 nxt_conf_map_object(nxt_mp_t *mp, const nxt_conf_value_t *value,
     const nxt_conf_map_t *map, nxt_uint_t n, void *data)
@@ -1144,15 +1311,14 @@ nxt_conf_copy_object(nxt_mp_t *mp, const nxt_conf_op_t *op,
         }
     }
 
-    size = sizeof(nxt_conf_object_t)
-           + count * sizeof(nxt_conf_object_member_t);
+    size = nxt_conf_object_size(count);
 
     dst->u.object = nxt_mp_get(mp, size);
     if (nxt_slow_path(dst->u.object == NULL)) {
         return NXT_ERROR;
     }
 
-    dst->u.object->count = count;
+    nxt_conf_object_init(dst->u.object, count);
 
     s = 0;
     d = 0;
@@ -1483,37 +1649,24 @@ nxt_conf_json_parse_value(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *start,
 }
 
 
-static const nxt_lvlhsh_proto_t  nxt_conf_object_hash_proto
-    nxt_aligned(64) =
-{
-    NXT_LVLHSH_DEFAULT,
-    nxt_conf_object_hash_test,
-    nxt_conf_object_hash_alloc,
-    nxt_conf_object_hash_free,
-};
-
-
 static u_char *
 nxt_conf_json_parse_object(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *start,
     u_char *end, nxt_conf_json_error_t *error)
 {
     u_char                    *p, *name;
-    nxt_mp_t                  *mp_temp;
-    nxt_int_t                 rc;
-    nxt_uint_t                count;
-    nxt_lvlhsh_t              hash;
-    nxt_lvlhsh_each_t         lhe;
+    uint32_t                  mask, *slots;
+    nxt_str_t                 str, prev;
+    nxt_bool_t                duplicate;
+    nxt_uint_t                n, count, size;
     nxt_conf_object_t         *object;
-    nxt_conf_object_member_t  *member, *element;
-
-    mp_temp = nxt_mp_create(1024, 128, 256, 32);
-    if (nxt_slow_path(mp_temp == NULL)) {
-        return NULL;
-    }
+    nxt_conf_object_member_t  *members, *member;
 
-    nxt_lvlhsh_init(&hash);
+    members = NULL;
+    slots = NULL;
+    mask = 0;
 
     count = 0;
+    size = 0;
     p = start;
 
     for ( ;; ) {
@@ -1545,33 +1698,58 @@ nxt_conf_json_parse_object(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *start,
 
         name = p;
 
-        count++;
+        if (count == size) {
+            size = (size == 0) ? 8 : size * 2;
 
-        member = nxt_mp_get(mp_temp, sizeof(nxt_conf_object_member_t));
-        if (nxt_slow_path(member == NULL)) {
-            goto error;
+            members = nxt_conf_json_object_grow(members, count, size);
+            if (nxt_slow_path(members == NULL)) {
+                goto error;
+            }
+
+            if (size >= NXT_CONF_OBJECT_INDEX_MIN) {
+                slots = (uint32_t *) &members[size];
+                mask = nxt_conf_object_index_size(size) - 1;
+            }
         }
 
+        member = &members[count];
+
         p = nxt_conf_json_parse_string(mp, &member->name, p, end, error);
 
         if (nxt_slow_path(p == NULL)) {
             goto error;
         }
 
-        rc = nxt_conf_object_hash_add(mp_temp, &hash, member);
+        if (slots != NULL) {
+            duplicate = (nxt_conf_object_index_add(members, slots, mask, count)
+                         != 0);
+
+        } else {
+            duplicate = 0;
 
-        if (nxt_slow_path(rc != NXT_OK)) {
+            nxt_conf_get_string(&member->name, &str);
 
-            if (rc == NXT_DECLINED) {
-                nxt_conf_json_parse_error(error, name,
-                    "Duplicate object member.  All JSON object members must "
-                    "have unique names."
-                );
+            for (n = 0; n < count; n++) {
+                nxt_conf_get_string(&members[n].name, &prev);
+
+                if (nxt_strstr_eq(&str, &prev)) {
+                    duplicate = 1;
+                    break;
+                }
             }
+        }
+
+        if (nxt_slow_path(duplicate)) {
+            nxt_conf_json_parse_error(error, name,
+                "Duplicate object member.  All JSON object members must "
+                "have unique names."
+            );
 
             goto error;
         }
 
+        count++;
+
         p = nxt_conf_json_skip_space(p, end);
 
         if (nxt_slow_path(p == end)) {
@@ -1639,8 +1817,7 @@ nxt_conf_json_parse_object(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *start,
         }
     }
 
-    object = nxt_mp_get(mp, sizeof(nxt_conf_object_t)
-                            + count * sizeof(nxt_conf_object_member_t));
+    object = nxt_mp_get(mp, nxt_conf_object_size(count));
     if (nxt_slow_path(object == NULL)) {
         goto error;
     }
@@ -1648,75 +1825,67 @@ nxt_conf_json_parse_object(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *start,
     value->u.object = object;
     value->type = NXT_CONF_VALUE_OBJECT;
 
-    object->count = count;
-    member = object->members;
+    nxt_conf_object_init(object, count);
 
-    nxt_lvlhsh_each_init(&lhe, &nxt_conf_object_hash_proto);
-
-    for ( ;; ) {
-        element = nxt_lvlhsh_each(&hash, &lhe);
-
-        if (element == NULL) {
-            break;
-        }
-
-        *member++ = *element;
+    if (count != 0) {
+        nxt_memcpy(object->members, members,
+                   count * sizeof(nxt_conf_object_member_t));
     }
 
-    nxt_mp_destroy(mp_temp);
+    nxt_free(members);
 
     return p + 1;
 
 error:
 
-    nxt_mp_destroy(mp_temp);
+    nxt_free(members);
     return NULL;
 }
 
 
-static nxt_int_t
-nxt_conf_object_hash_add(nxt_mp_t *mp, nxt_lvlhsh_t *lvlhsh,
-    nxt_conf_object_member_t *member)
-{
-    nxt_lvlhsh_query_t  lhq;
-
-    nxt_conf_get_string(&member->name, &lhq.key);
+/*
+ * The members are collected in a growing array to keep their order
+ * and to find duplicates by the same index as lookups use.
+ */
 
-    lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
-    lhq.replace = 0;
-    lhq.value = member;
-    lhq.proto = &nxt_conf_object_hash_proto;
-    lhq.pool = mp;
+static nxt_conf_object_member_t *
+nxt_conf_json_object_grow(nxt_conf_object_member_t *members, nxt_uint_t count,
+    nxt_uint_t size)
+{
+    size_t                    length;
+    uint32_t                  n, mask, *slots;
+    nxt_conf_object_member_t  *grown;
 
-    return nxt_lvlhsh_insert(lvlhsh, &lhq);
-}
+    length = size * sizeof(nxt_conf_object_member_t);
 
+    if (size >= NXT_CONF_OBJECT_INDEX_MIN) {
+        length += nxt_conf_object_index_size(size) * sizeof(uint32_t);
+    }
 
-static nxt_int_t
-nxt_conf_object_hash_test(nxt_lvlhsh_query_t *lhq, void *data)
-{
-    nxt_str_t                 str;
-    nxt_conf_object_member_t  *member;
+    grown = nxt_malloc(length);
 
-    member = data;
+    if (nxt_fast_path(grown != NULL)) {
 
-    nxt_conf_get_string(&member->name, &str);
+        if (count != 0) {
+            nxt_memcpy(grown, members,
+                       count * sizeof(nxt_conf_object_member_t));
+        }
 
-    return nxt_strstr_eq(&lhq->key, &str) ? NXT_OK : NXT_DECLINED;
-}
+        if (size >= NXT_CONF_OBJECT_INDEX_MIN) {
+            slots = (uint32_t *) &grown[size];
+            mask = nxt_conf_object_index_size(size) - 1;
 
+            nxt_memzero(slots, (mask + 1) * sizeof(uint32_t));
 
-static void *
-nxt_conf_object_hash_alloc(void *data, size_t size)
-{
-    return nxt_mp_align(data, size, size);
-}
+            for (n = 0; n < count; n++) {
+                (void) nxt_conf_object_index_add(grown, slots, mask, n);
+            }
+        }
+    }
 
+    nxt_free(members);
 
-static void
-nxt_conf_object_hash_free(void *data, void *p)
-{
-    nxt_mp_free(data, p);
+    return grown;
 }
 
 
@@ -1725,23 +1894,14 @@ nxt_conf_json_parse_array(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *start,
     u_char *end, nxt_conf_json_error_t *error)
 {
     u_char            *p;
-    nxt_mp_t          *mp_temp;
-    nxt_uint_t        count;
-    nxt_list_t        *list;
+    nxt_uint_t        count, size;
     nxt_conf_array_t  *array;
-    nxt_conf_value_t  *element;
+    nxt_conf_value_t  *elements, *grown;
 
-    mp_temp = nxt_mp_create(1024, 128, 256, 32);
-    if (nxt_slow_path(mp_temp == NULL)) {
-        return NULL;
-    }
-
-    list = nxt_list_create(mp_temp, 8, sizeof(nxt_conf_value_t));
-    if (nxt_slow_path(list == NULL)) {
-        goto error;
-    }
+    elements = NULL;
 
     count = 0;
+    size = 0;
     p = start;
 
     for ( ;; ) {
@@ -1761,19 +1921,30 @@ nxt_conf_json_parse_array(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *start,
             break;
         }
 
-        count++;
+        if (count == size) {
+            size = (size == 0) ? 8 : size * 2;
 
-        element = nxt_list_add(list);
-        if (nxt_slow_path(element == NULL)) {
-            goto error;
+            grown = nxt_malloc(size * sizeof(nxt_conf_value_t));
+            if (nxt_slow_path(grown == NULL)) {
+                goto error;
+            }
+
+            if (count != 0) {
+                nxt_memcpy(grown, elements, count * sizeof(nxt_conf_value_t));
+            }
+
+            nxt_free(elements);
+            elements = grown;
         }
 
-        p = nxt_conf_json_parse_value(mp, element, p, end, error);
+        p = nxt_conf_json_parse_value(mp, &elements[count], p, end, error);
 
         if (nxt_slow_path(p == NULL)) {
             goto error;
         }
 
+        count++;
+
         p = nxt_conf_json_skip_space(p, end);
 
         if (nxt_slow_path(p == end)) {
@@ -1811,19 +1982,19 @@ nxt_conf_json_parse_array(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *start,
     value->type = NXT_CONF_VALUE_ARRAY;
 
     array->count = count;
-    element = array->elements;
 
-    nxt_list_each(value, list) {
-        *element++ = *value;
-    } nxt_list_loop;
+    if (count != 0) {
+        nxt_memcpy(array->elements, elements,
+                   count * sizeof(nxt_conf_value_t));
+    }
 
-    nxt_mp_destroy(mp_temp);
+    nxt_free(elements);
 
     return p + 1;
 
 error:
 
-    nxt_mp_destroy(mp_temp);
+    nxt_free(elements);
     return NULL;
 }
 
@@ -1851,6 +2022,15 @@ nxt_conf_json_parse_string(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *start,
     surplus = 0;
 
     for (p = start; nxt_fast_path(p != end); p++) {
+
+        if (state == sw_usual) {
+            p = nxt_conf_json_string_scan(p, end);
+
+            if (nxt_slow_path(p == end)) {
+                break;
+            }
+        }
+
         ch = *p;
 
         switch (state) {
@@ -2539,23 +2719,63 @@ nxt_conf_json_print_object(u_char *p, const nxt_conf_value_t *value,
 }
 
 
+/*
+ * Quotation marks, backslashes, and control characters are the only bytes
+ * that need processing in a string.  The words without them are skipped
+ * at once: a byte is matched if it becomes zero after the exclusive or,
+ * or is below 0x20, and each test sets the high bit of such a byte.
+ */
+
+#define NXT_CONF_JSON_WORD(ch)  ((ch) * 0x0101010101010101ULL)
+
+nxt_inline u_char *
+nxt_conf_json_string_scan(u_char *p, const u_char *end)
+{
+    uint64_t  word, quote, backslash;
+
+    while (end - p >= 8) {
+        nxt_memcpy(&word, p, 8);
+
+        quote = word ^ NXT_CONF_JSON_WORD('"');
+        backslash = word ^ NXT_CONF_JSON_WORD('\\');
+
+        if ((((quote - NXT_CONF_JSON_WORD(0x01)) & ~quote)
+             | ((backslash - NXT_CONF_JSON_WORD(0x01)) & ~backslash)
+             | ((word - NXT_CONF_JSON_WORD(0x20)) & ~word))
+            & NXT_CONF_JSON_WORD(0x80))
+        {
+            break;
+        }
+
+        p += 8;
+    }
+
+    return p;
+}
+
+
 static size_t
 nxt_conf_json_escape_length(u_char *p, size_t size)
 {
-    u_char  ch;
+    u_char  ch, *end;
     size_t  len;
 
     len = size;
+    end = p + size;
 
-    while (size) {
-        ch = *p++;
+    while (p != end) {
+        p = nxt_conf_json_string_scan(p, end);
 
-        if (ch == '\\' || ch == '"') {
-            len++;
+        while (p != end) {
+            ch = *p++;
 
-        } else if (ch <= 0x1F) {
+            if (ch > 0x1F && ch != '\\' && ch != '"') {
+                continue;
+            }
 
             switch (ch) {
+            case '\\':
+            case '"':
             case '\n':
             case '\r':
             case '\t':
@@ -2567,9 +2787,9 @@ nxt_conf_json_escape_length(u_char *p, size_t size)
             default:
                 len += sizeof("\\u001F") - 2;
             }
-        }
 
-        size--;
+            break;
+        }
     }
 
     return len;
@@ -2579,23 +2799,36 @@ nxt_conf_json_escape_length(u_char *p, size_t size)
 static u_char *
 nxt_conf_json_escape(u_char *dst, u_char *src, size_t size)
 {
-    u_char  ch;
+    u_char  ch, *p, *end;
 
-    while (size) {
-        ch = *src++;
+    end = src + size;
 
-        if (ch > 0x1F) {
+    while (src != end) {
+        p = nxt_conf_json_string_scan(src, end);
 
-            if (ch == '\\' || ch == '"') {
-                *dst++ = '\\';
-            }
+        if (p != src) {
+            dst = nxt_cpymem(dst, src, p - src);
+            src = p;
+        }
 
-            *dst++ = ch;
+        /* The rest of the word and short tails are copied bytewise. */
+
+        while (src != end) {
+            ch = *src++;
+
+            if (ch > 0x1F && ch != '\\' && ch != '"') {
+                *dst++ = ch;
+                continue;
+            }
 
-        } else {
             *dst++ = '\\';
 
             switch (ch) {
+            case '\\':
+            case '"':
+                *dst++ = ch;
+                break;
+
             case '\n':
                 *dst++ = 'n';
                 break;
@@ -2624,9 +2857,9 @@ nxt_conf_json_escape(u_char *dst, u_char *src, size_t size)
 
                 *dst++ = (ch < 10) ? ('0' + ch) : ('A' + ch - 10);
             }
-        }
 
-        size--;
+            break;
+        }
     }
 
     return dst;
@@ -2660,3 +2893,345 @@ nxt_conf_json_position(u_char *start, const u_char *pos, nxt_uint_t *line,
         *column = 1 + symbols;
     }
 }
+
+
+/*
+ * The binary form of a configuration is used by the snapshot and to pass
+ * configurations to the router.  It is written in the native byte order.
+ * Each value starts with its type; a boolean is followed by a byte,
+ * a number by a length byte and its text, a string by a 32-bit length
+ * and its bytes, an array by a 32-bit count and its elements, and
+ * an object by a 32-bit count and its members, each being a name
+ * encoded as a string without the type and a value.
+ */
+
+size_t
+nxt_conf_bin_length(const nxt_conf_value_t *value)
+{
+    size_t             size;
+    nxt_str_t          str;
+    nxt_uint_t         n;
+    nxt_conf_array_t   *array;
+    nxt_conf_object_t  *object;
+
+    switch (value->type) {
+
+    case NXT_CONF_VALUE_NULL:
+        return 1;
+
+    case NXT_CONF_VALUE_BOOLEAN:
+        return 2;
+
+    case NXT_CONF_VALUE_INTEGER:
+    case NXT_CONF_VALUE_NUMBER:
+        return 2 + nxt_strlen(value->u.number);
+
+    case NXT_CONF_VALUE_SHORT_STRING:
+    case NXT_CONF_VALUE_STRING:
+        nxt_conf_get_string(value, &str);
+
+        return 1 + sizeof(uint32_t) + str.length;
+
+    case NXT_CONF_VALUE_ARRAY:
+        array = value->u.array;
+        size = 1 + sizeof(uint32_t);
+
+        for (n = 0; n < array->count; n++) {
+            size += nxt_conf_bin_length(&array->elements[n]);
+        }
+
+        return size;
+
+    case NXT_CONF_VALUE_OBJECT:
+        object = value->u.object;
+        size = 1 + sizeof(uint32_t);
+
+        for (n = 0; n < object->count; n++) {
+            nxt_conf_get_string(&object->members[n].name, &str);
+
+            size += sizeof(uint32_t) + str.length
+                    + nxt_conf_bin_length(&object->members[n].value);
+        }
+
+        return size;
+    }
+
+    nxt_unreachable();
+
+    return 0;
+}
+
+
+u_char *
+nxt_conf_bin_print(u_char *p, const nxt_conf_value_t *value)
+{
+    size_t             length;
+    uint32_t           count;
+    nxt_uint_t         n;
+    nxt_conf_array_t   *array;
+    nxt_conf_object_t  *object;
+
+    switch (value->type) {
+
+    case NXT_CONF_VALUE_NULL:
+        *p++ = NXT_CONF_VALUE_NULL;
+        return p;
+
+    case NXT_CONF_VALUE_BOOLEAN:
+        *p++ = NXT_CONF_VALUE_BOOLEAN;
+        *p++ = value->u.boolean;
+        return p;
+
+    case NXT_CONF_VALUE_INTEGER:
+    case NXT_CONF_VALUE_NUMBER:
+        length = nxt_strlen(value->u.number);
+
+        *p++ = value->type;
+        *p++ = length;
+
+        return nxt_cpymem(p, value->u.number, length);
+
+    case NXT_CONF_VALUE_SHORT_STRING:
+    case NXT_CONF_VALUE_STRING:
+        *p++ = NXT_CONF_VALUE_STRING;
+
+        return nxt_conf_bin_print_string(p, value);
+
+    case NXT_CONF_VALUE_ARRAY:
+        array = value->u.array;
+        count = array->count;
+
+        *p++ = NXT_CONF_VALUE_ARRAY;
+        p = nxt_cpymem(p, &count, sizeof(uint32_t));
+
+        for (n = 0; n < count; n++) {
+            p = nxt_conf_bin_print(p, &array->elements[n]);
+        }
+
+        return p;
+
+    case NXT_CONF_VALUE_OBJECT:
+        object = value->u.object;
+        count = object->count;
+
+        *p++ = NXT_CONF_VALUE_OBJECT;
+        p = nxt_cpymem(p, &count, sizeof(uint32_t));
+
+        for (n = 0; n < count; n++) {
+            p = nxt_conf_bin_print_string(p, &object->members[n].name);
+            p = nxt_conf_bin_print(p, &object->members[n].value);
+        }
+
+        return p;
+    }
+
+    nxt_unreachable();
+
+    return p;
+}
+
+
+static u_char *
+nxt_conf_bin_print_string(u_char *p, const nxt_conf_value_t *value)
+{
+    uint32_t   length;
+    nxt_str_t  str;
+
+    nxt_conf_get_string(value, &str);
+
+    length = str.length;
+
+    p = nxt_cpymem(p, &length, sizeof(uint32_t));
+
+    return nxt_cpymem(p, str.start, str.length);
+}
+
+
+nxt_conf_value_t *
+nxt_conf_bin_parse(nxt_mp_t *mp, u_char *start, u_char *end)
+{
+    u_char            *p;
+    nxt_conf_value_t  *value;
+
+    value = nxt_mp_get(mp, sizeof(nxt_conf_value_t));
+    if (nxt_slow_path(value == NULL)) {
+        return NULL;
+    }
+
+    p = nxt_conf_bin_parse_value(mp, value, start, end);
+
+    if (nxt_slow_path(p != end)) {
+        return NULL;
+    }
+
+    return value;
+}
+
+
+/*
+ * The input is trusted no more than JSON: every length and count
+ * is checked against the remaining size before it is used.
+ */
+
+static u_char *
+nxt_conf_bin_parse_value(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *p,
+    u_char *end)
+{
+    uint8_t            type;
+    size_t             length;
+    uint32_t           count, n;
+    nxt_conf_array_t   *array;
+    nxt_conf_object_t  *object;
+
+    if (nxt_slow_path(p == end)) {
+        return NULL;
+    }
+
+    type = *p++;
+
+    switch (type) {
+
+    case NXT_CONF_VALUE_NULL:
+        break;
+
+    case NXT_CONF_VALUE_BOOLEAN:
+        if (nxt_slow_path(p == end)) {
+            return NULL;
+        }
+
+        value->u.boolean = (*p++ != 0);
+        break;
+
+    case NXT_CONF_VALUE_INTEGER:
+    case NXT_CONF_VALUE_NUMBER:
+        if (nxt_slow_path(p == end)) {
+            return NULL;
+        }
+
+        length = *p++;
+
+        if (nxt_slow_path(length > NXT_CONF_MAX_NUMBER_LEN
+                          || (size_t) (end - p) < length))
+        {
+            return NULL;
+        }
+
+        nxt_memcpy(value->u.number, p, length);
+        value->u.number[length] = '\0';
+
+        p += length;
+        break;
+
+    case NXT_CONF_VALUE_STRING:
+        return nxt_conf_bin_parse_string(mp, value, p, end);
+
+    case NXT_CONF_VALUE_ARRAY:
+        if (nxt_slow_path(end - p < (ssize_t) sizeof(uint32_t))) {
+            return NULL;
+        }
+
+        nxt_memcpy(&count, p, sizeof(uint32_t));
+        p += sizeof(uint32_t);
+
+        /* Each element takes at least a byte. */
+
+        if (nxt_slow_path(count > (size_t) (end - p))) {
+            return NULL;
+        }
+
+        array = nxt_mp_get(mp, sizeof(nxt_conf_array_t)
+                               + count * sizeof(nxt_conf_value_t));
+        if (nxt_slow_path(array == NULL)) {
+            return NULL;
+        }
+
+        array->count = count;
+
+        for (n = 0; n < count; n++) {
+            p = nxt_conf_bin_parse_value(mp, &array->elements[n], p, end);
+
+            if (nxt_slow_path(p == NULL)) {
+                return NULL;
+            }
+        }
+
+        value->u.array = array;
+        break;
+
+    case NXT_CONF_VALUE_OBJECT:
+        if (nxt_slow_path(end - p < (ssize_t) sizeof(uint32_t))) {
+            return NULL;
+        }
+
+        nxt_memcpy(&count, p, sizeof(uint32_t));
+        p += sizeof(uint32_t);
+
+        /* Each member takes at least the name length and a byte. */
+
+        if (nxt_slow_path(count > (size_t) (end - p)
+                                  / (sizeof(uint32_t) + 1)))
+        {
+            return NULL;
+        }
+
+        object = nxt_mp_get(mp, nxt_conf_object_size(count));
+        if (nxt_slow_path(object == NULL)) {
+            return NULL;
+        }
+
+        nxt_conf_object_init(object, count);
+
+        for (n = 0; n < count; n++) {
+            p = nxt_conf_bin_parse_string(mp, &object->members[n].name, p,
+                                          end);
+            if (nxt_slow_path(p == NULL)) {
+                return NULL;
+            }
+
+            p = nxt_conf_bin_parse_value(mp, &object->members[n].value, p,
+                                         end);
+            if (nxt_slow_path(p == NULL)) {
+                return NULL;
+            }
+        }
+
+        value->u.object = object;
+        break;
+
+    default:
+        return NULL;
+    }
+
+    value->type = type;
+
+    return p;
+}
+
+
+static u_char *
+nxt_conf_bin_parse_string(nxt_mp_t *mp, nxt_conf_value_t *value, u_char *p,
+    u_char *end)
+{
+    uint32_t   length;
+    nxt_str_t  str;
+
+    if (nxt_slow_path(end - p < (ssize_t) sizeof(uint32_t))) {
+        return NULL;
+    }
+
+    nxt_memcpy(&length, p, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+
+    if (nxt_slow_path((size_t) (end - p) < length)) {
+        return NULL;
+    }
+
+    str.length = length;
+    str.start = p;
+
+    if (nxt_slow_path(nxt_conf_set_string_dup(value, mp, &str) != NXT_OK)) {
+        return NULL;
+    }
+
+    return p + length;
+}
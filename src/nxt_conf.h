@@ -115,6 +115,10 @@ u_char *nxt_conf_json_print(u_char *p, const nxt_conf_value_t *value,
 void nxt_conf_json_position(u_char *start, const u_char *pos, nxt_uint_t *line,
     nxt_uint_t *column);
 
+size_t nxt_conf_bin_length(const nxt_conf_value_t *value);
+u_char *nxt_conf_bin_print(u_char *p, const nxt_conf_value_t *value);
+nxt_conf_value_t *nxt_conf_bin_parse(nxt_mp_t *mp, u_char *start, u_char *end);
+
 nxt_int_t nxt_conf_validate(nxt_conf_validation_t *vldt);
 
 NXT_EXPORT void nxt_conf_get_string(const nxt_conf_value_t *value,
@@ -90,6 +90,32 @@ static nxt_int_t nxt_conf_vldt_mtypes_type(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
 static nxt_int_t nxt_conf_vldt_mtypes_extension(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value);
+static nxt_int_t nxt_conf_vldt_open_file_cache_max(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_open_file_cache_valid(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_compression(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_compression_encodings(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_compression_level(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_compression_min_length(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_control_debounce(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_limit_rate(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_limit_burst(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_limit_status(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_cache_time(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_cache_size(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_limit_count(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_listener(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
 #if (NXT_TLS)
@@ -118,6 +144,8 @@ static nxt_int_t nxt_conf_vldt_pass(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_return(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_precompressed(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_share(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_share_element(nxt_conf_validation_t *vldt,
@@ -210,6 +238,22 @@ static nxt_int_t nxt_conf_vldt_server(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
 static nxt_int_t nxt_conf_vldt_server_weight(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_server_max_fails(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_upstream_balancer(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_keepalive_connections(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_keepalive_requests(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_keepalive_idle_timeout(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_upstream_time(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_upstream_count(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_health_uri(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_access_log(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 
@@ -239,9 +283,12 @@ static nxt_int_t nxt_conf_vldt_js_module_element(nxt_conf_validation_t *vldt,
 
 
 static nxt_conf_vldt_object_t  nxt_conf_vldt_setting_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_control_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_http_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_websocket_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_static_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_open_file_cache_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_compression_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_forwarded_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_client_ip_members[];
 #if (NXT_TLS)
@@ -266,6 +313,12 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_app_cgroup_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_app_automount_members[];
 #endif
 static nxt_conf_vldt_object_t  nxt_conf_vldt_access_log_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_keepalive_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_health_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_retry_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_limit_requests_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_limit_concurrency_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_cache_members[];
 
 
 static nxt_conf_vldt_object_t  nxt_conf_vldt_root_members[] = {
@@ -309,6 +362,11 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_setting_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object,
         .u.members  = nxt_conf_vldt_http_members,
+    }, {
+        .name       = nxt_string("control"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_control_members,
 #if (NXT_HAVE_NJS)
     }, {
         .name       = nxt_string("js_module"),
@@ -321,6 +379,17 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_setting_members[] = {
 };
 
 
+static nxt_conf_vldt_object_t  nxt_conf_vldt_control_members[] = {
+    {
+        .name       = nxt_string("debounce"),
+        .type       = NXT_CONF_VLDT_NUMBER,
+        .validator  = nxt_conf_vldt_control_debounce,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
 static nxt_conf_vldt_object_t  nxt_conf_vldt_http_members[] = {
     {
         .name       = nxt_string("header_read_timeout"),
@@ -362,6 +431,11 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_http_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object,
         .u.members  = nxt_conf_vldt_static_members,
+    }, {
+        .name       = nxt_string("compression"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_compression_members,
     }, {
         .name       = nxt_string("log_route"),
         .type       = NXT_CONF_VLDT_BOOLEAN,
@@ -396,6 +470,49 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_static_members[] = {
         .name       = nxt_string("mime_types"),
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_mtypes,
+    }, {
+        .name       = nxt_string("open_file_cache"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_open_file_cache_members,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_open_file_cache_members[] = {
+    {
+        .name       = nxt_string("max"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_open_file_cache_max,
+    }, {
+        .name       = nxt_string("valid"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_open_file_cache_valid,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_compression_members[] = {
+    {
+        .name       = nxt_string("encodings"),
+        .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
+        .validator  = nxt_conf_vldt_compression_encodings,
+    }, {
+        .name       = nxt_string("level"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_compression_level,
+    }, {
+        .name       = nxt_string("min_length"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_compression_min_length,
+    }, {
+        .name       = nxt_string("types"),
+        .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
+        .validator  = nxt_conf_vldt_match_patterns,
     },
 
     NXT_CONF_VLDT_END
@@ -421,6 +538,14 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_listener_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object,
         .u.members  = nxt_conf_vldt_client_ip_members
+    }, {
+        .name       = nxt_string("http2"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    }, {
+        .name       = nxt_string("limit_connections"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_limit_count,
+        .u.string   = "limit_connections",
     },
 
 #if (NXT_TLS)
@@ -498,6 +623,9 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_tls_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object,
         .u.members  = nxt_conf_vldt_session_members,
+    }, {
+        .name       = nxt_string("ktls"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
     },
 
     NXT_CONF_VLDT_END
@@ -699,6 +827,113 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_action_common_members[] = {
         .validator  = nxt_conf_vldt_object_iterator,
         .u.object   = nxt_conf_vldt_response_header,
     },
+    {
+        .name       = nxt_string("compression"),
+        .type       = NXT_CONF_VLDT_OBJECT | NXT_CONF_VLDT_BOOLEAN,
+        .validator  = nxt_conf_vldt_compression,
+    }, {
+        .name       = nxt_string("limit_requests"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_limit_requests_members,
+    }, {
+        .name       = nxt_string("limit_concurrency"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_limit_concurrency_members,
+    }, {
+        .name       = nxt_string("cache"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_cache_members,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_limit_requests_members[] = {
+    {
+        .name       = nxt_string("key"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .flags      = NXT_CONF_VLDT_REQUIRED | NXT_CONF_VLDT_TSTR,
+    }, {
+        .name       = nxt_string("rate"),
+        .type       = NXT_CONF_VLDT_NUMBER,
+        .validator  = nxt_conf_vldt_limit_rate,
+        .flags      = NXT_CONF_VLDT_REQUIRED,
+    }, {
+        .name       = nxt_string("burst"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_limit_burst,
+    }, {
+        .name       = nxt_string("status"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_limit_status,
+    }, {
+        .name       = nxt_string("delay"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_limit_concurrency_members[] = {
+    {
+        .name       = nxt_string("key"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .flags      = NXT_CONF_VLDT_REQUIRED | NXT_CONF_VLDT_TSTR,
+    }, {
+        .name       = nxt_string("requests"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_limit_count,
+        .u.string   = "requests",
+        .flags      = NXT_CONF_VLDT_REQUIRED,
+    }, {
+        .name       = nxt_string("status"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_limit_status,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_cache_members[] = {
+    {
+        .name       = nxt_string("key"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .flags      = NXT_CONF_VLDT_TSTR,
+    }, {
+        .name       = nxt_string("valid"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_cache_time,
+        .u.string   = "valid",
+    }, {
+        .name       = nxt_string("size"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_cache_size,
+    }, {
+        .name       = nxt_string("collapse"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    }, {
+        .name       = nxt_string("collapse_timeout"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_cache_time,
+        .u.string   = "collapse_timeout",
+    }, {
+        .name       = nxt_string("path"),
+        .type       = NXT_CONF_VLDT_STRING,
+    }, {
+        .name       = nxt_string("stale"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_cache_time,
+        .u.string   = "stale",
+    }, {
+        .name       = nxt_string("revalidate"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    },
 
     NXT_CONF_VLDT_END
 };
@@ -769,6 +1004,11 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_share_action_members[] = {
         .validator  = nxt_conf_vldt_unsupported,
         .u.string   = "traverse_mounts",
 #endif
+    }, {
+        .name       = nxt_string("precompressed"),
+        .type       = NXT_CONF_VLDT_BOOLEAN | NXT_CONF_VLDT_STRING
+                      | NXT_CONF_VLDT_ARRAY,
+        .validator  = nxt_conf_vldt_precompressed,
     },
 
     NXT_CONF_VLDT_NEXT(nxt_conf_vldt_action_common_members)
@@ -1365,6 +1605,96 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object_iterator,
         .u.object   = nxt_conf_vldt_server,
+    }, {
+        .name       = nxt_string("keepalive"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_upstream_keepalive_members,
+    }, {
+        .name       = nxt_string("health"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_upstream_health_members,
+    }, {
+        .name       = nxt_string("retry"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_upstream_retry_members,
+    }, {
+        .name       = nxt_string("balancer"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .validator  = nxt_conf_vldt_upstream_balancer,
+    }, {
+        .name       = nxt_string("hash"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .flags      = NXT_CONF_VLDT_TSTR,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_keepalive_members[] = {
+    {
+        .name       = nxt_string("connections"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_keepalive_connections,
+    }, {
+        .name       = nxt_string("requests"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_keepalive_requests,
+    }, {
+        .name       = nxt_string("idle_timeout"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_keepalive_idle_timeout,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_health_members[] = {
+    {
+        .name       = nxt_string("interval"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_time,
+        .u.string   = "interval",
+    }, {
+        .name       = nxt_string("timeout"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_time,
+        .u.string   = "timeout",
+    }, {
+        .name       = nxt_string("fails"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_count,
+        .u.string   = "fails",
+    }, {
+        .name       = nxt_string("passes"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_count,
+        .u.string   = "passes",
+    }, {
+        .name       = nxt_string("uri"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .validator  = nxt_conf_vldt_health_uri,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_retry_members[] = {
+    {
+        .name       = nxt_string("tries"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_count,
+        .u.string   = "tries",
+    }, {
+        .name       = nxt_string("timeout"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_time,
+        .u.string   = "timeout",
     },
 
     NXT_CONF_VLDT_END
@@ -1376,6 +1706,15 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_server_members[] = {
         .name       = nxt_string("weight"),
         .type       = NXT_CONF_VLDT_NUMBER,
         .validator  = nxt_conf_vldt_server_weight,
+    }, {
+        .name       = nxt_string("max_fails"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_server_max_fails,
+    }, {
+        .name       = nxt_string("fail_timeout"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_time,
+        .u.string   = "fail_timeout",
     },
 
     NXT_CONF_VLDT_END
@@ -1553,9 +1892,318 @@ nxt_conf_vldt_var(nxt_conf_validation_t *vldt, const nxt_str_t *name,
 {
     u_char  error[NXT_MAX_ERROR_STR];
 
-    if (nxt_tstr_test(vldt->tstr_state, value, error) != NXT_OK) {
-        return nxt_conf_vldt_error(vldt, "%s in the \"%V\" value.",
-                                   error, name);
+    if (nxt_tstr_test(vldt->tstr_state, value, error) != NXT_OK) {
+        return nxt_conf_vldt_error(vldt, "%s in the \"%V\" value.",
+                                   error, name);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_if(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
+    void *data)
+{
+    nxt_str_t  str;
+
+    static const nxt_str_t  if_str = nxt_string("if");
+
+    if (nxt_conf_type(value) != NXT_CONF_STRING) {
+        return nxt_conf_vldt_error(vldt, "The \"if\" must be a string");
+    }
+
+    nxt_conf_get_string(value, &str);
+
+    if (str.length == 0) {
+        return NXT_OK;
+    }
+
+    if (str.start[0] == '!') {
+        str.start++;
+        str.length--;
+    }
+
+    if (nxt_is_tstr(&str)) {
+        return nxt_conf_vldt_var(vldt, &if_str, &str);
+    }
+
+    return NXT_OK;
+}
+
+
+typedef struct {
+    nxt_mp_t      *pool;
+    nxt_str_t     *type;
+    nxt_lvlhsh_t  hash;
+} nxt_conf_vldt_mtypes_ctx_t;
+
+
+static nxt_int_t
+nxt_conf_vldt_mtypes(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
+    void *data)
+{
+    nxt_int_t                   ret;
+    nxt_conf_vldt_mtypes_ctx_t  ctx;
+
+    ctx.pool = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(ctx.pool == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_lvlhsh_init(&ctx.hash);
+
+    vldt->ctx = &ctx;
+
+    ret = nxt_conf_vldt_object_iterator(vldt, value,
+                                        &nxt_conf_vldt_mtypes_type);
+
+    vldt->ctx = NULL;
+
+    nxt_mp_destroy(ctx.pool);
+
+    return ret;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_mtypes_type(nxt_conf_validation_t *vldt, nxt_str_t *name,
+    nxt_conf_value_t *value)
+{
+    nxt_int_t                   ret;
+    nxt_conf_vldt_mtypes_ctx_t  *ctx;
+
+    ret = nxt_conf_vldt_type(vldt, name, value,
+                             NXT_CONF_VLDT_STRING|NXT_CONF_VLDT_ARRAY);
+    if (ret != NXT_OK) {
+        return ret;
+    }
+
+    ctx = vldt->ctx;
+
+    ctx->type = nxt_mp_get(ctx->pool, sizeof(nxt_str_t));
+    if (nxt_slow_path(ctx->type == NULL)) {
+        return NXT_ERROR;
+    }
+
+    *ctx->type = *name;
+
+    if (nxt_conf_type(value) == NXT_CONF_ARRAY) {
+        return nxt_conf_vldt_array_iterator(vldt, value,
+                                            &nxt_conf_vldt_mtypes_extension);
+    }
+
+    /* NXT_CONF_STRING */
+
+    return nxt_conf_vldt_mtypes_extension(vldt, value);
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_mtypes_extension(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value)
+{
+    nxt_str_t                   exten, *dup_type;
+    nxt_conf_vldt_mtypes_ctx_t  *ctx;
+
+    ctx = vldt->ctx;
+
+    if (nxt_conf_type(value) != NXT_CONF_STRING) {
+        return nxt_conf_vldt_error(vldt, "The \"%V\" MIME type array must "
+                                   "contain only strings.", ctx->type);
+    }
+
+    nxt_conf_get_string(value, &exten);
+
+    if (exten.length == 0) {
+        return nxt_conf_vldt_error(vldt, "An empty file extension for "
+                                         "the \"%V\" MIME type.", ctx->type);
+    }
+
+    dup_type = nxt_http_static_mtype_get(&ctx->hash, &exten);
+
+    if (dup_type->length != 0) {
+        return nxt_conf_vldt_error(vldt, "The \"%V\" file extension has been "
+                                         "declared for \"%V\" and \"%V\" "
+                                         "MIME types at the same time.",
+                                         &exten, dup_type, ctx->type);
+    }
+
+    return nxt_http_static_mtypes_hash_add(ctx->pool, &ctx->hash, &exten,
+                                           ctx->type);
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_open_file_cache_max(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  max;
+
+    max = nxt_conf_get_number(value);
+
+    if (max < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"max\" number must "
+                                   "not be negative.");
+    }
+
+    if (max > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"max\" number must "
+                                   "not exceed %d.", NXT_INT32_T_MAX);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_open_file_cache_valid(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  valid;
+
+    valid = nxt_conf_get_number(value);
+
+    if (valid <= 0) {
+        return nxt_conf_vldt_error(vldt, "The \"valid\" number must "
+                                   "be greater than zero.");
+    }
+
+    if (valid > NXT_INT32_T_MAX / 1000) {
+        return nxt_conf_vldt_error(vldt, "The \"valid\" number must "
+                                   "not exceed %d.", NXT_INT32_T_MAX / 1000);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_compression(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    if (nxt_conf_type(value) == NXT_CONF_BOOLEAN) {
+        return NXT_OK;
+    }
+
+    return nxt_conf_vldt_object(vldt, value,
+                                nxt_conf_vldt_compression_members);
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_compression_encodings(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    uint32_t          i, j, n;
+    nxt_str_t         name, prev;
+    nxt_conf_value_t  *element;
+
+    n = nxt_conf_array_elements_count_or_1(value);
+
+    if (n == 0) {
+        return nxt_conf_vldt_error(vldt, "The \"encodings\" array "
+                                   "must contain at least one element.");
+    }
+
+    for (i = 0; i < n; i++) {
+        element = nxt_conf_get_array_element_or_itself(value, i);
+
+        if (nxt_conf_type(element) != NXT_CONF_STRING) {
+            return nxt_conf_vldt_error(vldt, "The \"encodings\" array "
+                                       "must contain only string values.");
+        }
+
+        nxt_conf_get_string(element, &name);
+
+        if (!nxt_http_compress_encoding(&name)) {
+            return nxt_conf_vldt_error(vldt, "The \"%V\" encoding "
+                                       "is not supported.", &name);
+        }
+
+        for (j = 0; j < i; j++) {
+            element = nxt_conf_get_array_element(value, j);
+            nxt_conf_get_string(element, &prev);
+
+            if (nxt_strstr_eq(&name, &prev)) {
+                return nxt_conf_vldt_error(vldt, "The \"%V\" encoding "
+                                           "is duplicated.", &name);
+            }
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_compression_level(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  level;
+
+    level = nxt_conf_get_number(value);
+
+    if (level < 1 || level > 9) {
+        return nxt_conf_vldt_error(vldt, "The \"level\" number must be "
+                                   "between 1 and 9.");
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_compression_min_length(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    if (nxt_conf_get_number(value) < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"min_length\" number must "
+                                   "not be negative.");
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_control_debounce(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    double  debounce;
+
+    debounce = nxt_conf_get_number(value);
+
+    if (debounce < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"debounce\" number must not "
+                                   "be negative.");
+    }
+
+    if (debounce > 60) {
+        return nxt_conf_vldt_error(vldt, "The \"debounce\" number must "
+                                   "not exceed 60.");
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_limit_rate(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    double  rate;
+
+    rate = nxt_conf_get_number(value);
+
+    if (rate < 0.001) {
+        return nxt_conf_vldt_error(vldt, "The \"rate\" number must be "
+                                   "equal to or greater than 0.001.");
+    }
+
+    if (rate > 1000000) {
+        return nxt_conf_vldt_error(vldt, "The \"rate\" number must "
+                                   "not exceed 1000000.");
     }
 
     return NXT_OK;
@@ -1563,135 +2211,109 @@ nxt_conf_vldt_var(nxt_conf_validation_t *vldt, const nxt_str_t *name,
 
 
 static nxt_int_t
-nxt_conf_vldt_if(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
-    void *data)
+nxt_conf_vldt_limit_burst(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
 {
-    nxt_str_t  str;
-
-    static const nxt_str_t  if_str = nxt_string("if");
-
-    if (nxt_conf_type(value) != NXT_CONF_STRING) {
-        return nxt_conf_vldt_error(vldt, "The \"if\" must be a string");
-    }
-
-    nxt_conf_get_string(value, &str);
+    int64_t  burst;
 
-    if (str.length == 0) {
-        return NXT_OK;
-    }
+    burst = nxt_conf_get_number(value);
 
-    if (str.start[0] == '!') {
-        str.start++;
-        str.length--;
+    if (burst < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"burst\" number must "
+                                   "not be negative.");
     }
 
-    if (nxt_is_tstr(&str)) {
-        return nxt_conf_vldt_var(vldt, &if_str, &str);
+    if (burst > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"burst\" number must "
+                                   "not exceed %d.", NXT_INT32_T_MAX);
     }
 
     return NXT_OK;
 }
 
 
-typedef struct {
-    nxt_mp_t      *pool;
-    nxt_str_t     *type;
-    nxt_lvlhsh_t  hash;
-} nxt_conf_vldt_mtypes_ctx_t;
-
-
 static nxt_int_t
-nxt_conf_vldt_mtypes(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
-    void *data)
+nxt_conf_vldt_limit_status(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
 {
-    nxt_int_t                   ret;
-    nxt_conf_vldt_mtypes_ctx_t  ctx;
+    int64_t  status;
 
-    ctx.pool = nxt_mp_create(1024, 128, 256, 32);
-    if (nxt_slow_path(ctx.pool == NULL)) {
-        return NXT_ERROR;
+    status = nxt_conf_get_number(value);
+
+    if (status < NXT_HTTP_BAD_REQUEST
+        || status > NXT_HTTP_SERVER_ERROR_MAX)
+    {
+        return nxt_conf_vldt_error(vldt, "The \"status\" value must be "
+                                   "an error code from 400 to 599.");
     }
 
-    nxt_lvlhsh_init(&ctx.hash);
+    return NXT_OK;
+}
 
-    vldt->ctx = &ctx;
 
-    ret = nxt_conf_vldt_object_iterator(vldt, value,
-                                        &nxt_conf_vldt_mtypes_type);
+static nxt_int_t
+nxt_conf_vldt_limit_count(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  count;
 
-    vldt->ctx = NULL;
+    count = nxt_conf_get_number(value);
 
-    nxt_mp_destroy(ctx.pool);
+    if (count < 1) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must be "
+                                   "equal to or greater than 1.", data);
+    }
 
-    return ret;
+    if (count > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must "
+                                   "not exceed %d.", data, NXT_INT32_T_MAX);
+    }
+
+    return NXT_OK;
 }
 
 
 static nxt_int_t
-nxt_conf_vldt_mtypes_type(nxt_conf_validation_t *vldt, nxt_str_t *name,
-    nxt_conf_value_t *value)
+nxt_conf_vldt_cache_time(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
 {
-    nxt_int_t                   ret;
-    nxt_conf_vldt_mtypes_ctx_t  *ctx;
+    int64_t  seconds;
 
-    ret = nxt_conf_vldt_type(vldt, name, value,
-                             NXT_CONF_VLDT_STRING|NXT_CONF_VLDT_ARRAY);
-    if (ret != NXT_OK) {
-        return ret;
-    }
-
-    ctx = vldt->ctx;
+    seconds = nxt_conf_get_number(value);
 
-    ctx->type = nxt_mp_get(ctx->pool, sizeof(nxt_str_t));
-    if (nxt_slow_path(ctx->type == NULL)) {
-        return NXT_ERROR;
+    if (seconds < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must be "
+                                   "equal to or greater than 0.", data);
     }
 
-    *ctx->type = *name;
-
-    if (nxt_conf_type(value) == NXT_CONF_ARRAY) {
-        return nxt_conf_vldt_array_iterator(vldt, value,
-                                            &nxt_conf_vldt_mtypes_extension);
+    if (seconds > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must "
+                                   "not exceed %d.", data, NXT_INT32_T_MAX);
     }
 
-    /* NXT_CONF_STRING */
-
-    return nxt_conf_vldt_mtypes_extension(vldt, value);
+    return NXT_OK;
 }
 
 
 static nxt_int_t
-nxt_conf_vldt_mtypes_extension(nxt_conf_validation_t *vldt,
-    nxt_conf_value_t *value)
+nxt_conf_vldt_cache_size(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
 {
-    nxt_str_t                   exten, *dup_type;
-    nxt_conf_vldt_mtypes_ctx_t  *ctx;
+    int64_t  size;
 
-    ctx = vldt->ctx;
-
-    if (nxt_conf_type(value) != NXT_CONF_STRING) {
-        return nxt_conf_vldt_error(vldt, "The \"%V\" MIME type array must "
-                                   "contain only strings.", ctx->type);
-    }
-
-    nxt_conf_get_string(value, &exten);
+    size = nxt_conf_get_number(value);
 
-    if (exten.length == 0) {
-        return nxt_conf_vldt_error(vldt, "An empty file extension for "
-                                         "the \"%V\" MIME type.", ctx->type);
+    if (size < 1) {
+        return nxt_conf_vldt_error(vldt, "The \"size\" number must be "
+                                   "equal to or greater than 1.");
     }
 
-    dup_type = nxt_http_static_mtype_get(&ctx->hash, &exten);
-
-    if (dup_type->length != 0) {
-        return nxt_conf_vldt_error(vldt, "The \"%V\" file extension has been "
-                                         "declared for \"%V\" and \"%V\" "
-                                         "MIME types at the same time.",
-                                         &exten, dup_type, ctx->type);
+    if (size > NXT_SIZE_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"size\" number must "
+                                   "not exceed %uz.", (size_t) NXT_SIZE_T_MAX);
     }
 
-    return nxt_http_static_mtypes_hash_add(ctx->pool, &ctx->hash, &exten,
-                                           ctx->type);
+    return NXT_OK;
 }
 
 
@@ -1906,6 +2528,55 @@ nxt_conf_vldt_return(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
 }
 
 
+static nxt_int_t
+nxt_conf_vldt_precompressed(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    uint32_t          i, j, n;
+    nxt_str_t         name, prev;
+    nxt_conf_value_t  *element;
+
+    if (nxt_conf_type(value) == NXT_CONF_BOOLEAN) {
+        return NXT_OK;
+    }
+
+    n = nxt_conf_array_elements_count_or_1(value);
+
+    if (n == 0) {
+        return nxt_conf_vldt_error(vldt, "The \"precompressed\" array "
+                                   "must contain at least one element.");
+    }
+
+    for (i = 0; i < n; i++) {
+        element = nxt_conf_get_array_element_or_itself(value, i);
+
+        if (nxt_conf_type(element) != NXT_CONF_STRING) {
+            return nxt_conf_vldt_error(vldt, "The \"precompressed\" array "
+                                       "must contain only string values.");
+        }
+
+        nxt_conf_get_string(element, &name);
+
+        if (!nxt_http_static_precompressed(&name)) {
+            return nxt_conf_vldt_error(vldt, "The \"%V\" precompressed "
+                                       "encoding is not supported.", &name);
+        }
+
+        for (j = 0; j < i; j++) {
+            element = nxt_conf_get_array_element(value, j);
+            nxt_conf_get_string(element, &prev);
+
+            if (nxt_strstr_eq(&name, &prev)) {
+                return nxt_conf_vldt_error(vldt, "The \"%V\" precompressed "
+                                           "encoding is duplicated.", &name);
+            }
+        }
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_conf_vldt_share(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
     void *data)
@@ -3270,6 +3941,8 @@ nxt_conf_vldt_upstream(nxt_conf_validation_t *vldt, nxt_str_t *name,
     nxt_conf_value_t  *conf;
 
     static const nxt_str_t  servers = nxt_string("servers");
+    static const nxt_str_t  balancer = nxt_string("balancer");
+    static const nxt_str_t  hash = nxt_string("hash");
 
     ret = nxt_conf_vldt_type(vldt, name, value, NXT_CONF_VLDT_OBJECT);
 
@@ -3289,6 +3962,14 @@ nxt_conf_vldt_upstream(nxt_conf_validation_t *vldt, nxt_str_t *name,
                                    "\"servers\" object value.", name);
     }
 
+    if (nxt_conf_get_object_member(value, &balancer, NULL) != NULL
+        && nxt_conf_get_object_member(value, &hash, NULL) != NULL)
+    {
+        return nxt_conf_vldt_error(vldt, "The \"%V\" upstream must not "
+                                   "contain both \"balancer\" and \"hash\".",
+                                   name);
+    }
+
     return NXT_OK;
 }
 
@@ -3343,6 +4024,188 @@ nxt_conf_vldt_server_weight(nxt_conf_validation_t *vldt,
 }
 
 
+static nxt_int_t
+nxt_conf_vldt_upstream_balancer(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    nxt_str_t  str;
+
+    nxt_conf_get_string(value, &str);
+
+    if (nxt_str_eq(&str, "round_robin", 11)
+        || nxt_str_eq(&str, "least_requests", 14)
+        || nxt_str_eq(&str, "two_choices", 11))
+    {
+        return NXT_OK;
+    }
+
+    return nxt_conf_vldt_error(vldt, "The \"balancer\" must be one of "
+                               "\"round_robin\", \"least_requests\", "
+                               "or \"two_choices\".");
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_server_max_fails(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  max_fails;
+
+    max_fails = nxt_conf_get_number(value);
+
+    if (max_fails < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"max_fails\" number must "
+                                   "not be negative.");
+    }
+
+    if (max_fails > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"max_fails\" number must "
+                                   "not exceed %d.", NXT_INT32_T_MAX);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_keepalive_connections(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  connections;
+
+    connections = nxt_conf_get_number(value);
+
+    if (connections < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"connections\" number must "
+                                   "not be negative.");
+    }
+
+    if (connections > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"connections\" number must "
+                                   "not exceed %d.", NXT_INT32_T_MAX);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_keepalive_requests(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  requests;
+
+    requests = nxt_conf_get_number(value);
+
+    if (requests < 1) {
+        return nxt_conf_vldt_error(vldt, "The \"requests\" number must be "
+                                   "equal to or greater than 1.");
+    }
+
+    if (requests > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"requests\" number must "
+                                   "not exceed %d.", NXT_INT32_T_MAX);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_keepalive_idle_timeout(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  timeout;
+
+    timeout = nxt_conf_get_number(value);
+
+    if (timeout <= 0) {
+        return nxt_conf_vldt_error(vldt, "The \"idle_timeout\" number must "
+                                   "be greater than zero.");
+    }
+
+    if (timeout > NXT_INT32_T_MAX / 1000) {
+        return nxt_conf_vldt_error(vldt, "The \"idle_timeout\" number must "
+                                   "not exceed %d.", NXT_INT32_T_MAX / 1000);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_upstream_time(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  time;
+
+    time = nxt_conf_get_number(value);
+
+    if (time <= 0) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must "
+                                   "be greater than zero.", data);
+    }
+
+    if (time > NXT_INT32_T_MAX / 1000) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must "
+                                   "not exceed %d.", data,
+                                   NXT_INT32_T_MAX / 1000);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_upstream_count(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  count;
+
+    count = nxt_conf_get_number(value);
+
+    if (count < 1) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must be "
+                                   "equal to or greater than 1.", data);
+    }
+
+    if (count > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must "
+                                   "not exceed %d.", data, NXT_INT32_T_MAX);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_health_uri(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    u_char     *p, *end;
+    nxt_str_t  uri;
+
+    nxt_conf_get_string(value, &uri);
+
+    if (uri.length == 0 || uri.start[0] != '/') {
+        return nxt_conf_vldt_error(vldt, "The \"uri\" value must start "
+                                   "with \"/\".");
+    }
+
+    end = uri.start + uri.length;
+
+    for (p = uri.start; p < end; p++) {
+        if (*p <= ' ' || *p == 0x7f) {
+            return nxt_conf_vldt_error(vldt, "The \"uri\" value must not "
+                                       "contain spaces or control "
+                                       "characters.");
+        }
+    }
+
+    return NXT_OK;
+}
+
+
 #if (NXT_HAVE_NJS)
 
 static nxt_int_t
@@ -136,6 +136,7 @@ struct nxt_conn_s {
     nxt_off_t                     sent;
     uint32_t                      max_chunk;
     uint32_t                      nbytes;
+    uint32_t                      requests;
 
     nxt_conn_io_t                 *io;
 
@@ -168,6 +169,7 @@ struct nxt_conn_s {
 
     uint8_t                       sendfile;     /* 2 bits */
     uint8_t                       tcp_nodelay;  /* 1 bit */
+    uint8_t                       alpn_h2;      /* 1 bit */
 
     nxt_queue_link_t              link;
 };
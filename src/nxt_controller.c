@@ -45,6 +45,12 @@ static nxt_int_t nxt_controller_prefork(nxt_task_t *task,
     nxt_process_t *process, nxt_mp_t *mp);
 static nxt_int_t nxt_controller_file_read(nxt_task_t *task, const char *name,
     nxt_str_t *str, nxt_mp_t *mp);
+static nxt_str_t *nxt_controller_snapshot_open(nxt_task_t *task,
+    nxt_mp_t *mp);
+static void nxt_controller_snapshot_cleanup(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_conf_value_t *nxt_controller_snapshot_load(nxt_task_t *task,
+    nxt_mp_t *mp, nxt_str_t *snapshot);
 static nxt_int_t nxt_controller_start(nxt_task_t *task,
     nxt_process_data_t *data);
 static void nxt_controller_process_new_port_handler(nxt_task_t *task,
@@ -85,7 +91,21 @@ static nxt_int_t nxt_controller_request_content_length(void *ctx,
 static void nxt_controller_process_request(nxt_task_t *task,
     nxt_controller_request_t *req);
 static void nxt_controller_process_config(nxt_task_t *task,
+    nxt_controller_request_t *req, nxt_str_t *path, nxt_bool_t staged);
+static nxt_int_t nxt_controller_conf_apply(nxt_task_t *task,
+    nxt_controller_request_t *req, nxt_conf_value_t *value, nxt_mp_t *mp);
+static nxt_msec_t nxt_controller_conf_debounce(nxt_conf_value_t *conf);
+static nxt_conf_value_t *nxt_controller_conf_current(void);
+static void nxt_controller_pending_cancel(nxt_task_t *task);
+static void nxt_controller_pending_timer_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_controller_pending_handler(nxt_task_t *task,
+    nxt_port_recv_msg_t *msg, void *data);
+static void nxt_controller_process_transaction(nxt_task_t *task,
     nxt_controller_request_t *req, nxt_str_t *path);
+static void nxt_controller_transaction_stage(nxt_task_t *task,
+    nxt_controller_request_t *req, nxt_conf_value_t *value, nxt_mp_t *mp);
+static void nxt_controller_transaction_discard(void);
 static nxt_bool_t nxt_controller_check_postpone_request(nxt_task_t *task);
 static void nxt_controller_process_status(nxt_task_t *task,
     nxt_controller_request_t *req);
@@ -98,7 +118,8 @@ static void nxt_controller_process_cert(nxt_task_t *task,
     nxt_controller_request_t *req, nxt_str_t *path);
 static void nxt_controller_process_cert_save(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
-static nxt_bool_t nxt_controller_cert_in_use(nxt_str_t *name);
+static nxt_bool_t nxt_controller_cert_in_use(nxt_conf_value_t *conf,
+    nxt_str_t *name);
 static void nxt_controller_cert_cleanup(nxt_task_t *task, void *obj,
     void *data);
 #endif
@@ -107,7 +128,8 @@ static void nxt_controller_process_script(nxt_task_t *task,
     nxt_controller_request_t *req, nxt_str_t *path);
 static void nxt_controller_process_script_save(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
-static nxt_bool_t nxt_controller_script_in_use(nxt_str_t *name);
+static nxt_bool_t nxt_controller_script_in_use(nxt_conf_value_t *conf,
+    nxt_str_t *name);
 static void nxt_controller_script_cleanup(nxt_task_t *task, void *obj,
     void *data);
 #endif
@@ -119,6 +141,8 @@ static void nxt_controller_conf_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
 static void nxt_controller_conf_store(nxt_task_t *task,
     nxt_conf_value_t *conf);
+static nxt_conf_value_t *nxt_controller_snapshot_create(nxt_mp_t *mp,
+    nxt_conf_value_t *conf);
 static void nxt_controller_response(nxt_task_t *task,
     nxt_controller_request_t *req, nxt_controller_response_t *resp);
 static u_char *nxt_controller_date(u_char *buf, nxt_realtime_t *now,
@@ -135,8 +159,15 @@ static nxt_lvlhsh_t            nxt_controller_fields_hash;
 static nxt_uint_t              nxt_controller_listening;
 static nxt_uint_t              nxt_controller_router_ready;
 static nxt_controller_conf_t   nxt_controller_conf;
+static nxt_controller_conf_t   nxt_controller_pending;
+static nxt_bool_t              nxt_controller_pending_sending;
+static nxt_timer_t             nxt_controller_pending_timer;
+static nxt_controller_conf_t   nxt_controller_transaction;
+static nxt_uint_t              nxt_controller_transaction_version;
+static nxt_uint_t              nxt_controller_conf_version;
 static nxt_queue_t             nxt_controller_waiting_requests;
 static nxt_bool_t              nxt_controller_waiting_init_conf;
+static nxt_bool_t              nxt_controller_snapshot_stale;
 static nxt_conf_value_t        *nxt_controller_status;
 
 
@@ -174,7 +205,7 @@ const nxt_process_init_t  nxt_controller_process = {
 static nxt_int_t
 nxt_controller_prefork(nxt_task_t *task, nxt_process_t *process, nxt_mp_t *mp)
 {
-    nxt_str_t              ver;
+    nxt_str_t              ver, *snapshot;
     nxt_int_t              ret, num;
     nxt_runtime_t          *rt;
     nxt_controller_init_t  ctrl_init;
@@ -217,6 +248,22 @@ nxt_controller_prefork(nxt_task_t *task, nxt_process_t *process, nxt_mp_t *mp)
         }
     }
 
+    /*
+     * The JSON configuration is still read to fall back to it
+     * if the snapshot turns out to be corrupted.
+     */
+
+    if (ctrl_init.conf.start != NULL) {
+        snapshot = nxt_controller_snapshot_open(task, mp);
+
+        if (snapshot != NULL) {
+            ctrl_init.snapshot = *snapshot;
+
+            nxt_mp_cleanup(mp, nxt_controller_snapshot_cleanup, task,
+                           snapshot, rt);
+        }
+    }
+
 #if (NXT_TLS)
     ctrl_init.certs = nxt_cert_store_load(task, mp);
 
@@ -287,6 +334,142 @@ nxt_controller_file_read(nxt_task_t *task, const char *name, nxt_str_t *str,
 }
 
 
+/*
+ * The snapshot is used only if it has been written by the same version
+ * for the current "conf.json"; otherwise the latter is parsed and validated.
+ */
+
+static nxt_str_t *
+nxt_controller_snapshot_open(nxt_task_t *task, nxt_mp_t *mp)
+{
+    void                 *p;
+    ssize_t              n;
+    nxt_int_t            ret;
+    nxt_str_t            *snapshot;
+    nxt_file_t           file;
+    nxt_runtime_t        *rt;
+    nxt_file_info_t      fi, conf_fi;
+    nxt_conf_snapshot_t  header;
+
+    rt = task->thread->runtime;
+
+    nxt_memzero(&file, sizeof(nxt_file_t));
+
+    file.name = (nxt_file_name_t *) rt->conf;
+
+    if (nxt_file_open(task, &file, NXT_FILE_RDONLY, NXT_FILE_OPEN, 0)
+        != NXT_OK)
+    {
+        return NULL;
+    }
+
+    ret = nxt_file_info(&file, &conf_fi);
+
+    nxt_file_close(task, &file);
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    file.name = (nxt_file_name_t *) rt->conf_snapshot;
+
+    if (nxt_file_open(task, &file, NXT_FILE_RDONLY, NXT_FILE_OPEN, 0)
+        != NXT_OK)
+    {
+        return NULL;
+    }
+
+    p = MAP_FAILED;
+
+    ret = nxt_file_info(&file, &fi);
+    if (nxt_slow_path(ret != NXT_OK || !nxt_is_file(&fi))) {
+        goto done;
+    }
+
+    n = nxt_file_read(&file, (u_char *) &header, sizeof(nxt_conf_snapshot_t),
+                      0);
+
+    if (n != sizeof(nxt_conf_snapshot_t)
+        || header.magic != NXT_CONF_SNAPSHOT_MAGIC
+        || header.version != NXT_VERNUM
+        || header.size != nxt_file_size(&fi) - sizeof(nxt_conf_snapshot_t)
+        || header.conf_size != (uint64_t) nxt_file_size(&conf_fi)
+        || header.conf_ino != (uint64_t) nxt_file_ino(&conf_fi)
+        || header.conf_mtime != (int64_t) nxt_file_mtime(&conf_fi))
+    {
+        nxt_debug(task, "configuration snapshot is outdated");
+        goto done;
+    }
+
+    p = nxt_mem_mmap(NULL, nxt_file_size(&fi), PROT_READ, MAP_PRIVATE,
+                     file.fd, 0);
+
+done:
+
+    nxt_file_close(task, &file);
+
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+
+    snapshot = nxt_mp_get(mp, sizeof(nxt_str_t));
+    if (nxt_slow_path(snapshot == NULL)) {
+        nxt_mem_munmap(p, nxt_file_size(&fi));
+        return NULL;
+    }
+
+    snapshot->length = nxt_file_size(&fi);
+    snapshot->start = p;
+
+    return snapshot;
+}
+
+
+static void
+nxt_controller_snapshot_cleanup(nxt_task_t *task, void *obj, void *data)
+{
+    pid_t          main_pid;
+    nxt_str_t      *snapshot;
+    nxt_runtime_t  *rt;
+
+    snapshot = obj;
+    rt = data;
+
+    main_pid = rt->port_by_type[NXT_PROCESS_MAIN]->pid;
+
+    if (nxt_pid == main_pid) {
+        nxt_mem_munmap(snapshot->start, snapshot->length);
+    }
+}
+
+
+static nxt_conf_value_t *
+nxt_controller_snapshot_load(nxt_task_t *task, nxt_mp_t *mp,
+    nxt_str_t *snapshot)
+{
+    u_char               *start, *end;
+    nxt_conf_value_t     *value;
+    nxt_conf_snapshot_t  *header;
+
+    header = (nxt_conf_snapshot_t *) snapshot->start;
+
+    start = snapshot->start + sizeof(nxt_conf_snapshot_t);
+    end = snapshot->start + snapshot->length;
+
+    value = NULL;
+
+    if (nxt_murmur_hash2(start, end - start) == header->checksum) {
+        value = nxt_conf_bin_parse(mp, start, end);
+    }
+
+    nxt_mem_munmap(snapshot->start, snapshot->length);
+
+    nxt_str_null(snapshot);
+
+    return value;
+}
+
+
 #if (NXT_TLS)
 
 static void
@@ -315,9 +498,17 @@ nxt_controller_start(nxt_task_t *task, nxt_process_data_t *data)
     nxt_mp_t               *mp;
     nxt_int_t              ret;
     nxt_str_t              *json;
-    nxt_conf_value_t       *conf;
+    nxt_conf_value_t       *conf, *snapshot;
     nxt_conf_validation_t  vldt;
     nxt_controller_init_t  *init;
+#if (NXT_TLS)
+    nxt_conf_value_t       *certs;
+#endif
+
+    static const nxt_str_t  config_str = nxt_string("config");
+#if (NXT_TLS)
+    static const nxt_str_t  certificates_str = nxt_string("certificates");
+#endif
 
     ret = nxt_http_fields_hash(&nxt_controller_fields_hash,
                                nxt_controller_request_fields,
@@ -329,11 +520,44 @@ nxt_controller_start(nxt_task_t *task, nxt_process_data_t *data)
 
     nxt_queue_init(&nxt_controller_waiting_requests);
 
+    nxt_controller_pending_timer.work_queue =
+                                      &task->thread->engine->fast_work_queue;
+    nxt_controller_pending_timer.handler = nxt_controller_pending_timer_handler;
+    nxt_controller_pending_timer.task = &task->thread->engine->task;
+    nxt_controller_pending_timer.log = task->log;
+
     init = &data->controller;
 
+    mp = NULL;
+    conf = NULL;
+    snapshot = NULL;
+
+    if (init->snapshot.start != NULL) {
+        mp = nxt_mp_create(1024, 128, 256, 32);
+        if (nxt_slow_path(mp == NULL)) {
+            return NXT_ERROR;
+        }
+
+        snapshot = nxt_controller_snapshot_load(task, mp, &init->snapshot);
+
+        if (snapshot != NULL) {
+            conf = nxt_conf_get_object_member(snapshot, &config_str, NULL);
+        }
+
+        if (nxt_slow_path(conf == NULL)) {
+            nxt_log(task, NXT_LOG_WARN,
+                    "configuration snapshot is corrupted, "
+                    "falling back to the JSON configuration");
+        }
+    }
+
 #if (NXT_TLS)
     if (init->certs != NULL) {
-        nxt_cert_info_init(task, init->certs);
+        certs = (snapshot != NULL)
+                ? nxt_conf_get_object_member(snapshot, &certificates_str, NULL)
+                : NULL;
+
+        nxt_cert_info_init(task, init->certs, certs);
         nxt_cert_store_release(init->certs);
     }
 #endif
@@ -345,15 +569,30 @@ nxt_controller_start(nxt_task_t *task, nxt_process_data_t *data)
     }
 #endif
 
+    if (conf != NULL) {
+        nxt_debug(task, "configuration restored from snapshot");
+
+        nxt_controller_conf.root = conf;
+        nxt_controller_conf.pool = mp;
+
+        return NXT_OK;
+    }
+
     json = &init->conf;
 
     if (json->start == NULL) {
+        if (mp != NULL) {
+            nxt_mp_destroy(mp);
+        }
+
         return NXT_OK;
     }
 
-    mp = nxt_mp_create(1024, 128, 256, 32);
-    if (nxt_slow_path(mp == NULL)) {
-        return NXT_ERROR;
+    if (mp == NULL) {
+        mp = nxt_mp_create(1024, 128, 256, 32);
+        if (nxt_slow_path(mp == NULL)) {
+            return NXT_ERROR;
+        }
     }
 
     conf = nxt_conf_json_parse_str(mp, json);
@@ -401,6 +640,8 @@ nxt_controller_start(nxt_task_t *task, nxt_process_data_t *data)
     nxt_controller_conf.root = conf;
     nxt_controller_conf.pool = mp;
 
+    nxt_controller_snapshot_stale = 1;
+
     return NXT_OK;
 }
 
@@ -549,6 +790,11 @@ nxt_controller_conf_init_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
         if (nxt_slow_path(nxt_controller_conf_default() != NXT_OK)) {
             nxt_abort();
         }
+
+    } else if (nxt_controller_snapshot_stale) {
+        nxt_controller_snapshot_stale = 0;
+
+        nxt_controller_conf_store(task, nxt_controller_conf.root);
     }
 
     if (nxt_controller_listening == 0) {
@@ -607,7 +853,9 @@ nxt_controller_conf_send(nxt_task_t *task, nxt_mp_t *mp, nxt_conf_value_t *conf,
 
     controller_port = rt->port_by_type[NXT_PROCESS_CONTROLLER];
 
-    size = nxt_conf_json_length(conf, NULL);
+    /* The router gets the validated configuration in the binary form. */
+
+    size = nxt_conf_bin_length(conf);
 
     b = nxt_buf_mem_alloc(mp, sizeof(size_t), 0);
     if (nxt_slow_path(b == NULL)) {
@@ -624,7 +872,7 @@ nxt_controller_conf_send(nxt_task_t *task, nxt_mp_t *mp, nxt_conf_value_t *conf,
         goto fail;
     }
 
-    end = nxt_conf_json_print(mem, conf, NULL);
+    end = nxt_conf_bin_print(mem, conf);
 
     nxt_mem_munmap(mem, size);
 
@@ -1106,7 +1354,22 @@ nxt_controller_process_request(nxt_task_t *task, nxt_controller_request_t *req)
             path.start += 7;
         }
 
-        nxt_controller_process_config(task, req, &path);
+        nxt_controller_process_config(task, req, &path, 0);
+        return;
+    }
+
+    if (nxt_str_start(&path, "/transaction", 12)
+        && (path.length == 12 || path.start[12] == '/'))
+    {
+        if (path.length == 12) {
+            path.length = 1;
+
+        } else {
+            path.length -= 12;
+            path.start += 12;
+        }
+
+        nxt_controller_process_transaction(task, req, &path);
         return;
     }
 
@@ -1226,7 +1489,8 @@ nxt_controller_process_request(nxt_task_t *task, nxt_controller_request_t *req)
         nxt_conf_set_member(value, &scripts_str, scripts, i++);
 #endif
 
-        nxt_conf_set_member(value, &config, nxt_controller_conf.root, i++);
+        nxt_conf_set_member(value, &config, nxt_controller_conf_current(),
+                            i++);
         nxt_conf_set_member(value, &status, nxt_controller_status, i);
 
         resp.status = 200;
@@ -1265,7 +1529,7 @@ nxt_controller_process_request(nxt_task_t *task, nxt_controller_request_t *req)
 
 static void
 nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
-    nxt_str_t *path)
+    nxt_str_t *path, nxt_bool_t staged)
 {
     nxt_mp_t                   *mp;
     nxt_int_t                  rc;
@@ -1273,8 +1537,7 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
     nxt_bool_t                 post;
     nxt_buf_mem_t              *mbuf;
     nxt_conf_op_t              *ops;
-    nxt_conf_value_t           *value;
-    nxt_conf_validation_t      vldt;
+    nxt_conf_value_t           *root, *value;
     nxt_conf_json_error_t      error;
     nxt_controller_response_t  resp;
 
@@ -1284,9 +1547,17 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
 
     c = req->conn;
 
+    /* The staged changes are made on top of the current configuration. */
+
+    root = nxt_controller_transaction.root;
+
+    if (!staged || root == NULL) {
+        root = nxt_controller_conf_current();
+    }
+
     if (nxt_str_eq(&req->parser.method, "GET", 3)) {
 
-        value = nxt_conf_get_path(nxt_controller_conf.root, path);
+        value = nxt_conf_get_path(root, path);
 
         if (value == NULL) {
             goto not_found;
@@ -1312,7 +1583,7 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
 
     if (post || nxt_str_eq(&req->parser.method, "PUT", 3)) {
 
-        if (nxt_controller_check_postpone_request(task)) {
+        if (!staged && nxt_controller_check_postpone_request(task)) {
             nxt_queue_insert_tail(&nxt_controller_waiting_requests, &req->link);
             return;
         }
@@ -1357,8 +1628,7 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
         }
 
         if (path->length != 1) {
-            rc = nxt_conf_op_compile(c->mem_pool, &ops,
-                                     nxt_controller_conf.root,
+            rc = nxt_conf_op_compile(c->mem_pool, &ops, root,
                                      path, value, post);
 
             if (rc != NXT_CONF_OP_OK) {
@@ -1376,7 +1646,7 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
                 goto alloc_fail;
             }
 
-            value = nxt_conf_clone(mp, ops, nxt_controller_conf.root);
+            value = nxt_conf_clone(mp, ops, root);
 
             if (nxt_slow_path(value == NULL)) {
                 nxt_mp_destroy(mp);
@@ -1384,48 +1654,19 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
             }
         }
 
-        nxt_memzero(&vldt, sizeof(nxt_conf_validation_t));
-
-        vldt.conf = value;
-        vldt.pool = c->mem_pool;
-        vldt.conf_pool = mp;
-        vldt.ver = NXT_VERNUM;
-
-        rc = nxt_conf_validate(&vldt);
-
-        if (nxt_slow_path(rc != NXT_OK)) {
-            nxt_mp_destroy(mp);
-
-            if (rc == NXT_DECLINED) {
-                resp.detail = vldt.error;
-                goto invalid_conf;
-            }
-
-            /* rc == NXT_ERROR */
-            goto alloc_fail;
-        }
-
-        rc = nxt_controller_conf_send(task, mp, value,
-                                      nxt_controller_conf_handler, req);
-
-        if (nxt_slow_path(rc != NXT_OK)) {
-            nxt_mp_destroy(mp);
+        if (staged) {
+            nxt_controller_transaction_stage(task, req, value, mp);
 
-            /* rc == NXT_ERROR */
-            goto alloc_fail;
+        } else {
+            (void) nxt_controller_conf_apply(task, req, value, mp);
         }
 
-        req->conf.root = value;
-        req->conf.pool = mp;
-
-        nxt_queue_insert_head(&nxt_controller_waiting_requests, &req->link);
-
         return;
     }
 
     if (nxt_str_eq(&req->parser.method, "DELETE", 6)) {
 
-        if (nxt_controller_check_postpone_request(task)) {
+        if (!staged && nxt_controller_check_postpone_request(task)) {
             nxt_queue_insert_tail(&nxt_controller_waiting_requests, &req->link);
             return;
         }
@@ -1440,9 +1681,7 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
             value = nxt_conf_json_parse_str(mp, &empty_obj);
 
         } else {
-            rc = nxt_conf_op_compile(c->mem_pool, &ops,
-                                     nxt_controller_conf.root,
-                                     path, NULL, 0);
+            rc = nxt_conf_op_compile(c->mem_pool, &ops, root, path, NULL, 0);
 
             if (rc != NXT_OK) {
                 if (rc == NXT_CONF_OP_NOT_FOUND) {
@@ -1459,7 +1698,7 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
                 goto alloc_fail;
             }
 
-            value = nxt_conf_clone(mp, ops, nxt_controller_conf.root);
+            value = nxt_conf_clone(mp, ops, root);
         }
 
         if (nxt_slow_path(value == NULL)) {
@@ -1467,27 +1706,87 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
             goto alloc_fail;
         }
 
-        nxt_memzero(&vldt, sizeof(nxt_conf_validation_t));
+        if (staged) {
+            nxt_controller_transaction_stage(task, req, value, mp);
 
-        vldt.conf = value;
-        vldt.pool = c->mem_pool;
-        vldt.conf_pool = mp;
-        vldt.ver = NXT_VERNUM;
+        } else {
+            (void) nxt_controller_conf_apply(task, req, value, mp);
+        }
 
-        rc = nxt_conf_validate(&vldt);
+        return;
+    }
 
-        if (nxt_slow_path(rc != NXT_OK)) {
-            nxt_mp_destroy(mp);
+not_allowed:
 
-            if (rc == NXT_DECLINED) {
-                resp.detail = vldt.error;
-                goto invalid_conf;
-            }
+    resp.status = 405;
+    resp.title = (u_char *) "Method isn't allowed.";
+    resp.offset = -1;
 
-            /* rc == NXT_ERROR */
-            goto alloc_fail;
+    nxt_controller_response(task, req, &resp);
+    return;
+
+not_found:
+
+    resp.status = 404;
+    resp.title = (u_char *) "Value doesn't exist.";
+    resp.offset = -1;
+
+    nxt_controller_response(task, req, &resp);
+    return;
+
+alloc_fail:
+
+    resp.status = 500;
+    resp.title = (u_char *) "Memory allocation failed.";
+    resp.offset = -1;
+
+    nxt_controller_response(task, req, &resp);
+}
+
+
+/*
+ * A validated configuration is sent to the router at once, unless
+ * its "debounce" setting is set.  Then the request is answered right
+ * away and the router gets the configuration once no changes follow
+ * for the debounce time, so a burst of changes costs a single
+ * reconfiguration.
+ */
+
+static nxt_int_t
+nxt_controller_conf_apply(nxt_task_t *task, nxt_controller_request_t *req,
+    nxt_conf_value_t *value, nxt_mp_t *mp)
+{
+    nxt_int_t                  rc;
+    nxt_msec_t                 debounce;
+    nxt_conf_validation_t      vldt;
+    nxt_controller_response_t  resp;
+
+    nxt_memzero(&resp, sizeof(nxt_controller_response_t));
+
+    nxt_memzero(&vldt, sizeof(nxt_conf_validation_t));
+
+    vldt.conf = value;
+    vldt.pool = req->conn->mem_pool;
+    vldt.conf_pool = mp;
+    vldt.ver = NXT_VERNUM;
+
+    rc = nxt_conf_validate(&vldt);
+
+    if (nxt_slow_path(rc != NXT_OK)) {
+        nxt_mp_destroy(mp);
+
+        if (rc == NXT_DECLINED) {
+            resp.detail = vldt.error;
+            goto invalid_conf;
         }
 
+        /* rc == NXT_ERROR */
+        goto alloc_fail;
+    }
+
+    debounce = nxt_controller_conf_debounce(value);
+
+    if (debounce == 0) {
         rc = nxt_controller_conf_send(task, mp, value,
                                       nxt_controller_conf_handler, req);
 
@@ -1498,36 +1797,286 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
             goto alloc_fail;
         }
 
+        /* The configuration already includes the pending changes. */
+
+        nxt_controller_pending_cancel(task);
+
+        nxt_controller_conf_version++;
+
         req->conf.root = value;
         req->conf.pool = mp;
 
         nxt_queue_insert_head(&nxt_controller_waiting_requests, &req->link);
 
-        return;
+        return NXT_OK;
     }
 
-not_allowed:
+    if (nxt_controller_pending.pool != NULL) {
+        nxt_mp_destroy(nxt_controller_pending.pool);
+    }
 
-    resp.status = 405;
-    resp.title = (u_char *) "Method isn't allowed.";
+    nxt_controller_pending.root = value;
+    nxt_controller_pending.pool = mp;
+
+    nxt_controller_conf_version++;
+
+    nxt_timer_add(task->thread->engine, &nxt_controller_pending_timer,
+                  debounce);
+
+    resp.status = 202;
+    resp.title = (u_char *) "Reconfiguration scheduled.";
+
+    nxt_controller_response(task, req, &resp);
+
+    return NXT_OK;
+
+invalid_conf:
+
+    resp.status = 400;
+    resp.title = (u_char *) "Invalid configuration.";
     resp.offset = -1;
 
     nxt_controller_response(task, req, &resp);
+    return NXT_DECLINED;
+
+alloc_fail:
+
+    resp.status = 500;
+    resp.title = (u_char *) "Memory allocation failed.";
+    resp.offset = -1;
+
+    nxt_controller_response(task, req, &resp);
+    return NXT_ERROR;
+}
+
+
+static nxt_msec_t
+nxt_controller_conf_debounce(nxt_conf_value_t *conf)
+{
+    nxt_conf_value_t  *value;
+
+    static const nxt_str_t  debounce_path =
+                                    nxt_string("/settings/control/debounce");
+
+    value = nxt_conf_get_path(conf, &debounce_path);
+
+    if (value == NULL) {
+        return 0;
+    }
+
+    return nxt_conf_get_number(value) * 1000;
+}
+
+
+static nxt_conf_value_t *
+nxt_controller_conf_current(void)
+{
+    if (nxt_controller_pending.root != NULL) {
+        return nxt_controller_pending.root;
+    }
+
+    return nxt_controller_conf.root;
+}
+
+
+static void
+nxt_controller_pending_cancel(nxt_task_t *task)
+{
+    if (nxt_controller_pending.pool == NULL) {
+        return;
+    }
+
+    nxt_timer_delete(task->thread->engine, &nxt_controller_pending_timer);
+
+    nxt_mp_destroy(nxt_controller_pending.pool);
+
+    nxt_controller_pending.root = NULL;
+    nxt_controller_pending.pool = NULL;
+}
+
+
+static void
+nxt_controller_pending_timer_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_int_t    rc;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    if (nxt_controller_check_postpone_request(task)) {
+        nxt_timer_add(task->thread->engine, timer,
+                      nxt_controller_conf_debounce(nxt_controller_pending.root));
+        return;
+    }
+
+    nxt_debug(task, "controller pending conf send");
+
+    rc = nxt_controller_conf_send(task, nxt_controller_pending.pool,
+                                  nxt_controller_pending.root,
+                                  nxt_controller_pending_handler, NULL);
+
+    if (nxt_slow_path(rc != NXT_OK)) {
+        nxt_alert(task, "failed to send scheduled configuration");
+
+        nxt_mp_destroy(nxt_controller_pending.pool);
+
+        nxt_controller_pending.root = NULL;
+        nxt_controller_pending.pool = NULL;
+
+        nxt_controller_conf_version++;
+
+        return;
+    }
+
+    nxt_controller_pending_sending = 1;
+}
+
+
+static void
+nxt_controller_pending_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
+    void *data)
+{
+    nxt_controller_pending_sending = 0;
+
+    if (msg->port_msg.type == NXT_PORT_MSG_RPC_READY) {
+        nxt_mp_destroy(nxt_controller_conf.pool);
+
+        nxt_controller_conf = nxt_controller_pending;
+
+        nxt_controller_conf_store(task, nxt_controller_conf.root);
+
+    } else {
+        nxt_alert(task, "failed to apply scheduled configuration");
+
+        nxt_mp_destroy(nxt_controller_pending.pool);
+
+        nxt_controller_conf_version++;
+    }
+
+    nxt_controller_pending.root = NULL;
+    nxt_controller_pending.pool = NULL;
+
+    nxt_controller_flush_requests(task);
+}
+
+
+/*
+ * The changes made under "/transaction/config" are staged without
+ * validation, as a configuration may be invalid halfway through them.
+ * A commit validates and applies them as a single reconfiguration,
+ * unless the configuration was changed after the first staged change.
+ */
+
+static void
+nxt_controller_process_transaction(nxt_task_t *task,
+    nxt_controller_request_t *req, nxt_str_t *path)
+{
+    nxt_mp_t                   *mp;
+    nxt_conf_value_t           *value;
+    nxt_controller_response_t  resp;
+
+    if (nxt_str_start(path, "/config", 7)
+        && (path->length == 7 || path->start[7] == '/'))
+    {
+        if (path->length == 7) {
+            path->length = 1;
+
+        } else {
+            path->length -= 7;
+            path->start += 7;
+        }
+
+        nxt_controller_process_config(task, req, path, 1);
+        return;
+    }
+
+    nxt_memzero(&resp, sizeof(nxt_controller_response_t));
+
+    if (path->length == 1) {
+
+        if (!nxt_str_eq(&req->parser.method, "DELETE", 6)) {
+            goto not_allowed;
+        }
+
+        if (nxt_controller_transaction.root == NULL) {
+            goto not_staged;
+        }
+
+        nxt_controller_transaction_discard();
+
+        resp.status = 200;
+        resp.title = (u_char *) "Staged changes discarded.";
+
+        nxt_controller_response(task, req, &resp);
+        return;
+    }
+
+    if (!nxt_str_eq(path, "/commit", 7)) {
+        resp.status = 404;
+        resp.title = (u_char *) "Value doesn't exist.";
+        resp.offset = -1;
+
+        nxt_controller_response(task, req, &resp);
+        return;
+    }
+
+    if (!nxt_str_eq(&req->parser.method, "POST", 4)) {
+        goto not_allowed;
+    }
+
+    if (nxt_controller_transaction.root == NULL) {
+        goto not_staged;
+    }
+
+    if (nxt_controller_check_postpone_request(task)) {
+        nxt_queue_insert_tail(&nxt_controller_waiting_requests, &req->link);
+        return;
+    }
+
+    if (nxt_controller_transaction_version != nxt_controller_conf_version) {
+        nxt_controller_transaction_discard();
+
+        resp.status = 409;
+        resp.title = (u_char *) "Configuration changed after the changes "
+                                "were staged.";
+        resp.offset = -1;
+
+        nxt_controller_response(task, req, &resp);
+        return;
+    }
+
+    /* The staged changes are kept if the configuration is invalid. */
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        goto alloc_fail;
+    }
+
+    value = nxt_conf_clone(mp, NULL, nxt_controller_transaction.root);
+    if (nxt_slow_path(value == NULL)) {
+        nxt_mp_destroy(mp);
+        goto alloc_fail;
+    }
+
+    if (nxt_controller_conf_apply(task, req, value, mp) == NXT_OK) {
+        nxt_controller_transaction_discard();
+    }
+
     return;
 
-not_found:
+not_allowed:
 
-    resp.status = 404;
-    resp.title = (u_char *) "Value doesn't exist.";
+    resp.status = 405;
+    resp.title = (u_char *) "Method isn't allowed.";
     resp.offset = -1;
 
     nxt_controller_response(task, req, &resp);
     return;
 
-invalid_conf:
+not_staged:
 
-    resp.status = 400;
-    resp.title = (u_char *) "Invalid configuration.";
+    resp.status = 404;
+    resp.title = (u_char *) "No changes are staged.";
     resp.offset = -1;
 
     nxt_controller_response(task, req, &resp);
@@ -1543,6 +2092,41 @@ nxt_controller_process_config(nxt_task_t *task, nxt_controller_request_t *req,
 }
 
 
+static void
+nxt_controller_transaction_stage(nxt_task_t *task,
+    nxt_controller_request_t *req, nxt_conf_value_t *value, nxt_mp_t *mp)
+{
+    nxt_controller_response_t  resp;
+
+    if (nxt_controller_transaction.root == NULL) {
+        nxt_controller_transaction_version = nxt_controller_conf_version;
+
+    } else {
+        nxt_mp_destroy(nxt_controller_transaction.pool);
+    }
+
+    nxt_controller_transaction.root = value;
+    nxt_controller_transaction.pool = mp;
+
+    nxt_memzero(&resp, sizeof(nxt_controller_response_t));
+
+    resp.status = 200;
+    resp.title = (u_char *) "Change staged.";
+
+    nxt_controller_response(task, req, &resp);
+}
+
+
+static void
+nxt_controller_transaction_discard(void)
+{
+    nxt_mp_destroy(nxt_controller_transaction.pool);
+
+    nxt_controller_transaction.root = NULL;
+    nxt_controller_transaction.pool = NULL;
+}
+
+
 static nxt_bool_t
 nxt_controller_check_postpone_request(nxt_task_t *task)
 {
@@ -1551,6 +2135,7 @@ nxt_controller_check_postpone_request(nxt_task_t *task)
 
     if (!nxt_queue_is_empty(&nxt_controller_waiting_requests)
         || nxt_controller_waiting_init_conf
+        || nxt_controller_pending_sending
         || !nxt_controller_router_ready)
     {
         return 1;
@@ -1778,7 +2363,11 @@ nxt_controller_process_cert(nxt_task_t *task,
 
     if (nxt_str_eq(&req->parser.method, "DELETE", 6)) {
 
-        if (nxt_controller_cert_in_use(&name)) {
+        if (nxt_controller_cert_in_use(nxt_controller_conf.root, &name)
+            || (nxt_controller_pending.root != NULL
+                && nxt_controller_cert_in_use(nxt_controller_pending.root,
+                                              &name)))
+        {
             goto cert_in_use;
         }
 
@@ -1896,6 +2485,9 @@ nxt_controller_process_cert_save(nxt_task_t *task, nxt_port_recv_msg_t *msg,
 
     nxt_fd_close(msg->fd[0]);
 
+    /* Refresh the certificate details in the snapshot. */
+    nxt_controller_conf_store(task, nxt_controller_conf.root);
+
     nxt_memzero(&resp, sizeof(nxt_controller_response_t));
 
     resp.status = 200;
@@ -1906,7 +2498,7 @@ nxt_controller_process_cert_save(nxt_task_t *task, nxt_port_recv_msg_t *msg,
 
 
 static nxt_bool_t
-nxt_controller_cert_in_use(nxt_str_t *name)
+nxt_controller_cert_in_use(nxt_conf_value_t *conf, nxt_str_t *name)
 {
     uint32_t          next;
     nxt_str_t         str;
@@ -1915,7 +2507,7 @@ nxt_controller_cert_in_use(nxt_str_t *name)
     static const nxt_str_t  listeners_path = nxt_string("/listeners");
     static const nxt_str_t  certificate_path = nxt_string("/tls/certificate");
 
-    listeners = nxt_conf_get_path(nxt_controller_conf.root, &listeners_path);
+    listeners = nxt_conf_get_path(conf, &listeners_path);
 
     if (listeners != NULL) {
         next = 0;
@@ -2042,7 +2634,11 @@ nxt_controller_process_script(nxt_task_t *task,
 
     if (nxt_str_eq(&req->parser.method, "DELETE", 6)) {
 
-        if (nxt_controller_script_in_use(&name)) {
+        if (nxt_controller_script_in_use(nxt_controller_conf.root, &name)
+            || (nxt_controller_pending.root != NULL
+                && nxt_controller_script_in_use(nxt_controller_pending.root,
+                                                &name)))
+        {
             goto script_in_use;
         }
 
@@ -2172,7 +2768,7 @@ nxt_controller_process_script_save(nxt_task_t *task, nxt_port_recv_msg_t *msg,
 
 
 static nxt_bool_t
-nxt_controller_script_in_use(nxt_str_t *name)
+nxt_controller_script_in_use(nxt_conf_value_t *conf, nxt_str_t *name)
 {
     uint32_t          i, n;
     nxt_str_t         str;
@@ -2180,8 +2776,7 @@ nxt_controller_script_in_use(nxt_str_t *name)
 
     static const nxt_str_t  js_module_path = nxt_string("/settings/js_module");
 
-    js_module = nxt_conf_get_path(nxt_controller_conf.root,
-                                    &js_module_path);
+    js_module = nxt_conf_get_path(conf, &js_module_path);
 
     if (js_module != NULL) {
 
@@ -2262,6 +2857,8 @@ nxt_controller_conf_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
     } else {
         nxt_mp_destroy(req->conf.pool);
 
+        nxt_controller_conf_version++;
+
         resp.status = 500;
         resp.title = (u_char *) "Failed to apply new configuration.";
         resp.offset = -1;
@@ -2422,26 +3019,44 @@ nxt_controller_app_restart_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
 }
 
 
+/*
+ * The JSON configuration is stored along with a binary snapshot of
+ * the validated configuration and of the certificate details, which
+ * allows to restore both on restart without parsing and validation.
+ */
+
 static void
 nxt_controller_conf_store(nxt_task_t *task, nxt_conf_value_t *conf)
 {
-    void           *mem;
-    u_char         *end;
-    size_t         size;
-    nxt_fd_t       fd;
-    nxt_buf_t      *b;
-    nxt_port_t     *main_port;
-    nxt_runtime_t  *rt;
+    void              *mem;
+    u_char            *end;
+    size_t            size, sizes[2];
+    nxt_fd_t          fd;
+    nxt_mp_t          *mp;
+    nxt_buf_t         *b;
+    nxt_port_t        *main_port;
+    nxt_runtime_t     *rt;
+    nxt_conf_value_t  *snapshot;
 
     rt = task->thread->runtime;
 
     main_port = rt->port_by_type[NXT_PROCESS_MAIN];
 
-    size = nxt_conf_json_length(conf, NULL);
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return;
+    }
+
+    snapshot = nxt_controller_snapshot_create(mp, conf);
+
+    sizes[0] = nxt_conf_json_length(conf, NULL);
+    sizes[1] = (snapshot != NULL) ? nxt_conf_bin_length(snapshot) : 0;
+
+    size = sizes[0] + sizes[1];
 
     fd = nxt_shm_open(task, size);
     if (nxt_slow_path(fd == -1)) {
-        return;
+        goto done;
     }
 
     mem = nxt_mem_mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
@@ -2451,26 +3066,72 @@ nxt_controller_conf_store(nxt_task_t *task, nxt_conf_value_t *conf)
 
     end = nxt_conf_json_print(mem, conf, NULL);
 
+    sizes[0] = end - (u_char *) mem;
+
+    if (snapshot != NULL) {
+        end = nxt_conf_bin_print(end, snapshot);
+    }
+
     nxt_mem_munmap(mem, size);
 
-    size = end - (u_char *) mem;
+    sizes[1] = end - (u_char *) mem - sizes[0];
 
-    b = nxt_buf_mem_alloc(task->thread->engine->mem_pool, sizeof(size_t), 0);
+    b = nxt_buf_mem_alloc(task->thread->engine->mem_pool, sizeof(sizes), 0);
     if (nxt_slow_path(b == NULL)) {
         goto fail;
     }
 
-    b->mem.free = nxt_cpymem(b->mem.pos, &size, sizeof(size_t));
+    b->mem.free = nxt_cpymem(b->mem.pos, sizes, sizeof(sizes));
 
     (void) nxt_port_socket_write(task, main_port,
                                 NXT_PORT_MSG_CONF_STORE | NXT_PORT_MSG_CLOSE_FD,
                                  fd, 0, -1, b);
 
-    return;
+    goto done;
 
 fail:
 
     nxt_fd_close(fd);
+
+done:
+
+    nxt_mp_destroy(mp);
+}
+
+
+static nxt_conf_value_t *
+nxt_controller_snapshot_create(nxt_mp_t *mp, nxt_conf_value_t *conf)
+{
+    nxt_conf_value_t  *snapshot;
+#if (NXT_TLS)
+    nxt_conf_value_t  *certs;
+
+    static const nxt_str_t  certificates_str = nxt_string("certificates");
+#endif
+    static const nxt_str_t  config_str = nxt_string("config");
+
+#if (NXT_TLS)
+    certs = nxt_cert_info_snapshot(mp);
+    if (nxt_slow_path(certs == NULL)) {
+        return NULL;
+    }
+
+    snapshot = nxt_conf_create_object(mp, 2);
+    if (nxt_slow_path(snapshot == NULL)) {
+        return NULL;
+    }
+
+    nxt_conf_set_member(snapshot, &certificates_str, certs, 1);
+#else
+    snapshot = nxt_conf_create_object(mp, 1);
+    if (nxt_slow_path(snapshot == NULL)) {
+        return NULL;
+    }
+#endif
+
+    nxt_conf_set_member(snapshot, &config_str, conf, 0);
+
+    return snapshot;
 }
 
 
@@ -2509,6 +3170,10 @@ nxt_controller_response(nxt_task_t *task, nxt_controller_request_t *req,
         nxt_str_set(&status_line, "200 OK");
         break;
 
+    case 202:
+        nxt_str_set(&status_line, "202 Accepted");
+        break;
+
     case 400:
         nxt_str_set(&status_line, "400 Bad Request");
         break;
@@ -2521,6 +3186,10 @@ nxt_controller_response(nxt_task_t *task, nxt_controller_request_t *req,
         nxt_str_set(&status_line, "405 Method Not Allowed");
         break;
 
+    case 409:
+        nxt_str_set(&status_line, "409 Conflict");
+        break;
+
     default:
         nxt_str_set(&status_line, "500 Internal Server Error");
         break;
@@ -225,6 +225,62 @@ extern const nxt_event_interface_t  nxt_epoll_level_engine;
 #endif
 
 
+#if (NXT_HAVE_IO_URING)
+
+typedef struct {
+    nxt_fd_event_t                *event;
+    uint32_t                      gen;
+    uint32_t                      events;
+} nxt_io_uring_slot_t;
+
+
+typedef struct {
+    int                           fd;
+    uint32_t                      gen;
+    nxt_uint_t                    nchanges;
+    nxt_uint_t                    mchanges;
+    nxt_uint_t                    nslots;
+
+    uint8_t                       error;  /* 1 bit */
+
+    uint32_t                      sq_mask;
+    uint32_t                      sq_entries;
+    uint32_t                      sq_tail;
+    uint32_t                      *sq_khead;
+    uint32_t                      *sq_ktail;
+    struct io_uring_sqe           *sqes;
+
+    uint32_t                      cq_mask;
+    uint32_t                      *cq_khead;
+    uint32_t                      *cq_ktail;
+    struct io_uring_cqe           *cqes;
+
+    void                          *sq_ring;
+    size_t                        sq_ring_size;
+    void                          *cq_ring;
+    size_t                        cq_ring_size;
+    size_t                        sqes_size;
+
+    nxt_fd_event_t                **changes;
+    nxt_io_uring_slot_t           *slots;
+
+#if (NXT_HAVE_EVENTFD)
+    nxt_work_handler_t            post_handler;
+    nxt_fd_event_t                eventfd;
+    uint32_t                      neventfd;
+#endif
+
+#if (NXT_HAVE_SIGNALFD)
+    nxt_fd_event_t                signalfd;
+#endif
+} nxt_io_uring_engine_t;
+
+
+extern const nxt_event_interface_t  nxt_io_uring_engine;
+
+#endif
+
+
 #if (NXT_HAVE_EVENTPORT)
 
 typedef struct {
@@ -429,6 +485,9 @@ struct nxt_event_engine_s {
 #if (NXT_HAVE_EPOLL)
         nxt_epoll_engine_t     epoll;
 #endif
+#if (NXT_HAVE_IO_URING)
+        nxt_io_uring_engine_t  io_uring;
+#endif
 #if (NXT_HAVE_EVENTPORT)
         nxt_eventport_engine_t eventport;
 #endif
@@ -481,6 +540,9 @@ struct nxt_event_engine_s {
     nxt_queue_t                joints;
     nxt_queue_t                listen_connections;
     nxt_queue_t                idle_connections;
+    nxt_lvlhsh_t               upstream_connections;
+    void                       *access_log;
+    void                       *open_file_cache;
     nxt_array_t                *mem_cache;
 
     nxt_atomic_uint_t          accepted_conns_cnt;
@@ -173,6 +173,9 @@ NXT_EXPORT nxt_int_t nxt_file_info(nxt_file_t *file, nxt_file_info_t *fi);
 #define nxt_file_mtime(fi)                                                    \
     (fi)->st_mtime
 
+#define nxt_file_ino(fi)                                                      \
+    (fi)->st_ino
+
 
 NXT_EXPORT nxt_int_t nxt_file_delete(nxt_file_name_t *name);
 NXT_EXPORT nxt_int_t nxt_file_set_access(nxt_file_name_t *name,
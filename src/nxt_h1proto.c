@@ -8,6 +8,7 @@
 #include <nxt_http.h>
 #include <nxt_upstream.h>
 #include <nxt_h1proto.h>
+#include <nxt_h2proto.h>
 #include <nxt_websocket.h>
 #include <nxt_websocket_header.h>
 
@@ -81,7 +82,6 @@ static void nxt_h1p_idle_response_timeout(nxt_task_t *task, void *obj,
 static nxt_msec_t nxt_h1p_idle_response_timer_value(nxt_conn_t *c,
     uintptr_t data);
 static void nxt_h1p_shutdown(nxt_task_t *task, nxt_conn_t *c);
-static void nxt_h1p_closing(nxt_task_t *task, nxt_conn_t *c);
 static void nxt_h1p_conn_ws_shutdown(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_conn_closing(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_conn_free(nxt_task_t *task, void *obj, void *data);
@@ -109,6 +109,8 @@ static void nxt_h1p_peer_read_timeout(nxt_task_t *task, void *obj, void *data);
 static nxt_msec_t nxt_h1p_peer_timer_value(nxt_conn_t *c, uintptr_t data);
 static void nxt_h1p_peer_close(nxt_task_t *task, nxt_http_peer_t *peer);
 static void nxt_h1p_peer_free(nxt_task_t *task, void *obj, void *data);
+static nxt_int_t nxt_h1p_peer_connection(void *ctx, nxt_http_field_t *field,
+    uintptr_t data);
 static nxt_int_t nxt_h1p_peer_transfer_encoding(void *ctx,
     nxt_http_field_t *field, uintptr_t data);
 
@@ -151,7 +153,16 @@ const nxt_http_proto_table_t  nxt_http_proto[3] = {
 
         .ws_frame_start   = nxt_h1p_websocket_frame_start,
     },
-    /* NXT_HTTP_PROTO_H2      */
+    /* NXT_HTTP_PROTO_H2 */
+    {
+        .body_read        = nxt_h2p_request_body_read,
+        .local_addr       = nxt_h2p_request_local_addr,
+        .header_send      = nxt_h2p_request_header_send,
+        .send             = nxt_h2p_request_send,
+        .body_bytes_sent  = nxt_h2p_request_body_bytes_sent,
+        .discard          = nxt_h2p_request_discard,
+        .close            = nxt_h2p_request_close,
+    },
     /* NXT_HTTP_PROTO_DEVNULL */
 };
 
@@ -178,13 +189,23 @@ static nxt_http_field_proc_t           nxt_h1p_fields[] = {
     { nxt_string("Content-Length"),    &nxt_http_request_content_length, 0 },
     { nxt_string("Authorization"),     &nxt_http_request_field,
         offsetof(nxt_http_request_t, authorization) },
+    { nxt_string("Accept-Encoding"),   &nxt_http_request_field,
+        offsetof(nxt_http_request_t, accept_encoding) },
+    { nxt_string("If-None-Match"),     &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_none_match) },
+    { nxt_string("If-Modified-Since"), &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_modified_since) },
+    { nxt_string("If-Range"),          &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_range) },
+    { nxt_string("Range"),             &nxt_http_request_field,
+        offsetof(nxt_http_request_t, range) },
 };
 
 
 static nxt_lvlhsh_t                    nxt_h1p_peer_fields_hash;
 
 static nxt_http_field_proc_t           nxt_h1p_peer_fields[] = {
-    { nxt_string("Connection"),        &nxt_http_proxy_skip, 0 },
+    { nxt_string("Connection"),        &nxt_h1p_peer_connection, 0 },
     { nxt_string("Transfer-Encoding"), &nxt_h1p_peer_transfer_encoding, 0 },
     { nxt_string("Server"),            &nxt_http_proxy_skip, 0 },
     { nxt_string("Date"),              &nxt_http_proxy_date, 0 },
@@ -228,6 +249,13 @@ nxt_http_conn_init(nxt_task_t *task, void *obj, void *data)
     skcf = joint->socket_conf;
     c->local = skcf->sockaddr;
 
+    if (skcf->limit_connections != 0
+        && nxt_http_limit_conn(task, c, skcf) != NXT_OK)
+    {
+        nxt_h1p_closing(task, c);
+        return;
+    }
+
     engine = task->thread->engine;
     c->read_work_queue = &engine->fast_work_queue;
     c->write_work_queue = &engine->fast_work_queue;
@@ -452,6 +480,11 @@ nxt_h1p_conn_proto_init(nxt_task_t *task, void *obj, void *data)
 
     nxt_debug(task, "h1p conn proto init");
 
+    if (nxt_h2p_conn_test(c)) {
+        nxt_h2p_conn_init(task, c);
+        return;
+    }
+
     h1p = nxt_mp_zget(c->mem_pool, sizeof(nxt_h1proto_t));
     if (nxt_slow_path(h1p == NULL)) {
         nxt_h1p_closing(task, c);
@@ -493,6 +526,7 @@ nxt_h1p_conn_request_init(nxt_task_t *task, void *obj, void *data)
 
 #if (NXT_TLS)
         r->tls = (c->u.tls != NULL);
+        r->sendfile = (c->sendfile == NXT_CONN_SENDFILE_ON);
 #endif
 
         r->task = c->task;
@@ -1177,7 +1211,7 @@ static const nxt_str_t  nxt_http_client_error[] = {
     nxt_string("HTTP/1.1 426 Upgrade Required\r\n"),
     nxt_string("HTTP/1.1 427 \r\n"),
     nxt_string("HTTP/1.1 428 \r\n"),
-    nxt_string("HTTP/1.1 429 \r\n"),
+    nxt_string("HTTP/1.1 429 Too Many Requests\r\n"),
     nxt_string("HTTP/1.1 430 \r\n"),
     nxt_string("HTTP/1.1 431 Request Header Fields Too Large\r\n"),
 };
@@ -2058,7 +2092,7 @@ nxt_h1p_conn_ws_shutdown(nxt_task_t *task, void *obj, void *data)
 }
 
 
-static void
+void
 nxt_h1p_closing(nxt_task_t *task, nxt_conn_t *c)
 {
     nxt_debug(task, "h1p closing");
@@ -2154,13 +2188,11 @@ nxt_h1p_peer_connect(nxt_task_t *task, nxt_http_peer_t *peer)
     peer->status = NXT_HTTP_UNSET;
     r = peer->request;
 
-    mp = nxt_mp_create(1024, 128, 256, 32);
-
-    if (nxt_slow_path(mp == NULL)) {
-        goto fail;
-    }
-
-    h1p = nxt_mp_zalloc(mp, sizeof(nxt_h1proto_t));
+    /*
+     * The protocol state is allocated from the request pool,
+     * since a keep-alive connection outlives the request.
+     */
+    h1p = nxt_mp_zalloc(r->mem_pool, sizeof(nxt_h1proto_t));
     if (nxt_slow_path(h1p == NULL)) {
         goto fail;
     }
@@ -2170,27 +2202,38 @@ nxt_h1p_peer_connect(nxt_task_t *task, nxt_http_peer_t *peer)
         goto fail;
     }
 
-    c = nxt_conn_create(mp, task);
-    if (nxt_slow_path(c == NULL)) {
-        goto fail;
+    c = peer->server->connection;
+
+    if (c == NULL) {
+        mp = nxt_mp_create(1024, 128, 256, 32);
+
+        if (nxt_slow_path(mp == NULL)) {
+            goto fail;
+        }
+
+        c = nxt_conn_create(mp, task);
+        if (nxt_slow_path(c == NULL)) {
+            goto fail;
+        }
+
+        c->mem_pool = mp;
+        c->remote = peer->server->sockaddr;
+        c->socket.write_ready = 1;
     }
 
-    c->mem_pool = mp;
     h1p->conn = c;
 
     peer->proto.h1 = h1p;
     h1p->request = r;
 
     c->socket.data = peer;
-    c->remote = peer->server->sockaddr;
-
-    c->socket.write_ready = 1;
-    c->write_state = &nxt_h1p_peer_connect_state;
+    c->requests++;
 
     /*
      * TODO: queues should be implemented via client proto interface.
      */
-    client = r->proto.h1->conn;
+    client = (r->protocol == NXT_HTTP_PROTO_H2) ? r->proto.h2->h2p->conn
+                                                : r->proto.h1->conn;
 
     socket = &client->socket;
     wq = socket->read_work_queue;
@@ -2204,12 +2247,30 @@ nxt_h1p_peer_connect(nxt_task_t *task, nxt_http_peer_t *peer)
     c->write_timer.work_queue = wq;
     /* TODO END */
 
+    if (peer->server->connection != NULL) {
+        nxt_debug(task, "h1p peer keepalive fd:%d", c->socket.fd);
+
+        nxt_h1p_peer_connected(task, c, peer);
+        return;
+    }
+
+    c->write_state = &nxt_h1p_peer_connect_state;
+
     nxt_conn_connect(task->thread->engine, c);
 
     return;
 
 fail:
 
+    c = peer->server->connection;
+
+    if (c != NULL) {
+        peer->server->connection = NULL;
+
+        c->write_state = &nxt_h1p_peer_close_state;
+        nxt_conn_close(task->thread->engine, c);
+    }
+
     peer->status = NXT_HTTP_INTERNAL_SERVER_ERROR;
 
     r->state->error_handler(task, r, peer);
@@ -2270,6 +2331,7 @@ nxt_h1p_peer_header_send(nxt_task_t *task, nxt_http_peer_t *peer)
     nxt_int_t           ret;
     nxt_str_t           target;
     nxt_buf_t           *header, *body;
+    nxt_bool_t          keepalive;
     nxt_conn_t          *c;
     nxt_http_field_t    *field;
     nxt_http_request_t  *r;
@@ -2283,6 +2345,9 @@ nxt_h1p_peer_header_send(nxt_task_t *task, nxt_http_peer_t *peer)
         goto fail;
     }
 
+    /* HTTP/1.1 connections are persistent unless stated otherwise. */
+    keepalive = (peer->server->upstream->keepalive != NULL);
+
     size = r->method->length + sizeof(" ") + target.length
            + sizeof(" HTTP/1.1\r\n")
            + sizeof("Connection: close\r\n")
@@ -2308,7 +2373,10 @@ nxt_h1p_peer_header_send(nxt_task_t *task, nxt_http_peer_t *peer)
     *p++ = ' ';
     p = nxt_cpymem(p, target.start, target.length);
     p = nxt_cpymem(p, " HTTP/1.1\r\n", 11);
-    p = nxt_cpymem(p, "Connection: close\r\n", 19);
+
+    if (!keepalive) {
+        p = nxt_cpymem(p, "Connection: close\r\n", 19);
+    }
 
     nxt_list_each(field, r->fields) {
 
@@ -2609,6 +2677,31 @@ nxt_h1p_peer_header_read_done(nxt_task_t *task, void *obj, void *data)
 
         h1p = peer->proto.h1;
 
+        /*
+         * A response on a keep-alive connection is complete when its body
+         * has been read, otherwise the body is read until the server closes
+         * the connection.
+         */
+
+        if (h1p->keepalive
+            && (peer->status == NXT_HTTP_NO_CONTENT
+                || peer->status == NXT_HTTP_NOT_MODIFIED
+                || nxt_str_eq(r->method, "HEAD", 4)
+                || (r->resp.content_length_n == 0 && !h1p->chunked)))
+        {
+            /* The response has no body. */
+
+            h1p->keepalive &= (nxt_buf_mem_used_size(&b->mem) == 0);
+
+            nxt_http_proxy_buf_mem_free(task, r, b);
+
+            peer->body = nxt_http_buf_last(r);
+            peer->closed = 1;
+
+            r->state->ready_handler(task, r, peer);
+            return;
+        }
+
         if (h1p->chunked) {
             if (r->resp.content_length != NULL) {
                 peer->status = NXT_HTTP_BAD_GATEWAY;
@@ -2619,6 +2712,10 @@ nxt_h1p_peer_header_read_done(nxt_task_t *task, void *obj, void *data)
 
         } else if (r->resp.content_length_n > 0) {
             h1p->remainder = r->resp.content_length_n;
+
+        } else {
+            /* The response body is delimited by connection close. */
+            h1p->keepalive = 0;
         }
 
         if (nxt_buf_mem_used_size(&b->mem) != 0) {
@@ -2655,9 +2752,10 @@ nxt_h1p_peer_header_read_done(nxt_task_t *task, void *obj, void *data)
 static nxt_int_t
 nxt_h1p_peer_header_parse(nxt_http_peer_t *peer, nxt_buf_mem_t *bm)
 {
-    u_char     *p;
-    size_t     length;
-    nxt_int_t  status;
+    u_char         *p;
+    size_t         length;
+    nxt_int_t      status;
+    nxt_h1proto_t  *h1p;
 
     if (peer->status < 0) {
         length = nxt_buf_mem_used_size(bm);
@@ -2680,6 +2778,10 @@ nxt_h1p_peer_header_parse(nxt_http_peer_t *peer, nxt_buf_mem_t *bm)
             return NXT_ERROR;
         }
 
+        h1p = peer->proto.h1;
+        h1p->keepalive = (p[7] == '1'
+                          && peer->server->upstream->keepalive != NULL);
+
         p += 12;
         length -= 12;
 
@@ -2774,6 +2876,15 @@ nxt_h1p_peer_body_process(nxt_task_t *task, nxt_http_peer_t *peer,
     } else if (h1p->remainder > 0) {
         length = nxt_buf_chain_length(out);
         h1p->remainder -= length;
+
+        if (h1p->keepalive && h1p->remainder <= 0) {
+            r = peer->request;
+            r->inconsistent = (h1p->remainder != 0);
+            h1p->keepalive &= !r->inconsistent;
+
+            nxt_buf_chain_add(&out, nxt_http_buf_last(r));
+            peer->closed = 1;
+        }
     }
 
     peer->body = out;
@@ -2795,6 +2906,8 @@ nxt_h1p_peer_closed(nxt_task_t *task, void *obj, void *data)
 
     r = peer->request;
 
+    peer->proto.h1->keepalive = 0;
+
     if (peer->header_received) {
         peer->body = nxt_http_buf_last(r);
         peer->closed = 1;
@@ -2889,18 +3002,34 @@ nxt_h1p_peer_timer_value(nxt_conn_t *c, uintptr_t data)
 static void
 nxt_h1p_peer_close(nxt_task_t *task, nxt_http_peer_t *peer)
 {
-    nxt_conn_t  *c;
+    nxt_int_t      ret;
+    nxt_bool_t     keepalive;
+    nxt_conn_t     *c;
+    nxt_h1proto_t  *h1p;
 
     nxt_debug(task, "h1p peer close");
 
+    h1p = peer->proto.h1;
+
+    /* The peer is marked as closed when the response has been read. */
+    keepalive = peer->closed && h1p->keepalive;
+
     peer->closed = 1;
 
-    c = peer->proto.h1->conn;
+    c = h1p->conn;
     task = &c->task;
     c->socket.task = task;
     c->read_timer.task = task;
     c->write_timer.task = task;
 
+    if (keepalive && c->write == NULL && c->socket.fd != -1) {
+        ret = nxt_upstream_keepalive_put(task,
+                                         peer->server->upstream->keepalive, c);
+        if (ret == NXT_OK) {
+            return;
+        }
+    }
+
     if (c->socket.fd != -1) {
         c->write_state = &nxt_h1p_peer_close_state;
 
@@ -2932,6 +3061,24 @@ nxt_h1p_peer_free(nxt_task_t *task, void *obj, void *data)
 }
 
 
+static nxt_int_t
+nxt_h1p_peer_connection(void *ctx, nxt_http_field_t *field, uintptr_t data)
+{
+    nxt_http_request_t  *r;
+
+    r = ctx;
+    field->skip = 1;
+
+    if (field->value_length == 5
+        && nxt_memcasecmp(field->value, "close", 5) == 0)
+    {
+        r->peer->proto.h1->keepalive = 0;
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_h1p_peer_transfer_encoding(void *ctx, nxt_http_field_t *field,
     uintptr_t data)
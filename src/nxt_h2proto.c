@@ -0,0 +1,3288 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include <nxt_h2proto.h>
+
+
+#define NXT_H2P_PREFACE              "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+
+#define NXT_H2P_FRAME_HEADER_SIZE    9
+#define NXT_H2P_DEFAULT_FRAME_SIZE   16384
+#define NXT_H2P_MAX_FRAME_SIZE       ((1 << 24) - 1)
+#define NXT_H2P_READ_BUFFER_SIZE                                              \
+    (NXT_H2P_FRAME_HEADER_SIZE + 2 * NXT_H2P_DEFAULT_FRAME_SIZE)
+
+#define NXT_H2P_MAX_WINDOW           0x7fffffff
+#define NXT_H2P_DEFAULT_WINDOW       65535
+#define NXT_H2P_CONN_WINDOW          (1024 * 1024)
+
+#define NXT_H2P_MAX_STREAMS          128
+#define NXT_H2P_MAX_HEADER_BLOCK     (64 * 1024)
+#define NXT_H2P_HPACK_TABLE_SIZE     4096
+#define NXT_H2P_HPACK_ENTRY_OVERHEAD 32
+
+#define NXT_H2P_DATA                 0x0
+#define NXT_H2P_HEADERS              0x1
+#define NXT_H2P_PRIORITY             0x2
+#define NXT_H2P_RST_STREAM           0x3
+#define NXT_H2P_SETTINGS             0x4
+#define NXT_H2P_PUSH_PROMISE         0x5
+#define NXT_H2P_PING                 0x6
+#define NXT_H2P_GOAWAY               0x7
+#define NXT_H2P_WINDOW_UPDATE        0x8
+#define NXT_H2P_CONTINUATION         0x9
+
+#define NXT_H2P_END_STREAM           0x01
+#define NXT_H2P_ACK                  0x01
+#define NXT_H2P_END_HEADERS          0x04
+#define NXT_H2P_PADDED               0x08
+#define NXT_H2P_PRIORITY_FLAG        0x20
+
+#define NXT_H2P_HEADER_TABLE_SIZE    0x1
+#define NXT_H2P_ENABLE_PUSH          0x2
+#define NXT_H2P_MAX_CONCURRENT       0x3
+#define NXT_H2P_INITIAL_WINDOW_SIZE  0x4
+#define NXT_H2P_MAX_FRAME_SIZE_ID    0x5
+
+#define NXT_H2P_NO_ERROR             0x0
+#define NXT_H2P_PROTOCOL_ERROR       0x1
+#define NXT_H2P_INTERNAL_ERROR       0x2
+#define NXT_H2P_FLOW_CONTROL_ERROR   0x3
+#define NXT_H2P_STREAM_CLOSED        0x5
+#define NXT_H2P_FRAME_SIZE_ERROR     0x6
+#define NXT_H2P_REFUSED_STREAM       0x7
+#define NXT_H2P_CANCEL               0x8
+#define NXT_H2P_COMPRESSION_ERROR    0x9
+#define NXT_H2P_ENHANCE_YOUR_CALM    0xb
+
+
+typedef struct {
+    nxt_str_t                 name;
+    nxt_str_t                 value;
+} nxt_h2p_header_t;
+
+
+typedef nxt_int_t (*nxt_h2p_frame_handler_t)(nxt_task_t *task,
+    nxt_h2proto_t *h2p, uint32_t id, nxt_uint_t flags, u_char *pos,
+    size_t length);
+
+
+static void nxt_h2p_conn_read(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_read_next(nxt_task_t *task, nxt_h2proto_t *h2p);
+static nxt_int_t nxt_h2p_data(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, size_t length);
+static nxt_int_t nxt_h2p_headers(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, size_t length);
+static nxt_int_t nxt_h2p_priority(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, size_t length);
+static nxt_int_t nxt_h2p_rst_stream(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, size_t length);
+static nxt_int_t nxt_h2p_settings(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, size_t length);
+static nxt_int_t nxt_h2p_push_promise(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, size_t length);
+static nxt_int_t nxt_h2p_ping(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, size_t length);
+static nxt_int_t nxt_h2p_goaway(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, size_t length);
+static nxt_int_t nxt_h2p_window_update(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, size_t length);
+static nxt_int_t nxt_h2p_continuation(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, size_t length);
+static nxt_int_t nxt_h2p_header_block(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, u_char *end);
+static nxt_int_t nxt_h2p_header_block_skip(nxt_task_t *task,
+    nxt_h2proto_t *h2p, u_char *pos, u_char *end);
+static nxt_int_t nxt_h2p_stream_create(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, u_char *end);
+static nxt_int_t nxt_h2p_request_header_process(nxt_task_t *task,
+    nxt_h2p_stream_t *stream, nxt_array_t *headers);
+static nxt_int_t nxt_h2p_body_append(nxt_task_t *task,
+    nxt_h2p_stream_t *stream, u_char *pos, size_t size);
+static nxt_buf_t *nxt_h2p_body_file(nxt_task_t *task, nxt_http_request_t *r);
+static void nxt_h2p_body_done(nxt_task_t *task, nxt_h2p_stream_t *stream);
+static nxt_h2p_stream_t *nxt_h2p_stream_find(nxt_h2proto_t *h2p, uint32_t id);
+static void nxt_h2p_stream_out_drain(nxt_task_t *task,
+    nxt_h2p_stream_t *stream);
+static void nxt_h2p_stream_abort(nxt_task_t *task, nxt_h2p_stream_t *stream);
+static void nxt_h2p_stream_error(nxt_task_t *task, nxt_h2p_stream_t *stream);
+static void nxt_h2p_stream_output(nxt_task_t *task, nxt_h2p_stream_t *stream);
+static void nxt_h2p_streams_output(nxt_task_t *task, nxt_h2proto_t *h2p);
+
+static nxt_int_t nxt_h2p_hpack_int(u_char **pos, u_char *end,
+    nxt_uint_t prefix, uint32_t *value);
+static nxt_int_t nxt_h2p_hpack_string(nxt_mp_t *mp, u_char **pos, u_char *end,
+    nxt_str_t *str);
+static u_char *nxt_h2p_huff_decode(u_char *dst, u_char *src, size_t size);
+static nxt_int_t nxt_h2p_hpack_get(nxt_h2p_hpack_t *hpack, uint32_t index,
+    nxt_str_t *name, nxt_str_t *value, nxt_bool_t *dynamic);
+static nxt_int_t nxt_h2p_hpack_add(nxt_h2p_hpack_t *hpack, nxt_str_t *name,
+    nxt_str_t *value);
+static void nxt_h2p_hpack_evict(nxt_h2p_hpack_t *hpack, size_t size);
+static u_char *nxt_h2p_hpack_int_encode(u_char *p, nxt_uint_t prefix,
+    uint32_t value, u_char first);
+static nxt_uint_t nxt_h2p_hpack_name_index(u_char *name, size_t length);
+
+static nxt_buf_t *nxt_h2p_buf_alloc(nxt_h2proto_t *h2p, size_t size);
+static nxt_buf_t *nxt_h2p_buf_shadow(nxt_h2proto_t *h2p, nxt_buf_t *b,
+    size_t size);
+static nxt_buf_t *nxt_h2p_buf_sync(nxt_h2proto_t *h2p, nxt_buf_t *b);
+static void nxt_h2p_buf_completion(nxt_task_t *task, void *obj, void *data);
+static nxt_int_t nxt_h2p_send_settings(nxt_task_t *task, nxt_h2proto_t *h2p);
+static void nxt_h2p_send_window_update(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, uint32_t increment);
+static void nxt_h2p_send_rst_stream(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, uint32_t code);
+static void nxt_h2p_send_goaway(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t code);
+static void nxt_h2p_conn_write(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_buf_t *out);
+static void nxt_h2p_conn_sent(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_write_error(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_h2p_conn_send_timeout(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_h2p_conn_close(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_error(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_idle_timeout(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_read_timeout(nxt_task_t *task, void *obj, void *data);
+static nxt_msec_t nxt_h2p_conn_timer_value(nxt_conn_t *c, uintptr_t data);
+static void nxt_h2p_protocol_error(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t code);
+static void nxt_h2p_shutdown(nxt_task_t *task, nxt_h2proto_t *h2p);
+static void nxt_h2p_close_test(nxt_task_t *task, nxt_h2proto_t *h2p);
+
+
+static const nxt_conn_state_t  nxt_h2p_idle_state;
+static const nxt_conn_state_t  nxt_h2p_read_state;
+static const nxt_conn_state_t  nxt_h2p_send_state;
+
+
+static const nxt_h2p_frame_handler_t  nxt_h2p_frame_handlers[] = {
+    nxt_h2p_data,
+    nxt_h2p_headers,
+    nxt_h2p_priority,
+    nxt_h2p_rst_stream,
+    nxt_h2p_settings,
+    nxt_h2p_push_promise,
+    nxt_h2p_ping,
+    nxt_h2p_goaway,
+    nxt_h2p_window_update,
+    nxt_h2p_continuation,
+};
+
+
+nxt_inline u_char *
+nxt_h2p_uint32(u_char *p, uint32_t value)
+{
+    *p++ = (u_char) (value >> 24);
+    *p++ = (u_char) (value >> 16);
+    *p++ = (u_char) (value >> 8);
+    *p++ = (u_char) value;
+
+    return p;
+}
+
+
+nxt_inline u_char *
+nxt_h2p_frame_header(u_char *p, uint32_t length, nxt_uint_t type,
+    nxt_uint_t flags, uint32_t id)
+{
+    *p++ = (u_char) (length >> 16);
+    *p++ = (u_char) (length >> 8);
+    *p++ = (u_char) length;
+    *p++ = (u_char) type;
+    *p++ = (u_char) flags;
+
+    return nxt_h2p_uint32(p, id);
+}
+
+
+static nxt_lvlhsh_t                    nxt_h2p_fields_hash;
+
+static nxt_http_field_proc_t           nxt_h2p_fields[] = {
+    { nxt_string("Host"),              &nxt_http_request_host, 0 },
+    { nxt_string("Cookie"),            &nxt_http_request_field,
+        offsetof(nxt_http_request_t, cookie) },
+    { nxt_string("Referer"),           &nxt_http_request_field,
+        offsetof(nxt_http_request_t, referer) },
+    { nxt_string("User-Agent"),        &nxt_http_request_field,
+        offsetof(nxt_http_request_t, user_agent) },
+    { nxt_string("Content-Type"),      &nxt_http_request_field,
+        offsetof(nxt_http_request_t, content_type) },
+    { nxt_string("Content-Length"),    &nxt_http_request_content_length, 0 },
+    { nxt_string("Authorization"),     &nxt_http_request_field,
+        offsetof(nxt_http_request_t, authorization) },
+    { nxt_string("Accept-Encoding"),   &nxt_http_request_field,
+        offsetof(nxt_http_request_t, accept_encoding) },
+    { nxt_string("If-None-Match"),     &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_none_match) },
+    { nxt_string("If-Modified-Since"), &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_modified_since) },
+    { nxt_string("If-Range"),          &nxt_http_request_field,
+        offsetof(nxt_http_request_t, if_range) },
+    { nxt_string("Range"),             &nxt_http_request_field,
+        offsetof(nxt_http_request_t, range) },
+};
+
+
+/* RFC 7541, Appendix A. */
+
+static const nxt_h2p_header_t  nxt_h2p_static_table[] = {
+    { nxt_string(":authority"),                  nxt_null_string },
+    { nxt_string(":method"),                     nxt_string("GET") },
+    { nxt_string(":method"),                     nxt_string("POST") },
+    { nxt_string(":path"),                       nxt_string("/") },
+    { nxt_string(":path"),                       nxt_string("/index.html") },
+    { nxt_string(":scheme"),                     nxt_string("http") },
+    { nxt_string(":scheme"),                     nxt_string("https") },
+    { nxt_string(":status"),                     nxt_string("200") },
+    { nxt_string(":status"),                     nxt_string("204") },
+    { nxt_string(":status"),                     nxt_string("206") },
+    { nxt_string(":status"),                     nxt_string("304") },
+    { nxt_string(":status"),                     nxt_string("400") },
+    { nxt_string(":status"),                     nxt_string("404") },
+    { nxt_string(":status"),                     nxt_string("500") },
+    { nxt_string("accept-charset"),              nxt_null_string },
+    { nxt_string("accept-encoding"),             nxt_string("gzip, deflate") },
+    { nxt_string("accept-language"),             nxt_null_string },
+    { nxt_string("accept-ranges"),               nxt_null_string },
+    { nxt_string("accept"),                      nxt_null_string },
+    { nxt_string("access-control-allow-origin"), nxt_null_string },
+    { nxt_string("age"),                         nxt_null_string },
+    { nxt_string("allow"),                       nxt_null_string },
+    { nxt_string("authorization"),               nxt_null_string },
+    { nxt_string("cache-control"),               nxt_null_string },
+    { nxt_string("content-disposition"),         nxt_null_string },
+    { nxt_string("content-encoding"),            nxt_null_string },
+    { nxt_string("content-language"),            nxt_null_string },
+    { nxt_string("content-length"),              nxt_null_string },
+    { nxt_string("content-location"),            nxt_null_string },
+    { nxt_string("content-range"),               nxt_null_string },
+    { nxt_string("content-type"),                nxt_null_string },
+    { nxt_string("cookie"),                      nxt_null_string },
+    { nxt_string("date"),                        nxt_null_string },
+    { nxt_string("etag"),                        nxt_null_string },
+    { nxt_string("expect"),                      nxt_null_string },
+    { nxt_string("expires"),                     nxt_null_string },
+    { nxt_string("from"),                        nxt_null_string },
+    { nxt_string("host"),                        nxt_null_string },
+    { nxt_string("if-match"),                    nxt_null_string },
+    { nxt_string("if-modified-since"),           nxt_null_string },
+    { nxt_string("if-none-match"),               nxt_null_string },
+    { nxt_string("if-range"),                    nxt_null_string },
+    { nxt_string("if-unmodified-since"),         nxt_null_string },
+    { nxt_string("last-modified"),               nxt_null_string },
+    { nxt_string("link"),                        nxt_null_string },
+    { nxt_string("location"),                    nxt_null_string },
+    { nxt_string("max-forwards"),                nxt_null_string },
+    { nxt_string("proxy-authenticate"),          nxt_null_string },
+    { nxt_string("proxy-authorization"),         nxt_null_string },
+    { nxt_string("range"),                       nxt_null_string },
+    { nxt_string("referer"),                     nxt_null_string },
+    { nxt_string("refresh"),                     nxt_null_string },
+    { nxt_string("retry-after"),                 nxt_null_string },
+    { nxt_string("server"),                      nxt_null_string },
+    { nxt_string("set-cookie"),                  nxt_null_string },
+    { nxt_string("strict-transport-security"),   nxt_null_string },
+    { nxt_string("transfer-encoding"),           nxt_null_string },
+    { nxt_string("user-agent"),                  nxt_null_string },
+    { nxt_string("vary"),                        nxt_null_string },
+    { nxt_string("via"),                         nxt_null_string },
+    { nxt_string("www-authenticate"),            nxt_null_string },
+};
+
+
+/*
+ * Code lengths of the canonical Huffman code, RFC 7541, Appendix B.
+ * The codes are assigned in the order of length and then of symbol,
+ * so the decoding tables are built from the lengths on startup.
+ */
+
+static const uint8_t  nxt_h2p_huff_length[257] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+     6, 10, 10, 12, 13,  6,  8, 11, 10, 10,  8, 11,  8,  6,  6,  6,
+     5,  5,  5,  6,  6,  6,  6,  6,  6,  6,  7,  8, 15,  6, 12, 10,
+    13,  6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,
+     7,  7,  7,  7,  7,  7,  7,  7,  8,  7,  8, 13, 19, 13, 14,  6,
+    15,  5,  6,  5,  6,  5,  6,  6,  6,  5,  7,  7,  6,  6,  6,  5,
+     6,  7,  6,  5,  5,  6,  7,  7,  7,  7,  7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30,
+};
+
+#define NXT_H2P_HUFF_MAX_LENGTH  30
+#define NXT_H2P_HUFF_EOS         256
+
+static uint32_t  nxt_h2p_huff_first[NXT_H2P_HUFF_MAX_LENGTH + 1];
+static uint32_t  nxt_h2p_huff_count[NXT_H2P_HUFF_MAX_LENGTH + 1];
+static uint32_t  nxt_h2p_huff_offset[NXT_H2P_HUFF_MAX_LENGTH + 1];
+static uint16_t  nxt_h2p_huff_symbols[257];
+
+
+nxt_int_t
+nxt_h2p_init(nxt_task_t *task)
+{
+    uint32_t    code, fill[NXT_H2P_HUFF_MAX_LENGTH + 1];
+    nxt_uint_t  i, len;
+
+    for (i = 0; i < nxt_nitems(nxt_h2p_huff_length); i++) {
+        nxt_h2p_huff_count[nxt_h2p_huff_length[i]]++;
+    }
+
+    code = 0;
+
+    for (len = 1; len <= NXT_H2P_HUFF_MAX_LENGTH; len++) {
+        nxt_h2p_huff_first[len] = code;
+        code = (code + nxt_h2p_huff_count[len]) << 1;
+
+        nxt_h2p_huff_offset[len] = nxt_h2p_huff_offset[len - 1]
+                                   + nxt_h2p_huff_count[len - 1];
+        fill[len] = nxt_h2p_huff_offset[len];
+    }
+
+    for (i = 0; i < nxt_nitems(nxt_h2p_huff_length); i++) {
+        len = nxt_h2p_huff_length[i];
+        nxt_h2p_huff_symbols[fill[len]++] = i;
+    }
+
+    return nxt_http_fields_hash(&nxt_h2p_fields_hash,
+                                nxt_h2p_fields, nxt_nitems(nxt_h2p_fields));
+}
+
+
+nxt_bool_t
+nxt_h2p_conn_test(nxt_conn_t *c)
+{
+    size_t                   size;
+    nxt_buf_t                *b;
+    nxt_socket_conf_joint_t  *joint;
+
+    joint = c->listen->socket.data;
+
+    if (joint == NULL || !joint->socket_conf->http2) {
+        return 0;
+    }
+
+    if (c->alpn_h2) {
+        return 1;
+    }
+
+    /* HTTP/2 with prior knowledge, RFC 9113, Section 3.3. */
+
+    b = c->read;
+    size = nxt_buf_mem_used_size(&b->mem);
+    size = nxt_min(size, nxt_length(NXT_H2P_PREFACE));
+
+    return (size >= nxt_length("PRI ")
+            && memcmp(b->mem.pos, NXT_H2P_PREFACE, size) == 0);
+}
+
+
+void
+nxt_h2p_conn_init(nxt_task_t *task, nxt_conn_t *c)
+{
+    size_t         size;
+    nxt_buf_t      *b, *in;
+    nxt_uint_t     i;
+    nxt_h2proto_t  *h2p;
+
+    nxt_debug(task, "h2p conn init");
+
+    h2p = nxt_mp_zget(c->mem_pool, sizeof(nxt_h2proto_t));
+    if (nxt_slow_path(h2p == NULL)) {
+        goto fail;
+    }
+
+    b = nxt_buf_mem_alloc(c->mem_pool, NXT_H2P_READ_BUFFER_SIZE, 0);
+    if (nxt_slow_path(b == NULL)) {
+        goto fail;
+    }
+
+    /* The engine buffer is returned, the preread data are kept. */
+
+    in = c->read;
+    size = nxt_buf_mem_used_size(&in->mem);
+    b->mem.free = nxt_cpymem(b->mem.free, in->mem.pos, size);
+
+    in->completion_handler(task, in, in->parent);
+
+    c->read = b;
+    c->socket.data = h2p;
+    h2p->conn = c;
+
+    for (i = 0; i < NXT_H2P_STREAMS_HASH; i++) {
+        nxt_queue_init(&h2p->streams[i]);
+    }
+
+    nxt_queue_init(&h2p->blocked);
+
+    h2p->hpack.max_size = NXT_H2P_HPACK_TABLE_SIZE;
+    h2p->send_window = NXT_H2P_DEFAULT_WINDOW;
+    h2p->recv_window = NXT_H2P_CONN_WINDOW;
+    h2p->initial_window = NXT_H2P_DEFAULT_WINDOW;
+    h2p->max_frame_size = NXT_H2P_DEFAULT_FRAME_SIZE;
+
+    if (nxt_slow_path(nxt_h2p_send_settings(task, h2p) != NXT_OK)) {
+        goto fail;
+    }
+
+    nxt_h2p_conn_read(task, c, h2p);
+    return;
+
+fail:
+
+    nxt_h1p_closing(task, c);
+}
+
+
+static const nxt_conn_state_t  nxt_h2p_idle_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h2p_conn_read,
+    .close_handler = nxt_h2p_conn_close,
+    .error_handler = nxt_h2p_conn_error,
+
+    .timer_handler = nxt_h2p_idle_timeout,
+    .timer_value = nxt_h2p_conn_timer_value,
+    .timer_data = offsetof(nxt_socket_conf_t, idle_timeout),
+    .timer_autoreset = 1,
+};
+
+
+static const nxt_conn_state_t  nxt_h2p_read_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h2p_conn_read,
+    .close_handler = nxt_h2p_conn_close,
+    .error_handler = nxt_h2p_conn_error,
+
+    .timer_handler = nxt_h2p_read_timeout,
+    .timer_value = nxt_h2p_conn_timer_value,
+    .timer_data = offsetof(nxt_socket_conf_t, body_read_timeout),
+    .timer_autoreset = 1,
+};
+
+
+static void
+nxt_h2p_conn_read(nxt_task_t *task, void *obj, void *data)
+{
+    u_char         *p, *end;
+    size_t         size;
+    uint32_t       id, length;
+    nxt_int_t      ret;
+    nxt_buf_t      *b;
+    nxt_conn_t     *c;
+    nxt_uint_t     type, flags;
+    nxt_h2proto_t  *h2p;
+
+    c = obj;
+    h2p = data;
+
+    nxt_debug(task, "h2p conn read");
+
+    b = c->read;
+    p = b->mem.pos;
+    end = b->mem.free;
+
+    if (!h2p->preface) {
+        size = nxt_min((size_t) (end - p), nxt_length(NXT_H2P_PREFACE));
+
+        if (nxt_slow_path(memcmp(p, NXT_H2P_PREFACE, size) != 0)) {
+            nxt_log(task, NXT_LOG_INFO, "h2p: invalid connection preface");
+
+            nxt_h2p_protocol_error(task, h2p, NXT_H2P_PROTOCOL_ERROR);
+            return;
+        }
+
+        if (size < nxt_length(NXT_H2P_PREFACE)) {
+            nxt_h2p_conn_read_next(task, h2p);
+            return;
+        }
+
+        p += size;
+        h2p->preface = 1;
+    }
+
+    while (end - p >= NXT_H2P_FRAME_HEADER_SIZE) {
+        length = (p[0] << 16) | (p[1] << 8) | p[2];
+        type = p[3];
+        flags = p[4];
+        id = ((p[5] & 0x7f) << 24) | (p[6] << 16) | (p[7] << 8) | p[8];
+
+        if (nxt_slow_path(length > NXT_H2P_DEFAULT_FRAME_SIZE)) {
+            nxt_h2p_protocol_error(task, h2p, NXT_H2P_FRAME_SIZE_ERROR);
+            return;
+        }
+
+        if ((size_t) (end - p) < NXT_H2P_FRAME_HEADER_SIZE + length) {
+            break;
+        }
+
+        p += NXT_H2P_FRAME_HEADER_SIZE;
+
+        nxt_debug(task, "h2p frame type:%ui flags:%ui id:%uD length:%uD",
+                  type, flags, id, length);
+
+        if (nxt_slow_path(h2p->hblock_id != 0
+                          && (type != NXT_H2P_CONTINUATION
+                              || id != h2p->hblock_id)))
+        {
+            nxt_h2p_protocol_error(task, h2p, NXT_H2P_PROTOCOL_ERROR);
+            return;
+        }
+
+        if (nxt_fast_path(type < nxt_nitems(nxt_h2p_frame_handlers))) {
+            ret = nxt_h2p_frame_handlers[type](task, h2p, id, flags, p,
+                                               length);
+
+            if (nxt_slow_path(ret != NXT_H2P_NO_ERROR)) {
+                nxt_h2p_protocol_error(task, h2p, ret);
+                return;
+            }
+
+            if (nxt_slow_path(h2p->closing)) {
+                return;
+            }
+        }
+
+        p += length;
+    }
+
+    size = end - p;
+
+    if (p != b->mem.start) {
+        nxt_memmove(b->mem.start, p, size);
+    }
+
+    b->mem.pos = b->mem.start;
+    b->mem.free = b->mem.start + size;
+
+    nxt_h2p_conn_read_next(task, h2p);
+}
+
+
+static void
+nxt_h2p_conn_read_next(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    nxt_conn_t  *c;
+
+    c = h2p->conn;
+
+    c->read_state = (h2p->nstreams != 0) ? &nxt_h2p_read_state
+                                         : &nxt_h2p_idle_state;
+
+    nxt_conn_read(task->thread->engine, c);
+}
+
+
+static nxt_int_t
+nxt_h2p_data(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, size_t length)
+{
+    size_t              size, padding;
+    nxt_int_t           ret;
+    nxt_h2p_stream_t    *stream;
+    nxt_http_request_t  *r;
+
+    if (nxt_slow_path(id == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    size = length;
+
+    if (flags & NXT_H2P_PADDED) {
+        if (nxt_slow_path(length == 0 || pos[0] >= length)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        padding = pos[0];
+        pos++;
+        size -= padding + 1;
+    }
+
+    h2p->recv_window -= length;
+
+    if (nxt_slow_path(h2p->recv_window < 0)) {
+        return NXT_H2P_FLOW_CONTROL_ERROR;
+    }
+
+    if (h2p->recv_window < NXT_H2P_CONN_WINDOW / 2) {
+        nxt_h2p_send_window_update(task, h2p, 0,
+                                   NXT_H2P_CONN_WINDOW - h2p->recv_window);
+        h2p->recv_window = NXT_H2P_CONN_WINDOW;
+    }
+
+    stream = nxt_h2p_stream_find(h2p, id);
+
+    if (stream == NULL) {
+        if (nxt_slow_path(id > h2p->last_id)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        /* The stream has been already closed. */
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(stream->in_closed)) {
+        nxt_h2p_send_rst_stream(task, h2p, id, NXT_H2P_STREAM_CLOSED);
+        stream->reset = 1;
+        return NXT_H2P_NO_ERROR;
+    }
+
+    stream->recv_window -= length;
+
+    if (nxt_slow_path(stream->recv_window < 0)) {
+        nxt_h2p_send_rst_stream(task, h2p, id, NXT_H2P_FLOW_CONTROL_ERROR);
+        stream->reset = 1;
+        nxt_h2p_stream_abort(task, stream);
+        return NXT_H2P_NO_ERROR;
+    }
+
+    r = stream->request;
+
+    if (flags & NXT_H2P_END_STREAM) {
+        stream->in_closed = 1;
+
+    } else if (stream->recv_window < NXT_H2P_DEFAULT_WINDOW / 2
+               && !stream->error)
+    {
+        nxt_h2p_send_window_update(task, h2p, id,
+                                   NXT_H2P_DEFAULT_WINDOW
+                                   - stream->recv_window);
+        stream->recv_window = NXT_H2P_DEFAULT_WINDOW;
+    }
+
+    if (stream->error) {
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (size != 0) {
+        ret = nxt_h2p_body_append(task, stream, pos, size);
+
+        if (nxt_slow_path(ret != NXT_OK)) {
+            stream->error = 1;
+            stream->body_wait = 0;
+
+            nxt_http_request_error(task, r, ret);
+            return NXT_H2P_NO_ERROR;
+        }
+    }
+
+    if (stream->in_closed) {
+        nxt_h2p_body_done(task, stream);
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_headers(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, size_t length)
+{
+    size_t  padding;
+    u_char  *end;
+
+    if (nxt_slow_path(id == 0 || (id & 1) == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    end = pos + length;
+
+    if (flags & NXT_H2P_PADDED) {
+        if (nxt_slow_path(length == 0)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        padding = *pos++;
+
+        if (nxt_slow_path(padding >= (size_t) (end - pos))) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        end -= padding;
+    }
+
+    if (flags & NXT_H2P_PRIORITY_FLAG) {
+        if (nxt_slow_path(end - pos < 5)) {
+            return NXT_H2P_FRAME_SIZE_ERROR;
+        }
+
+        /* Stream priorities are deprecated and ignored. */
+        pos += 5;
+    }
+
+    if (flags & NXT_H2P_END_HEADERS) {
+        return nxt_h2p_header_block(task, h2p, id, flags, pos, end);
+    }
+
+    length = end - pos;
+
+    h2p->hblock = nxt_malloc(length);
+    if (nxt_slow_path(h2p->hblock == NULL)) {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    nxt_memcpy(h2p->hblock, pos, length);
+
+    h2p->hblock_size = length;
+    h2p->hblock_id = id;
+    h2p->hblock_flags = flags;
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_continuation(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, size_t length)
+{
+    u_char     *p;
+    size_t     size;
+    nxt_int_t  ret;
+
+    if (nxt_slow_path(h2p->hblock_id == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    size = h2p->hblock_size + length;
+
+    if (nxt_slow_path(size > NXT_H2P_MAX_HEADER_BLOCK)) {
+        return NXT_H2P_ENHANCE_YOUR_CALM;
+    }
+
+    p = nxt_realloc(h2p->hblock, size);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    nxt_memcpy(p + h2p->hblock_size, pos, length);
+
+    h2p->hblock = p;
+    h2p->hblock_size = size;
+
+    if ((flags & NXT_H2P_END_HEADERS) == 0) {
+        return NXT_H2P_NO_ERROR;
+    }
+
+    ret = nxt_h2p_header_block(task, h2p, h2p->hblock_id, h2p->hblock_flags,
+                               p, p + size);
+
+    nxt_free(h2p->hblock);
+
+    h2p->hblock = NULL;
+    h2p->hblock_size = 0;
+    h2p->hblock_id = 0;
+
+    return ret;
+}
+
+
+static nxt_int_t
+nxt_h2p_header_block(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, u_char *end)
+{
+    nxt_int_t         ret;
+    nxt_h2p_stream_t  *stream;
+
+    stream = nxt_h2p_stream_find(h2p, id);
+
+    if (stream != NULL) {
+        /* Trailer fields are decoded only to keep the HPACK state. */
+
+        if (nxt_slow_path((flags & NXT_H2P_END_STREAM) == 0
+                          || stream->in_closed))
+        {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        ret = nxt_h2p_header_block_skip(task, h2p, pos, end);
+        if (nxt_slow_path(ret != NXT_H2P_NO_ERROR)) {
+            return ret;
+        }
+
+        stream->in_closed = 1;
+
+        if (!stream->error) {
+            nxt_h2p_body_done(task, stream);
+        }
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(id <= h2p->last_id)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    h2p->last_id = id;
+
+    if (nxt_slow_path(h2p->goaway
+                      || h2p->nstreams >= NXT_H2P_MAX_STREAMS
+                      || h2p->conn->listen->socket.data == NULL))
+    {
+        ret = nxt_h2p_header_block_skip(task, h2p, pos, end);
+        if (nxt_slow_path(ret != NXT_H2P_NO_ERROR)) {
+            return ret;
+        }
+
+        nxt_h2p_send_rst_stream(task, h2p, id, NXT_H2P_REFUSED_STREAM);
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    return nxt_h2p_stream_create(task, h2p, id, flags, pos, end);
+}
+
+
+static nxt_int_t
+nxt_h2p_header_block_skip(nxt_task_t *task, nxt_h2proto_t *h2p, u_char *pos,
+    u_char *end)
+{
+    nxt_mp_t   *mp;
+    nxt_int_t  ret;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    ret = nxt_h2p_hpack_decode(&h2p->hpack, mp, pos, end, NULL, 0);
+
+    nxt_mp_destroy(mp);
+
+    return (ret == NXT_ERROR) ? NXT_H2P_COMPRESSION_ERROR : NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_stream_create(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, u_char *end)
+{
+    size_t                   limit;
+    nxt_int_t                ret;
+    nxt_conn_t               *c;
+    nxt_array_t              *headers;
+    nxt_h2p_stream_t         *stream;
+    nxt_socket_conf_t        *skcf;
+    nxt_http_request_t       *r;
+    nxt_socket_conf_joint_t  *joint;
+
+    nxt_debug(task, "h2p stream create %uD", id);
+
+    c = h2p->conn;
+
+    r = nxt_http_request_create(task);
+    if (nxt_slow_path(r == NULL)) {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    stream = nxt_mp_zget(r->mem_pool, sizeof(nxt_h2p_stream_t));
+    if (nxt_slow_path(stream == NULL)) {
+        goto fail;
+    }
+
+    headers = nxt_array_create(r->mem_pool, 8, sizeof(nxt_h2p_header_t));
+    if (nxt_slow_path(headers == NULL)) {
+        goto fail;
+    }
+
+    joint = c->listen->socket.data;
+    skcf = joint->socket_conf;
+
+    limit = skcf->large_header_buffer_size * skcf->large_header_buffers;
+
+    ret = nxt_h2p_hpack_decode(&h2p->hpack, r->mem_pool, pos, end, headers,
+                               limit);
+
+    if (nxt_slow_path(ret == NXT_ERROR)) {
+        nxt_mp_release(r->mem_pool);
+        return NXT_H2P_COMPRESSION_ERROR;
+    }
+
+    if (h2p->nstreams == 0) {
+        nxt_conn_active(task->thread->engine, c);
+    }
+
+    h2p->nstreams++;
+
+    stream->h2p = h2p;
+    stream->request = r;
+    stream->id = id;
+    stream->out_tail = &stream->out;
+    stream->send_window = h2p->initial_window;
+    stream->recv_window = NXT_H2P_DEFAULT_WINDOW;
+    stream->in_closed = ((flags & NXT_H2P_END_STREAM) != 0);
+
+    nxt_queue_insert_tail(&h2p->streams[(id >> 1) % NXT_H2P_STREAMS_HASH],
+                          &stream->link);
+
+    r->proto.h2 = stream;
+    r->protocol = NXT_HTTP_PROTO_H2;
+    r->remote = c->remote;
+
+#if (NXT_TLS)
+    r->tls = (c->u.tls != NULL);
+#endif
+
+    r->task = c->task;
+    task = &r->task;
+
+    joint->count++;
+
+    r->conf = joint;
+    r->log_route = skcf->log_route;
+
+    if (c->local == NULL) {
+        c->local = skcf->sockaddr;
+    }
+
+    if (ret == NXT_DECLINED) {
+        ret = NXT_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE;
+
+    } else {
+        ret = nxt_h2p_request_header_process(task, stream, headers);
+    }
+
+    if (nxt_fast_path(ret == NXT_OK)) {
+
+#if (NXT_TLS)
+        if (c->u.tls == NULL && skcf->tls != NULL) {
+            ret = NXT_HTTP_TO_HTTPS;
+            goto error;
+        }
+#endif
+
+        r->state->ready_handler(task, r, NULL);
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+#if (NXT_TLS)
+error:
+#endif
+
+    stream->error = 1;
+
+    nxt_http_request_error(task, r, ret);
+
+    return NXT_H2P_NO_ERROR;
+
+fail:
+
+    nxt_mp_release(r->mem_pool);
+
+    return NXT_H2P_INTERNAL_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_request_header_process(nxt_task_t *task, nxt_h2p_stream_t *stream,
+    nxt_array_t *headers)
+{
+    u_char              *p, *version, ch;
+    size_t              size, cookie_size;
+    nxt_int_t           ret;
+    nxt_str_t           *method, *path, *authority, *name, *value;
+    nxt_uint_t          i, j, regular;
+    nxt_buf_mem_t       mem;
+    nxt_h2p_header_t    *h;
+    nxt_http_request_t  *r;
+
+    r = stream->request;
+
+    method = NULL;
+    path = NULL;
+    authority = NULL;
+    regular = 0;
+    cookie_size = 0;
+
+    h = headers->elts;
+
+    /*
+     * The request is converted to the HTTP/1.1 form and processed by
+     * the HTTP/1.x parser to apply the same target normalization and
+     * field validation rules.
+     */
+
+    size = nxt_length(" HTTP/1.1\r\n\r\n");
+
+    for (i = 0; i < headers->nelts; i++) {
+        name = &h[i].name;
+        value = &h[i].value;
+
+        if (nxt_slow_path(name->length == 0)) {
+            return NXT_HTTP_BAD_REQUEST;
+        }
+
+        for (j = 0; j < value->length; j++) {
+            ch = value->start[j];
+
+            if (nxt_slow_path(ch == '\0' || ch == '\r' || ch == '\n')) {
+                return NXT_HTTP_BAD_REQUEST;
+            }
+        }
+
+        if (name->start[0] == ':') {
+            if (nxt_slow_path(regular)) {
+                return NXT_HTTP_BAD_REQUEST;
+            }
+
+            if (nxt_str_eq(name, ":method", 7)) {
+                if (nxt_slow_path(method != NULL)) {
+                    return NXT_HTTP_BAD_REQUEST;
+                }
+
+                method = value;
+
+            } else if (nxt_str_eq(name, ":path", 5)) {
+                if (nxt_slow_path(path != NULL)) {
+                    return NXT_HTTP_BAD_REQUEST;
+                }
+
+                path = value;
+
+            } else if (nxt_str_eq(name, ":authority", 10)) {
+                if (nxt_slow_path(authority != NULL)) {
+                    return NXT_HTTP_BAD_REQUEST;
+                }
+
+                authority = value;
+
+            } else if (nxt_slow_path(!nxt_str_eq(name, ":scheme", 7))) {
+                return NXT_HTTP_BAD_REQUEST;
+            }
+
+            continue;
+        }
+
+        regular = 1;
+
+        for (j = 0; j < name->length; j++) {
+            ch = name->start[j];
+
+            if (nxt_slow_path(ch <= ' ' || ch >= 0x7f || ch == ':'
+                              || (ch >= 'A' && ch <= 'Z')))
+            {
+                return NXT_HTTP_BAD_REQUEST;
+            }
+        }
+
+        /* Connection-specific fields, RFC 9113, Section 8.2.2. */
+
+        if (nxt_str_eq(name, "connection", 10)
+            || nxt_str_eq(name, "keep-alive", 10)
+            || nxt_str_eq(name, "proxy-connection", 16)
+            || nxt_str_eq(name, "transfer-encoding", 17)
+            || nxt_str_eq(name, "upgrade", 7)
+            || nxt_str_eq(name, "te", 2))
+        {
+            name->length = 0;
+            continue;
+        }
+
+        if (nxt_str_eq(name, "cookie", 6)) {
+            cookie_size += value->length + nxt_length("; ");
+            continue;
+        }
+
+        if (nxt_str_eq(name, "host", 4)) {
+            authority = NULL;
+        }
+
+        size += name->length + value->length + nxt_length(": \r\n");
+    }
+
+    if (nxt_slow_path(method == NULL || path == NULL
+                      || method->length == 0 || path->length == 0))
+    {
+        return NXT_HTTP_BAD_REQUEST;
+    }
+
+    for (j = 0; j < method->length; j++) {
+        ch = method->start[j];
+
+        if (nxt_slow_path(ch <= ' ' || ch >= 0x7f)) {
+            return NXT_HTTP_BAD_REQUEST;
+        }
+    }
+
+    for (j = 0; j < path->length; j++) {
+        ch = path->start[j];
+
+        if (nxt_slow_path(ch <= ' ' || ch == 0x7f)) {
+            return NXT_HTTP_BAD_REQUEST;
+        }
+    }
+
+    size += method->length + path->length;
+
+    if (authority != NULL) {
+        size += nxt_length("host: \r\n") + authority->length;
+    }
+
+    if (cookie_size != 0) {
+        size += nxt_length("cookie: \r\n") + cookie_size;
+    }
+
+    p = nxt_mp_nget(r->mem_pool, size);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+    mem.start = p;
+    mem.pos = p;
+
+    p = nxt_cpymem(p, method->start, method->length);
+    *p++ = ' ';
+    p = nxt_cpymem(p, path->start, path->length);
+    p = nxt_cpymem(p, " HTTP/", 6);
+    version = p;
+    p = nxt_cpymem(p, "1.1\r\n", 5);
+
+    if (authority != NULL) {
+        p = nxt_cpymem(p, "host: ", 6);
+        p = nxt_cpymem(p, authority->start, authority->length);
+        *p++ = '\r'; *p++ = '\n';
+    }
+
+    if (cookie_size != 0) {
+        p = nxt_cpymem(p, "cookie: ", 8);
+
+        for (i = 0; i < headers->nelts; i++) {
+            if (nxt_str_eq(&h[i].name, "cookie", 6)) {
+                if (p[-1] != ' ') {
+                    *p++ = ';'; *p++ = ' ';
+                }
+
+                p = nxt_cpymem(p, h[i].value.start, h[i].value.length);
+            }
+        }
+
+        *p++ = '\r'; *p++ = '\n';
+    }
+
+    for (i = 0; i < headers->nelts; i++) {
+        name = &h[i].name;
+
+        if (name->length == 0 || name->start[0] == ':'
+            || nxt_str_eq(name, "cookie", 6))
+        {
+            continue;
+        }
+
+        p = nxt_cpymem(p, name->start, name->length);
+        *p++ = ':'; *p++ = ' ';
+        p = nxt_cpymem(p, h[i].value.start, h[i].value.length);
+        *p++ = '\r'; *p++ = '\n';
+    }
+
+    *p++ = '\r'; *p++ = '\n';
+
+    mem.free = p;
+    mem.end = p;
+
+    ret = nxt_http_parse_request_init(&stream->parser, r->mem_pool);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+    stream->parser.discard_unsafe_fields =
+                                   r->conf->socket_conf->discard_unsafe_fields;
+
+    ret = nxt_http_parse_request(&stream->parser, &mem);
+
+    if (nxt_slow_path(ret != NXT_DONE)) {
+        return (ret == NXT_HTTP_PARSE_TOO_LARGE_FIELD)
+               ? NXT_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE
+               : NXT_HTTP_BAD_REQUEST;
+    }
+
+    version[0] = '2';
+    version[2] = '0';
+    stream->parser.version.s.major = '2';
+    stream->parser.version.s.minor = '0';
+
+    r->request_line.start = stream->parser.method.start;
+    r->request_line.length = stream->parser.request_line_end
+                             - r->request_line.start;
+
+    if (nxt_slow_path(r->log_route)) {
+        nxt_log(task, NXT_LOG_NOTICE, "http request line \"%V\"",
+                &r->request_line);
+    }
+
+    r->target.start = stream->parser.target_start;
+    r->target.length = stream->parser.target_end
+                       - stream->parser.target_start;
+
+    r->quoted_target = stream->parser.quoted_target;
+
+    r->version.start = stream->parser.version.str;
+    r->version.length = sizeof(stream->parser.version.str);
+
+    r->method = &stream->parser.method;
+    r->path = &stream->parser.path;
+    r->args = &stream->parser.args;
+
+    r->fields = stream->parser.fields;
+
+    return nxt_http_fields_process(r->fields, &nxt_h2p_fields_hash, r);
+}
+
+
+void
+nxt_h2p_request_body_read(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_h2p_stream_t  *stream;
+
+    stream = r->proto.h2;
+
+    nxt_debug(task, "h2p request body read %O", r->content_length_n);
+
+    stream->body_wait = 1;
+
+    if (stream->in_closed) {
+        nxt_h2p_body_done(task, stream);
+    }
+}
+
+
+static nxt_int_t
+nxt_h2p_body_append(nxt_task_t *task, nxt_h2p_stream_t *stream, u_char *pos,
+    size_t size)
+{
+    size_t              used;
+    ssize_t             res;
+    nxt_off_t           total;
+    nxt_buf_t           *b, *fb;
+    nxt_socket_conf_t   *skcf;
+    nxt_http_request_t  *r;
+
+    r = stream->request;
+    skcf = r->conf->socket_conf;
+
+    total = stream->body_received + size;
+
+    if (r->content_length_n != -1) {
+        if (nxt_slow_path(total > r->content_length_n)) {
+            return NXT_HTTP_BAD_REQUEST;
+        }
+
+    } else if (nxt_slow_path(total > (nxt_off_t) skcf->max_body_size)) {
+        return NXT_HTTP_PAYLOAD_TOO_LARGE;
+    }
+
+    b = r->body;
+
+    if (b == NULL) {
+        if (r->content_length_n > (nxt_off_t) skcf->body_buffer_size) {
+            b = nxt_h2p_body_file(task, r);
+
+        } else {
+            used = (r->content_length_n != -1)
+                   ? (size_t) r->content_length_n : skcf->body_buffer_size;
+
+            b = nxt_buf_mem_alloc(r->mem_pool, used, 0);
+        }
+
+        if (nxt_slow_path(b == NULL)) {
+            return NXT_HTTP_INTERNAL_SERVER_ERROR;
+        }
+
+        r->body = b;
+    }
+
+    if (!nxt_buf_is_file(b)
+        && size > (size_t) nxt_buf_mem_free_size(&b->mem))
+    {
+        /* A request without "Content-Length" exceeds the buffer size. */
+
+        fb = nxt_h2p_body_file(task, r);
+        if (nxt_slow_path(fb == NULL)) {
+            return NXT_HTTP_INTERNAL_SERVER_ERROR;
+        }
+
+        used = nxt_buf_mem_used_size(&b->mem);
+
+        res = nxt_fd_write(fb->file->fd, b->mem.pos, used);
+        if (nxt_slow_path(res < (ssize_t) used)) {
+            return NXT_HTTP_INTERNAL_SERVER_ERROR;
+        }
+
+        fb->file_end = used;
+
+        nxt_mp_free(r->mem_pool, b);
+
+        b = fb;
+        r->body = b;
+    }
+
+    if (nxt_buf_is_file(b)) {
+        res = nxt_fd_write(b->file->fd, pos, size);
+        if (nxt_slow_path(res < (ssize_t) size)) {
+            return NXT_HTTP_INTERNAL_SERVER_ERROR;
+        }
+
+        b->file_end += size;
+
+    } else {
+        b->mem.free = nxt_cpymem(b->mem.free, pos, size);
+    }
+
+    stream->body_received = total;
+
+    return NXT_OK;
+}
+
+
+static nxt_buf_t *
+nxt_h2p_body_file(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_str_t  *tmp_path, tmp_name;
+    nxt_buf_t  *b;
+
+    static const nxt_str_t tmp_name_pattern = nxt_string("/req-XXXXXXXX");
+
+    tmp_path = &r->conf->socket_conf->body_temp_path;
+
+    tmp_name.length = tmp_path->length + tmp_name_pattern.length;
+
+    b = nxt_buf_file_alloc(r->mem_pool,
+                           sizeof(nxt_file_t) + tmp_name.length + 1, 0);
+    if (nxt_slow_path(b == NULL)) {
+        return NULL;
+    }
+
+    tmp_name.start = nxt_pointer_to(b->mem.start, sizeof(nxt_file_t));
+
+    memcpy(tmp_name.start, tmp_path->start, tmp_path->length);
+    memcpy(tmp_name.start + tmp_path->length, tmp_name_pattern.start,
+           tmp_name_pattern.length);
+    tmp_name.start[tmp_name.length] = '\0';
+
+    b->file = (nxt_file_t *) b->mem.start;
+    nxt_memzero(b->file, sizeof(nxt_file_t));
+
+    b->mem.start = NULL;
+    b->mem.end = NULL;
+    b->mem.pos = NULL;
+    b->mem.free = NULL;
+
+    b->file->fd = mkstemp((char *) tmp_name.start);
+    if (nxt_slow_path(b->file->fd == -1)) {
+        nxt_alert(task, "mkstemp(%s) failed %E", tmp_name.start, nxt_errno);
+        return NULL;
+    }
+
+    nxt_debug(task, "create body tmp file \"%V\", %d",
+              &tmp_name, b->file->fd);
+
+    unlink((char *) tmp_name.start);
+
+    return b;
+}
+
+
+static void
+nxt_h2p_body_done(nxt_task_t *task, nxt_h2p_stream_t *stream)
+{
+    u_char              *p;
+    uint32_t            hash;
+    nxt_uint_t          i;
+    nxt_http_field_t    *field;
+    nxt_http_request_t  *r;
+
+    static const char  content_length[] = "content-length";
+
+    if (!stream->body_wait) {
+        return;
+    }
+
+    stream->body_wait = 0;
+
+    r = stream->request;
+
+    nxt_debug(task, "h2p body done %O", stream->body_received);
+
+    if (r->body != NULL && nxt_buf_is_file(r->body)) {
+        r->body->file->size = r->body->file_end;
+    }
+
+    if (r->content_length_n == -1) {
+
+        if (stream->body_received != 0) {
+            /*
+             * The body length is passed to applications
+             * the same way as for HTTP/1.x requests.
+             */
+            field = nxt_list_zero_add(r->fields);
+            if (nxt_slow_path(field == NULL)) {
+                goto fail;
+            }
+
+            p = nxt_mp_nget(r->mem_pool, NXT_OFF_T_LEN);
+            if (nxt_slow_path(p == NULL)) {
+                goto fail;
+            }
+
+            hash = NXT_HTTP_FIELD_HASH_INIT;
+
+            for (i = 0; i < nxt_length(content_length); i++) {
+                hash = nxt_http_field_hash_char(hash, content_length[i]);
+            }
+
+            field->hash = nxt_http_field_hash_end(hash) & 0xFFFF;
+
+            nxt_http_field_name_set(field, content_length);
+
+            field->value = p;
+            p = nxt_sprintf(p, p + NXT_OFF_T_LEN, "%O", stream->body_received);
+            field->value_length = p - field->value;
+
+            r->content_length = field;
+            r->content_length_n = stream->body_received;
+        }
+
+    } else if (nxt_slow_path(stream->body_received != r->content_length_n)) {
+        stream->error = 1;
+
+        nxt_http_request_error(task, r, NXT_HTTP_BAD_REQUEST);
+        return;
+    }
+
+    r->state->ready_handler(task, r, NULL);
+    return;
+
+fail:
+
+    stream->error = 1;
+
+    nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+}
+
+
+static nxt_int_t
+nxt_h2p_priority(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, size_t length)
+{
+    if (nxt_slow_path(id == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(length != 5)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_rst_stream(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, size_t length)
+{
+    nxt_h2p_stream_t  *stream;
+
+    if (nxt_slow_path(id == 0 || id > h2p->last_id)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(length != 4)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    stream = nxt_h2p_stream_find(h2p, id);
+
+    if (stream != NULL) {
+        nxt_debug(task, "h2p stream %uD reset by peer", id);
+
+        stream->reset = 1;
+
+        nxt_h2p_stream_abort(task, stream);
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_settings(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, size_t length)
+{
+    u_char            *end;
+    int32_t           delta;
+    uint32_t          value;
+    nxt_buf_t         *b;
+    nxt_uint_t        i, setting;
+    nxt_queue_t       *streams;
+    nxt_queue_link_t  *lnk;
+    nxt_h2p_stream_t  *stream;
+
+    if (nxt_slow_path(id != 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (flags & NXT_H2P_ACK) {
+        return (length == 0) ? NXT_H2P_NO_ERROR : NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    if (nxt_slow_path(length % 6 != 0)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    delta = 0;
+
+    for (end = pos + length; pos < end; pos += 6) {
+        setting = (pos[0] << 8) | pos[1];
+        value = ((uint32_t) pos[2] << 24) | (pos[3] << 16) | (pos[4] << 8)
+                | pos[5];
+
+        switch (setting) {
+
+        case NXT_H2P_INITIAL_WINDOW_SIZE:
+            if (nxt_slow_path(value > NXT_H2P_MAX_WINDOW)) {
+                return NXT_H2P_FLOW_CONTROL_ERROR;
+            }
+
+            delta = (int32_t) value - h2p->initial_window;
+            h2p->initial_window = value;
+            break;
+
+        case NXT_H2P_MAX_FRAME_SIZE_ID:
+            if (nxt_slow_path(value < NXT_H2P_DEFAULT_FRAME_SIZE
+                              || value > NXT_H2P_MAX_FRAME_SIZE))
+            {
+                return NXT_H2P_PROTOCOL_ERROR;
+            }
+
+            h2p->max_frame_size = value;
+            break;
+
+        case NXT_H2P_ENABLE_PUSH:
+            if (nxt_slow_path(value > 1)) {
+                return NXT_H2P_PROTOCOL_ERROR;
+            }
+
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    b = nxt_h2p_buf_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    b->mem.free = nxt_h2p_frame_header(b->mem.free, 0, NXT_H2P_SETTINGS,
+                                       NXT_H2P_ACK, 0);
+
+    nxt_h2p_conn_write(task, h2p, b);
+
+    if (delta != 0) {
+        for (i = 0; i < NXT_H2P_STREAMS_HASH; i++) {
+            streams = &h2p->streams[i];
+
+            for (lnk = nxt_queue_first(streams);
+                 lnk != nxt_queue_tail(streams);
+                 lnk = nxt_queue_next(lnk))
+            {
+                stream = nxt_queue_link_data(lnk, nxt_h2p_stream_t, link);
+
+                if (nxt_slow_path((int64_t) stream->send_window + delta
+                                  > NXT_H2P_MAX_WINDOW))
+                {
+                    return NXT_H2P_FLOW_CONTROL_ERROR;
+                }
+
+                stream->send_window += delta;
+            }
+        }
+
+        if (delta > 0) {
+            nxt_h2p_streams_output(task, h2p);
+        }
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_push_promise(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, size_t length)
+{
+    return NXT_H2P_PROTOCOL_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_ping(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, size_t length)
+{
+    u_char     *p;
+    nxt_buf_t  *b;
+
+    if (nxt_slow_path(id != 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(length != 8)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    if (flags & NXT_H2P_ACK) {
+        return NXT_H2P_NO_ERROR;
+    }
+
+    b = nxt_h2p_buf_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE + 8);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    p = nxt_h2p_frame_header(b->mem.free, 8, NXT_H2P_PING, NXT_H2P_ACK, 0);
+    b->mem.free = nxt_cpymem(p, pos, 8);
+
+    nxt_h2p_conn_write(task, h2p, b);
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_goaway(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, size_t length)
+{
+    if (nxt_slow_path(id != 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(length < 8)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    nxt_debug(task, "h2p goaway received");
+
+    /* The connection is closed after the active streams complete. */
+
+    h2p->goaway = 1;
+
+    if (h2p->nstreams == 0) {
+        nxt_h2p_shutdown(task, h2p);
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_int_t
+nxt_h2p_window_update(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, size_t length)
+{
+    uint32_t          increment;
+    nxt_h2p_stream_t  *stream;
+
+    if (nxt_slow_path(length != 4)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    increment = ((pos[0] & 0x7f) << 24) | (pos[1] << 16) | (pos[2] << 8)
+                | pos[3];
+
+    if (id == 0) {
+        if (nxt_slow_path(increment == 0)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        if (nxt_slow_path((int64_t) h2p->send_window + increment
+                          > NXT_H2P_MAX_WINDOW))
+        {
+            return NXT_H2P_FLOW_CONTROL_ERROR;
+        }
+
+        h2p->send_window += increment;
+
+        nxt_h2p_streams_output(task, h2p);
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    stream = nxt_h2p_stream_find(h2p, id);
+
+    if (stream == NULL) {
+        return (id > h2p->last_id) ? NXT_H2P_PROTOCOL_ERROR
+                                   : NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(increment == 0
+                      || (int64_t) stream->send_window + increment
+                         > NXT_H2P_MAX_WINDOW))
+    {
+        nxt_h2p_send_rst_stream(task, h2p, id, (increment == 0)
+                                               ? NXT_H2P_PROTOCOL_ERROR
+                                               : NXT_H2P_FLOW_CONTROL_ERROR);
+        stream->reset = 1;
+
+        nxt_h2p_stream_abort(task, stream);
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    stream->send_window += increment;
+
+    if (stream->out != NULL) {
+        nxt_h2p_stream_output(task, stream);
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_h2p_stream_t *
+nxt_h2p_stream_find(nxt_h2proto_t *h2p, uint32_t id)
+{
+    nxt_queue_t       *streams;
+    nxt_queue_link_t  *lnk;
+    nxt_h2p_stream_t  *stream;
+
+    streams = &h2p->streams[(id >> 1) % NXT_H2P_STREAMS_HASH];
+
+    for (lnk = nxt_queue_first(streams);
+         lnk != nxt_queue_tail(streams);
+         lnk = nxt_queue_next(lnk))
+    {
+        stream = nxt_queue_link_data(lnk, nxt_h2p_stream_t, link);
+
+        if (stream->id == id) {
+            return stream;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void
+nxt_h2p_stream_abort(nxt_task_t *task, nxt_h2p_stream_t *stream)
+{
+    nxt_http_request_t  *r;
+
+    nxt_debug(task, "h2p stream %uD abort", stream->id);
+
+    stream->in_closed = 1;
+
+    if (stream->aborted) {
+        return;
+    }
+
+    stream->aborted = 1;
+
+    r = stream->request;
+
+    /*
+     * A request waiting for an application or a proxied server response
+     * is finished when the response starts to avoid releasing the request
+     * while it is being processed.
+     */
+
+    if (stream->body_wait || r->header_sent) {
+        stream->body_wait = 0;
+
+        nxt_h2p_stream_error(task, stream);
+    }
+}
+
+
+static void
+nxt_h2p_stream_error(nxt_task_t *task, nxt_h2p_stream_t *stream)
+{
+    nxt_http_request_t  *r;
+
+    if (stream->error && !stream->aborted) {
+        return;
+    }
+
+    if (stream->out_closed) {
+        return;
+    }
+
+    stream->error = 1;
+    stream->out_closed = 1;
+
+    r = stream->request;
+
+    r->state->error_handler(task, r, stream);
+}
+
+
+void
+nxt_h2p_request_local_addr(nxt_task_t *task, nxt_http_request_t *r)
+{
+    r->local = nxt_conn_local_addr(task, r->proto.h2->h2p->conn);
+}
+
+
+void
+nxt_h2p_request_header_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_work_handler_t body_handler, void *data)
+{
+    u_char            *p, *start, status[3];
+    size_t            size, length, rest;
+    nxt_buf_t         *b, *out;
+    nxt_uint_t        n, index, flags, type;
+    nxt_h2proto_t     *h2p;
+    nxt_h2p_stream_t  *stream;
+    nxt_http_field_t  *field;
+
+    nxt_debug(task, "h2p request header send");
+
+    r->header_sent = 1;
+
+    stream = r->proto.h2;
+    h2p = stream->h2p;
+
+    if (nxt_slow_path(stream->aborted)) {
+        if (body_handler != NULL) {
+            nxt_work_queue_add(&task->thread->engine->fast_work_queue,
+                               body_handler, task, r, data);
+
+        } else {
+            nxt_h2p_stream_error(task, stream);
+        }
+
+        return;
+    }
+
+    n = r->status;
+
+    if (n > NXT_HTTP_STATUS_MAX) {
+        n = NXT_HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+    size = nxt_length(":status") + sizeof(status) + 4;
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (!field->skip) {
+            size += field->name_length + field->value_length + 16;
+        }
+
+    } nxt_list_loop;
+
+    b = nxt_h2p_buf_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE + size);
+    if (nxt_slow_path(b == NULL)) {
+        goto fail;
+    }
+
+    start = b->mem.free + NXT_H2P_FRAME_HEADER_SIZE;
+    p = start;
+
+    switch (n) {
+    case NXT_HTTP_OK:
+        *p++ = 0x88;
+        break;
+    case NXT_HTTP_NO_CONTENT:
+        *p++ = 0x89;
+        break;
+    case NXT_HTTP_PARTIAL_CONTENT:
+        *p++ = 0x8a;
+        break;
+    case NXT_HTTP_NOT_MODIFIED:
+        *p++ = 0x8b;
+        break;
+    case NXT_HTTP_BAD_REQUEST:
+        *p++ = 0x8c;
+        break;
+    case NXT_HTTP_NOT_FOUND:
+        *p++ = 0x8d;
+        break;
+    case NXT_HTTP_INTERNAL_SERVER_ERROR:
+        *p++ = 0x8e;
+        break;
+    default:
+        /* Literal without indexing, the ":status" name index is 8. */
+        *p++ = 0x08;
+        *p++ = sizeof(status);
+        (void) nxt_sprintf(status, status + sizeof(status), "%03ui", n);
+        p = nxt_cpymem(p, status, sizeof(status));
+        break;
+    }
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (field->skip) {
+            continue;
+        }
+
+        index = nxt_h2p_hpack_name_index(field->name, field->name_length);
+
+        if (index == (nxt_uint_t) -1) {
+            /* Connection-specific field. */
+            continue;
+        }
+
+        if (index != 0) {
+            p = nxt_h2p_hpack_int_encode(p, 4, index, 0);
+
+        } else {
+            *p++ = 0;
+            p = nxt_h2p_hpack_int_encode(p, 7, field->name_length, 0);
+            nxt_memcpy_lowcase(p, field->name, field->name_length);
+            p += field->name_length;
+        }
+
+        p = nxt_h2p_hpack_int_encode(p, 7, field->value_length, 0);
+        p = nxt_cpymem(p, field->value, field->value_length);
+
+    } nxt_list_loop;
+
+    length = p - start;
+
+    flags = (body_handler == NULL) ? NXT_H2P_END_STREAM : 0;
+
+    if (length <= h2p->max_frame_size) {
+        (void) nxt_h2p_frame_header(b->mem.free, length, NXT_H2P_HEADERS,
+                                    flags | NXT_H2P_END_HEADERS, stream->id);
+        b->mem.free = p;
+
+        out = b;
+
+    } else {
+        /* The header block is split into HEADERS and CONTINUATION frames. */
+
+        n = (length + h2p->max_frame_size - 1) / h2p->max_frame_size;
+
+        out = nxt_h2p_buf_alloc(h2p, length + n * NXT_H2P_FRAME_HEADER_SIZE);
+        if (nxt_slow_path(out == NULL)) {
+            goto fail;
+        }
+
+        type = NXT_H2P_HEADERS;
+        p = start;
+        rest = length;
+
+        do {
+            size = nxt_min(rest, h2p->max_frame_size);
+            rest -= size;
+
+            if (rest == 0) {
+                flags |= NXT_H2P_END_HEADERS;
+            }
+
+            out->mem.free = nxt_h2p_frame_header(out->mem.free, size, type,
+                                                 flags, stream->id);
+            out->mem.free = nxt_cpymem(out->mem.free, p, size);
+
+            p += size;
+            type = NXT_H2P_CONTINUATION;
+            flags = 0;
+
+        } while (rest != 0);
+
+        b->completion_handler(task, b, b->parent);
+    }
+
+    if (body_handler != NULL) {
+        /*
+         * The body handler will run before c->io->write() handler,
+         * because the latter was inqueued by nxt_conn_write()
+         * in engine->write_work_queue.
+         */
+        nxt_work_queue_add(&task->thread->engine->fast_work_queue,
+                           body_handler, task, r, data);
+
+    } else {
+        stream->out_closed = 1;
+        stream->complete = 1;
+
+        /*
+         * The last buffers of different streams must not be coalesced
+         * by nxt_sendbuf_completion(), so they are completed together
+         * with the frame buffers.
+         */
+        out->data = nxt_http_buf_last(r);
+    }
+
+    nxt_h2p_conn_write(task, h2p, out);
+    return;
+
+fail:
+
+    nxt_h2p_stream_error(task, stream);
+}
+
+
+void
+nxt_h2p_request_send(nxt_task_t *task, nxt_http_request_t *r, nxt_buf_t *out)
+{
+    nxt_h2p_stream_t  *stream;
+
+    nxt_debug(task, "h2p request send");
+
+    stream = r->proto.h2;
+
+    if (nxt_slow_path(stream->aborted || stream->out_closed)) {
+        nxt_h2p_stream_error(task, stream);
+
+        nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, out);
+        return;
+    }
+
+    *stream->out_tail = out;
+
+    while (out->next != NULL) {
+        out = out->next;
+    }
+
+    stream->out_tail = &out->next;
+
+    nxt_h2p_stream_output(task, stream);
+}
+
+
+static void
+nxt_h2p_stream_output(nxt_task_t *task, nxt_h2p_stream_t *stream)
+{
+    size_t            size;
+    int32_t           window;
+    nxt_buf_t         *b, *hb, *sb, *out, **tail;
+    nxt_h2proto_t     *h2p;
+    nxt_work_queue_t  *wq;
+
+    h2p = stream->h2p;
+    wq = &task->thread->engine->fast_work_queue;
+
+    out = NULL;
+    tail = &out;
+
+    while (stream->out != NULL) {
+        b = stream->out;
+
+        if (nxt_buf_is_sync(b)) {
+            stream->out = b->next;
+            b->next = NULL;
+
+            if (!nxt_buf_is_last(b)) {
+                nxt_work_queue_add(wq, b->completion_handler, task, b,
+                                   b->parent);
+                continue;
+            }
+
+            hb = nxt_h2p_buf_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE);
+            if (nxt_slow_path(hb == NULL)) {
+                stream->out = b;
+                goto fail;
+            }
+
+            hb->mem.free = nxt_h2p_frame_header(hb->mem.free, 0, NXT_H2P_DATA,
+                                                NXT_H2P_END_STREAM,
+                                                stream->id);
+            hb->data = b;
+
+            *tail = hb;
+            tail = &hb->next;
+
+            stream->out_closed = 1;
+            stream->complete = 1;
+            break;
+        }
+
+        size = nxt_buf_used_size(b);
+
+        if (size == 0) {
+            stream->out = b->next;
+            b->next = NULL;
+
+            nxt_work_queue_add(wq, b->completion_handler, task, b, b->parent);
+            continue;
+        }
+
+        window = nxt_min(stream->send_window, h2p->send_window);
+
+        if (window <= 0) {
+            if (!stream->blocked) {
+                stream->blocked = 1;
+                nxt_queue_insert_tail(&h2p->blocked, &stream->blocked_link);
+            }
+
+            break;
+        }
+
+        size = nxt_min(size, (size_t) window);
+        size = nxt_min(size, h2p->max_frame_size);
+
+        hb = nxt_h2p_buf_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE);
+        if (nxt_slow_path(hb == NULL)) {
+            goto fail;
+        }
+
+        sb = nxt_h2p_buf_shadow(h2p, b, size);
+        if (nxt_slow_path(sb == NULL)) {
+            hb->completion_handler(task, hb, hb->parent);
+            goto fail;
+        }
+
+        hb->mem.free = nxt_h2p_frame_header(hb->mem.free, size, NXT_H2P_DATA,
+                                            0, stream->id);
+        hb->next = sb;
+
+        *tail = hb;
+        tail = &sb->next;
+
+        stream->send_window -= size;
+        h2p->send_window -= size;
+        stream->body_sent += size;
+
+        if (nxt_buf_used_size(b) == 0) {
+            /* The last shadow buffer completes the original one. */
+            sb->data = b;
+            stream->partial = 0;
+
+            stream->out = b->next;
+            b->next = NULL;
+
+        } else {
+            stream->partial = 1;
+        }
+    }
+
+    if (stream->out == NULL) {
+        stream->out_tail = &stream->out;
+
+        if (stream->blocked) {
+            stream->blocked = 0;
+            nxt_queue_remove(&stream->blocked_link);
+        }
+    }
+
+    if (out != NULL) {
+        nxt_h2p_conn_write(task, h2p, out);
+    }
+
+    return;
+
+fail:
+
+    if (out != NULL) {
+        nxt_h2p_conn_write(task, h2p, out);
+    }
+
+    nxt_h2p_stream_error(task, stream);
+}
+
+
+static void
+nxt_h2p_streams_output(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    nxt_queue_t       blocked;
+    nxt_queue_link_t  *lnk;
+    nxt_h2p_stream_t  *stream;
+
+    if (nxt_queue_is_empty(&h2p->blocked)) {
+        return;
+    }
+
+    nxt_queue_init(&blocked);
+    nxt_queue_add(&blocked, &h2p->blocked);
+    nxt_queue_init(&h2p->blocked);
+
+    while (!nxt_queue_is_empty(&blocked)) {
+        lnk = nxt_queue_first(&blocked);
+        nxt_queue_remove(lnk);
+
+        stream = nxt_queue_link_data(lnk, nxt_h2p_stream_t, blocked_link);
+        stream->blocked = 0;
+
+        if (h2p->send_window > 0) {
+            nxt_h2p_stream_output(task, stream);
+
+        } else {
+            stream->blocked = 1;
+            nxt_queue_insert_tail(&h2p->blocked, &stream->blocked_link);
+        }
+    }
+}
+
+
+nxt_off_t
+nxt_h2p_request_body_bytes_sent(nxt_task_t *task, nxt_http_proto_t proto)
+{
+    return proto.h2->body_sent;
+}
+
+
+void
+nxt_h2p_request_discard(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *last)
+{
+    nxt_h2p_stream_t  *stream;
+
+    nxt_debug(task, "h2p request discard");
+
+    stream = r->proto.h2;
+    stream->error = 1;
+    stream->out_closed = 1;
+
+    nxt_h2p_stream_out_drain(task, stream);
+
+    nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, last);
+}
+
+
+static void
+nxt_h2p_stream_out_drain(nxt_task_t *task, nxt_h2p_stream_t *stream)
+{
+    nxt_buf_t  *b, *sb, *next;
+
+    if (stream->blocked) {
+        stream->blocked = 0;
+        nxt_queue_remove(&stream->blocked_link);
+    }
+
+    b = stream->out;
+
+    stream->out = NULL;
+    stream->out_tail = &stream->out;
+
+    if (b == NULL) {
+        return;
+    }
+
+    if (stream->partial) {
+        stream->partial = 0;
+
+        /*
+         * The first buffer is referred by DATA frames being sent,
+         * so it is completed after them.
+         */
+
+        sb = nxt_h2p_buf_sync(stream->h2p, b);
+
+        if (nxt_fast_path(sb != NULL)) {
+            next = b->next;
+            b->next = NULL;
+            b = next;
+
+            nxt_h2p_conn_write(task, stream->h2p, sb);
+        }
+    }
+
+    nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, b);
+}
+
+
+void
+nxt_h2p_request_close(nxt_task_t *task, nxt_http_proto_t proto,
+    nxt_socket_conf_joint_t *joint)
+{
+    nxt_conn_t        *c;
+    nxt_h2proto_t     *h2p;
+    nxt_h2p_stream_t  *stream;
+
+    stream = proto.h2;
+    h2p = stream->h2p;
+    c = h2p->conn;
+
+    nxt_debug(task, "h2p request close %uD", stream->id);
+
+    nxt_router_conf_release(task, joint);
+
+    nxt_h2p_stream_out_drain(task, stream);
+
+    nxt_queue_remove(&stream->link);
+
+    if (!stream->reset && (!stream->in_closed || !stream->complete)) {
+        /*
+         * The client is still sending the request body or the response
+         * has been interrupted.
+         */
+        nxt_h2p_send_rst_stream(task, h2p, stream->id,
+                                stream->complete ? NXT_H2P_NO_ERROR
+                                                 : NXT_H2P_INTERNAL_ERROR);
+    }
+
+    h2p->nstreams--;
+
+    task = &c->task;
+
+    if (h2p->closing) {
+        nxt_h2p_close_test(task, h2p);
+        return;
+    }
+
+    if (h2p->nstreams == 0) {
+        if (h2p->goaway) {
+            nxt_h2p_shutdown(task, h2p);
+            return;
+        }
+
+        nxt_conn_idle(task->thread->engine, c);
+
+        c->read_state = &nxt_h2p_idle_state;
+    }
+}
+
+
+nxt_int_t
+nxt_h2p_hpack_decode(nxt_h2p_hpack_t *hpack, nxt_mp_t *mp, u_char *pos,
+    u_char *end, nxt_array_t *headers, size_t limit)
+{
+    u_char            ch;
+    size_t            size;
+    uint32_t          index;
+    nxt_str_t         name, value;
+    nxt_bool_t        dynamic, indexing;
+    nxt_h2p_header_t  *h;
+
+    size = 0;
+
+    while (pos < end) {
+        ch = *pos;
+
+        if (ch & 0x80) {
+            /* Indexed header field. */
+
+            if (nxt_h2p_hpack_int(&pos, end, 7, &index) != NXT_OK
+                || nxt_h2p_hpack_get(hpack, index, &name, &value, &dynamic)
+                   != NXT_OK)
+            {
+                return NXT_ERROR;
+            }
+
+            indexing = 0;
+
+        } else if ((ch & 0xe0) == 0x20) {
+            /* Dynamic table size update. */
+
+            if (nxt_h2p_hpack_int(&pos, end, 5, &index) != NXT_OK
+                || index > NXT_H2P_HPACK_TABLE_SIZE)
+            {
+                return NXT_ERROR;
+            }
+
+            hpack->max_size = index;
+            nxt_h2p_hpack_evict(hpack, 0);
+
+            continue;
+
+        } else {
+            /* Literal header field. */
+
+            indexing = ((ch & 0x40) != 0);
+
+            if (nxt_h2p_hpack_int(&pos, end, indexing ? 6 : 4, &index)
+                != NXT_OK)
+            {
+                return NXT_ERROR;
+            }
+
+            if (index != 0) {
+                if (nxt_h2p_hpack_get(hpack, index, &name, &value, &dynamic)
+                    != NXT_OK)
+                {
+                    return NXT_ERROR;
+                }
+
+            } else {
+                if (nxt_h2p_hpack_string(mp, &pos, end, &name) != NXT_OK) {
+                    return NXT_ERROR;
+                }
+
+                dynamic = 0;
+            }
+
+            if (nxt_h2p_hpack_string(mp, &pos, end, &value) != NXT_OK) {
+                return NXT_ERROR;
+            }
+        }
+
+        size += name.length + value.length + NXT_H2P_HPACK_ENTRY_OVERHEAD;
+
+        if (headers != NULL && size <= limit) {
+            h = nxt_array_add(headers);
+            if (nxt_slow_path(h == NULL)) {
+                return NXT_ERROR;
+            }
+
+            h->name = name;
+            h->value = value;
+
+            /* Dynamic table entries can be evicted by the next fields. */
+
+            if (dynamic) {
+                h->name.start = nxt_mp_nget(mp, name.length + value.length);
+                if (nxt_slow_path(h->name.start == NULL)) {
+                    return NXT_ERROR;
+                }
+
+                nxt_memcpy(h->name.start, name.start, name.length);
+
+                if (ch & 0x80) {
+                    h->value.start = h->name.start + name.length;
+                    nxt_memcpy(h->value.start, value.start, value.length);
+                }
+            }
+        }
+
+        if (indexing && nxt_h2p_hpack_add(hpack, &name, &value) != NXT_OK) {
+            return NXT_ERROR;
+        }
+    }
+
+    return (size > limit && headers != NULL) ? NXT_DECLINED : NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_h2p_hpack_int(u_char **pos, u_char *end, nxt_uint_t prefix,
+    uint32_t *value)
+{
+    u_char      *p;
+    uint32_t    v, mask;
+    nxt_uint_t  shift;
+
+    p = *pos;
+
+    if (nxt_slow_path(p == end)) {
+        return NXT_ERROR;
+    }
+
+    mask = (1 << prefix) - 1;
+    v = *p++ & mask;
+
+    if (v == mask) {
+        shift = 0;
+
+        do {
+            if (nxt_slow_path(p == end || shift > 21)) {
+                return NXT_ERROR;
+            }
+
+            v += (uint32_t) (*p & 0x7f) << shift;
+            shift += 7;
+
+        } while (*p++ & 0x80);
+    }
+
+    *pos = p;
+    *value = v;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_h2p_hpack_string(nxt_mp_t *mp, u_char **pos, u_char *end, nxt_str_t *str)
+{
+    u_char      *p, *start;
+    uint32_t    length;
+    nxt_bool_t  huffman;
+
+    p = *pos;
+
+    if (nxt_slow_path(p == end)) {
+        return NXT_ERROR;
+    }
+
+    huffman = ((*p & 0x80) != 0);
+
+    if (nxt_h2p_hpack_int(&p, end, 7, &length) != NXT_OK
+        || length > (size_t) (end - p))
+    {
+        return NXT_ERROR;
+    }
+
+    *pos = p + length;
+
+    if (length == 0) {
+        str->length = 0;
+        str->start = p;
+
+        return NXT_OK;
+    }
+
+    if (huffman) {
+        /* The shortest code is 5 bits long. */
+        start = nxt_mp_nget(mp, length * 8 / 5);
+        if (nxt_slow_path(start == NULL)) {
+            return NXT_ERROR;
+        }
+
+        p = nxt_h2p_huff_decode(start, p, length);
+        if (nxt_slow_path(p == NULL)) {
+            return NXT_ERROR;
+        }
+
+        str->length = p - start;
+        str->start = start;
+
+        return NXT_OK;
+    }
+
+    start = nxt_mp_nget(mp, length);
+    if (nxt_slow_path(start == NULL)) {
+        return NXT_ERROR;
+    }
+
+    str->length = length;
+    str->start = nxt_cpymem(start, p, length) - length;
+
+    return NXT_OK;
+}
+
+
+static u_char *
+nxt_h2p_huff_decode(u_char *dst, u_char *src, size_t size)
+{
+    u_char      *end;
+    uint32_t    code, n;
+    nxt_uint_t  bit, len, symbol;
+
+    code = 0;
+    len = 0;
+
+    for (end = src + size; src < end; src++) {
+
+        for (bit = 0x80; bit != 0; bit >>= 1) {
+            code = (code << 1) | ((*src & bit) != 0);
+            len++;
+
+            n = code - nxt_h2p_huff_first[len];
+
+            if (n < nxt_h2p_huff_count[len]) {
+                symbol = nxt_h2p_huff_symbols[nxt_h2p_huff_offset[len] + n];
+
+                if (nxt_slow_path(symbol == NXT_H2P_HUFF_EOS)) {
+                    return NULL;
+                }
+
+                *dst++ = symbol;
+
+                code = 0;
+                len = 0;
+
+            } else if (nxt_slow_path(len == NXT_H2P_HUFF_MAX_LENGTH)) {
+                return NULL;
+            }
+        }
+    }
+
+    /* The padding is the most significant bits of the EOS code. */
+
+    if (nxt_slow_path(len > 7 || code != (1u << len) - 1)) {
+        return NULL;
+    }
+
+    return dst;
+}
+
+
+static nxt_int_t
+nxt_h2p_hpack_get(nxt_h2p_hpack_t *hpack, uint32_t index, nxt_str_t *name,
+    nxt_str_t *value, nxt_bool_t *dynamic)
+{
+    nxt_h2p_hpack_entry_t  *entry;
+
+    if (nxt_slow_path(index == 0)) {
+        return NXT_ERROR;
+    }
+
+    if (index <= nxt_nitems(nxt_h2p_static_table)) {
+        *name = nxt_h2p_static_table[index - 1].name;
+        *value = nxt_h2p_static_table[index - 1].value;
+        *dynamic = 0;
+
+        return NXT_OK;
+    }
+
+    index -= nxt_nitems(nxt_h2p_static_table) + 1;
+
+    if (nxt_slow_path(index >= hpack->added - hpack->deleted)) {
+        return NXT_ERROR;
+    }
+
+    entry = hpack->entries[(hpack->added - 1 - index) % NXT_H2P_HPACK_ENTRIES];
+
+    name->length = entry->name_length;
+    name->start = entry->data;
+    value->length = entry->value_length;
+    value->start = entry->data + entry->name_length;
+    *dynamic = 1;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_h2p_hpack_add(nxt_h2p_hpack_t *hpack, nxt_str_t *name, nxt_str_t *value)
+{
+    size_t                 size;
+    u_char                 *p;
+    nxt_h2p_hpack_entry_t  *entry;
+
+    size = name->length + value->length + NXT_H2P_HPACK_ENTRY_OVERHEAD;
+
+    if (size > hpack->max_size) {
+        /* RFC 7541, Section 4.4. */
+        nxt_h2p_hpack_evict(hpack, size);
+        return NXT_OK;
+    }
+
+    entry = nxt_malloc(sizeof(nxt_h2p_hpack_entry_t) + name->length
+                       + value->length);
+    if (nxt_slow_path(entry == NULL)) {
+        return NXT_ERROR;
+    }
+
+    entry->size = size;
+    entry->name_length = name->length;
+    entry->value_length = value->length;
+
+    /*
+     * The name can refer to an entry that is about to be evicted,
+     * so it is copied first, see RFC 7541, Section 4.4.
+     */
+
+    p = nxt_cpymem(entry->data, name->start, name->length);
+    nxt_memcpy(p, value->start, value->length);
+
+    nxt_h2p_hpack_evict(hpack, size);
+
+    hpack->entries[hpack->added % NXT_H2P_HPACK_ENTRIES] = entry;
+    hpack->added++;
+    hpack->size += size;
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_h2p_hpack_evict(nxt_h2p_hpack_t *hpack, size_t size)
+{
+    nxt_h2p_hpack_entry_t  *entry;
+
+    while (hpack->size + size > hpack->max_size
+           && hpack->added != hpack->deleted)
+    {
+        entry = hpack->entries[hpack->deleted % NXT_H2P_HPACK_ENTRIES];
+
+        hpack->size -= entry->size;
+        hpack->deleted++;
+
+        nxt_free(entry);
+    }
+}
+
+
+static u_char *
+nxt_h2p_hpack_int_encode(u_char *p, nxt_uint_t prefix, uint32_t value,
+    u_char first)
+{
+    uint32_t  mask;
+
+    mask = (1 << prefix) - 1;
+
+    if (value < mask) {
+        *p++ = first | value;
+        return p;
+    }
+
+    *p++ = first | mask;
+    value -= mask;
+
+    while (value >= 0x80) {
+        *p++ = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+
+    *p++ = value;
+
+    return p;
+}
+
+
+/*
+ * Returns the static table index of a response field name,
+ * 0 if the name is absent in the table, or (nxt_uint_t) -1
+ * if the field must not be sent in HTTP/2.
+ */
+
+static nxt_uint_t
+nxt_h2p_hpack_name_index(u_char *name, size_t length)
+{
+    nxt_uint_t  i;
+
+    for (i = 14; i < nxt_nitems(nxt_h2p_static_table); i++) {
+
+        if (nxt_h2p_static_table[i].name.length == length
+            && nxt_memcasecmp(nxt_h2p_static_table[i].name.start, name,
+                              length) == 0)
+        {
+            return (i == 56) ? (nxt_uint_t) -1 : i + 1;
+        }
+    }
+
+    switch (length) {
+
+    case 7:
+        if (nxt_memcasecmp(name, "upgrade", 7) == 0) {
+            return (nxt_uint_t) -1;
+        }
+
+        break;
+
+    case 10:
+        if (nxt_memcasecmp(name, "connection", 10) == 0
+            || nxt_memcasecmp(name, "keep-alive", 10) == 0)
+        {
+            return (nxt_uint_t) -1;
+        }
+
+        break;
+
+    case 16:
+        if (nxt_memcasecmp(name, "proxy-connection", 16) == 0) {
+            return (nxt_uint_t) -1;
+        }
+
+        break;
+    }
+
+    return 0;
+}
+
+
+static nxt_buf_t *
+nxt_h2p_buf_alloc(nxt_h2proto_t *h2p, size_t size)
+{
+    nxt_mp_t   *mp;
+    nxt_buf_t  *b;
+
+    mp = h2p->conn->mem_pool;
+
+    b = nxt_buf_mem_alloc(mp, size, 0);
+
+    if (nxt_fast_path(b != NULL)) {
+        b->data = NULL;
+        b->completion_handler = nxt_h2p_buf_completion;
+        b->parent = mp;
+
+        nxt_mp_retain(mp);
+    }
+
+    return b;
+}
+
+
+/*
+ * A shadow buffer refers to a part of the response buffer sent
+ * in a DATA frame.  The original buffer is completed together
+ * with the shadow buffer referring to its last part.
+ */
+
+static nxt_buf_t *
+nxt_h2p_buf_shadow(nxt_h2proto_t *h2p, nxt_buf_t *b, size_t size)
+{
+    nxt_mp_t   *mp;
+    nxt_buf_t  *sb;
+
+    mp = h2p->conn->mem_pool;
+
+    if (nxt_buf_is_file(b)) {
+        sb = nxt_mp_zalloc(mp, NXT_BUF_FILE_SIZE);
+        if (nxt_slow_path(sb == NULL)) {
+            return NULL;
+        }
+
+        nxt_buf_set_file(sb);
+
+        sb->file = b->file;
+        sb->file_pos = b->file_pos;
+        sb->file_end = b->file_pos + size;
+
+        b->file_pos += size;
+
+    } else {
+        sb = nxt_mp_zalloc(mp, NXT_BUF_MEM_SIZE);
+        if (nxt_slow_path(sb == NULL)) {
+            return NULL;
+        }
+
+        sb->mem.start = b->mem.pos;
+        sb->mem.pos = b->mem.pos;
+        sb->mem.free = b->mem.pos + size;
+        sb->mem.end = sb->mem.free;
+
+        b->mem.pos += size;
+    }
+
+    sb->completion_handler = nxt_h2p_buf_completion;
+    sb->parent = mp;
+
+    nxt_mp_retain(mp);
+
+    return sb;
+}
+
+
+static nxt_buf_t *
+nxt_h2p_buf_sync(nxt_h2proto_t *h2p, nxt_buf_t *b)
+{
+    nxt_mp_t   *mp;
+    nxt_buf_t  *sb;
+
+    mp = h2p->conn->mem_pool;
+
+    sb = nxt_mp_zalloc(mp, NXT_BUF_SYNC_SIZE);
+    if (nxt_slow_path(sb == NULL)) {
+        return NULL;
+    }
+
+    nxt_buf_set_sync(sb);
+
+    sb->data = b;
+    sb->completion_handler = nxt_h2p_buf_completion;
+    sb->parent = mp;
+
+    nxt_mp_retain(mp);
+
+    return sb;
+}
+
+
+static void
+nxt_h2p_buf_completion(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_mp_t   *mp;
+    nxt_buf_t  *b, *next, *orig;
+
+    b = obj;
+
+    do {
+        next = b->next;
+        orig = b->data;
+        mp = b->parent;
+
+        nxt_mp_free(mp, b);
+        nxt_mp_release(mp);
+
+        if (orig != NULL) {
+            orig->next = NULL;
+            orig->completion_handler(task, orig, orig->parent);
+        }
+
+        b = next;
+    } while (b != NULL);
+}
+
+
+static nxt_int_t
+nxt_h2p_send_settings(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    u_char     *p;
+    nxt_buf_t  *b;
+
+    b = nxt_h2p_buf_alloc(h2p, 2 * NXT_H2P_FRAME_HEADER_SIZE + 6 + 4);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_h2p_frame_header(b->mem.free, 6, NXT_H2P_SETTINGS, 0, 0);
+
+    *p++ = 0;
+    *p++ = NXT_H2P_MAX_CONCURRENT;
+    *p++ = 0;
+    *p++ = 0;
+    *p++ = 0;
+    *p++ = NXT_H2P_MAX_STREAMS;
+
+    p = nxt_h2p_frame_header(p, 4, NXT_H2P_WINDOW_UPDATE, 0, 0);
+    b->mem.free = nxt_h2p_uint32(p, NXT_H2P_CONN_WINDOW
+                                    - NXT_H2P_DEFAULT_WINDOW);
+
+    nxt_h2p_conn_write(task, h2p, b);
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_h2p_send_window_update(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    uint32_t increment)
+{
+    u_char     *p;
+    nxt_buf_t  *b;
+
+    b = nxt_h2p_buf_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE + 4);
+    if (nxt_slow_path(b == NULL)) {
+        return;
+    }
+
+    p = nxt_h2p_frame_header(b->mem.free, 4, NXT_H2P_WINDOW_UPDATE, 0, id);
+    b->mem.free = nxt_h2p_uint32(p, increment);
+
+    nxt_h2p_conn_write(task, h2p, b);
+}
+
+
+static void
+nxt_h2p_send_rst_stream(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    uint32_t code)
+{
+    u_char     *p;
+    nxt_buf_t  *b;
+
+    nxt_debug(task, "h2p send rst stream %uD: %uD", id, code);
+
+    b = nxt_h2p_buf_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE + 4);
+    if (nxt_slow_path(b == NULL)) {
+        return;
+    }
+
+    p = nxt_h2p_frame_header(b->mem.free, 4, NXT_H2P_RST_STREAM, 0, id);
+    b->mem.free = nxt_h2p_uint32(p, code);
+
+    nxt_h2p_conn_write(task, h2p, b);
+}
+
+
+static void
+nxt_h2p_send_goaway(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t code)
+{
+    u_char     *p;
+    nxt_buf_t  *b;
+
+    nxt_debug(task, "h2p send goaway %uD: %uD", h2p->last_id, code);
+
+    h2p->goaway = 1;
+
+    b = nxt_h2p_buf_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE + 8);
+    if (nxt_slow_path(b == NULL)) {
+        return;
+    }
+
+    p = nxt_h2p_frame_header(b->mem.free, 8, NXT_H2P_GOAWAY, 0, 0);
+    p = nxt_h2p_uint32(p, h2p->last_id);
+    b->mem.free = nxt_h2p_uint32(p, code);
+
+    nxt_h2p_conn_write(task, h2p, b);
+}
+
+
+static const nxt_conn_state_t  nxt_h2p_send_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h2p_conn_sent,
+    .error_handler = nxt_h2p_conn_write_error,
+
+    .timer_handler = nxt_h2p_conn_send_timeout,
+    .timer_value = nxt_h2p_conn_timer_value,
+    .timer_data = offsetof(nxt_socket_conf_t, send_timeout),
+    .timer_autoreset = 1,
+};
+
+
+static void
+nxt_h2p_conn_write(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_buf_t *out)
+{
+    nxt_conn_t  *c;
+
+    c = h2p->conn;
+
+    if (nxt_slow_path(c->block_write)) {
+        nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, out);
+        return;
+    }
+
+    if (c->write == NULL) {
+        c->write = out;
+        c->write_state = &nxt_h2p_send_state;
+
+        nxt_conn_write(task->thread->engine, c);
+
+    } else {
+        *h2p->conn_write_tail = out;
+    }
+
+    while (out->next != NULL) {
+        out = out->next;
+    }
+
+    h2p->conn_write_tail = &out->next;
+}
+
+
+static void
+nxt_h2p_conn_sent(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t          *c;
+    nxt_h2proto_t       *h2p;
+    nxt_event_engine_t  *engine;
+
+    c = obj;
+    h2p = data;
+
+    nxt_debug(task, "h2p conn sent");
+
+    engine = task->thread->engine;
+
+    c->write = nxt_sendbuf_completion(task, &engine->fast_work_queue,
+                                      c->write);
+
+    if (c->write != NULL) {
+        nxt_conn_write(engine, c);
+
+    } else if (h2p->closing) {
+        nxt_h2p_close_test(task, h2p);
+    }
+}
+
+
+static void
+nxt_h2p_conn_write_error(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t     *c;
+    nxt_buf_t      *b;
+    nxt_h2proto_t  *h2p;
+
+    c = obj;
+    h2p = data;
+
+    nxt_debug(task, "h2p conn write error");
+
+    c->block_write = 1;
+
+    b = c->write;
+    c->write = NULL;
+
+    nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, b);
+
+    nxt_h2p_shutdown(task, h2p);
+}
+
+
+static void
+nxt_h2p_conn_send_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    nxt_debug(task, "h2p conn send timeout");
+
+    c = nxt_write_timer_conn(timer);
+    c->socket.timedout = 1;
+
+    nxt_h2p_conn_write_error(task, c, c->socket.data);
+}
+
+
+static void
+nxt_h2p_conn_close(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t     *c;
+    nxt_h2proto_t  *h2p;
+
+    c = obj;
+    h2p = data;
+
+    nxt_debug(task, "h2p conn close");
+
+    c->block_write = 1;
+
+    nxt_h2p_conn_write_error(task, c, h2p);
+}
+
+
+static void
+nxt_h2p_conn_error(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_debug(task, "h2p conn error");
+
+    nxt_h2p_conn_close(task, obj, data);
+}
+
+
+static void
+nxt_h2p_idle_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    nxt_debug(task, "h2p idle timeout");
+
+    c = nxt_read_timer_conn(timer);
+
+    nxt_h2p_protocol_error(task, c->socket.data, NXT_H2P_NO_ERROR);
+}
+
+
+static void
+nxt_h2p_read_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_uint_t          i;
+    nxt_conn_t          *c;
+    nxt_timer_t         *timer;
+    nxt_queue_t         *streams;
+    nxt_h2proto_t       *h2p;
+    nxt_queue_link_t    *lnk, *next;
+    nxt_h2p_stream_t    *stream;
+    nxt_http_request_t  *r;
+
+    timer = obj;
+
+    nxt_debug(task, "h2p read timeout");
+
+    c = nxt_read_timer_conn(timer);
+    h2p = c->socket.data;
+
+    for (i = 0; i < NXT_H2P_STREAMS_HASH; i++) {
+        streams = &h2p->streams[i];
+
+        for (lnk = nxt_queue_first(streams);
+             lnk != nxt_queue_tail(streams);
+             lnk = next)
+        {
+            next = nxt_queue_next(lnk);
+            stream = nxt_queue_link_data(lnk, nxt_h2p_stream_t, link);
+
+            if (stream->body_wait) {
+                stream->body_wait = 0;
+                stream->error = 1;
+
+                r = stream->request;
+
+                nxt_http_request_error(&r->task, r, NXT_HTTP_REQUEST_TIMEOUT);
+            }
+        }
+    }
+
+    nxt_h2p_conn_read_next(task, h2p);
+}
+
+
+static nxt_msec_t
+nxt_h2p_conn_timer_value(nxt_conn_t *c, uintptr_t data)
+{
+    nxt_socket_conf_joint_t  *joint;
+
+    joint = c->listen->socket.data;
+
+    if (nxt_fast_path(joint != NULL)) {
+        return nxt_value_at(nxt_msec_t, joint->socket_conf, data);
+    }
+
+    /*
+     * Listening socket had been closed while
+     * connection was in keep-alive state.
+     */
+    return 1;
+}
+
+
+static void
+nxt_h2p_protocol_error(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t code)
+{
+    if (code != NXT_H2P_NO_ERROR) {
+        nxt_log(task, NXT_LOG_INFO, "h2p: connection error %uD", code);
+    }
+
+    if (!h2p->closing) {
+        nxt_h2p_send_goaway(task, h2p, code);
+    }
+
+    nxt_h2p_shutdown(task, h2p);
+}
+
+
+static void
+nxt_h2p_shutdown(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    nxt_uint_t        i;
+    nxt_conn_t        *c;
+    nxt_queue_t       *streams;
+    nxt_queue_link_t  *lnk, *next;
+    nxt_h2p_stream_t  *stream;
+
+    if (h2p->closing) {
+        return;
+    }
+
+    nxt_debug(task, "h2p shutdown");
+
+    h2p->closing = 1;
+    h2p->goaway = 1;
+
+    c = h2p->conn;
+    c->block_read = 1;
+
+    nxt_timer_disable(task->thread->engine, &c->read_timer);
+
+    if (h2p->nstreams == 0) {
+        nxt_conn_active(task->thread->engine, c);
+    }
+
+    for (i = 0; i < NXT_H2P_STREAMS_HASH; i++) {
+        streams = &h2p->streams[i];
+
+        for (lnk = nxt_queue_first(streams);
+             lnk != nxt_queue_tail(streams);
+             lnk = next)
+        {
+            next = nxt_queue_next(lnk);
+            stream = nxt_queue_link_data(lnk, nxt_h2p_stream_t, link);
+
+            stream->reset = 1;
+
+            nxt_h2p_stream_abort(&stream->request->task, stream);
+        }
+    }
+
+    nxt_h2p_close_test(task, h2p);
+}
+
+
+static void
+nxt_h2p_close_test(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    nxt_conn_t       *c;
+    nxt_h2p_hpack_t  *hpack;
+
+    c = h2p->conn;
+
+    if (h2p->nstreams != 0 || c->write != NULL || h2p->closed) {
+        return;
+    }
+
+    nxt_debug(task, "h2p conn closing");
+
+    h2p->closed = 1;
+
+    hpack = &h2p->hpack;
+    hpack->max_size = 0;
+    nxt_h2p_hpack_evict(hpack, 0);
+
+    if (h2p->hblock != NULL) {
+        nxt_free(h2p->hblock);
+        h2p->hblock = NULL;
+    }
+
+    nxt_h1p_closing(task, c);
+}
@@ -0,0 +1,122 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_H2PROTO_H_INCLUDED_
+#define _NXT_H2PROTO_H_INCLUDED_
+
+
+#include <nxt_main.h>
+#include <nxt_http_parse.h>
+#include <nxt_http.h>
+#include <nxt_router.h>
+
+
+#define NXT_H2P_STREAMS_HASH      32
+#define NXT_H2P_HPACK_ENTRIES     128
+
+
+typedef struct nxt_h2proto_s      nxt_h2proto_t;
+
+
+typedef struct {
+    uint32_t                  size;
+    uint32_t                  name_length;
+    uint32_t                  value_length;
+    u_char                    data[];
+} nxt_h2p_hpack_entry_t;
+
+
+typedef struct {
+    nxt_h2p_hpack_entry_t     *entries[NXT_H2P_HPACK_ENTRIES];
+    uint32_t                  added;
+    uint32_t                  deleted;
+    uint32_t                  size;
+    uint32_t                  max_size;
+} nxt_h2p_hpack_t;
+
+
+struct nxt_h2p_stream_s {
+    nxt_http_request_parse_t  parser;
+
+    nxt_queue_link_t          link;          /* nxt_h2proto_t.streams */
+    nxt_queue_link_t          blocked_link;  /* nxt_h2proto_t.blocked */
+
+    nxt_h2proto_t             *h2p;
+    nxt_http_request_t        *request;
+
+    nxt_buf_t                 *out;
+    nxt_buf_t                 **out_tail;
+
+    nxt_off_t                 body_sent;
+    nxt_off_t                 body_received;
+
+    uint32_t                  id;
+    int32_t                   send_window;
+    int32_t                   recv_window;
+
+    uint8_t                   in_closed;     /* 1 bit */
+    uint8_t                   out_closed;    /* 1 bit */
+    uint8_t                   body_wait;     /* 1 bit */
+    uint8_t                   blocked;       /* 1 bit */
+    uint8_t                   aborted;       /* 1 bit */
+    uint8_t                   error;         /* 1 bit */
+    uint8_t                   reset;         /* 1 bit */
+    uint8_t                   partial;       /* 1 bit */
+    uint8_t                   complete;      /* 1 bit */
+};
+
+
+struct nxt_h2proto_s {
+    nxt_queue_t               streams[NXT_H2P_STREAMS_HASH];
+    nxt_queue_t               blocked;
+
+    nxt_h2p_hpack_t           hpack;
+
+    /* The header block assembled from HEADERS and CONTINUATION frames. */
+    u_char                    *hblock;
+    size_t                    hblock_size;
+    uint32_t                  hblock_id;
+    uint8_t                   hblock_flags;
+
+    uint32_t                  nstreams;
+    uint32_t                  last_id;
+
+    int32_t                   send_window;
+    int32_t                   recv_window;
+    int32_t                   initial_window;
+    uint32_t                  max_frame_size;
+
+    nxt_buf_t                 **conn_write_tail;
+
+    uint8_t                   preface;       /* 1 bit */
+    uint8_t                   goaway;        /* 1 bit */
+    uint8_t                   closing;       /* 1 bit */
+    uint8_t                   closed;        /* 1 bit */
+
+    nxt_conn_t                *conn;
+};
+
+
+nxt_bool_t nxt_h2p_conn_test(nxt_conn_t *c);
+void nxt_h2p_conn_init(nxt_task_t *task, nxt_conn_t *c);
+
+void nxt_h2p_request_body_read(nxt_task_t *task, nxt_http_request_t *r);
+void nxt_h2p_request_local_addr(nxt_task_t *task, nxt_http_request_t *r);
+void nxt_h2p_request_header_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_work_handler_t body_handler, void *data);
+void nxt_h2p_request_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *out);
+
+nxt_int_t nxt_h2p_hpack_decode(nxt_h2p_hpack_t *hpack, nxt_mp_t *mp,
+    u_char *pos, u_char *end, nxt_array_t *headers, size_t limit);
+nxt_off_t nxt_h2p_request_body_bytes_sent(nxt_task_t *task,
+    nxt_http_proto_t proto);
+void nxt_h2p_request_discard(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *last);
+void nxt_h2p_request_close(nxt_task_t *task, nxt_http_proto_t proto,
+    nxt_socket_conf_joint_t *joint);
+
+
+#endif  /* _NXT_H2PROTO_H_INCLUDED_ */
@@ -19,6 +19,7 @@ typedef enum {
 
     NXT_HTTP_OK = 200,
     NXT_HTTP_NO_CONTENT = 204,
+    NXT_HTTP_PARTIAL_CONTENT = 206,
 
     NXT_HTTP_MULTIPLE_CHOICES = 300,
     NXT_HTTP_MOVED_PERMANENTLY = 301,
@@ -36,7 +37,9 @@ typedef enum {
     NXT_HTTP_LENGTH_REQUIRED = 411,
     NXT_HTTP_PAYLOAD_TOO_LARGE = 413,
     NXT_HTTP_URI_TOO_LONG = 414,
+    NXT_HTTP_RANGE_NOT_SATISFIABLE = 416,
     NXT_HTTP_UPGRADE_REQUIRED = 426,
+    NXT_HTTP_TOO_MANY_REQUESTS = 429,
     NXT_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE = 431,
 
     NXT_HTTP_TO_HTTPS = 497,
@@ -74,6 +77,7 @@ typedef struct {
 
 
 typedef struct nxt_h1proto_s        nxt_h1proto_t;
+typedef struct nxt_h2p_stream_s     nxt_h2p_stream_t;
 
 struct nxt_h1p_websocket_timer_s {
     nxt_timer_t                     timer;
@@ -85,6 +89,7 @@ struct nxt_h1p_websocket_timer_s {
 typedef union {
     void                            *any;
     nxt_h1proto_t                   *h1;
+    nxt_h2p_stream_t                *h2;
 } nxt_http_proto_t;
 
 
@@ -114,6 +119,11 @@ typedef struct {
 
 
 typedef struct nxt_upstream_server_s  nxt_upstream_server_t;
+typedef struct nxt_http_compress_s    nxt_http_compress_t;
+typedef struct nxt_http_limit_s       nxt_http_limit_t;
+typedef struct nxt_http_limit_node_s  nxt_http_limit_node_t;
+typedef struct nxt_http_cache_s       nxt_http_cache_t;
+typedef struct nxt_http_cache_ctx_s   nxt_http_cache_ctx_t;
 
 typedef struct {
     nxt_http_proto_t                proto;
@@ -161,6 +171,11 @@ struct nxt_http_request_s {
     nxt_http_field_t                *referer;
     nxt_http_field_t                *user_agent;
     nxt_http_field_t                *authorization;
+    nxt_http_field_t                *accept_encoding;
+    nxt_http_field_t                *if_none_match;
+    nxt_http_field_t                *if_modified_since;
+    nxt_http_field_t                *if_range;
+    nxt_http_field_t                *range;
     nxt_off_t                       content_length_n;
 
     nxt_sockaddr_t                  *remote;
@@ -183,6 +198,10 @@ struct nxt_http_request_s {
     nxt_http_peer_t                 *peer;
     nxt_buf_t                       *last;
 
+    nxt_http_compress_t             *compress;
+    nxt_http_limit_node_t           *limit_node;
+    nxt_http_cache_ctx_t            *cache;
+
     nxt_queue_link_t                app_link;   /* nxt_app_t.ack_waiting_req */
     nxt_event_engine_t              *engine;
     nxt_work_t                      err_work;
@@ -194,11 +213,13 @@ struct nxt_http_request_s {
     uint8_t                         log_route;    /* 1 bit */
     uint8_t                         quoted_target;  /* 1 bit */
     uint8_t                         uri_changed;  /* 1 bit */
+    uint8_t                         limit_delayed;  /* 1 bit */
 
     uint8_t                         pass_count;   /* 8 bits */
     uint8_t                         app_target;
     nxt_http_protocol_t             protocol:8;   /* 2 bits */
     uint8_t                         tls;          /* 1 bit  */
+    uint8_t                         sendfile;     /* 1 bit  */
     uint8_t                         logged;       /* 1 bit  */
     uint8_t                         header_sent;  /* 1 bit  */
     uint8_t                         inconsistent; /* 1 bit  */
@@ -231,6 +252,8 @@ typedef struct nxt_http_route_addr_rule_s  nxt_http_route_addr_rule_t;
 typedef struct {
     nxt_conf_value_t                *rewrite;
     nxt_conf_value_t                *set_headers;
+    nxt_conf_value_t                *limit_requests;
+    nxt_conf_value_t                *limit_concurrency;
     nxt_conf_value_t                *pass;
     nxt_conf_value_t                *ret;
     nxt_conf_value_t                *location;
@@ -240,8 +263,11 @@ typedef struct {
     nxt_str_t                       chroot;
     nxt_conf_value_t                *follow_symlinks;
     nxt_conf_value_t                *traverse_mounts;
+    nxt_conf_value_t                *precompressed;
     nxt_conf_value_t                *types;
     nxt_conf_value_t                *fallback;
+    nxt_conf_value_t                *compress;
+    nxt_conf_value_t                *cache;
 } nxt_http_action_conf_t;
 
 
@@ -260,6 +286,10 @@ struct nxt_http_action_s {
 
     nxt_tstr_t                      *rewrite;
     nxt_array_t                     *set_headers;  /* of nxt_http_field_t */
+    nxt_http_compress_conf_t        *compress;
+    nxt_http_limit_t                *limit;
+    nxt_http_limit_t                *concurrency;
+    nxt_http_cache_t                *cache;
     nxt_http_action_t               *fallback;
 };
 
@@ -322,6 +352,7 @@ nxt_http_date(u_char *buf, struct tm *tm)
 
 nxt_int_t nxt_http_init(nxt_task_t *task);
 nxt_int_t nxt_h1p_init(nxt_task_t *task);
+nxt_int_t nxt_h2p_init(nxt_task_t *task);
 nxt_int_t nxt_http_response_hash_init(nxt_task_t *task);
 
 void nxt_http_conn_init(nxt_task_t *task, void *obj, void *data);
@@ -397,6 +428,34 @@ nxt_int_t nxt_http_set_headers(nxt_http_request_t *r);
 nxt_int_t nxt_http_return_init(nxt_router_conf_t *rtcf,
     nxt_http_action_t *action, nxt_http_action_conf_t *acf);
 
+nxt_int_t nxt_http_compress_init(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf);
+nxt_http_compress_conf_t *nxt_http_compress_conf_create(nxt_task_t *task,
+    nxt_mp_t *mp, nxt_conf_value_t *cv);
+nxt_bool_t nxt_http_compress_encoding(nxt_str_t *name);
+void nxt_http_compress_accept(nxt_http_field_t *field, nxt_str_t *names,
+    nxt_int_t *quality, nxt_uint_t n);
+nxt_int_t nxt_http_compress_header_filter(nxt_task_t *task,
+    nxt_http_request_t *r);
+void nxt_http_compress_body_filter(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *out);
+
+nxt_int_t nxt_http_limit_init(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf);
+nxt_int_t nxt_http_limit(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action);
+void nxt_http_limit_release(nxt_http_request_t *r);
+nxt_int_t nxt_http_limit_conn(nxt_task_t *task, nxt_conn_t *c,
+    nxt_socket_conf_t *skcf);
+
+nxt_int_t nxt_http_cache_init(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf);
+nxt_int_t nxt_http_cache(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action);
+void nxt_http_cache_header_filter(nxt_task_t *task, nxt_http_request_t *r);
+nxt_buf_t *nxt_http_cache_body_filter(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_buf_t *out);
+
 nxt_int_t nxt_http_static_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     nxt_http_action_t *action, nxt_http_action_conf_t *acf);
 nxt_int_t nxt_http_static_mtypes_init(nxt_mp_t *mp, nxt_lvlhsh_t *hash);
@@ -404,6 +463,8 @@ nxt_int_t nxt_http_static_mtypes_hash_add(nxt_mp_t *mp, nxt_lvlhsh_t *hash,
     const nxt_str_t *exten, nxt_str_t *type);
 nxt_str_t *nxt_http_static_mtype_get(nxt_lvlhsh_t *hash,
     const nxt_str_t *exten);
+nxt_bool_t nxt_http_static_precompressed(nxt_str_t *name);
+void nxt_http_static_cache_free(nxt_task_t *task, nxt_event_engine_t *engine);
 
 nxt_http_action_t *nxt_http_application_handler(nxt_task_t *task,
     nxt_http_request_t *r, nxt_http_action_t *action);
@@ -438,6 +499,7 @@ void nxt_h1p_websocket_frame_start(nxt_task_t *task, nxt_http_request_t *r,
 void nxt_h1p_complete_buffers(nxt_task_t *task, nxt_h1proto_t *h1p,
     nxt_bool_t all);
 nxt_msec_t nxt_h1p_conn_request_timer_value(nxt_conn_t *c, uintptr_t data);
+void nxt_h1p_closing(nxt_task_t *task, nxt_conn_t *c);
 
 extern const nxt_conn_state_t  nxt_h1p_idle_close_state;
 
@@ -0,0 +1,2002 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+
+
+/*
+ * The response cache is shared by all router engines.  Like the request
+ * limits, it is split into stripes by the key hash; each stripe is protected
+ * with its own spinlock and owns an equal share of the cache size, so
+ * a response is cached only if it fits in the share of a stripe.
+ *
+ * With "path", the bodies larger than a page are written to unlinked
+ * temporary files like the request bodies stored in "body_temp_path",
+ * while the index remains in memory.  A file lives while its entry is
+ * referenced, and hits are sent with sendfile() where possible.
+ */
+
+#define NXT_HTTP_CACHE_STRIPES       16      /* The upper 4 bits of a hash. */
+#define NXT_HTTP_CACHE_BUF_SIZE      4096
+#define NXT_HTTP_CACHE_READ_SIZE     (128 * 1024)
+
+
+typedef struct nxt_http_cache_stripe_s  nxt_http_cache_stripe_t;
+
+
+/*
+ * An entry is referenced by the cache and by each request that sends it,
+ * so an entry replaced or evicted while being sent is freed afterwards.
+ * The header fields of an entry point to the memory following the entry,
+ * the body is allocated separately as it grows while being received.
+ */
+
+typedef struct {
+    nxt_queue_link_t            link;
+    nxt_http_cache_stripe_t     *stripe;
+    uint32_t                    hash;
+    uint32_t                    count;
+    size_t                      size;
+    nxt_time_t                  date;
+    nxt_time_t                  expires;
+    nxt_http_status_t           status;
+    nxt_uint_t                  nfields;
+    nxt_http_field_t            *fields;
+    nxt_str_t                   key;
+    u_char                      *body;
+    size_t                      body_length;
+    nxt_file_t                  file;
+} nxt_http_cache_entry_t;
+
+
+struct nxt_http_cache_stripe_s {
+    nxt_thread_spinlock_t       lock;
+    nxt_lvlhsh_t                hash;
+    nxt_lvlhsh_t                pending;  /* of nxt_http_cache_ctx_t */
+    nxt_queue_t                 lru;
+    size_t                      size;
+} nxt_aligned(64);
+
+
+struct nxt_http_cache_s {
+    nxt_tstr_t                  *key;
+    nxt_time_t                  valid;
+    size_t                      max;     /* The share of a stripe. */
+    nxt_http_cache_stripe_t     *stripes;
+    nxt_time_t                  stale;
+    nxt_str_t                   path;
+    nxt_msec_t                  collapse_timeout;
+    /* Set once a file cannot be created in "path". */
+    nxt_atomic_t                memory_only;
+    uint8_t                     collapse;    /* 1 bit */
+    uint8_t                     revalidate;  /* 1 bit */
+};
+
+
+/*
+ * The state of a response being stored.  With collapsing, the first
+ * request of a key is the leader, and the requests of the same key that
+ * arrive meanwhile wait in its queue, possibly in other engines, until
+ * the leader either shares its response with them or gives up, or until
+ * the collapse timeout expires.
+ */
+
+struct nxt_http_cache_ctx_s {
+    nxt_http_cache_t            *cache;
+    nxt_http_cache_entry_t      *entry;
+    size_t                      capacity;
+    nxt_str_t                   key;
+    uint32_t                    hash;
+    uint8_t                     leader;      /* 1 bit */
+    uint8_t                     revalidate;  /* 1 bit */
+    uint8_t                     replay;      /* 1 bit */
+    uint8_t                     waiting;     /* 1 bit */
+
+    /* An expired entry to revalidate or to send on error. */
+    nxt_http_cache_entry_t      *stale;
+
+    nxt_queue_t                 waiters;
+    nxt_queue_link_t            link;
+    nxt_http_action_t           *action;
+    nxt_http_cache_entry_t      *shared;
+    nxt_event_engine_t          *engine;
+    nxt_work_t                  work;
+    nxt_timer_t                 timer;
+};
+
+
+/* The state of a body being read from a file. */
+
+typedef struct {
+    nxt_http_request_t          *request;
+    nxt_http_cache_entry_t      *entry;
+    nxt_off_t                   pos;
+} nxt_http_cache_read_t;
+
+
+typedef struct {
+    nxt_str_t                   key;
+    nxt_int_t                   valid;
+    size_t                      size;
+    nxt_str_t                   path;
+    nxt_int_t                   stale;
+    nxt_int_t                   collapse_timeout;
+    uint8_t                     collapse;
+    uint8_t                     revalidate;
+} nxt_http_cache_conf_t;
+
+
+static nxt_int_t nxt_http_cache_key(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_t *cache, nxt_str_t *key);
+static nxt_http_cache_ctx_t *nxt_http_cache_ctx_create(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_action_t *action, nxt_str_t *key);
+static nxt_http_cache_entry_t *nxt_http_cache_find(
+    nxt_http_cache_stripe_t *stripe, nxt_http_cache_ctx_t *ctx,
+    nxt_time_t now);
+static nxt_int_t nxt_http_cache_conditional(nxt_http_request_t *r,
+    nxt_http_cache_entry_t *entry);
+static nxt_int_t nxt_http_cache_collapse(nxt_http_cache_stripe_t *stripe,
+    nxt_http_cache_ctx_t *ctx, nxt_bool_t get);
+static void nxt_http_cache_wake_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_cache_timeout_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_cache_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_entry_t *entry);
+static nxt_int_t nxt_http_cache_response(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_cache_entry_t *entry);
+static void nxt_http_cache_send_body(nxt_task_t *task, void *obj, void *data);
+static nxt_bool_t nxt_http_cache_sendfile(nxt_http_request_t *r);
+static nxt_buf_t *nxt_http_cache_file_buf(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_cache_entry_t *entry);
+static void nxt_http_cache_file_buf_completion(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_cache_read_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_cache_replay(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *ctx, nxt_time_t ttl);
+static nxt_buf_t *nxt_http_cache_replay_body(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_cache_ctx_t *ctx, nxt_buf_t *out);
+static nxt_time_t nxt_http_cache_ttl(nxt_http_request_t *r,
+    nxt_http_cache_t *cache);
+static nxt_time_t nxt_http_cache_control(nxt_http_field_t *f);
+static nxt_int_t nxt_http_cache_file_create(nxt_task_t *task,
+    nxt_http_cache_t *cache, nxt_http_cache_entry_t *entry);
+static nxt_http_cache_entry_t *nxt_http_cache_entry_create(
+    nxt_http_request_t *r, nxt_http_cache_ctx_t *ctx, nxt_time_t ttl);
+static nxt_int_t nxt_http_cache_body_add(nxt_http_cache_ctx_t *ctx,
+    nxt_buf_t *b);
+static nxt_int_t nxt_http_cache_body_write(nxt_http_cache_entry_t *entry,
+    nxt_buf_t *b, size_t size);
+static void nxt_http_cache_done(nxt_task_t *task, nxt_http_cache_ctx_t *ctx,
+    nxt_bool_t store);
+static nxt_bool_t nxt_http_cache_insert(nxt_http_cache_stripe_t *stripe,
+    nxt_http_cache_entry_t *entry, size_t max);
+static void nxt_http_cache_entry_unlink(nxt_http_cache_stripe_t *stripe,
+    nxt_http_cache_entry_t *entry);
+static void nxt_http_cache_entry_release(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_cache_entry_free(nxt_http_cache_entry_t *entry);
+static nxt_http_field_t *nxt_http_cache_entry_field(
+    nxt_http_cache_entry_t *entry, const char *name, size_t length);
+static void nxt_http_cache_ctx_cleanup(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_cache_cleanup(nxt_task_t *task, void *obj, void *data);
+static nxt_int_t nxt_http_cache_hash_test(nxt_lvlhsh_query_t *lhq,
+    void *data);
+static nxt_int_t nxt_http_cache_pending_test(nxt_lvlhsh_query_t *lhq,
+    void *data);
+
+
+static nxt_conf_map_t  nxt_http_cache_conf[] = {
+    {
+        nxt_string("key"),
+        NXT_CONF_MAP_STR,
+        offsetof(nxt_http_cache_conf_t, key)
+    },
+    {
+        nxt_string("valid"),
+        NXT_CONF_MAP_INT,
+        offsetof(nxt_http_cache_conf_t, valid)
+    },
+    {
+        nxt_string("size"),
+        NXT_CONF_MAP_SIZE,
+        offsetof(nxt_http_cache_conf_t, size)
+    },
+    {
+        nxt_string("collapse"),
+        NXT_CONF_MAP_INT8,
+        offsetof(nxt_http_cache_conf_t, collapse)
+    },
+    {
+        nxt_string("collapse_timeout"),
+        NXT_CONF_MAP_INT,
+        offsetof(nxt_http_cache_conf_t, collapse_timeout)
+    },
+    {
+        nxt_string("path"),
+        NXT_CONF_MAP_STR,
+        offsetof(nxt_http_cache_conf_t, path)
+    },
+    {
+        nxt_string("stale"),
+        NXT_CONF_MAP_INT,
+        offsetof(nxt_http_cache_conf_t, stale)
+    },
+    {
+        nxt_string("revalidate"),
+        NXT_CONF_MAP_INT8,
+        offsetof(nxt_http_cache_conf_t, revalidate)
+    },
+};
+
+
+static const nxt_lvlhsh_proto_t  nxt_http_cache_hash_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    nxt_http_cache_hash_test,
+    nxt_lvlhsh_alloc,
+    nxt_lvlhsh_free,
+};
+
+
+static const nxt_lvlhsh_proto_t  nxt_http_cache_pending_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    nxt_http_cache_pending_test,
+    nxt_lvlhsh_alloc,
+    nxt_lvlhsh_free,
+};
+
+
+static const nxt_http_request_state_t  nxt_http_cache_send_state
+    nxt_aligned(64) =
+{
+    .error_handler = nxt_http_request_error_handler,
+};
+
+
+nxt_int_t
+nxt_http_cache_init(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf)
+{
+    nxt_mp_t               *mp;
+    nxt_int_t              ret;
+    nxt_uint_t             i;
+    nxt_http_cache_t       *cache;
+    nxt_http_cache_conf_t  conf;
+
+    mp = rtcf->mem_pool;
+
+    nxt_str_set(&conf.key, "$host$request_uri");
+    conf.valid = 0;
+    conf.size = 16 * 1024 * 1024;
+    conf.collapse = 0;
+    conf.collapse_timeout = 5;
+    nxt_str_null(&conf.path);
+    conf.stale = 0;
+    conf.revalidate = 0;
+
+    ret = nxt_conf_map_object(mp, acf->cache, nxt_http_cache_conf,
+                              nxt_nitems(nxt_http_cache_conf), &conf);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    cache = nxt_mp_zget(mp, sizeof(nxt_http_cache_t));
+    if (nxt_slow_path(cache == NULL)) {
+        return NXT_ERROR;
+    }
+
+    cache->key = nxt_tstr_compile(rtcf->tstr_state, &conf.key, 0);
+    if (nxt_slow_path(cache->key == NULL)) {
+        return NXT_ERROR;
+    }
+
+    cache->valid = conf.valid;
+    cache->max = conf.size / NXT_HTTP_CACHE_STRIPES;
+    cache->collapse = conf.collapse;
+    cache->collapse_timeout = nxt_min(conf.collapse_timeout,
+                                      NXT_INT32_T_MAX / 1000) * 1000;
+    cache->stale = conf.stale;
+    cache->revalidate = conf.revalidate;
+
+    if (conf.path.length != 0) {
+        cache->path.length = conf.path.length;
+        cache->path.start = nxt_mp_nget(mp, conf.path.length + 1);
+        if (nxt_slow_path(cache->path.start == NULL)) {
+            return NXT_ERROR;
+        }
+
+        nxt_memcpy(cache->path.start, conf.path.start, conf.path.length);
+        cache->path.start[conf.path.length] = '\0';
+    }
+
+    cache->stripes = nxt_mp_align(mp, 64, NXT_HTTP_CACHE_STRIPES
+                                          * sizeof(nxt_http_cache_stripe_t));
+    if (nxt_slow_path(cache->stripes == NULL)) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < NXT_HTTP_CACHE_STRIPES; i++) {
+        nxt_memzero(&cache->stripes[i], sizeof(nxt_http_cache_stripe_t));
+        nxt_queue_init(&cache->stripes[i].lru);
+    }
+
+    ret = nxt_mp_cleanup(mp, nxt_http_cache_cleanup, task, cache, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    action->cache = cache;
+
+    return NXT_OK;
+}
+
+
+/*
+ * A fresh response found in the cache is sent without processing
+ * the action.  Otherwise, the response of a GET request is stored
+ * if it turns out to be cacheable.
+ */
+
+nxt_int_t
+nxt_http_cache(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action)
+{
+    nxt_int_t                ret;
+    nxt_str_t                key;
+    nxt_bool_t               get;
+    nxt_http_cache_t         *cache;
+    nxt_http_cache_ctx_t     *ctx;
+    nxt_event_engine_t       *engine;
+    nxt_http_cache_entry_t   *entry;
+    nxt_http_cache_stripe_t  *stripe;
+
+    cache = action->cache;
+
+    if (cache == NULL || r->cache != NULL || r->authorization != NULL) {
+        return NXT_OK;
+    }
+
+    get = nxt_str_eq(r->method, "GET", 3);
+
+    if (!get && !nxt_str_eq(r->method, "HEAD", 4)) {
+        return NXT_OK;
+    }
+
+    ret = nxt_http_cache_key(task, r, cache, &key);
+    if (ret != NXT_OK) {
+        return (ret == NXT_DECLINED) ? NXT_OK : ret;
+    }
+
+    ctx = nxt_http_cache_ctx_create(task, r, action, &key);
+    if (nxt_slow_path(ctx == NULL)) {
+        return NXT_ERROR;
+    }
+
+    stripe = &cache->stripes[ctx->hash >> 28];
+
+    ret = NXT_OK;
+
+    nxt_thread_spin_lock(&stripe->lock);
+
+    entry = nxt_http_cache_find(stripe, ctx, nxt_thread_time(task->thread));
+
+    if (entry == NULL && cache->collapse) {
+        ret = nxt_http_cache_collapse(stripe, ctx, get);
+    }
+
+    nxt_thread_spin_unlock(&stripe->lock);
+
+    if (entry != NULL) {
+        ret = nxt_mp_cleanup(r->mem_pool, nxt_http_cache_entry_release,
+                             task, entry, NULL);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            nxt_http_cache_entry_release(task, entry, NULL);
+            return NXT_ERROR;
+        }
+
+        nxt_debug(task, "http cache hit: \"%V\"", &key);
+
+        nxt_http_cache_send(task, r, entry);
+
+        return NXT_DONE;
+    }
+
+    if (ret == NXT_AGAIN) {
+        nxt_debug(task, "http cache wait: \"%V\"", &key);
+
+        /*
+         * The request memory pool is retained until the leader
+         * wakes the request up or the collapse timeout expires.
+         */
+        nxt_mp_retain(r->mem_pool);
+
+        engine = task->thread->engine;
+
+        ctx->timer.task = &engine->task;
+        ctx->timer.work_queue = &engine->fast_work_queue;
+        ctx->timer.log = engine->task.log;
+        ctx->timer.bias = NXT_TIMER_DEFAULT_BIAS;
+        ctx->timer.handler = nxt_http_cache_timeout_handler;
+
+        nxt_timer_add(engine, &ctx->timer, cache->collapse_timeout);
+
+        return NXT_DONE;
+    }
+
+    nxt_debug(task, "http cache miss: \"%V\"", &key);
+
+    if (get) {
+        r->cache = ctx;
+
+        if (ctx->stale != NULL && cache->revalidate) {
+            ret = nxt_http_cache_conditional(r, ctx->stale);
+            if (nxt_slow_path(ret == NXT_ERROR)) {
+                return NXT_ERROR;
+            }
+
+            ctx->revalidate = (ret == NXT_OK);
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_http_cache_ctx_t *
+nxt_http_cache_ctx_create(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action, nxt_str_t *key)
+{
+    nxt_int_t             ret;
+    nxt_http_cache_ctx_t  *ctx;
+
+    ctx = nxt_mp_zget(r->mem_pool, sizeof(nxt_http_cache_ctx_t));
+    if (nxt_slow_path(ctx == NULL)) {
+        return NULL;
+    }
+
+    ctx->cache = action->cache;
+    ctx->action = action;
+    ctx->hash = nxt_murmur_hash2(key->start, key->length);
+
+    ctx->key.length = key->length;
+    ctx->key.start = nxt_mp_nget(r->mem_pool, key->length);
+    if (nxt_slow_path(ctx->key.start == NULL)) {
+        return NULL;
+    }
+
+    nxt_memcpy(ctx->key.start, key->start, key->length);
+
+    nxt_queue_init(&ctx->waiters);
+
+    ctx->engine = task->thread->engine;
+    nxt_work_set(&ctx->work, nxt_http_cache_wake_handler, &r->task, r, ctx);
+
+    ret = nxt_mp_cleanup(r->mem_pool, nxt_http_cache_ctx_cleanup, task,
+                         ctx, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    return ctx;
+}
+
+
+static nxt_int_t
+nxt_http_cache_key(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_t *cache, nxt_str_t *key)
+{
+    nxt_int_t          ret;
+    nxt_router_conf_t  *rtcf;
+
+    if (nxt_tstr_is_const(cache->key)) {
+        nxt_tstr_str(cache->key, key);
+
+    } else {
+        rtcf = r->conf->socket_conf->router_conf;
+
+        ret = nxt_tstr_query_init(&r->tstr_query, rtcf->tstr_state,
+                                  &r->tstr_cache, r, r->mem_pool);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        nxt_tstr_query(task, r->tstr_query, cache->key, key);
+
+        if (nxt_slow_path(nxt_tstr_query_failed(r->tstr_query))) {
+            return NXT_ERROR;
+        }
+    }
+
+    /* Requests with an empty key are not cached. */
+
+    return (key->length != 0) ? NXT_OK : NXT_DECLINED;
+}
+
+
+/* The stripe lock must be held. */
+
+static nxt_http_cache_entry_t *
+nxt_http_cache_find(nxt_http_cache_stripe_t *stripe, nxt_http_cache_ctx_t *ctx,
+    nxt_time_t now)
+{
+    nxt_lvlhsh_query_t      lhq;
+    nxt_http_cache_entry_t  *entry;
+
+    lhq.key = ctx->key;
+    lhq.key_hash = ctx->hash;
+    lhq.proto = &nxt_http_cache_hash_proto;
+
+    if (nxt_lvlhsh_find(&stripe->hash, &lhq) != NXT_OK) {
+        return NULL;
+    }
+
+    entry = lhq.value;
+
+    if (entry->expires <= now) {
+        /*
+         * An expired entry is kept while it can be sent on error,
+         * or until it is revalidated or replaced if it has validators.
+         */
+
+        if (entry->expires + ctx->cache->stale > now
+            || (ctx->cache->revalidate
+                && (nxt_http_cache_entry_field(entry, "ETag", 4) != NULL
+                    || nxt_http_cache_entry_field(entry, "Last-Modified", 13)
+                       != NULL)))
+        {
+            entry->count++;
+            ctx->stale = entry;
+
+        } else {
+            nxt_http_cache_entry_unlink(stripe, entry);
+        }
+
+        return NULL;
+    }
+
+    entry->count++;
+
+    nxt_queue_remove(&entry->link);
+    nxt_queue_insert_head(&stripe->lru, &entry->link);
+
+    return entry;
+}
+
+
+/*
+ * The request is passed to the action with the validators of the expired
+ * entry unless it is conditional itself, as a "304 Not Modified" response
+ * would be sent to the client then.
+ */
+
+static nxt_int_t
+nxt_http_cache_conditional(nxt_http_request_t *r,
+    nxt_http_cache_entry_t *entry)
+{
+    nxt_http_field_t  *f, *field;
+
+    if (r->if_none_match != NULL || r->if_modified_since != NULL) {
+        return NXT_DECLINED;
+    }
+
+    field = nxt_http_cache_entry_field(entry, "ETag", 4);
+
+    if (field != NULL) {
+        f = nxt_list_zero_add(r->fields);
+        if (nxt_slow_path(f == NULL)) {
+            return NXT_ERROR;
+        }
+
+        nxt_http_field_name_set(f, "If-None-Match");
+        f->value = field->value;
+        f->value_length = field->value_length;
+
+        r->if_none_match = f;
+    }
+
+    field = nxt_http_cache_entry_field(entry, "Last-Modified", 13);
+
+    if (field != NULL) {
+        f = nxt_list_zero_add(r->fields);
+        if (nxt_slow_path(f == NULL)) {
+            return NXT_ERROR;
+        }
+
+        nxt_http_field_name_set(f, "If-Modified-Since");
+        f->value = field->value;
+        f->value_length = field->value_length;
+
+        r->if_modified_since = f;
+    }
+
+    return (r->if_none_match != NULL || r->if_modified_since != NULL)
+           ? NXT_OK : NXT_DECLINED;
+}
+
+
+/*
+ * A request waits for the leader of its key if there is one, otherwise
+ * a GET request becomes the leader.  The stripe lock must be held.
+ */
+
+static nxt_int_t
+nxt_http_cache_collapse(nxt_http_cache_stripe_t *stripe,
+    nxt_http_cache_ctx_t *ctx, nxt_bool_t get)
+{
+    nxt_lvlhsh_query_t    lhq;
+    nxt_http_cache_ctx_t  *leader;
+
+    lhq.key = ctx->key;
+    lhq.key_hash = ctx->hash;
+    lhq.proto = &nxt_http_cache_pending_proto;
+    lhq.pool = NULL;
+
+    if (nxt_lvlhsh_find(&stripe->pending, &lhq) == NXT_OK) {
+        leader = lhq.value;
+
+        nxt_queue_insert_tail(&leader->waiters, &ctx->link);
+        ctx->waiting = 1;
+
+        return NXT_AGAIN;
+    }
+
+    if (get) {
+        lhq.replace = 0;
+        lhq.value = ctx;
+
+        if (nxt_fast_path(nxt_lvlhsh_insert(&stripe->pending, &lhq)
+                          == NXT_OK))
+        {
+            ctx->leader = 1;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * The handler runs in the engine of a waiting request: the request is
+ * either sent the response shared by the leader or processed as usual.
+ */
+
+static void
+nxt_http_cache_wake_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_int_t               ret;
+    nxt_http_action_t       *action;
+    nxt_http_request_t      *r;
+    nxt_http_cache_ctx_t    *ctx;
+    nxt_http_cache_entry_t  *entry;
+
+    r = obj;
+    ctx = data;
+
+    nxt_timer_delete(task->thread->engine, &ctx->timer);
+
+    entry = ctx->shared;
+    ctx->shared = NULL;
+
+    if (r->proto.any == NULL || r->error) {
+        if (entry != NULL) {
+            nxt_http_cache_entry_release(task, entry, NULL);
+        }
+
+        goto done;
+    }
+
+    if (entry != NULL) {
+        ret = nxt_mp_cleanup(r->mem_pool, nxt_http_cache_entry_release,
+                             task, entry, NULL);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            nxt_http_cache_entry_release(task, entry, NULL);
+            nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+            goto done;
+        }
+
+        nxt_debug(task, "http cache collapsed: \"%V\"", &ctx->key);
+
+        nxt_http_cache_send(task, r, entry);
+
+        goto done;
+    }
+
+    nxt_debug(task, "http cache miss: \"%V\"", &ctx->key);
+
+    if (nxt_str_eq(r->method, "GET", 3)) {
+        r->cache = ctx;
+    }
+
+    action = ctx->action->handler(task, r, ctx->action);
+
+    if (action == NXT_HTTP_ACTION_ERROR) {
+        nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+
+    } else if (action != NULL) {
+        nxt_http_request_action(task, r, action);
+    }
+
+done:
+
+    nxt_mp_release(r->mem_pool);
+}
+
+
+/*
+ * The handler runs in the engine of a waiting request if the leader
+ * has not responded in time: the request is removed from the queue
+ * and is processed as usual, but its response is not stored.
+ */
+
+static void
+nxt_http_cache_timeout_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_bool_t               waiting;
+    nxt_timer_t              *timer;
+    nxt_http_action_t        *action;
+    nxt_http_request_t       *r;
+    nxt_http_cache_ctx_t     *ctx;
+    nxt_http_cache_stripe_t  *stripe;
+
+    timer = obj;
+
+    ctx = nxt_timer_data(timer, nxt_http_cache_ctx_t, timer);
+    r = ctx->work.obj;
+
+    stripe = &ctx->cache->stripes[ctx->hash >> 28];
+
+    nxt_thread_spin_lock(&stripe->lock);
+
+    waiting = ctx->waiting;
+
+    if (waiting) {
+        ctx->waiting = 0;
+        nxt_queue_remove(&ctx->link);
+    }
+
+    nxt_thread_spin_unlock(&stripe->lock);
+
+    if (!waiting) {
+        /* The leader has already posted the wake up work. */
+        return;
+    }
+
+    task = &r->task;
+
+    if (r->proto.any == NULL || r->error) {
+        goto done;
+    }
+
+    nxt_log(task, NXT_LOG_INFO, "http cache collapse timeout: \"%V\"",
+            &ctx->key);
+
+    action = ctx->action->handler(task, r, ctx->action);
+
+    if (action == NXT_HTTP_ACTION_ERROR) {
+        nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+
+    } else if (action != NULL) {
+        nxt_http_request_action(task, r, action);
+    }
+
+done:
+
+    nxt_mp_release(r->mem_pool);
+}
+
+
+static void
+nxt_http_cache_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_entry_t *entry)
+{
+    nxt_int_t  ret;
+
+    ret = nxt_http_cache_response(task, r, entry);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+        return;
+    }
+
+    r->state = &nxt_http_cache_send_state;
+
+    if (entry->body_length == 0 || nxt_str_eq(r->method, "HEAD", 4)) {
+        nxt_http_request_header_send(task, r, NULL, NULL);
+        return;
+    }
+
+    nxt_http_request_header_send(task, r, nxt_http_cache_send_body, entry);
+}
+
+
+static nxt_int_t
+nxt_http_cache_response(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_entry_t *entry)
+{
+    u_char            *p;
+    nxt_uint_t        i;
+    nxt_time_t        age;
+    nxt_http_field_t  *f;
+
+    r->status = entry->status;
+
+    r->resp.fields = nxt_list_create(r->mem_pool, entry->nfields + 4,
+                                     sizeof(nxt_http_field_t));
+    if (nxt_slow_path(r->resp.fields == NULL)) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < entry->nfields; i++) {
+        f = nxt_list_add(r->resp.fields);
+        if (nxt_slow_path(f == NULL)) {
+            return NXT_ERROR;
+        }
+
+        *f = entry->fields[i];
+    }
+
+    f = nxt_list_zero_add(r->resp.fields);
+    if (nxt_slow_path(f == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_mp_nget(r->mem_pool, NXT_TIME_T_LEN);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    age = nxt_thread_time(task->thread) - entry->date;
+
+    nxt_http_field_name_set(f, "Age");
+    f->value = p;
+    f->value_length = nxt_sprintf(p, p + NXT_TIME_T_LEN, "%T",
+                                  nxt_max(age, 0))
+                      - p;
+
+    r->resp.date = NULL;
+    r->resp.content_type = NULL;
+    r->resp.content_length = NULL;
+    r->resp.content_length_n = entry->body_length;
+
+    return NXT_OK;
+}
+
+
+/* The body is sent from the entry held by the request. */
+
+static void
+nxt_http_cache_send_body(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t               *b;
+    nxt_http_request_t      *r;
+    nxt_http_cache_read_t   *read;
+    nxt_http_cache_entry_t  *entry;
+
+    r = obj;
+    entry = data;
+
+    if (entry->file.fd == -1) {
+        b = nxt_http_buf_mem(task, r, 0);
+        if (nxt_slow_path(b == NULL)) {
+            return;
+        }
+
+        b->mem.start = entry->body;
+        b->mem.pos = entry->body;
+        b->mem.free = entry->body + entry->body_length;
+        b->mem.end = b->mem.free;
+
+        b->next = nxt_http_buf_last(r);
+
+        nxt_http_request_send(task, r, b);
+        return;
+    }
+
+    if (nxt_http_cache_sendfile(r)) {
+        b = nxt_http_cache_file_buf(task, r, entry);
+        if (nxt_slow_path(b == NULL)) {
+            return;
+        }
+
+        b->next = nxt_http_buf_last(r);
+
+        nxt_http_request_send(task, r, b);
+        return;
+    }
+
+    /* The file is read in parts, the next part after the previous is sent. */
+
+    read = nxt_mp_get(r->mem_pool, sizeof(nxt_http_cache_read_t));
+    if (nxt_slow_path(read == NULL)) {
+        nxt_http_request_error_handler(task, r, r->proto.any);
+        return;
+    }
+
+    b = nxt_buf_mem_alloc(r->mem_pool,
+                          nxt_min(entry->body_length,
+                                  NXT_HTTP_CACHE_READ_SIZE),
+                          0);
+    if (nxt_slow_path(b == NULL)) {
+        nxt_http_request_error_handler(task, r, r->proto.any);
+        return;
+    }
+
+    read->request = r;
+    read->entry = entry;
+    read->pos = 0;
+
+    b->completion_handler = nxt_http_cache_read_handler;
+    b->parent = read;
+
+    nxt_mp_retain(r->mem_pool);
+
+    nxt_http_cache_read_handler(task, b, read);
+}
+
+
+/*
+ * The file is passed to the connection as is unless the connection
+ * encrypts in user space or the response is compressed.
+ */
+
+static nxt_bool_t
+nxt_http_cache_sendfile(nxt_http_request_t *r)
+{
+    if (r->compress != NULL || r->protocol != NXT_HTTP_PROTO_H1) {
+        return 0;
+    }
+
+#if (NXT_TLS)
+    if (r->tls && !r->sendfile) {
+        return 0;
+    }
+#endif
+
+    return 1;
+}
+
+
+static nxt_buf_t *
+nxt_http_cache_file_buf(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_entry_t *entry)
+{
+    nxt_buf_t  *b;
+
+    b = nxt_buf_file_alloc(r->mem_pool, 0, 0);
+    if (nxt_slow_path(b == NULL)) {
+        nxt_http_request_error_handler(task, r, r->proto.any);
+        return NULL;
+    }
+
+    b->file = &entry->file;
+    b->file_pos = 0;
+    b->file_end = entry->body_length;
+
+    b->completion_handler = nxt_http_cache_file_buf_completion;
+    b->parent = r;
+
+    nxt_mp_retain(r->mem_pool);
+
+    return b;
+}
+
+
+static void
+nxt_http_cache_file_buf_completion(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t           *b, *next;
+    nxt_http_request_t  *r;
+
+    r = data;
+
+    for (b = obj; b != NULL; b = next) {
+        next = b->next;
+
+        nxt_mp_free(r->mem_pool, b);
+        nxt_mp_release(r->mem_pool);
+    }
+}
+
+
+static void
+nxt_http_cache_read_handler(nxt_task_t *task, void *obj, void *data)
+{
+    size_t                  size;
+    ssize_t                 n;
+    nxt_buf_t               *b;
+    nxt_http_request_t      *r;
+    nxt_http_cache_read_t   *read;
+    nxt_http_cache_entry_t  *entry;
+
+    b = obj;
+    read = data;
+    r = read->request;
+    entry = read->entry;
+
+    if (r->error || read->pos == (nxt_off_t) entry->body_length) {
+        goto done;
+    }
+
+    size = nxt_min(entry->body_length - read->pos,
+                   (size_t) (b->mem.end - b->mem.start));
+
+    n = nxt_file_read(&entry->file, b->mem.start, size, read->pos);
+
+    if (nxt_slow_path(n != (ssize_t) size)) {
+        nxt_http_request_error_handler(task, r, r->proto.any);
+        goto done;
+    }
+
+    read->pos += n;
+
+    b->mem.pos = b->mem.start;
+    b->mem.free = b->mem.start + n;
+
+    b->next = (read->pos == (nxt_off_t) entry->body_length)
+              ? nxt_http_buf_last(r) : NULL;
+
+    nxt_http_request_send(task, r, b);
+
+    return;
+
+done:
+
+    nxt_mp_free(r->mem_pool, b);
+    nxt_mp_release(r->mem_pool);
+}
+
+
+/*
+ * The expired entry replaces the response to the revalidation request
+ * if it is "304 Not Modified", or an error response within "stale".
+ */
+
+static void
+nxt_http_cache_replay(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *ctx, nxt_time_t ttl)
+{
+    nxt_int_t                ret;
+    nxt_http_cache_entry_t   *entry;
+    nxt_http_cache_stripe_t  *stripe;
+
+    entry = ctx->stale;
+
+    nxt_debug(task, "http cache %s: \\"%V\\"",
+              (ttl != -1) ? "revalidated" : "stale", &ctx->key);
+
+    if (ttl > 0) {
+        stripe = entry->stripe;
+
+        nxt_thread_spin_lock(&stripe->lock);
+
+        entry->date = nxt_thread_time(task->thread);
+        entry->expires = entry->date + ttl;
+
+        nxt_thread_spin_unlock(&stripe->lock);
+    }
+
+    ret = nxt_http_cache_response(task, r, entry);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_http_cache_done(task, ctx, 0);
+        r->cache = NULL;
+        return;
+    }
+
+    ctx->replay = 1;
+
+    /* The collapsed requests are sent the same response. */
+
+    nxt_http_cache_done(task, ctx, 0);
+}
+
+
+/*
+ * The body of the action response is discarded,
+ * and the body of the entry is sent before the last buffer.
+ */
+
+static nxt_buf_t *
+nxt_http_cache_replay_body(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *ctx, nxt_buf_t *out)
+{
+    nxt_buf_t               *b, *next, *last, *drop, **prev;
+    nxt_http_cache_entry_t  *entry;
+
+    last = NULL;
+    drop = NULL;
+    prev = &drop;
+
+    for (b = out; b != NULL; b = next) {
+        next = b->next;
+        b->next = NULL;
+
+        if (nxt_buf_is_last(b)) {
+            last = b;
+            continue;
+        }
+
+        *prev = b;
+        prev = &b->next;
+    }
+
+    if (drop != NULL) {
+        nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, drop);
+    }
+
+    if (last == NULL) {
+        return NULL;
+    }
+
+    r->cache = NULL;
+
+    entry = ctx->stale;
+
+    if (entry->body_length == 0) {
+        return last;
+    }
+
+    if (entry->file.fd == -1) {
+        b = nxt_http_buf_mem(task, r, 0);
+        if (nxt_slow_path(b == NULL)) {
+            return NULL;
+        }
+
+        b->mem.start = entry->body;
+        b->mem.pos = entry->body;
+        b->mem.free = entry->body + entry->body_length;
+        b->mem.end = b->mem.free;
+
+    } else if (nxt_http_cache_sendfile(r)) {
+        b = nxt_http_cache_file_buf(task, r, entry);
+        if (nxt_slow_path(b == NULL)) {
+            return NULL;
+        }
+
+    } else {
+        /* Replaying is rare, so the file is read at once. */
+
+        b = nxt_http_buf_mem(task, r, entry->body_length);
+        if (nxt_slow_path(b == NULL)) {
+            return NULL;
+        }
+
+        if (nxt_file_read(&entry->file, b->mem.start, entry->body_length, 0)
+            != (ssize_t) entry->body_length)
+        {
+            nxt_http_request_error_handler(task, r, r->proto.any);
+            return NULL;
+        }
+
+        b->mem.free = b->mem.end;
+    }
+
+    b->next = last;
+
+    return b;
+}
+
+
+/*
+ * The response is stored before the header filters of the action, so
+ * the response header fields and compression are applied to each hit.
+ */
+
+void
+nxt_http_cache_header_filter(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_int_t             ret;
+    nxt_off_t             length;
+    nxt_time_t            ttl;
+    nxt_http_cache_ctx_t  *ctx;
+
+    ctx = r->cache;
+
+    if (ctx->stale != NULL) {
+        if (r->status == NXT_HTTP_NOT_MODIFIED && ctx->revalidate) {
+            ttl = nxt_http_cache_ttl(r, ctx->cache);
+
+            nxt_http_cache_replay(task, r, ctx, nxt_max(ttl, 0));
+            return;
+        }
+
+        switch (r->status) {
+
+        case NXT_HTTP_INTERNAL_SERVER_ERROR:
+        case NXT_HTTP_BAD_GATEWAY:
+        case NXT_HTTP_SERVICE_UNAVAILABLE:
+        case NXT_HTTP_GATEWAY_TIMEOUT:
+            if (ctx->stale->expires + ctx->cache->stale
+                > nxt_thread_time(task->thread))
+            {
+                nxt_http_cache_replay(task, r, ctx, -1);
+                return;
+            }
+
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    switch ((nxt_uint_t) r->status) {
+
+    case NXT_HTTP_OK:
+    case 203:
+    case NXT_HTTP_NO_CONTENT:
+    case NXT_HTTP_MOVED_PERMANENTLY:
+    case NXT_HTTP_PERMANENT_REDIRECT:
+    case NXT_HTTP_NOT_FOUND:
+    case 410:
+        break;
+
+    default:
+        goto bypass;
+    }
+
+    length = r->resp.content_length_n;
+
+    if (length == -1
+        && r->resp.content_length != NULL
+        && !r->resp.content_length->skip)
+    {
+        length = nxt_off_t_parse(r->resp.content_length->value,
+                                 r->resp.content_length->value_length);
+    }
+
+    if (length > (nxt_off_t) ctx->cache->max) {
+        goto bypass;
+    }
+
+    ttl = nxt_http_cache_ttl(r, ctx->cache);
+
+    if (ttl == -1) {
+        goto bypass;
+    }
+
+    /*
+     * A response without the freshness lifetime is not stored,
+     * but it is still shared with the collapsed requests.
+     */
+
+    if (ttl == 0 && !ctx->leader) {
+        goto bypass;
+    }
+
+    ctx->entry = nxt_http_cache_entry_create(r, ctx, ttl);
+    if (nxt_slow_path(ctx->entry == NULL)) {
+        goto bypass;
+    }
+
+    if (ctx->entry->size + length > ctx->cache->max) {
+        goto bypass;
+    }
+
+    if (ctx->cache->path.length != 0
+        && !ctx->cache->memory_only
+        && (length == -1 || length > NXT_HTTP_CACHE_BUF_SIZE))
+    {
+        ret = nxt_http_cache_file_create(task, ctx->cache, ctx->entry);
+
+        if (nxt_fast_path(ret == NXT_OK)) {
+            return;
+        }
+
+        if (nxt_slow_path(ret == NXT_ERROR)) {
+            goto bypass;
+        }
+
+        /* The body is stored in memory, see nxt_http_cache_file_create(). */
+    }
+
+    if (length > 0) {
+        ctx->entry->body = nxt_malloc(length);
+        if (nxt_slow_path(ctx->entry->body == NULL)) {
+            goto bypass;
+        }
+
+        ctx->capacity = length;
+    }
+
+    return;
+
+bypass:
+
+    nxt_http_cache_done(task, ctx, 0);
+
+    r->cache = NULL;
+}
+
+
+/*
+ * Returns the freshness lifetime of a response, 0 if it is not specified,
+ * or -1 if the response cannot be shared.
+ */
+
+static nxt_time_t
+nxt_http_cache_ttl(nxt_http_request_t *r, nxt_http_cache_t *cache)
+{
+    nxt_time_t        ttl, age;
+    nxt_http_field_t  *f;
+
+    ttl = cache->valid;
+
+    nxt_list_each(f, r->resp.fields) {
+
+        if (f->skip) {
+            continue;
+        }
+
+        if (f->name_length == nxt_length("Cache-Control")
+            && nxt_memcasecmp(f->name, "Cache-Control", f->name_length) == 0)
+        {
+            age = nxt_http_cache_control(f);
+
+            if (age == 0) {
+                return -1;
+            }
+
+            if (age > 0) {
+                ttl = age;
+            }
+
+        } else if ((f->name_length == nxt_length("Set-Cookie")
+                    && nxt_memcasecmp(f->name, "Set-Cookie", f->name_length)
+                       == 0)
+                   || (f->name_length == nxt_length("Vary")
+                       && nxt_memcasecmp(f->name, "Vary", f->name_length)
+                          == 0))
+        {
+            return -1;
+        }
+
+    } nxt_list_loop;
+
+    return nxt_max(ttl, 0);
+}
+
+
+/*
+ * Returns the max-age or the s-maxage value, 0 if the response must not
+ * be stored, or -1 if the freshness lifetime is not specified.
+ */
+
+static nxt_time_t
+nxt_http_cache_control(nxt_http_field_t *f)
+{
+    u_char      *p, *end, *start;
+    size_t      length;
+    nxt_int_t   n;
+    nxt_time_t  age, shared;
+
+    age = -1;
+    shared = -1;
+
+    p = f->value;
+    end = p + f->value_length;
+
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+            p++;
+        }
+
+        start = p;
+
+        while (p < end && *p != ',') {
+            p++;
+        }
+
+        length = p - start;
+
+        while (length > 0
+               && (start[length - 1] == ' ' || start[length - 1] == '\t'))
+        {
+            length--;
+        }
+
+        if ((length == nxt_length("no-store")
+             && nxt_memcasecmp(start, "no-store", length) == 0)
+            || (length == nxt_length("no-cache")
+                && nxt_memcasecmp(start, "no-cache", length) == 0)
+            || (length == nxt_length("private")
+                && nxt_memcasecmp(start, "private", length) == 0))
+        {
+            return 0;
+        }
+
+        if (length > nxt_length("max-age=")
+            && nxt_memcasecmp(start, "max-age=", nxt_length("max-age=")) == 0)
+        {
+            n = nxt_int_parse(start + nxt_length("max-age="),
+                              length - nxt_length("max-age="));
+            age = nxt_max(n, 0);
+
+        } else if (length > nxt_length("s-maxage=")
+                   && nxt_memcasecmp(start, "s-maxage=",
+                                     nxt_length("s-maxage=")) == 0)
+        {
+            n = nxt_int_parse(start + nxt_length("s-maxage="),
+                              length - nxt_length("s-maxage="));
+            shared = nxt_max(n, 0);
+        }
+    }
+
+    return (shared != -1) ? shared : age;
+}
+
+
+static nxt_int_t
+nxt_http_cache_file_create(nxt_task_t *task, nxt_http_cache_t *cache,
+    nxt_http_cache_entry_t *entry)
+{
+    u_char     *name, *p;
+    nxt_err_t  err;
+
+    static const nxt_str_t  pattern = nxt_string("/cache-XXXXXXXX");
+
+    name = nxt_malloc(cache->path.length + pattern.length + 1);
+    if (nxt_slow_path(name == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_cpymem(name, cache->path.start, cache->path.length);
+    p = nxt_cpymem(p, pattern.start, pattern.length);
+    *p = '\0';
+
+    entry->file.fd = mkstemp((char *) name);
+
+    if (nxt_slow_path(entry->file.fd == -1)) {
+        err = nxt_errno;
+
+        /*
+         * The cache falls back to memory until it is reconfigured,
+         * so the failure is reported only once.
+         */
+
+        if (nxt_atomic_cmp_set(&cache->memory_only, 0, 1)) {
+            nxt_alert(task, "mkstemp(%s) failed %E, responses are "
+                      "cached in memory only", name, err);
+        }
+
+        nxt_free(name);
+
+        return NXT_DECLINED;
+    }
+
+    nxt_debug(task, "create cache file \"%s\", %d", name, entry->file.fd);
+
+    (void) unlink((char *) name);
+
+    nxt_free(name);
+
+    entry->file.name = (nxt_file_name_t *) cache->path.start;
+
+    return NXT_OK;
+}
+
+
+static nxt_http_cache_entry_t *
+nxt_http_cache_entry_create(nxt_http_request_t *r, nxt_http_cache_ctx_t *ctx,
+    nxt_time_t ttl)
+{
+    u_char                  *p;
+    size_t                  size;
+    nxt_uint_t              n;
+    nxt_http_field_t        *f, *field;
+    nxt_http_cache_entry_t  *entry;
+
+    /* The fields added for each response are not stored. */
+
+    n = 0;
+    size = sizeof(nxt_http_cache_entry_t) + ctx->key.length;
+
+    nxt_list_each(f, r->resp.fields) {
+
+        if (f->skip || f->hopbyhop || f == r->resp.date
+            || f == r->resp.content_length)
+        {
+            continue;
+        }
+
+        n++;
+        size += sizeof(nxt_http_field_t) + f->name_length + f->value_length;
+
+    } nxt_list_loop;
+
+    entry = nxt_malloc(size);
+    if (nxt_slow_path(entry == NULL)) {
+        return NULL;
+    }
+
+    nxt_memzero(entry, sizeof(nxt_http_cache_entry_t));
+
+    entry->file.fd = -1;
+
+    entry->size = size;
+    entry->hash = ctx->hash;
+    entry->count = 1;
+    entry->date = nxt_thread_time(r->task.thread);
+    entry->expires = entry->date + ttl;
+    entry->status = r->status;
+    entry->nfields = n;
+    entry->fields = (nxt_http_field_t *) (entry + 1);
+
+    p = (u_char *) &entry->fields[n];
+
+    entry->key.start = p;
+    entry->key.length = ctx->key.length;
+    p = nxt_cpymem(p, ctx->key.start, ctx->key.length);
+
+    field = entry->fields;
+
+    nxt_list_each(f, r->resp.fields) {
+
+        if (f->skip || f->hopbyhop || f == r->resp.date
+            || f == r->resp.content_length)
+        {
+            continue;
+        }
+
+        *field = *f;
+
+        field->name = p;
+        p = nxt_cpymem(p, f->name, f->name_length);
+
+        field->value = p;
+        p = nxt_cpymem(p, f->value, f->value_length);
+
+        field++;
+
+    } nxt_list_loop;
+
+    return entry;
+}
+
+
+nxt_buf_t *
+nxt_http_cache_body_filter(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *out)
+{
+    nxt_buf_t             *b;
+    nxt_http_cache_ctx_t  *ctx;
+
+    ctx = r->cache;
+
+    if (ctx->replay) {
+        return nxt_http_cache_replay_body(task, r, ctx, out);
+    }
+
+    for (b = out; b != NULL; b = b->next) {
+
+        if (nxt_buf_is_last(b)) {
+            nxt_http_cache_done(task, ctx, !r->error);
+
+            r->cache = NULL;
+            break;
+        }
+
+        if (nxt_http_cache_body_add(ctx, b) != NXT_OK) {
+            nxt_debug(task, "http cache store failed: \"%V\"", &ctx->key);
+
+            nxt_http_cache_done(task, ctx, 0);
+
+            r->cache = NULL;
+            break;
+        }
+    }
+
+    return out;
+}
+
+
+static nxt_int_t
+nxt_http_cache_body_add(nxt_http_cache_ctx_t *ctx, nxt_buf_t *b)
+{
+    u_char                  *p;
+    size_t                  size, capacity;
+    ssize_t                 n;
+    nxt_http_cache_entry_t  *entry;
+
+    if (nxt_buf_is_sync(b)) {
+        return NXT_OK;
+    }
+
+    if (nxt_buf_is_file(b)) {
+        size = b->file_end - b->file_pos;
+
+    } else {
+        size = nxt_buf_mem_used_size(&b->mem);
+    }
+
+    entry = ctx->entry;
+
+    if (entry->size + entry->body_length + size > ctx->cache->max) {
+        return NXT_DECLINED;
+    }
+
+    if (entry->file.fd != -1) {
+        return nxt_http_cache_body_write(entry, b, size);
+    }
+
+    if (entry->body_length + size > ctx->capacity) {
+        capacity = nxt_max(ctx->capacity * 2, NXT_HTTP_CACHE_BUF_SIZE);
+        capacity = nxt_max(capacity, entry->body_length + size);
+
+        p = nxt_realloc(entry->body, capacity);
+        if (nxt_slow_path(p == NULL)) {
+            return NXT_ERROR;
+        }
+
+        entry->body = p;
+        ctx->capacity = capacity;
+    }
+
+    p = entry->body + entry->body_length;
+
+    if (nxt_buf_is_file(b)) {
+        n = nxt_file_read(b->file, p, size, b->file_pos);
+
+        if (nxt_slow_path(n != (ssize_t) size)) {
+            return NXT_ERROR;
+        }
+
+    } else {
+        nxt_memcpy(p, b->mem.pos, size);
+    }
+
+    entry->body_length += size;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_cache_body_write(nxt_http_cache_entry_t *entry, nxt_buf_t *b,
+    size_t size)
+{
+    size_t     n;
+    ssize_t    ret;
+    nxt_off_t  pos;
+    u_char     buf[NXT_HTTP_CACHE_BUF_SIZE];
+
+    if (!nxt_buf_is_file(b)) {
+        ret = nxt_file_write(&entry->file, b->mem.pos, size,
+                             entry->body_length);
+        if (nxt_slow_path(ret != (ssize_t) size)) {
+            return NXT_ERROR;
+        }
+
+        entry->body_length += size;
+
+        return NXT_OK;
+    }
+
+    pos = b->file_pos;
+
+    while (size != 0) {
+        n = nxt_min(size, sizeof(buf));
+
+        ret = nxt_file_read(b->file, buf, n, pos);
+        if (nxt_slow_path(ret != (ssize_t) n)) {
+            return NXT_ERROR;
+        }
+
+        ret = nxt_file_write(&entry->file, buf, n, entry->body_length);
+        if (nxt_slow_path(ret != (ssize_t) n)) {
+            return NXT_ERROR;
+        }
+
+        pos += n;
+        size -= n;
+        entry->body_length += n;
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * Stores the response if it is fresh and hands it to the collapsed
+ * requests, or wakes them up to be processed as usual otherwise.
+ */
+
+static void
+nxt_http_cache_done(nxt_task_t *task, nxt_http_cache_ctx_t *ctx,
+    nxt_bool_t store)
+{
+    uint32_t                 count;
+    nxt_bool_t               stored;
+    nxt_queue_t              waiters;
+    nxt_lvlhsh_query_t       lhq;
+    nxt_http_cache_ctx_t     *waiter;
+    nxt_http_cache_entry_t   *entry, *shared;
+    nxt_http_cache_stripe_t  *stripe;
+
+    entry = ctx->entry;
+    ctx->entry = NULL;
+
+    if (entry != NULL && !store) {
+        nxt_http_cache_entry_free(entry);
+        entry = NULL;
+    }
+
+    if (entry == NULL && !ctx->leader) {
+        return;
+    }
+
+    shared = (ctx->replay) ? ctx->stale : entry;
+
+    stripe = &ctx->cache->stripes[ctx->hash >> 28];
+
+    if (entry != NULL) {
+        entry->stripe = stripe;
+        entry->size += entry->body_length;
+    }
+
+    nxt_queue_init(&waiters);
+
+    stored = 0;
+    count = 0;
+
+    nxt_thread_spin_lock(&stripe->lock);
+
+    if (entry != NULL && entry->expires > nxt_thread_time(task->thread)) {
+        stored = nxt_http_cache_insert(stripe, entry, ctx->cache->max);
+    }
+
+    if (ctx->leader) {
+        ctx->leader = 0;
+
+        lhq.key = ctx->key;
+        lhq.key_hash = ctx->hash;
+        lhq.proto = &nxt_http_cache_pending_proto;
+        lhq.pool = NULL;
+
+        (void) nxt_lvlhsh_delete(&stripe->pending, &lhq);
+
+        if (!nxt_queue_is_empty(&ctx->waiters)) {
+            nxt_queue_add(&waiters, &ctx->waiters);
+        }
+
+        nxt_queue_each(waiter, &waiters, nxt_http_cache_ctx_t, link) {
+
+            waiter->waiting = 0;
+            waiter->shared = shared;
+
+            if (shared != NULL) {
+                shared->count++;
+            }
+
+        } nxt_queue_loop;
+    }
+
+    if (entry != NULL && !stored) {
+        count = --entry->count;
+    }
+
+    nxt_thread_spin_unlock(&stripe->lock);
+
+    if (entry != NULL && !stored && count == 0) {
+        nxt_http_cache_entry_free(entry);
+    }
+
+    /* A woken request may be freed before its link is used. */
+
+    nxt_queue_each(waiter, &waiters, nxt_http_cache_ctx_t, link) {
+
+        nxt_event_engine_post(waiter->engine, &waiter->work);
+
+    } nxt_queue_loop;
+}
+
+
+/* The stripe lock must be held. */
+
+static nxt_bool_t
+nxt_http_cache_insert(nxt_http_cache_stripe_t *stripe,
+    nxt_http_cache_entry_t *entry, size_t max)
+{
+    nxt_int_t               ret;
+    nxt_queue_link_t        *link;
+    nxt_lvlhsh_query_t      lhq;
+    nxt_http_cache_entry_t  *old;
+
+    lhq.key = entry->key;
+    lhq.key_hash = entry->hash;
+    lhq.replace = 1;
+    lhq.value = entry;
+    lhq.proto = &nxt_http_cache_hash_proto;
+    lhq.pool = NULL;
+
+    ret = nxt_lvlhsh_insert(&stripe->hash, &lhq);
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return 0;
+    }
+
+    if (lhq.value != entry) {
+        /* A response stored concurrently is replaced. */
+
+        old = lhq.value;
+
+        nxt_queue_remove(&old->link);
+        stripe->size -= old->size;
+
+        if (--old->count == 0) {
+            nxt_http_cache_entry_free(old);
+        }
+    }
+
+    nxt_queue_insert_head(&stripe->lru, &entry->link);
+    stripe->size += entry->size;
+
+    while (stripe->size > max) {
+        link = nxt_queue_last(&stripe->lru);
+        old = nxt_queue_link_data(link, nxt_http_cache_entry_t, link);
+
+        nxt_http_cache_entry_unlink(stripe, old);
+    }
+
+    return 1;
+}
+
+
+/* The stripe lock must be held. */
+
+static void
+nxt_http_cache_entry_unlink(nxt_http_cache_stripe_t *stripe,
+    nxt_http_cache_entry_t *entry)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key = entry->key;
+    lhq.key_hash = entry->hash;
+    lhq.proto = &nxt_http_cache_hash_proto;
+    lhq.pool = NULL;
+
+    (void) nxt_lvlhsh_delete(&stripe->hash, &lhq);
+
+    nxt_queue_remove(&entry->link);
+    stripe->size -= entry->size;
+
+    if (--entry->count == 0) {
+        nxt_http_cache_entry_free(entry);
+    }
+}
+
+
+static void
+nxt_http_cache_entry_release(nxt_task_t *task, void *obj, void *data)
+{
+    uint32_t                 count;
+    nxt_http_cache_entry_t   *entry;
+    nxt_http_cache_stripe_t  *stripe;
+
+    entry = obj;
+    stripe = entry->stripe;
+
+    nxt_thread_spin_lock(&stripe->lock);
+
+    count = --entry->count;
+
+    nxt_thread_spin_unlock(&stripe->lock);
+
+    if (count == 0) {
+        nxt_http_cache_entry_free(entry);
+    }
+}
+
+
+static void
+nxt_http_cache_entry_free(nxt_http_cache_entry_t *entry)
+{
+    if (entry->body != NULL) {
+        nxt_free(entry->body);
+    }
+
+    if (entry->file.fd != -1) {
+        nxt_fd_close(entry->file.fd);
+    }
+
+    nxt_free(entry);
+}
+
+
+static nxt_http_field_t *
+nxt_http_cache_entry_field(nxt_http_cache_entry_t *entry, const char *name,
+    size_t length)
+{
+    nxt_uint_t        i;
+    nxt_http_field_t  *f;
+
+    for (i = 0; i < entry->nfields; i++) {
+        f = &entry->fields[i];
+
+        if (f->name_length == length
+            && nxt_memcasecmp(f->name, name, length) == 0)
+        {
+            return f;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void
+nxt_http_cache_ctx_cleanup(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_cache_ctx_t  *ctx;
+
+    ctx = obj;
+
+    /* The collapsed requests are woken up if the response is incomplete. */
+
+    nxt_http_cache_done(task, ctx, 0);
+
+    if (ctx->stale != NULL) {
+        nxt_http_cache_entry_release(task, ctx->stale, NULL);
+    }
+}
+
+
+static void
+nxt_http_cache_cleanup(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_uint_t               i;
+    nxt_http_cache_t         *cache;
+    nxt_http_cache_entry_t   *entry;
+    nxt_http_cache_stripe_t  *stripe;
+
+    cache = obj;
+
+    /* The requests holding entries hold the configuration as well. */
+
+    for (i = 0; i < NXT_HTTP_CACHE_STRIPES; i++) {
+        stripe = &cache->stripes[i];
+
+        nxt_queue_each(entry, &stripe->lru, nxt_http_cache_entry_t, link) {
+
+            nxt_http_cache_entry_unlink(stripe, entry);
+
+        } nxt_queue_loop;
+    }
+}
+
+
+static nxt_int_t
+nxt_http_cache_hash_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_http_cache_entry_t  *entry;
+
+    entry = data;
+
+    if (nxt_strstr_eq(&lhq->key, &entry->key)) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+static nxt_int_t
+nxt_http_cache_pending_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_http_cache_ctx_t  *ctx;
+
+    ctx = data;
+
+    if (nxt_strstr_eq(&lhq->key, &ctx->key)) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
@@ -0,0 +1,1286 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+
+#if (NXT_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#if (NXT_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+#if (NXT_HAVE_BROTLI)
+#include <brotli/encode.h>
+#endif
+
+
+#define NXT_HTTP_COMPRESS_ENCODINGS    4
+#define NXT_HTTP_COMPRESS_BUF_SIZE     (16 * 1024)
+
+/*
+ * Larger batches of a response body are compressed by the router
+ * thread pool to not block the event engine.
+ */
+#define NXT_HTTP_COMPRESS_THREAD_SIZE  (64 * 1024)
+
+
+typedef struct {
+    nxt_str_t                  name;
+    nxt_int_t                  (*init)(nxt_http_compress_t *ctx,
+                                   nxt_int_t level);
+    nxt_int_t                  (*compress)(nxt_http_compress_t *ctx,
+                                   u_char *in, size_t size, nxt_bool_t last);
+    void                       (*free)(nxt_http_compress_t *ctx);
+    int                        window_bits;
+} nxt_http_compress_encoder_t;
+
+
+struct nxt_http_compress_conf_s {
+    const nxt_http_compress_encoder_t  *encoders[NXT_HTTP_COMPRESS_ENCODINGS];
+    nxt_uint_t                         nencoders;
+    nxt_int_t                          level;
+    nxt_off_t                          min_length;
+    nxt_http_route_rule_t              *types;
+};
+
+
+typedef struct {
+    nxt_conf_value_t           *encodings;
+    nxt_int_t                  level;
+    nxt_off_t                  min_length;
+    nxt_conf_value_t           *types;
+} nxt_http_compress_conf_map_t;
+
+
+/*
+ * The compressed data buffers are allocated with nxt_malloc(), since
+ * they may be allocated by a thread pool thread.  The consumed source
+ * buffers are completed once the data compressed from them is sent.
+ */
+
+typedef struct {
+    nxt_buf_t                  buf;
+    nxt_buf_t                  *in;
+} nxt_http_compress_buf_t;
+
+
+struct nxt_http_compress_s {
+    const nxt_http_compress_encoder_t  *encoder;
+
+    union {
+#if (NXT_HAVE_ZLIB)
+        z_stream                       zlib;
+#endif
+#if (NXT_HAVE_ZSTD)
+        ZSTD_CCtx                      *zstd;
+#endif
+#if (NXT_HAVE_BROTLI)
+        BrotliEncoderState             *brotli;
+#endif
+        void                           *any;
+    } u;
+
+    nxt_http_request_t                 *request;
+    nxt_event_engine_t                 *engine;
+
+    nxt_buf_t                          *in;
+    nxt_buf_t                          *batch;
+    nxt_buf_t                          *last;
+
+    nxt_buf_t                          *out;
+    nxt_buf_t                          **tail;
+    nxt_buf_t                          *buf;
+
+    nxt_work_t                         work;
+
+    uint8_t                            ready;   /* 1 bit */
+    uint8_t                            busy;    /* 1 bit */
+    uint8_t                            finish;  /* 1 bit */
+    uint8_t                            done;    /* 1 bit */
+    uint8_t                            error;   /* 1 bit */
+};
+
+
+static const nxt_http_compress_encoder_t *nxt_http_compress_encoder(
+    nxt_str_t *name);
+static const nxt_http_compress_encoder_t *nxt_http_compress_negotiate(
+    nxt_http_compress_conf_t *conf, nxt_http_field_t *field);
+static nxt_int_t nxt_http_compress_quality(u_char **pos, u_char *end);
+static nxt_int_t nxt_http_compress_etag(nxt_http_request_t *r,
+    nxt_http_field_t *etag);
+static void nxt_http_compress_process(nxt_task_t *task,
+    nxt_http_compress_t *ctx);
+static void nxt_http_compress_thread(nxt_task_t *task, void *obj, void *data);
+static void nxt_http_compress_done(nxt_task_t *task, void *obj, void *data);
+static void nxt_http_compress_run(nxt_http_compress_t *ctx);
+static void nxt_http_compress_output(nxt_task_t *task,
+    nxt_http_compress_t *ctx);
+static nxt_buf_t *nxt_http_compress_buf(nxt_http_compress_t *ctx);
+static void nxt_http_compress_buf_free(nxt_buf_t *b);
+static void nxt_http_compress_buf_completion(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_compress_finish(nxt_http_compress_t *ctx);
+static void nxt_http_compress_cleanup(nxt_task_t *task, void *obj,
+    void *data);
+
+#if (NXT_HAVE_ZLIB)
+static nxt_int_t nxt_http_compress_zlib_init(nxt_http_compress_t *ctx,
+    nxt_int_t level);
+static nxt_int_t nxt_http_compress_zlib(nxt_http_compress_t *ctx, u_char *in,
+    size_t size, nxt_bool_t last);
+static void nxt_http_compress_zlib_free(nxt_http_compress_t *ctx);
+#endif
+
+#if (NXT_HAVE_ZSTD)
+static nxt_int_t nxt_http_compress_zstd_init(nxt_http_compress_t *ctx,
+    nxt_int_t level);
+static nxt_int_t nxt_http_compress_zstd(nxt_http_compress_t *ctx, u_char *in,
+    size_t size, nxt_bool_t last);
+static void nxt_http_compress_zstd_free(nxt_http_compress_t *ctx);
+#endif
+
+#if (NXT_HAVE_BROTLI)
+static nxt_int_t nxt_http_compress_brotli_init(nxt_http_compress_t *ctx,
+    nxt_int_t level);
+static nxt_int_t nxt_http_compress_brotli(nxt_http_compress_t *ctx,
+    u_char *in, size_t size, nxt_bool_t last);
+static void nxt_http_compress_brotli_free(nxt_http_compress_t *ctx);
+#endif
+
+
+static const nxt_http_compress_encoder_t  nxt_http_compress_encoders[] = {
+#if (NXT_HAVE_ZLIB)
+    {
+        nxt_string("gzip"),
+        nxt_http_compress_zlib_init,
+        nxt_http_compress_zlib,
+        nxt_http_compress_zlib_free,
+        MAX_WBITS + 16,
+    },
+    {
+        nxt_string("deflate"),
+        nxt_http_compress_zlib_init,
+        nxt_http_compress_zlib,
+        nxt_http_compress_zlib_free,
+        MAX_WBITS,
+    },
+#endif
+#if (NXT_HAVE_ZSTD)
+    {
+        nxt_string("zstd"),
+        nxt_http_compress_zstd_init,
+        nxt_http_compress_zstd,
+        nxt_http_compress_zstd_free,
+        0,
+    },
+#endif
+#if (NXT_HAVE_BROTLI)
+    {
+        nxt_string("br"),
+        nxt_http_compress_brotli_init,
+        nxt_http_compress_brotli,
+        nxt_http_compress_brotli_free,
+        0,
+    },
+#endif
+    {
+        nxt_null_string, NULL, NULL, NULL, 0,
+    },
+};
+
+
+static nxt_conf_map_t  nxt_http_compress_conf[] = {
+    {
+        nxt_string("encodings"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_compress_conf_map_t, encodings)
+    },
+    {
+        nxt_string("level"),
+        NXT_CONF_MAP_INT,
+        offsetof(nxt_http_compress_conf_map_t, level)
+    },
+    {
+        nxt_string("min_length"),
+        NXT_CONF_MAP_OFF,
+        offsetof(nxt_http_compress_conf_map_t, min_length)
+    },
+    {
+        nxt_string("types"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_compress_conf_map_t, types)
+    },
+};
+
+
+nxt_int_t
+nxt_http_compress_init(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf)
+{
+    action->compress = nxt_http_compress_conf_create(task, rtcf->mem_pool,
+                                                     acf->compress);
+    if (nxt_slow_path(action->compress == NULL)) {
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+nxt_http_compress_conf_t *
+nxt_http_compress_conf_create(nxt_task_t *task, nxt_mp_t *mp,
+    nxt_conf_value_t *cv)
+{
+    nxt_int_t                     ret;
+    nxt_str_t                     name;
+    nxt_uint_t                    i, n;
+    nxt_conf_value_t              *value;
+    nxt_http_compress_conf_t      *conf;
+    nxt_http_compress_conf_map_t  map;
+
+    static nxt_str_t  default_types = nxt_string(
+        "[\"text/*\", \"application/javascript\", \"application/json\","
+        " \"application/xml\", \"image/svg+xml\"]");
+
+    conf = nxt_mp_zget(mp, sizeof(nxt_http_compress_conf_t));
+    if (nxt_slow_path(conf == NULL)) {
+        return NULL;
+    }
+
+    /* The "false" value disables compression inherited from settings. */
+
+    if (nxt_conf_type(cv) == NXT_CONF_BOOLEAN && !nxt_conf_get_boolean(cv)) {
+        return conf;
+    }
+
+    map.encodings = NULL;
+    map.level = 1;
+    map.min_length = 20;
+    map.types = NULL;
+
+    if (nxt_conf_type(cv) == NXT_CONF_OBJECT) {
+        ret = nxt_conf_map_object(mp, cv, nxt_http_compress_conf,
+                                  nxt_nitems(nxt_http_compress_conf), &map);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NULL;
+        }
+    }
+
+    conf->level = map.level;
+    conf->min_length = map.min_length;
+
+    if (map.encodings == NULL) {
+        conf->encoders[0] = &nxt_http_compress_encoders[0];
+        conf->nencoders = (conf->encoders[0]->name.length != 0);
+
+    } else {
+        n = nxt_conf_array_elements_count_or_1(map.encodings);
+
+        for (i = 0; i < n && i < NXT_HTTP_COMPRESS_ENCODINGS; i++) {
+            value = nxt_conf_get_array_element_or_itself(map.encodings, i);
+            nxt_conf_get_string(value, &name);
+
+            conf->encoders[i] = nxt_http_compress_encoder(&name);
+            if (nxt_slow_path(conf->encoders[i] == NULL)) {
+                return NULL;
+            }
+        }
+
+        conf->nencoders = i;
+    }
+
+    if (map.types == NULL) {
+        map.types = nxt_conf_json_parse_str(mp, &default_types);
+        if (nxt_slow_path(map.types == NULL)) {
+            return NULL;
+        }
+    }
+
+    conf->types = nxt_http_route_types_rule_create(task, mp, map.types);
+    if (nxt_slow_path(conf->types == NULL)) {
+        return NULL;
+    }
+
+    return conf;
+}
+
+
+nxt_bool_t
+nxt_http_compress_encoding(nxt_str_t *name)
+{
+    return (nxt_http_compress_encoder(name) != NULL);
+}
+
+
+static const nxt_http_compress_encoder_t *
+nxt_http_compress_encoder(nxt_str_t *name)
+{
+    const nxt_http_compress_encoder_t  *encoder;
+
+    for (encoder = nxt_http_compress_encoders;
+         encoder->name.length != 0;
+         encoder++)
+    {
+        if (nxt_strstr_eq(name, &encoder->name)) {
+            return encoder;
+        }
+    }
+
+    return NULL;
+}
+
+
+nxt_int_t
+nxt_http_compress_header_filter(nxt_task_t *task, nxt_http_request_t *r)
+{
+    u_char                             *p, *end;
+    nxt_int_t                          ret;
+    nxt_off_t                          length;
+    nxt_http_field_t                   *f, *type, *etag, *ranges;
+    nxt_http_compress_t                *ctx;
+    nxt_http_compress_conf_t           *conf;
+    const nxt_http_compress_encoder_t  *encoder;
+
+    if (r->action != NULL && r->action->compress != NULL) {
+        conf = r->action->compress;
+
+    } else {
+        conf = r->conf->socket_conf->router_conf->compress;
+    }
+
+    if (conf == NULL
+        || conf->nencoders == 0
+        || r->status != NXT_HTTP_OK
+        || r->accept_encoding == NULL
+        || nxt_str_eq(r->method, "HEAD", 4))
+    {
+        return NXT_OK;
+    }
+
+    length = r->resp.content_length_n;
+
+    if (length == -1
+        && r->resp.content_length != NULL
+        && !r->resp.content_length->skip)
+    {
+        length = nxt_off_t_parse(r->resp.content_length->value,
+                                 r->resp.content_length->value_length);
+    }
+
+    if (length >= 0 && length < conf->min_length) {
+        return NXT_OK;
+    }
+
+    type = NULL;
+    etag = NULL;
+    ranges = NULL;
+
+    nxt_list_each(f, r->resp.fields) {
+
+        if (f->skip) {
+            continue;
+        }
+
+        switch (f->name_length) {
+
+        case nxt_length("ETag"):
+            if (nxt_memcasecmp(f->name, "ETag", f->name_length) == 0) {
+                etag = f;
+            }
+
+            break;
+
+        case nxt_length("Content-Type"):
+            if (nxt_memcasecmp(f->name, "Content-Type", f->name_length) == 0) {
+                type = f;
+            }
+
+            break;
+
+        case nxt_length("Accept-Ranges"):
+            if (nxt_memcasecmp(f->name, "Accept-Ranges", f->name_length) == 0)
+            {
+                ranges = f;
+
+            } else if (nxt_memcasecmp(f->name, "Cache-Control",
+                                      f->name_length) == 0
+                       && nxt_memcasestrn(f->value,
+                                          f->value + f->value_length,
+                                          "no-transform",
+                                          nxt_length("no-transform"))
+                          != NULL)
+            {
+                return NXT_OK;
+            }
+
+            break;
+
+        case nxt_length("Content-Encoding"):
+            if (nxt_memcasecmp(f->name, "Content-Encoding", f->name_length)
+                == 0)
+            {
+                return NXT_OK;
+            }
+
+            break;
+        }
+
+    } nxt_list_loop;
+
+    if (type == NULL) {
+        return NXT_OK;
+    }
+
+    /* Parameters like "charset" are not matched. */
+
+    p = type->value;
+    end = memchr(p, ';', type->value_length);
+
+    if (end == NULL) {
+        end = p + type->value_length;
+    }
+
+    while (end > p && (end[-1] == ' ' || end[-1] == '\t')) {
+        end--;
+    }
+
+    ret = nxt_http_route_test_rule(r, conf->types, p, end - p);
+    if (nxt_slow_path(ret == NXT_ERROR)) {
+        return NXT_ERROR;
+    }
+
+    if (ret == 0) {
+        return NXT_OK;
+    }
+
+    encoder = nxt_http_compress_negotiate(conf, r->accept_encoding);
+    if (encoder == NULL) {
+        return NXT_OK;
+    }
+
+    ctx = nxt_mp_zget(r->mem_pool, sizeof(nxt_http_compress_t));
+    if (nxt_slow_path(ctx == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ctx->encoder = encoder;
+    ctx->request = r;
+    ctx->tail = &ctx->out;
+
+    ret = nxt_mp_cleanup(r->mem_pool, nxt_http_compress_cleanup, &r->task,
+                         ctx, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    ret = encoder->init(ctx, conf->level);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_alert(task, "%V compression initialization failed",
+                  &encoder->name);
+        return NXT_ERROR;
+    }
+
+    ctx->ready = 1;
+
+    f = nxt_list_zero_add(r->resp.fields);
+    if (nxt_slow_path(f == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_http_field_name_set(f, "Content-Encoding");
+    f->value = encoder->name.start;
+    f->value_length = encoder->name.length;
+
+    f = nxt_list_zero_add(r->resp.fields);
+    if (nxt_slow_path(f == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_http_field_set(f, "Vary", "Accept-Encoding");
+
+    if (etag != NULL) {
+        ret = nxt_http_compress_etag(r, etag);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+    }
+
+    if (ranges != NULL) {
+        ranges->skip = 1;
+    }
+
+    if (r->resp.content_length != NULL) {
+        r->resp.content_length->skip = 1;
+    }
+
+    r->resp.content_length_n = -1;
+
+    r->compress = ctx;
+
+    nxt_debug(task, "http compress: %V", &encoder->name);
+
+    return NXT_OK;
+}
+
+
+/*
+ * The first encoding of the configured ones with the highest quality
+ * in the "Accept-Encoding" header field is selected.
+ */
+
+static const nxt_http_compress_encoder_t *
+nxt_http_compress_negotiate(nxt_http_compress_conf_t *conf,
+    nxt_http_field_t *field)
+{
+    nxt_int_t                          best;
+    nxt_uint_t                         i;
+    nxt_str_t                          names[NXT_HTTP_COMPRESS_ENCODINGS];
+    const nxt_http_compress_encoder_t  *selected;
+    nxt_int_t                          quality[NXT_HTTP_COMPRESS_ENCODINGS];
+
+    for (i = 0; i < conf->nencoders; i++) {
+        names[i] = conf->encoders[i]->name;
+    }
+
+    nxt_http_compress_accept(field, names, quality, conf->nencoders);
+
+    selected = NULL;
+    best = 0;
+
+    for (i = 0; i < conf->nencoders; i++) {
+        if (quality[i] > best) {
+            best = quality[i];
+            selected = conf->encoders[i];
+        }
+    }
+
+    return selected;
+}
+
+
+/*
+ * The Accept-Encoding quality values of the names are set in thousandths,
+ * zero means that the encoding is not acceptable.
+ */
+
+void
+nxt_http_compress_accept(nxt_http_field_t *field, nxt_str_t *names,
+    nxt_int_t *quality, nxt_uint_t n)
+{
+    u_char      *p, *end, *name;
+    size_t      length;
+    nxt_int_t   q, any;
+    nxt_uint_t  i;
+
+    for (i = 0; i < n; i++) {
+        quality[i] = -1;
+    }
+
+    any = -1;
+
+    p = field->value;
+    end = p + field->value_length;
+
+    while (p < end) {
+
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+            p++;
+        }
+
+        name = p;
+
+        while (p < end
+               && *p != ',' && *p != ';' && *p != ' ' && *p != '\t')
+        {
+            p++;
+        }
+
+        length = p - name;
+
+        q = nxt_http_compress_quality(&p, end);
+
+        if (length == 1 && *name == '*') {
+            any = q;
+            continue;
+        }
+
+        for (i = 0; i < n; i++) {
+            if (length == names[i].length
+                && nxt_memcasecmp(name, names[i].start, length) == 0)
+            {
+                quality[i] = q;
+            }
+        }
+    }
+
+    for (i = 0; i < n; i++) {
+        if (quality[i] == -1) {
+            quality[i] = nxt_max(any, 0);
+        }
+    }
+}
+
+
+/* The quality value is returned in thousandths. */
+
+static nxt_int_t
+nxt_http_compress_quality(u_char **pos, u_char *end)
+{
+    u_char     *p;
+    nxt_int_t  q, scale;
+
+    p = *pos;
+    q = 1000;
+
+    while (p < end && *p != ',') {
+
+        if (*p++ != ';') {
+            continue;
+        }
+
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+
+        if (end - p < 2 || (p[0] | 0x20) != 'q' || p[1] != '=') {
+            continue;
+        }
+
+        p += 2;
+        q = 0;
+
+        if (p < end && (*p == '0' || *p == '1')) {
+            q = (*p++ - '0') * 1000;
+
+            if (p < end && *p == '.') {
+                p++;
+
+                for (scale = 100;
+                     scale != 0 && p < end && *p >= '0' && *p <= '9';
+                     scale /= 10)
+                {
+                    q += (*p++ - '0') * scale;
+                }
+            }
+        }
+
+        q = nxt_min(q, 1000);
+    }
+
+    *pos = p;
+
+    return q;
+}
+
+
+static nxt_int_t
+nxt_http_compress_etag(nxt_http_request_t *r, nxt_http_field_t *etag)
+{
+    u_char  *p;
+
+    if (etag->value_length >= 2
+        && etag->value[0] == 'W'
+        && etag->value[1] == '/')
+    {
+        return NXT_OK;
+    }
+
+    p = nxt_mp_nget(r->mem_pool, etag->value_length + 2);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p[0] = 'W';
+    p[1] = '/';
+    nxt_memcpy(p + 2, etag->value, etag->value_length);
+
+    etag->value = p;
+    etag->value_length += 2;
+
+    return NXT_OK;
+}
+
+
+void
+nxt_http_compress_body_filter(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *out)
+{
+    nxt_http_compress_t  *ctx;
+
+    ctx = r->compress;
+
+    if (nxt_slow_path(ctx->done)) {
+        if (r->error) {
+            nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue,
+                              out);
+            return;
+        }
+
+        nxt_http_proto[r->protocol].send(task, r, out);
+        return;
+    }
+
+    nxt_buf_chain_add(&ctx->in, out);
+
+    if (!ctx->busy) {
+        nxt_http_compress_process(task, ctx);
+    }
+}
+
+
+static void
+nxt_http_compress_process(nxt_task_t *task, nxt_http_compress_t *ctx)
+{
+    size_t              size;
+    nxt_buf_t           *b, **prev;
+    nxt_array_t         *pools;
+    nxt_thread_pool_t   *tp;
+    nxt_event_engine_t  *engine;
+    nxt_http_request_t  *r;
+
+    r = ctx->request;
+
+    ctx->batch = ctx->in;
+    ctx->in = NULL;
+
+    size = 0;
+    prev = &ctx->batch;
+
+    while (*prev != NULL) {
+        b = *prev;
+
+        if (nxt_buf_is_last(b)) {
+            *prev = b->next;
+            b->next = NULL;
+
+            ctx->last = b;
+            ctx->finish = 1;
+            continue;
+        }
+
+        if (!nxt_buf_is_sync(b)) {
+            size += nxt_buf_mem_used_size(&b->mem);
+        }
+
+        prev = &b->next;
+    }
+
+    engine = task->thread->engine;
+    pools = task->thread->runtime->thread_pools;
+
+    /* See the comment in nxt_router_access_log_flush(). */
+
+    if (size >= NXT_HTTP_COMPRESS_THREAD_SIZE
+        && !engine->shutdown
+        && !nxt_array_is_empty(pools))
+    {
+        tp = ((nxt_thread_pool_t **) pools->elts)[pools->nelts - 1];
+
+        ctx->busy = 1;
+        ctx->engine = engine;
+
+        nxt_mp_retain(r->mem_pool);
+
+        ctx->work.next = NULL;
+        nxt_work_set(&ctx->work, nxt_http_compress_thread, &tp->task,
+                     ctx, NULL);
+
+        if (nxt_fast_path(nxt_thread_pool_post(tp, &ctx->work) == NXT_OK)) {
+            return;
+        }
+
+        ctx->busy = 0;
+
+        nxt_mp_release(r->mem_pool);
+    }
+
+    nxt_http_compress_run(ctx);
+    nxt_http_compress_output(task, ctx);
+}
+
+
+/* The handler is called by a thread pool thread. */
+
+static void
+nxt_http_compress_thread(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_compress_t  *ctx;
+
+    ctx = obj;
+
+    nxt_http_compress_run(ctx);
+
+    ctx->work.next = NULL;
+    nxt_work_set(&ctx->work, nxt_http_compress_done, &ctx->request->task,
+                 ctx, NULL);
+
+    nxt_event_engine_post(ctx->engine, &ctx->work);
+}
+
+
+static void
+nxt_http_compress_done(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_mp_t             *mp;
+    nxt_http_compress_t  *ctx;
+
+    ctx = obj;
+    mp = ctx->request->mem_pool;
+
+    ctx->busy = 0;
+
+    nxt_http_compress_output(task, ctx);
+
+    if (ctx->in != NULL) {
+        nxt_http_compress_process(task, ctx);
+    }
+
+    nxt_mp_release(mp);
+}
+
+
+static void
+nxt_http_compress_run(nxt_http_compress_t *ctx)
+{
+    size_t     size;
+    nxt_int_t  ret;
+    nxt_buf_t  *b;
+
+    for (b = ctx->batch; b != NULL; b = b->next) {
+
+        if (nxt_buf_is_sync(b)) {
+            continue;
+        }
+
+        /* Response bodies are passed in memory buffers. */
+
+        if (nxt_slow_path(!nxt_buf_is_mem(b))) {
+            ctx->error = 1;
+            return;
+        }
+
+        size = nxt_buf_mem_used_size(&b->mem);
+
+        if (size != 0) {
+            ret = ctx->encoder->compress(ctx, b->mem.pos, size, 0);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                ctx->error = 1;
+                return;
+            }
+
+            b->mem.pos = b->mem.free;
+        }
+    }
+
+    if (ctx->finish) {
+        ret = ctx->encoder->compress(ctx, NULL, 0, 1);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            ctx->error = 1;
+        }
+    }
+}
+
+
+static void
+nxt_http_compress_output(nxt_task_t *task, nxt_http_compress_t *ctx)
+{
+    nxt_buf_t           *b, *in, *out, *last, **prev;
+    nxt_work_queue_t    *wq;
+    nxt_http_request_t  *r;
+
+    r = ctx->request;
+    wq = &task->thread->engine->fast_work_queue;
+
+    in = ctx->batch;
+    out = ctx->out;
+
+    ctx->batch = NULL;
+    ctx->out = NULL;
+    ctx->tail = &ctx->out;
+    ctx->buf = NULL;
+
+    if (nxt_slow_path(ctx->error || r->error || r->proto.any == NULL)) {
+        nxt_http_compress_buf_free(out);
+
+        nxt_sendbuf_drain(task, wq, in);
+        nxt_sendbuf_drain(task, wq, ctx->in);
+        ctx->in = NULL;
+
+        last = ctx->last;
+        ctx->last = NULL;
+
+        nxt_http_compress_finish(ctx);
+
+        if (r->proto.any == NULL) {
+            return;
+        }
+
+        if (!r->error) {
+            nxt_alert(task, "%V compression failed", &ctx->encoder->name);
+
+            nxt_http_request_error_handler(task, r, r->proto.any);
+        }
+
+        nxt_sendbuf_drain(task, wq, last);
+        return;
+    }
+
+    last = NULL;
+    prev = &out;
+
+    while (*prev != NULL) {
+        b = *prev;
+
+        if (nxt_buf_mem_used_size(&b->mem) == 0) {
+            *prev = b->next;
+            nxt_free(b);
+            continue;
+        }
+
+        b->completion_handler = nxt_http_compress_buf_completion;
+        b->parent = r;
+
+        nxt_mp_retain(r->mem_pool);
+
+        last = b;
+        prev = &b->next;
+    }
+
+    if (last != NULL) {
+        ((nxt_http_compress_buf_t *) last)->in = in;
+
+    } else {
+        nxt_sendbuf_drain(task, wq, in);
+    }
+
+    if (ctx->finish) {
+        *prev = ctx->last;
+        ctx->last = NULL;
+
+        nxt_http_compress_finish(ctx);
+    }
+
+    if (out != NULL) {
+        nxt_http_proto[r->protocol].send(task, r, out);
+    }
+}
+
+
+static nxt_buf_t *
+nxt_http_compress_buf(nxt_http_compress_t *ctx)
+{
+    nxt_buf_t                *b;
+    nxt_http_compress_buf_t  *cb;
+
+    b = ctx->buf;
+
+    if (b != NULL && b->mem.free != b->mem.end) {
+        return b;
+    }
+
+    cb = nxt_malloc(sizeof(nxt_http_compress_buf_t)
+                    + NXT_HTTP_COMPRESS_BUF_SIZE);
+    if (nxt_slow_path(cb == NULL)) {
+        return NULL;
+    }
+
+    nxt_memzero(cb, sizeof(nxt_http_compress_buf_t));
+
+    b = &cb->buf;
+    nxt_buf_mem_init(b, cb + 1, NXT_HTTP_COMPRESS_BUF_SIZE);
+
+    *ctx->tail = b;
+    ctx->tail = &b->next;
+    ctx->buf = b;
+
+    return b;
+}
+
+
+static void
+nxt_http_compress_buf_free(nxt_buf_t *b)
+{
+    nxt_buf_t  *next;
+
+    while (b != NULL) {
+        next = b->next;
+        nxt_free(b);
+        b = next;
+    }
+}
+
+
+static void
+nxt_http_compress_buf_completion(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t                *b, *next;
+    nxt_http_request_t       *r;
+    nxt_http_compress_buf_t  *cb;
+
+    b = obj;
+    r = data;
+
+    do {
+        next = b->next;
+        cb = (nxt_http_compress_buf_t *) b;
+
+        if (cb->in != NULL) {
+            nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue,
+                              cb->in);
+        }
+
+        nxt_free(cb);
+        nxt_mp_release(r->mem_pool);
+
+        b = next;
+    } while (b != NULL);
+}
+
+
+static void
+nxt_http_compress_finish(nxt_http_compress_t *ctx)
+{
+    ctx->done = 1;
+
+    if (ctx->ready) {
+        ctx->ready = 0;
+        ctx->encoder->free(ctx);
+    }
+}
+
+
+static void
+nxt_http_compress_cleanup(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_compress_t  *ctx;
+
+    ctx = obj;
+
+    nxt_http_compress_finish(ctx);
+}
+
+
+#if (NXT_HAVE_ZLIB)
+
+static nxt_int_t
+nxt_http_compress_zlib_init(nxt_http_compress_t *ctx, nxt_int_t level)
+{
+    int       ret;
+    z_stream  *z;
+
+    z = &ctx->u.zlib;
+
+    z->zalloc = Z_NULL;
+    z->zfree = Z_NULL;
+    z->opaque = Z_NULL;
+
+    ret = deflateInit2(z, level, Z_DEFLATED,
+                       ctx->encoder->window_bits, 8, Z_DEFAULT_STRATEGY);
+
+    return (ret == Z_OK) ? NXT_OK : NXT_ERROR;
+}
+
+
+static nxt_int_t
+nxt_http_compress_zlib(nxt_http_compress_t *ctx, u_char *in, size_t size,
+    nxt_bool_t last)
+{
+    int        ret, flush;
+    z_stream   *z;
+    nxt_buf_t  *b;
+
+    z = &ctx->u.zlib;
+
+    z->next_in = in;
+    z->avail_in = size;
+
+    flush = last ? Z_FINISH : Z_NO_FLUSH;
+
+    for ( ;; ) {
+        b = nxt_http_compress_buf(ctx);
+        if (nxt_slow_path(b == NULL)) {
+            return NXT_ERROR;
+        }
+
+        z->next_out = b->mem.free;
+        z->avail_out = b->mem.end - b->mem.free;
+
+        ret = deflate(z, flush);
+
+        b->mem.free = z->next_out;
+
+        if (ret == Z_STREAM_END) {
+            return NXT_OK;
+        }
+
+        if (nxt_slow_path(ret != Z_OK && ret != Z_BUF_ERROR)) {
+            return NXT_ERROR;
+        }
+
+        if (!last && z->avail_out != 0) {
+            return NXT_OK;
+        }
+    }
+}
+
+
+static void
+nxt_http_compress_zlib_free(nxt_http_compress_t *ctx)
+{
+    (void) deflateEnd(&ctx->u.zlib);
+}
+
+#endif
+
+
+#if (NXT_HAVE_ZSTD)
+
+static nxt_int_t
+nxt_http_compress_zstd_init(nxt_http_compress_t *ctx, nxt_int_t level)
+{
+    size_t  ret;
+
+    ctx->u.zstd = ZSTD_createCCtx();
+    if (nxt_slow_path(ctx->u.zstd == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ret = ZSTD_CCtx_setParameter(ctx->u.zstd, ZSTD_c_compressionLevel, level);
+
+    if (nxt_slow_path(ZSTD_isError(ret))) {
+        ZSTD_freeCCtx(ctx->u.zstd);
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_compress_zstd(nxt_http_compress_t *ctx, u_char *in, size_t size,
+    nxt_bool_t last)
+{
+    size_t             rest;
+    nxt_buf_t          *b;
+    ZSTD_inBuffer      input;
+    ZSTD_outBuffer     output;
+    ZSTD_EndDirective  mode;
+
+    input.src = in;
+    input.size = size;
+    input.pos = 0;
+
+    mode = last ? ZSTD_e_end : ZSTD_e_continue;
+
+    for ( ;; ) {
+        b = nxt_http_compress_buf(ctx);
+        if (nxt_slow_path(b == NULL)) {
+            return NXT_ERROR;
+        }
+
+        output.dst = b->mem.free;
+        output.size = b->mem.end - b->mem.free;
+        output.pos = 0;
+
+        rest = ZSTD_compressStream2(ctx->u.zstd, &output, &input, mode);
+
+        if (nxt_slow_path(ZSTD_isError(rest))) {
+            return NXT_ERROR;
+        }
+
+        b->mem.free += output.pos;
+
+        if (last ? rest == 0 : input.pos == input.size) {
+            return NXT_OK;
+        }
+    }
+}
+
+
+static void
+nxt_http_compress_zstd_free(nxt_http_compress_t *ctx)
+{
+    ZSTD_freeCCtx(ctx->u.zstd);
+}
+
+#endif
+
+
+#if (NXT_HAVE_BROTLI)
+
+static nxt_int_t
+nxt_http_compress_brotli_init(nxt_http_compress_t *ctx, nxt_int_t level)
+{
+    ctx->u.brotli = BrotliEncoderCreateInstance(NULL, NULL, NULL);
+    if (nxt_slow_path(ctx->u.brotli == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (nxt_slow_path(!BrotliEncoderSetParameter(ctx->u.brotli,
+                                                 BROTLI_PARAM_QUALITY,
+                                                 level)))
+    {
+        BrotliEncoderDestroyInstance(ctx->u.brotli);
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_compress_brotli(nxt_http_compress_t *ctx, u_char *in, size_t size,
+    nxt_bool_t last)
+{
+    size_t                  avail_in, avail_out;
+    uint8_t                 *next_out;
+    nxt_buf_t               *b;
+    const uint8_t           *next_in;
+    BrotliEncoderOperation  op;
+
+    next_in = in;
+    avail_in = size;
+
+    op = last ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_PROCESS;
+
+    for ( ;; ) {
+        b = nxt_http_compress_buf(ctx);
+        if (nxt_slow_path(b == NULL)) {
+            return NXT_ERROR;
+        }
+
+        next_out = b->mem.free;
+        avail_out = b->mem.end - b->mem.free;
+
+        if (nxt_slow_path(!BrotliEncoderCompressStream(ctx->u.brotli, op,
+                                                       &avail_in, &next_in,
+                                                       &avail_out, &next_out,
+                                                       NULL)))
+        {
+            return NXT_ERROR;
+        }
+
+        b->mem.free = next_out;
+
+        if (avail_in == 0
+            && !BrotliEncoderHasMoreOutput(ctx->u.brotli)
+            && (!last || BrotliEncoderIsFinished(ctx->u.brotli)))
+        {
+            return NXT_OK;
+        }
+    }
+}
+
+
+static void
+nxt_http_compress_brotli_free(nxt_http_compress_t *ctx)
+{
+    BrotliEncoderDestroyInstance(ctx->u.brotli);
+}
+
+#endif
@@ -0,0 +1,726 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+
+
+/*
+ * The request rate is limited with the "leaky bucket" method, and the
+ * number of concurrent connections and requests is limited by counters.
+ * The state of a limit is shared by all router engines and is split into
+ * stripes by the key hash; each stripe is protected with its own spinlock,
+ * so engines contend only for the keys that fall into the same stripe.
+ * The rate and the bucket excess are kept in thousandths of a request.
+ */
+
+#define NXT_HTTP_LIMIT_STRIPES  16      /* The upper 4 bits of a hash. */
+#define NXT_HTTP_LIMIT_KEYS     4096    /* Per stripe of a rate limit. */
+
+
+typedef struct nxt_http_limit_stripe_s  nxt_http_limit_stripe_t;
+
+struct nxt_http_limit_node_s {
+    /* The LRU link is used by rate limits only. */
+    nxt_queue_link_t            link;
+    nxt_http_limit_stripe_t     *stripe;
+    uint32_t                    hash;
+    uint32_t                    count;
+    nxt_msec_t                  last;
+    int64_t                     excess;
+    nxt_str_t                   key;
+};
+
+
+struct nxt_http_limit_stripe_s {
+    nxt_thread_spinlock_t       lock;
+    nxt_lvlhsh_t                hash;
+    nxt_queue_t                 lru;
+    uint32_t                    count;
+} nxt_aligned(64);
+
+
+struct nxt_http_limit_s {
+    nxt_tstr_t                  *key;
+    int64_t                     rate;
+    int64_t                     burst;
+    uint32_t                    max;
+    nxt_http_status_t           status;
+    uint8_t                     delay;   /* 1 bit */
+    nxt_http_limit_stripe_t     *stripes;
+};
+
+
+typedef struct {
+    nxt_str_t                   key;
+    nxt_conf_value_t            *rate;
+    int64_t                     burst;
+    int32_t                     requests;
+    nxt_int_t                   status;
+    uint8_t                     delay;
+} nxt_http_limit_conf_t;
+
+
+static nxt_http_limit_t *nxt_http_limit_create(nxt_task_t *task,
+    nxt_router_conf_t *rtcf, nxt_conf_value_t *cv);
+static nxt_int_t nxt_http_limit_rate(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action);
+static nxt_int_t nxt_http_limit_concurrency(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_limit_t *limit);
+static nxt_int_t nxt_http_limit_key(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_limit_t *limit, nxt_str_t *key);
+static nxt_int_t nxt_http_limit_acquire(nxt_http_limit_stripe_t *stripes,
+    nxt_str_t *key, uint32_t max, nxt_http_limit_node_t **nodep);
+static void nxt_http_limit_node_release(nxt_http_limit_node_t *node);
+static nxt_http_limit_node_t *nxt_http_limit_node_find(
+    nxt_http_limit_stripe_t *stripe, nxt_str_t *key, uint32_t hash);
+static nxt_http_limit_node_t *nxt_http_limit_node_add(
+    nxt_http_limit_stripe_t *stripe, nxt_str_t *key, uint32_t hash);
+static void nxt_http_limit_node_expire(nxt_http_limit_t *limit,
+    nxt_http_limit_stripe_t *stripe, nxt_msec_t now);
+static void nxt_http_limit_node_delete(nxt_http_limit_node_t *node);
+static void nxt_http_limit_delay_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_limit_conn_cleanup(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_limit_cleanup(nxt_task_t *task, void *obj, void *data);
+static nxt_int_t nxt_http_limit_hash_test(nxt_lvlhsh_query_t *lhq,
+    void *data);
+
+
+/*
+ * Connections are counted apart from configurations, since
+ * they may outlive the configuration they were accepted with.
+ */
+static nxt_http_limit_stripe_t  nxt_http_limit_conns[NXT_HTTP_LIMIT_STRIPES];
+
+
+static nxt_conf_map_t  nxt_http_limit_conf[] = {
+    {
+        nxt_string("key"),
+        NXT_CONF_MAP_STR,
+        offsetof(nxt_http_limit_conf_t, key)
+    },
+    {
+        nxt_string("rate"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_limit_conf_t, rate)
+    },
+    {
+        nxt_string("burst"),
+        NXT_CONF_MAP_INT64,
+        offsetof(nxt_http_limit_conf_t, burst)
+    },
+    {
+        nxt_string("requests"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_http_limit_conf_t, requests)
+    },
+    {
+        nxt_string("status"),
+        NXT_CONF_MAP_INT,
+        offsetof(nxt_http_limit_conf_t, status)
+    },
+    {
+        nxt_string("delay"),
+        NXT_CONF_MAP_INT8,
+        offsetof(nxt_http_limit_conf_t, delay)
+    },
+};
+
+
+static const nxt_lvlhsh_proto_t  nxt_http_limit_hash_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    nxt_http_limit_hash_test,
+    nxt_lvlhsh_alloc,
+    nxt_lvlhsh_free,
+};
+
+
+nxt_int_t
+nxt_http_limit_init(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf)
+{
+    if (acf->limit_requests != NULL) {
+        action->limit = nxt_http_limit_create(task, rtcf,
+                                              acf->limit_requests);
+        if (nxt_slow_path(action->limit == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    if (acf->limit_concurrency != NULL) {
+        action->concurrency = nxt_http_limit_create(task, rtcf,
+                                                    acf->limit_concurrency);
+        if (nxt_slow_path(action->concurrency == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_http_limit_t *
+nxt_http_limit_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_conf_value_t *cv)
+{
+    nxt_mp_t               *mp;
+    nxt_int_t              ret;
+    nxt_uint_t             i;
+    nxt_http_limit_t       *limit;
+    nxt_http_limit_conf_t  conf;
+
+    mp = rtcf->mem_pool;
+
+    nxt_memzero(&conf, sizeof(nxt_http_limit_conf_t));
+
+    conf.status = NXT_HTTP_TOO_MANY_REQUESTS;
+
+    ret = nxt_conf_map_object(mp, cv, nxt_http_limit_conf,
+                              nxt_nitems(nxt_http_limit_conf), &conf);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    limit = nxt_mp_zget(mp, sizeof(nxt_http_limit_t));
+    if (nxt_slow_path(limit == NULL)) {
+        return NULL;
+    }
+
+    limit->key = nxt_tstr_compile(rtcf->tstr_state, &conf.key, 0);
+    if (nxt_slow_path(limit->key == NULL)) {
+        return NULL;
+    }
+
+    if (conf.rate != NULL) {
+        limit->rate = nxt_max((int64_t) (nxt_conf_get_number(conf.rate)
+                                         * 1000), 1);
+    }
+
+    limit->burst = conf.burst * 1000;
+    limit->max = conf.requests;
+    limit->status = conf.status;
+    limit->delay = conf.delay;
+
+    limit->stripes = nxt_mp_align(mp, 64, NXT_HTTP_LIMIT_STRIPES
+                                          * sizeof(nxt_http_limit_stripe_t));
+    if (nxt_slow_path(limit->stripes == NULL)) {
+        return NULL;
+    }
+
+    for (i = 0; i < NXT_HTTP_LIMIT_STRIPES; i++) {
+        nxt_memzero(&limit->stripes[i], sizeof(nxt_http_limit_stripe_t));
+        nxt_queue_init(&limit->stripes[i].lru);
+    }
+
+    ret = nxt_mp_cleanup(mp, nxt_http_limit_cleanup, task, limit, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    return limit;
+}
+
+
+nxt_int_t
+nxt_http_limit(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action)
+{
+    nxt_int_t  ret;
+
+    if (action->limit != NULL && !r->limit_delayed) {
+        ret = nxt_http_limit_rate(task, r, action);
+        if (ret != NXT_OK) {
+            return ret;
+        }
+    }
+
+    r->limit_delayed = 0;
+
+    /* A request is accounted only by the first concurrency limit. */
+
+    if (action->concurrency != NULL && r->limit_node == NULL) {
+        return nxt_http_limit_concurrency(task, r, action->concurrency);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_limit_rate(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action)
+{
+    int64_t                  excess;
+    uint32_t                 hash;
+    nxt_int_t                ret;
+    nxt_str_t                key;
+    nxt_msec_t               now;
+    nxt_msec_int_t           elapsed;
+    nxt_http_limit_t         *limit;
+    nxt_event_engine_t       *engine;
+    nxt_http_limit_node_t    *node;
+    nxt_http_limit_stripe_t  *stripe;
+
+    limit = action->limit;
+
+    ret = nxt_http_limit_key(task, r, limit, &key);
+    if (ret != NXT_OK) {
+        return (ret == NXT_DECLINED) ? NXT_OK : ret;
+    }
+
+    engine = task->thread->engine;
+    now = engine->timers.now;
+
+    hash = nxt_murmur_hash2(key.start, key.length);
+
+    /* The lower bits of the hash are used by the level hash. */
+    stripe = &limit->stripes[hash >> 28];
+
+    nxt_thread_spin_lock(&stripe->lock);
+
+    nxt_http_limit_node_expire(limit, stripe, now);
+
+    node = nxt_http_limit_node_find(stripe, &key, hash);
+
+    if (node == NULL) {
+        excess = 0;
+
+        if (stripe->count >= NXT_HTTP_LIMIT_KEYS) {
+            node = nxt_queue_link_data(nxt_queue_last(&stripe->lru),
+                                       nxt_http_limit_node_t, link);
+
+            nxt_queue_remove(&node->link);
+            nxt_http_limit_node_delete(node);
+        }
+
+        node = nxt_http_limit_node_add(stripe, &key, hash);
+
+        if (nxt_slow_path(node == NULL)) {
+            nxt_thread_spin_unlock(&stripe->lock);
+
+            /* The state cannot be kept, so the request is not limited. */
+
+            return NXT_OK;
+        }
+
+    } else {
+        nxt_queue_remove(&node->link);
+
+        elapsed = nxt_msec_diff(now, node->last);
+
+        if (elapsed < 0) {
+            /* The engines update their time independently. */
+            elapsed = 0;
+        }
+
+        excess = node->excess - limit->rate * elapsed / 1000 + 1000;
+
+        if (excess < 0) {
+            excess = 0;
+        }
+    }
+
+    nxt_queue_insert_head(&stripe->lru, &node->link);
+
+    if (excess > limit->burst) {
+        nxt_thread_spin_unlock(&stripe->lock);
+
+        nxt_log(task, NXT_LOG_INFO, "limiting requests, excess: %L.%03L "
+                "by key \"%V\"", excess / 1000, excess % 1000, &key);
+
+        nxt_http_request_error(task, r, limit->status);
+
+        return NXT_DECLINED;
+    }
+
+    node->excess = excess;
+    node->last = now;
+
+    nxt_thread_spin_unlock(&stripe->lock);
+
+    if (!limit->delay || excess == 0) {
+        return NXT_OK;
+    }
+
+    nxt_debug(task, "http limit delay: %L", excess * 1000 / limit->rate);
+
+    /*
+     * The request memory pool is retained until the timer fires,
+     * since the request may be closed by the client meanwhile.
+     */
+    nxt_mp_retain(r->mem_pool);
+
+    r->limit_delayed = 1;
+    r->timer_data = action;
+
+    r->timer.task = &engine->task;
+    r->timer.work_queue = &engine->fast_work_queue;
+    r->timer.log = engine->task.log;
+    r->timer.bias = NXT_TIMER_DEFAULT_BIAS;
+    r->timer.handler = nxt_http_limit_delay_handler;
+
+    nxt_timer_add(engine, &r->timer, excess * 1000 / limit->rate);
+
+    return NXT_AGAIN;
+}
+
+
+static nxt_int_t
+nxt_http_limit_concurrency(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_limit_t *limit)
+{
+    nxt_int_t  ret;
+    nxt_str_t  key;
+
+    ret = nxt_http_limit_key(task, r, limit, &key);
+    if (ret != NXT_OK) {
+        return (ret == NXT_DECLINED) ? NXT_OK : ret;
+    }
+
+    ret = nxt_http_limit_acquire(limit->stripes, &key, limit->max,
+                                 &r->limit_node);
+
+    if (ret == NXT_DECLINED) {
+        nxt_log(task, NXT_LOG_INFO, "limiting concurrent requests "
+                "by key \"%V\"", &key);
+
+        nxt_http_request_error(task, r, limit->status);
+    }
+
+    return ret;
+}
+
+
+void
+nxt_http_limit_release(nxt_http_request_t *r)
+{
+    if (r->limit_node != NULL) {
+        nxt_http_limit_node_release(r->limit_node);
+        r->limit_node = NULL;
+    }
+}
+
+
+nxt_int_t
+nxt_http_limit_conn(nxt_task_t *task, nxt_conn_t *c, nxt_socket_conf_t *skcf)
+{
+    u_char                 *p;
+    nxt_int_t              ret;
+    nxt_str_t              key;
+    nxt_http_limit_node_t  *node;
+
+    /* The addresses are counted per listen socket. */
+
+    key.length = sizeof(nxt_listen_socket_t *) + c->remote->address_length;
+
+    key.start = nxt_mp_nget(c->mem_pool, key.length);
+    if (nxt_slow_path(key.start == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_cpymem(key.start, &skcf->listen, sizeof(nxt_listen_socket_t *));
+    nxt_memcpy(p, nxt_sockaddr_address(c->remote),
+               c->remote->address_length);
+
+    ret = nxt_http_limit_acquire(nxt_http_limit_conns, &key,
+                                 skcf->limit_connections, &node);
+
+    if (ret == NXT_DECLINED) {
+        nxt_log(task, NXT_LOG_INFO, "limiting connections from %*s",
+                (size_t) c->remote->address_length,
+                nxt_sockaddr_address(c->remote));
+
+        return NXT_DECLINED;
+    }
+
+    if (node == NULL) {
+        return NXT_OK;
+    }
+
+    ret = nxt_mp_cleanup(c->mem_pool, nxt_http_limit_conn_cleanup, task,
+                         node, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_http_limit_node_release(node);
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_limit_key(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_limit_t *limit, nxt_str_t *key)
+{
+    nxt_int_t          ret;
+    nxt_router_conf_t  *rtcf;
+
+    if (nxt_tstr_is_const(limit->key)) {
+        nxt_tstr_str(limit->key, key);
+
+    } else {
+        rtcf = r->conf->socket_conf->router_conf;
+
+        ret = nxt_tstr_query_init(&r->tstr_query, rtcf->tstr_state,
+                                  &r->tstr_cache, r, r->mem_pool);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        nxt_tstr_query(task, r->tstr_query, limit->key, key);
+
+        if (nxt_slow_path(nxt_tstr_query_failed(r->tstr_query))) {
+            return NXT_ERROR;
+        }
+    }
+
+    /* Requests with an empty key are not limited. */
+
+    return (key->length != 0) ? NXT_OK : NXT_DECLINED;
+}
+
+
+/*
+ * The node of a counter exists while the count is not zero.  If the node
+ * cannot be allocated, the counter is not limited and no node is returned.
+ */
+
+static nxt_int_t
+nxt_http_limit_acquire(nxt_http_limit_stripe_t *stripes, nxt_str_t *key,
+    uint32_t max, nxt_http_limit_node_t **nodep)
+{
+    uint32_t                 hash;
+    nxt_http_limit_node_t    *node;
+    nxt_http_limit_stripe_t  *stripe;
+
+    hash = nxt_murmur_hash2(key->start, key->length);
+    stripe = &stripes[hash >> 28];
+
+    nxt_thread_spin_lock(&stripe->lock);
+
+    node = nxt_http_limit_node_find(stripe, key, hash);
+
+    if (node == NULL) {
+        node = nxt_http_limit_node_add(stripe, key, hash);
+
+    } else if (node->count >= max) {
+        nxt_thread_spin_unlock(&stripe->lock);
+        return NXT_DECLINED;
+    }
+
+    if (nxt_fast_path(node != NULL)) {
+        node->count++;
+    }
+
+    nxt_thread_spin_unlock(&stripe->lock);
+
+    *nodep = node;
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_http_limit_node_release(nxt_http_limit_node_t *node)
+{
+    nxt_http_limit_stripe_t  *stripe;
+
+    stripe = node->stripe;
+
+    nxt_thread_spin_lock(&stripe->lock);
+
+    if (--node->count == 0) {
+        nxt_http_limit_node_delete(node);
+    }
+
+    nxt_thread_spin_unlock(&stripe->lock);
+}
+
+
+static nxt_http_limit_node_t *
+nxt_http_limit_node_find(nxt_http_limit_stripe_t *stripe, nxt_str_t *key,
+    uint32_t hash)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key = *key;
+    lhq.key_hash = hash;
+    lhq.proto = &nxt_http_limit_hash_proto;
+
+    if (nxt_lvlhsh_find(&stripe->hash, &lhq) != NXT_OK) {
+        return NULL;
+    }
+
+    return lhq.value;
+}
+
+
+static nxt_http_limit_node_t *
+nxt_http_limit_node_add(nxt_http_limit_stripe_t *stripe, nxt_str_t *key,
+    uint32_t hash)
+{
+    nxt_int_t              ret;
+    nxt_lvlhsh_query_t     lhq;
+    nxt_http_limit_node_t  *node;
+
+    node = nxt_malloc(sizeof(nxt_http_limit_node_t) + key->length);
+    if (nxt_slow_path(node == NULL)) {
+        return NULL;
+    }
+
+    node->stripe = stripe;
+    node->hash = hash;
+    node->count = 0;
+
+    node->key.length = key->length;
+    node->key.start = (u_char *) node + sizeof(nxt_http_limit_node_t);
+    nxt_memcpy(node->key.start, key->start, key->length);
+
+    lhq.key = node->key;
+    lhq.key_hash = hash;
+    lhq.replace = 0;
+    lhq.value = node;
+    lhq.proto = &nxt_http_limit_hash_proto;
+    lhq.pool = NULL;
+
+    ret = nxt_lvlhsh_insert(&stripe->hash, &lhq);
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_free(node);
+        return NULL;
+    }
+
+    stripe->count++;
+
+    return node;
+}
+
+
+/*
+ * A node which would not limit the next request anyway is the same
+ * as a missing one, so a couple of such least recently used nodes
+ * are deleted on each lookup.
+ */
+
+static void
+nxt_http_limit_node_expire(nxt_http_limit_t *limit,
+    nxt_http_limit_stripe_t *stripe, nxt_msec_t now)
+{
+    nxt_uint_t             n;
+    nxt_msec_int_t         elapsed;
+    nxt_http_limit_node_t  *node;
+
+    for (n = 0; n < 2 && stripe->count != 0; n++) {
+        node = nxt_queue_link_data(nxt_queue_last(&stripe->lru),
+                                   nxt_http_limit_node_t, link);
+
+        elapsed = nxt_msec_diff(now, node->last);
+
+        if (elapsed < 0
+            || node->excess - limit->rate * elapsed / 1000 + 1000 > 0)
+        {
+            return;
+        }
+
+        nxt_queue_remove(&node->link);
+        nxt_http_limit_node_delete(node);
+    }
+}
+
+
+static void
+nxt_http_limit_node_delete(nxt_http_limit_node_t *node)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key = node->key;
+    lhq.key_hash = node->hash;
+    lhq.proto = &nxt_http_limit_hash_proto;
+    lhq.pool = NULL;
+
+    (void) nxt_lvlhsh_delete(&node->stripe->hash, &lhq);
+
+    node->stripe->count--;
+
+    nxt_free(node);
+}
+
+
+static void
+nxt_http_limit_delay_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_timer_t         *timer;
+    nxt_http_action_t   *action;
+    nxt_http_request_t  *r;
+
+    timer = obj;
+
+    r = nxt_timer_data(timer, nxt_http_request_t, timer);
+    action = r->timer_data;
+
+    r->timer_data = NULL;
+
+    nxt_debug(task, "http limit delay handler");
+
+    if (r->proto.any != NULL && !r->error) {
+        nxt_http_request_action(task, r, action);
+    }
+
+    nxt_mp_release(r->mem_pool);
+}
+
+
+static void
+nxt_http_limit_conn_cleanup(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_limit_node_release(obj);
+}
+
+
+static void
+nxt_http_limit_cleanup(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_uint_t               i;
+    nxt_http_limit_t         *limit;
+    nxt_http_limit_node_t    *node;
+    nxt_http_limit_stripe_t  *stripe;
+
+    limit = obj;
+
+    /*
+     * The nodes of a concurrency limit are not linked, as they are
+     * released by the requests which hold the configuration.
+     */
+
+    for (i = 0; i < NXT_HTTP_LIMIT_STRIPES; i++) {
+        stripe = &limit->stripes[i];
+
+        nxt_queue_each(node, &stripe->lru, nxt_http_limit_node_t, link) {
+
+            nxt_queue_remove(&node->link);
+            nxt_http_limit_node_delete(node);
+
+        } nxt_queue_loop;
+    }
+}
+
+
+static nxt_int_t
+nxt_http_limit_hash_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_http_limit_node_t  *node;
+
+    node = data;
+
+    if (nxt_strstr_eq(&lhq->key, &node->key)) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
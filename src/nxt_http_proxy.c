@@ -30,6 +30,13 @@ static void nxt_http_proxy_send_body(nxt_task_t *task, void *obj, void *data);
 static void nxt_http_proxy_buf_mem_completion(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_http_proxy_error(nxt_task_t *task, void *obj, void *data);
+static nxt_bool_t nxt_http_proxy_retry(nxt_http_request_t *r,
+    nxt_http_peer_t *peer);
+static nxt_bool_t nxt_http_proxy_next(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_peer_t *peer);
+static void nxt_http_proxy_done(nxt_task_t *task, nxt_http_peer_t *peer,
+    nxt_bool_t failed);
+static nxt_bool_t nxt_http_proxy_idempotent(nxt_http_request_t *r);
 
 
 static const nxt_http_request_state_t  nxt_http_proxy_header_send_state;
@@ -82,6 +89,8 @@ nxt_http_proxy_init(nxt_mp_t *mp, nxt_http_action_t *action,
         up->name.length = sa->length;
         up->name.start = nxt_sockaddr_start(sa);
         up->proto = &nxt_upstream_simple_proto;
+        up->keepalive = NULL;
+        up->retry = NULL;
 
         proxy = nxt_mp_alloc(mp, sizeof(nxt_upstream_proxy_t));
         if (nxt_slow_path(proxy == NULL)) {
@@ -143,6 +152,8 @@ nxt_upstream_proxy_handler(nxt_task_t *task, nxt_http_request_t *r,
     peer->server = us;
 
     us->upstream = upstream;
+    us->start = task->thread->engine->timers.now;
+
     upstream->proto->get(task, us);
 
     return NULL;
@@ -311,6 +322,8 @@ nxt_http_proxy_send_body(nxt_task_t *task, void *obj, void *data)
     } else {
         nxt_http_proto[peer->protocol].peer_close(task, peer);
 
+        nxt_http_proxy_done(task, peer, 0);
+
         nxt_mp_release(r->mem_pool);
     }
 }
@@ -375,6 +388,7 @@ nxt_http_proxy_buf_mem_free(nxt_task_t *task, nxt_http_request_t *r,
 static void
 nxt_http_proxy_error(nxt_task_t *task, void *obj, void *data)
 {
+    nxt_bool_t          failed;
     nxt_http_peer_t     *peer;
     nxt_http_request_t  *r;
 
@@ -383,12 +397,115 @@ nxt_http_proxy_error(nxt_task_t *task, void *obj, void *data)
 
     nxt_http_proto[peer->protocol].peer_close(task, peer);
 
+    if (nxt_http_proxy_retry(r, peer)) {
+        nxt_debug(task, "http proxy retry");
+
+        peer->server->connection = NULL;
+        peer->closed = 0;
+
+        nxt_http_proxy_upstream_ready(task, peer->server);
+        return;
+    }
+
+    /*
+     * Only a failure to connect to the server, to send the request,
+     * or to receive the response header is accounted to the server
+     * and may be retried on the next one.
+     */
+
+    failed = !peer->header_received
+             && (peer->status == NXT_HTTP_BAD_GATEWAY
+                 || peer->status == NXT_HTTP_GATEWAY_TIMEOUT);
+
+    nxt_http_proxy_done(task, peer, failed);
+
+    if (failed && nxt_http_proxy_next(task, r, peer)) {
+        nxt_log(task, NXT_LOG_INFO, "upstream \"%V\": trying next server",
+                &peer->server->upstream->name);
+
+        peer->server->connection = NULL;
+        peer->closed = 0;
+
+        peer->server->upstream->proto->get(task, peer->server);
+        return;
+    }
+
     nxt_mp_release(r->mem_pool);
 
     nxt_http_request_error(&r->task, r, peer->status);
 }
 
 
+static nxt_bool_t
+nxt_http_proxy_retry(nxt_http_request_t *r, nxt_http_peer_t *peer)
+{
+    /*
+     * A keep-alive connection can be closed by the server at the moment
+     * the request is sent, so the request is repeated once over a new
+     * connection unless the server may have started to process it.
+     */
+
+    if (peer->server->connection == NULL
+        || peer->header_received
+        || peer->status != NXT_HTTP_BAD_GATEWAY)
+    {
+        return 0;
+    }
+
+    return nxt_http_proxy_idempotent(r);
+}
+
+
+static nxt_bool_t
+nxt_http_proxy_next(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_peer_t *peer)
+{
+    nxt_upstream_retry_t   *retry;
+    nxt_upstream_server_t  *us;
+
+    us = peer->server;
+    retry = us->upstream->retry;
+
+    if (retry == NULL || !nxt_http_proxy_idempotent(r)) {
+        return 0;
+    }
+
+    if (retry->tries != 0 && us->tries >= retry->tries) {
+        return 0;
+    }
+
+    if (retry->timeout != 0
+        && nxt_msec_diff(task->thread->engine->timers.now, us->start)
+           >= (nxt_msec_int_t) retry->timeout)
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+
+static void
+nxt_http_proxy_done(nxt_task_t *task, nxt_http_peer_t *peer, nxt_bool_t failed)
+{
+    nxt_upstream_server_t  *us;
+
+    us = peer->server;
+
+    if (us->upstream->proto->done != NULL) {
+        us->upstream->proto->done(task, us, failed);
+    }
+}
+
+
+static nxt_bool_t
+nxt_http_proxy_idempotent(nxt_http_request_t *r)
+{
+    return !(nxt_str_eq(r->method, "POST", 4)
+             || nxt_str_eq(r->method, "PATCH", 5));
+}
+
+
 nxt_int_t
 nxt_http_proxy_date(void *ctx, nxt_http_field_t *field, uintptr_t data)
 {
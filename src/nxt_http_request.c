@@ -75,6 +75,12 @@ nxt_http_init(nxt_task_t *task)
         return ret;
     }
 
+    ret = nxt_h2p_init(task);
+
+    if (ret != NXT_OK) {
+        return ret;
+    }
+
     return nxt_http_response_hash_init(task);
 }
 
@@ -562,11 +568,31 @@ nxt_http_request_action(nxt_task_t *task, nxt_http_request_t *r,
     if (nxt_fast_path(action != NULL)) {
 
         do {
+            ret = nxt_http_limit(task, r, action);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                if (ret == NXT_ERROR) {
+                    break;
+                }
+
+                /* The request is delayed or rejected. */
+                return;
+            }
+
             ret = nxt_http_rewrite(task, r);
             if (nxt_slow_path(ret != NXT_OK)) {
                 break;
             }
 
+            ret = nxt_http_cache(task, r, action);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                if (ret == NXT_ERROR) {
+                    break;
+                }
+
+                /* The response is sent from the cache. */
+                return;
+            }
+
             action = action->handler(task, r, action);
 
             if (action == NULL) {
@@ -636,11 +662,22 @@ nxt_http_request_header_send(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_field_t   *server, *date, *content_length;
     nxt_socket_conf_t  *skcf;
 
+    if (r->cache != NULL) {
+        nxt_http_cache_header_filter(task, r);
+    }
+
     ret = nxt_http_set_headers(r);
     if (nxt_slow_path(ret != NXT_OK)) {
         goto fail;
     }
 
+    if (body_handler != NULL) {
+        ret = nxt_http_compress_header_filter(task, r);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto fail;
+        }
+    }
+
     /*
      * TODO: "Server", "Date", and "Content-Length" processing should be moved
      * to the last header filter.
@@ -727,6 +764,19 @@ void
 nxt_http_request_send(nxt_task_t *task, nxt_http_request_t *r, nxt_buf_t *out)
 {
     if (nxt_fast_path(r->proto.any != NULL)) {
+
+        if (r->cache != NULL) {
+            out = nxt_http_cache_body_filter(task, r, out);
+            if (out == NULL) {
+                return;
+            }
+        }
+
+        if (r->compress != NULL) {
+            nxt_http_compress_body_filter(task, r, out);
+            return;
+        }
+
         nxt_http_proto[r->protocol].send(task, r, out);
     }
 }
@@ -846,6 +896,8 @@ nxt_http_request_close_handler(nxt_task_t *task, void *obj, void *data)
 
     r->proto.any = NULL;
 
+    nxt_http_limit_release(r);
+
     if (r->body != NULL && nxt_buf_is_file(r->body)
         && r->body->file->fd != -1)
     {
@@ -124,7 +124,11 @@ typedef struct {
 struct nxt_http_route_addr_rule_s {
     /* The object must be the first field. */
     nxt_http_route_object_t        object:8;
+    /* Whether one of the positive patterns must match. */
+    uint8_t                        positive;   /* 1 bit */
     uint32_t                       items;
+    nxt_http_route_addr_table_t    *exclude;
+    nxt_http_route_addr_table_t    *include;
     nxt_http_route_addr_pattern_t  addr_pattern[];
 };
 
@@ -143,8 +147,46 @@ typedef struct {
 } nxt_http_route_match_t;
 
 
+/*
+ * A route with many matches is indexed by URI, host, and method values
+ * and prefixes of positive patterns to skip the matches which cannot
+ * be selected by a request.  The indices of the matches are kept sorted
+ * to test the remaining matches in the configuration order.
+ */
+
+typedef struct {
+    nxt_str_t                      key;
+    nxt_array_t                    *matches;
+} nxt_http_route_key_t;
+
+
+typedef struct {
+    nxt_lvlhsh_t                   exact;
+    nxt_lvlhsh_t                   prefix;
+    nxt_array_t                    *prefix_lengths;
+    nxt_array_t                    *rest;
+    uint32_t                       keys;
+} nxt_http_route_index_t;
+
+
+typedef struct {
+    nxt_http_route_index_t         index[3];
+} nxt_http_route_dispatch_t;
+
+
+typedef struct {
+    uint32_t                       *start;
+    uint32_t                       *end;
+} nxt_http_route_list_t;
+
+
+#define NXT_HTTP_ROUTE_DISPATCH_MIN    8
+#define NXT_HTTP_ROUTE_DISPATCH_LISTS  16
+
+
 struct nxt_http_route_s {
     nxt_str_t                      name;
+    nxt_http_route_dispatch_t      *dispatch;
     uint32_t                       items;
     nxt_http_route_match_t         *match[];
 };
@@ -175,6 +217,8 @@ static nxt_http_route_rule_t *nxt_http_route_rule_create(nxt_task_t *task,
     nxt_http_uri_encoding_t encoding);
 static int nxt_http_pattern_compare(const void *one, const void *two);
 static int nxt_http_addr_pattern_compare(const void *one, const void *two);
+static nxt_int_t nxt_http_route_addr_rule_compile(nxt_mp_t *mp,
+    nxt_http_route_addr_rule_t *addr_rule);
 static nxt_int_t nxt_http_route_pattern_create(nxt_task_t *task, nxt_mp_t *mp,
     nxt_conf_value_t *cv, nxt_http_route_pattern_t *pattern,
     nxt_http_route_pattern_case_t pattern_case,
@@ -187,6 +231,21 @@ static nxt_int_t nxt_http_route_pattern_slice(nxt_array_t *slices,
     nxt_http_uri_encoding_t encoding,
     nxt_http_route_pattern_case_t pattern_case);
 
+static nxt_int_t nxt_http_route_dispatch_create(nxt_mp_t *mp,
+    nxt_http_route_t *route);
+static nxt_int_t nxt_http_route_index_create(nxt_mp_t *mp,
+    nxt_http_route_t *route, nxt_http_route_index_t *index, nxt_uint_t n);
+static nxt_http_route_rule_t *nxt_http_route_index_rule(
+    nxt_http_route_match_t *match, nxt_uint_t n);
+static nxt_bool_t nxt_http_route_rule_indexable(nxt_http_route_rule_t *rule,
+    nxt_bool_t prefix);
+static nxt_http_route_pattern_slice_t *nxt_http_route_pattern_key(
+    nxt_http_route_pattern_t *pattern);
+static nxt_int_t nxt_http_route_index_add(nxt_mp_t *mp, nxt_lvlhsh_t *hash,
+    nxt_http_route_pattern_slice_t *slice, uint32_t i);
+static nxt_int_t nxt_http_route_key_test(nxt_lvlhsh_query_t *lhq,
+    void *data);
+
 static nxt_int_t nxt_http_route_resolve(nxt_task_t *task,
     nxt_router_temp_conf_t *tmcf, nxt_http_route_t *route);
 static nxt_int_t nxt_http_action_resolve(nxt_task_t *task,
@@ -202,6 +261,13 @@ static nxt_int_t nxt_http_route_find(nxt_http_routes_t *routes, nxt_str_t *name,
 
 static nxt_http_action_t *nxt_http_route_handler(nxt_task_t *task,
     nxt_http_request_t *r, nxt_http_action_t *start);
+static nxt_http_action_t *nxt_http_route_dispatch(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_route_t *route);
+static nxt_uint_t nxt_http_route_index_lists(nxt_http_request_t *r,
+    nxt_http_route_index_t *index, nxt_uint_t n, nxt_http_route_list_t *lists,
+    size_t *total);
+static nxt_http_route_list_t *nxt_http_route_index_find(nxt_lvlhsh_t *hash,
+    u_char *start, size_t length, nxt_http_route_list_t *list);
 static nxt_http_action_t *nxt_http_route_match(nxt_task_t *task,
     nxt_http_request_t *r, nxt_http_route_match_t *match);
 static nxt_int_t nxt_http_route_table(nxt_http_request_t *r,
@@ -385,6 +451,14 @@ nxt_http_route_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         *m++ = match;
     }
 
+    route->dispatch = NULL;
+
+    if (nxt_http_route_dispatch_create(tmcf->router_conf->mem_pool, route)
+        != NXT_OK)
+    {
+        return NULL;
+    }
+
     return route;
 }
 
@@ -588,6 +662,16 @@ static nxt_conf_map_t  nxt_http_route_action_conf[] = {
         NXT_CONF_MAP_PTR,
         offsetof(nxt_http_action_conf_t, set_headers)
     },
+    {
+        nxt_string("limit_requests"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, limit_requests)
+    },
+    {
+        nxt_string("limit_concurrency"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, limit_concurrency)
+    },
     {
         nxt_string("pass"),
         NXT_CONF_MAP_PTR,
@@ -633,6 +717,11 @@ static nxt_conf_map_t  nxt_http_route_action_conf[] = {
         NXT_CONF_MAP_PTR,
         offsetof(nxt_http_action_conf_t, traverse_mounts)
     },
+    {
+        nxt_string("precompressed"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, precompressed)
+    },
     {
         nxt_string("types"),
         NXT_CONF_MAP_PTR,
@@ -643,6 +732,16 @@ static nxt_conf_map_t  nxt_http_route_action_conf[] = {
         NXT_CONF_MAP_PTR,
         offsetof(nxt_http_action_conf_t, fallback)
     },
+    {
+        nxt_string("compression"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, compress)
+    },
+    {
+        nxt_string("cache"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, cache)
+    },
 };
 
 
@@ -683,6 +782,27 @@ nxt_http_action_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         }
     }
 
+    if (acf.compress != NULL) {
+        ret = nxt_http_compress_init(task, rtcf, action, &acf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    if (acf.limit_requests != NULL || acf.limit_concurrency != NULL) {
+        ret = nxt_http_limit_init(task, rtcf, action, &acf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    if (acf.cache != NULL) {
+        ret = nxt_http_cache_init(task, rtcf, action, &acf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
     if (acf.ret != NULL) {
         return nxt_http_return_init(rtcf, action, &acf);
     }
@@ -900,10 +1020,79 @@ nxt_http_route_addr_rule_create(nxt_task_t *task, nxt_mp_t *mp,
             nxt_http_addr_pattern_compare);
     }
 
+    if (nxt_http_route_addr_rule_compile(mp, addr_rule) != NXT_OK) {
+        return NULL;
+    }
+
     return addr_rule;
 }
 
 
+/*
+ * The negative and the positive patterns without a port are moved
+ * to the exclude and the include address tables, so large address lists
+ * are matched with a binary search.  The rest are matched one by one.
+ */
+
+static nxt_int_t
+nxt_http_route_addr_rule_compile(nxt_mp_t *mp,
+    nxt_http_route_addr_rule_t *addr_rule)
+{
+    uint32_t                       i, n, negative, tabular;
+    nxt_http_route_addr_pattern_t  *pattern;
+
+    n = addr_rule->items;
+    pattern = addr_rule->addr_pattern;
+
+    addr_rule->exclude = NULL;
+    addr_rule->include = NULL;
+
+    negative = 0;
+    tabular = 0;
+
+    for (i = 0; i < n; i++) {
+        negative += pattern[i].base.negative;
+        tabular += nxt_http_route_addr_pattern_tabular(&pattern[i]);
+    }
+
+    /* An empty rule matches nothing. */
+    addr_rule->positive = (negative != n || n == 0);
+
+    if (tabular == 0) {
+        return NXT_OK;
+    }
+
+    /* The negative patterns go first. */
+
+    if (negative != 0) {
+        addr_rule->exclude = nxt_http_route_addr_table_create(mp, pattern,
+                                                              negative);
+        if (nxt_slow_path(addr_rule->exclude == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    if (negative != n) {
+        addr_rule->include = nxt_http_route_addr_table_create(mp,
+                                                        &pattern[negative],
+                                                        n - negative);
+        if (nxt_slow_path(addr_rule->include == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    addr_rule->items = 0;
+
+    for (i = 0; i < n; i++) {
+        if (!nxt_http_route_addr_pattern_tabular(&pattern[i])) {
+            pattern[addr_rule->items++] = pattern[i];
+        }
+    }
+
+    return NXT_OK;
+}
+
+
 nxt_http_route_rule_t *
 nxt_http_route_types_rule_create(nxt_task_t *task, nxt_mp_t *mp,
     nxt_conf_value_t *types)
@@ -1231,6 +1420,347 @@ nxt_http_route_pattern_slice(nxt_array_t *slices,
 }
 
 
+typedef struct {
+    nxt_http_route_object_t        object;
+    uintptr_t                      offset;
+} nxt_http_route_index_conf_t;
+
+
+static const nxt_http_route_index_conf_t  nxt_http_route_index_conf[] = {
+    { NXT_HTTP_ROUTE_STRING_PTR, offsetof(nxt_http_request_t, path) },
+    { NXT_HTTP_ROUTE_STRING, offsetof(nxt_http_request_t, host) },
+    { NXT_HTTP_ROUTE_STRING_PTR, offsetof(nxt_http_request_t, method) },
+};
+
+
+static const nxt_lvlhsh_proto_t  nxt_http_route_key_hash_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    nxt_http_route_key_test,
+    nxt_lvlhsh_alloc,
+    nxt_lvlhsh_free,
+};
+
+
+static nxt_int_t
+nxt_http_route_dispatch_create(nxt_mp_t *mp, nxt_http_route_t *route)
+{
+    nxt_int_t                  ret;
+    nxt_uint_t                 n;
+    nxt_bool_t                 indexed;
+    nxt_http_route_dispatch_t  *dispatch;
+
+    if (route->items < NXT_HTTP_ROUTE_DISPATCH_MIN) {
+        return NXT_OK;
+    }
+
+    dispatch = nxt_mp_zalloc(mp, sizeof(nxt_http_route_dispatch_t));
+    if (nxt_slow_path(dispatch == NULL)) {
+        return NXT_ERROR;
+    }
+
+    indexed = 0;
+
+    for (n = 0; n < nxt_nitems(nxt_http_route_index_conf); n++) {
+        ret = nxt_http_route_index_create(mp, route, &dispatch->index[n], n);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        indexed |= (dispatch->index[n].keys != 0);
+    }
+
+    if (indexed) {
+        route->dispatch = dispatch;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_route_index_create(nxt_mp_t *mp, nxt_http_route_t *route,
+    nxt_http_route_index_t *index, nxt_uint_t n)
+{
+    uint32_t                        i, j, k, *length, *p;
+    nxt_int_t                       ret;
+    nxt_bool_t                      prefix;
+    nxt_lvlhsh_t                    *hash;
+    nxt_http_route_rule_t           *rule;
+    nxt_http_route_pattern_t        *pattern;
+    nxt_http_route_pattern_slice_t  *slice;
+
+    index->prefix_lengths = nxt_array_create(mp, 4, sizeof(uint32_t));
+    if (nxt_slow_path(index->prefix_lengths == NULL)) {
+        return NXT_ERROR;
+    }
+
+    index->rest = nxt_array_create(mp, 4, sizeof(uint32_t));
+    if (nxt_slow_path(index->rest == NULL)) {
+        return NXT_ERROR;
+    }
+
+    /* Distinct prefix lengths are sorted to stop at the value length. */
+
+    for (i = 0; i < route->items; i++) {
+        rule = nxt_http_route_index_rule(route->match[i], n);
+
+        if (rule == NULL || !nxt_http_route_rule_indexable(rule, 1)) {
+            continue;
+        }
+
+        for (j = 0; j < rule->items; j++) {
+            slice = nxt_http_route_pattern_key(&rule->pattern[j]);
+
+            if (slice == NULL || slice->type != NXT_HTTP_ROUTE_PATTERN_BEGIN) {
+                continue;
+            }
+
+            length = index->prefix_lengths->elts;
+
+            for (k = 0; k < index->prefix_lengths->nelts; k++) {
+                if (length[k] >= slice->length) {
+                    break;
+                }
+            }
+
+            if (k < index->prefix_lengths->nelts
+                && length[k] == slice->length)
+            {
+                continue;
+            }
+
+            p = nxt_array_add(index->prefix_lengths);
+            if (nxt_slow_path(p == NULL)) {
+                return NXT_ERROR;
+            }
+
+            length = index->prefix_lengths->elts;
+
+            nxt_memmove(&length[k + 1], &length[k],
+                        (index->prefix_lengths->nelts - k - 1)
+                        * sizeof(uint32_t));
+
+            length[k] = slice->length;
+        }
+    }
+
+    /*
+     * Each prefix length adds a list to merge along with the exact value
+     * and the rest lists, so too many lengths disable prefix lookups.
+     */
+    prefix = (index->prefix_lengths->nelts
+              <= NXT_HTTP_ROUTE_DISPATCH_LISTS - 2);
+
+    if (!prefix) {
+        index->prefix_lengths->nelts = 0;
+    }
+
+    for (i = 0; i < route->items; i++) {
+        rule = nxt_http_route_index_rule(route->match[i], n);
+
+        if (rule == NULL || !nxt_http_route_rule_indexable(rule, prefix)) {
+            p = nxt_array_add(index->rest);
+            if (nxt_slow_path(p == NULL)) {
+                return NXT_ERROR;
+            }
+
+            *p = i;
+            continue;
+        }
+
+        for (j = 0; j < rule->items; j++) {
+            pattern = &rule->pattern[j];
+
+            if (pattern->negative) {
+                continue;
+            }
+
+            slice = nxt_http_route_pattern_key(pattern);
+
+            hash = (slice->type == NXT_HTTP_ROUTE_PATTERN_EXACT)
+                   ? &index->exact : &index->prefix;
+
+            ret = nxt_http_route_index_add(mp, hash, slice, i);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NXT_ERROR;
+            }
+
+            index->keys++;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_http_route_rule_t *
+nxt_http_route_index_rule(nxt_http_route_match_t *match, nxt_uint_t n)
+{
+    uint32_t                           i;
+    nxt_http_route_rule_t              *rule;
+    const nxt_http_route_index_conf_t  *conf;
+
+    conf = &nxt_http_route_index_conf[n];
+
+    for (i = 0; i < match->items; i++) {
+        rule = match->test[i].rule;
+
+        if (rule->object == conf->object && rule->u.offset == conf->offset) {
+            return rule;
+        }
+    }
+
+    return NULL;
+}
+
+
+/*
+ * A rule can be indexed if it has positive patterns and all of them
+ * are exact values or prefixes.  Negative patterns are tested later.
+ */
+
+static nxt_bool_t
+nxt_http_route_rule_indexable(nxt_http_route_rule_t *rule, nxt_bool_t prefix)
+{
+    uint32_t                        i;
+    nxt_bool_t                      positive;
+    nxt_http_route_pattern_t        *pattern;
+    nxt_http_route_pattern_slice_t  *slice;
+
+    positive = 0;
+
+    for (i = 0; i < rule->items; i++) {
+        pattern = &rule->pattern[i];
+
+        if (pattern->negative) {
+            continue;
+        }
+
+        slice = nxt_http_route_pattern_key(pattern);
+
+        if (slice == NULL
+            || (!prefix && slice->type == NXT_HTTP_ROUTE_PATTERN_BEGIN))
+        {
+            return 0;
+        }
+
+        positive = 1;
+    }
+
+    return positive;
+}
+
+
+static nxt_http_route_pattern_slice_t *
+nxt_http_route_pattern_key(nxt_http_route_pattern_t *pattern)
+{
+    nxt_http_route_pattern_slice_t  *slice;
+
+#if (NXT_HAVE_REGEX)
+    if (pattern->regex) {
+        return NULL;
+    }
+#endif
+
+    if (!pattern->case_sensitive || pattern->u.pattern_slices->nelts != 1) {
+        return NULL;
+    }
+
+    slice = pattern->u.pattern_slices->elts;
+
+    if (slice->length != pattern->min_length) {
+        return NULL;
+    }
+
+    switch (slice->type) {
+
+    case NXT_HTTP_ROUTE_PATTERN_EXACT:
+        return slice;
+
+    case NXT_HTTP_ROUTE_PATTERN_BEGIN:
+        return (slice->length != 0) ? slice : NULL;
+
+    default:
+        return NULL;
+    }
+}
+
+
+static nxt_int_t
+nxt_http_route_index_add(nxt_mp_t *mp, nxt_lvlhsh_t *hash,
+    nxt_http_route_pattern_slice_t *slice, uint32_t i)
+{
+    uint32_t              *p;
+    nxt_int_t             ret;
+    nxt_lvlhsh_query_t    lhq;
+    nxt_http_route_key_t  *key;
+
+    lhq.key.length = slice->length;
+    lhq.key.start = slice->start;
+    lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
+    lhq.proto = &nxt_http_route_key_hash_proto;
+
+    if (nxt_lvlhsh_find(hash, &lhq) == NXT_OK) {
+        key = lhq.value;
+
+        p = key->matches->elts;
+
+        /* A rule may have the same pattern twice. */
+        if (p[key->matches->nelts - 1] == i) {
+            return NXT_OK;
+        }
+
+    } else {
+        key = nxt_mp_get(mp, sizeof(nxt_http_route_key_t));
+        if (nxt_slow_path(key == NULL)) {
+            return NXT_ERROR;
+        }
+
+        key->key = lhq.key;
+
+        key->matches = nxt_array_create(mp, 1, sizeof(uint32_t));
+        if (nxt_slow_path(key->matches == NULL)) {
+            return NXT_ERROR;
+        }
+
+        lhq.replace = 0;
+        lhq.value = key;
+        lhq.pool = mp;
+
+        ret = nxt_lvlhsh_insert(hash, &lhq);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+    }
+
+    p = nxt_array_add(key->matches);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    *p = i;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_route_key_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_http_route_key_t  *key;
+
+    key = data;
+
+    if (nxt_strstr_eq(&lhq->key, &key->key)) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
 nxt_int_t
 nxt_http_routes_resolve(nxt_task_t *task, nxt_router_temp_conf_t *tmcf)
 {
@@ -1570,6 +2100,25 @@ nxt_http_route_handler(nxt_task_t *task, nxt_http_request_t *r,
 
     route = start->u.route;
 
+    /* The index is not used to log every discarded match. */
+
+    if (route->dispatch != NULL && !r->log_route) {
+        action = nxt_http_route_dispatch(task, r, route);
+
+        if (action != NULL) {
+
+            if (action != NXT_HTTP_ACTION_ERROR) {
+                r->action = action;
+            }
+
+            return action;
+        }
+
+        nxt_http_request_error(task, r, NXT_HTTP_NOT_FOUND);
+
+        return NULL;
+    }
+
     for (i = 0; i < route->items; i++) {
         action = nxt_http_route_match(task, r, route->match[i]);
 
@@ -1600,6 +2149,154 @@ nxt_http_route_handler(nxt_task_t *task, nxt_http_request_t *r,
 }
 
 
+static nxt_http_action_t *
+nxt_http_route_dispatch(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_route_t *route)
+{
+    size_t                  total, min;
+    uint32_t                i, next;
+    nxt_uint_t              n, nlists, k;
+    nxt_http_action_t       *action;
+    nxt_http_route_list_t   *list, *lists, *end, *tmp;
+    nxt_http_route_index_t  *index;
+    nxt_http_route_list_t   lists1[NXT_HTTP_ROUTE_DISPATCH_LISTS];
+    nxt_http_route_list_t   lists2[NXT_HTTP_ROUTE_DISPATCH_LISTS];
+
+    lists = lists1;
+    tmp = lists2;
+    nlists = 0;
+    min = 0;
+
+    /* The index which leaves the least matches to test is used. */
+
+    for (k = 0; k < nxt_nitems(nxt_http_route_index_conf); k++) {
+        index = &route->dispatch->index[k];
+
+        if (index->keys == 0) {
+            continue;
+        }
+
+        n = nxt_http_route_index_lists(r, index, k, tmp, &total);
+
+        if (nlists == 0 || total < min) {
+            list = lists;
+            lists = tmp;
+            tmp = list;
+
+            nlists = n;
+            min = total;
+        }
+    }
+
+    end = lists + nlists;
+    next = 0;
+
+    for ( ;; ) {
+        i = route->items;
+
+        for (list = lists; list < end; list++) {
+
+            /* A match may be found both by value and by prefix. */
+            while (list->start < list->end && *list->start < next) {
+                list->start++;
+            }
+
+            if (list->start < list->end && *list->start < i) {
+                i = *list->start;
+            }
+        }
+
+        if (i == route->items) {
+            return NULL;
+        }
+
+        next = i + 1;
+
+        action = nxt_http_route_match(task, r, route->match[i]);
+
+        if (action != NULL) {
+            return action;
+        }
+    }
+}
+
+
+static nxt_uint_t
+nxt_http_route_index_lists(nxt_http_request_t *r,
+    nxt_http_route_index_t *index, nxt_uint_t n, nxt_http_route_list_t *lists,
+    size_t *total)
+{
+    void                               *p;
+    uint32_t                           i, *length;
+    nxt_str_t                          *s;
+    nxt_http_route_list_t              *list, *l;
+    const nxt_http_route_index_conf_t  *conf;
+
+    conf = &nxt_http_route_index_conf[n];
+
+    p = nxt_pointer_to(r, conf->offset);
+
+    s = (conf->object == NXT_HTTP_ROUTE_STRING) ? p : *(nxt_str_t **) p;
+
+    list = lists;
+
+    /* A missing value matches no pattern. */
+
+    if (s != NULL) {
+        list = nxt_http_route_index_find(&index->exact, s->start, s->length,
+                                         list);
+
+        length = index->prefix_lengths->elts;
+
+        for (i = 0; i < index->prefix_lengths->nelts; i++) {
+            if (length[i] > s->length) {
+                break;
+            }
+
+            list = nxt_http_route_index_find(&index->prefix, s->start,
+                                             length[i], list);
+        }
+    }
+
+    list->start = index->rest->elts;
+    list->end = list->start + index->rest->nelts;
+    list++;
+
+    *total = 0;
+
+    for (l = lists; l < list; l++) {
+        *total += l->end - l->start;
+    }
+
+    return list - lists;
+}
+
+
+static nxt_http_route_list_t *
+nxt_http_route_index_find(nxt_lvlhsh_t *hash, u_char *start, size_t length,
+    nxt_http_route_list_t *list)
+{
+    nxt_lvlhsh_query_t    lhq;
+    nxt_http_route_key_t  *key;
+
+    lhq.key.length = length;
+    lhq.key.start = start;
+    lhq.key_hash = nxt_djb_hash(start, length);
+    lhq.proto = &nxt_http_route_key_hash_proto;
+
+    if (nxt_lvlhsh_find(hash, &lhq) != NXT_OK) {
+        return list;
+    }
+
+    key = lhq.value;
+
+    list->start = key->matches->elts;
+    list->end = list->start + key->matches->nelts;
+
+    return list + 1;
+}
+
+
 static nxt_http_action_t *
 nxt_http_route_match(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_route_match_t *match)
@@ -1879,39 +2576,40 @@ nxt_int_t
 nxt_http_route_addr_rule(nxt_http_request_t *r,
     nxt_http_route_addr_rule_t *addr_rule, nxt_sockaddr_t *sa)
 {
-    uint32_t                       n;
-    nxt_bool_t                     matches;
-    nxt_http_route_addr_pattern_t  *p;
+    nxt_http_route_addr_pattern_t  *p, *end;
 
-    n = addr_rule->items;
+    p = addr_rule->addr_pattern;
+    end = p + addr_rule->items;
 
-    if (n == 0) {
+    if (addr_rule->exclude != NULL
+        && nxt_http_route_addr_table_find(addr_rule->exclude, sa))
+    {
         return 0;
     }
 
-    p = &addr_rule->addr_pattern[0] - 1;
+    while (p < end && p->base.negative) {
+        if (!nxt_http_route_addr_pattern_match(p, sa)) {
+            return 0;
+        }
 
-    do {
         p++;
-        n--;
-
-        matches = nxt_http_route_addr_pattern_match(p, sa);
-
-        if (p->base.negative) {
-            if (matches) {
-                continue;
-            }
+    }
 
-            return 0;
-        }
+    if (addr_rule->include != NULL
+        && nxt_http_route_addr_table_find(addr_rule->include, sa))
+    {
+        return 1;
+    }
 
-        if (matches) {
+    while (p < end) {
+        if (nxt_http_route_addr_pattern_match(p, sa)) {
             return 1;
         }
 
-    } while (n > 0);
+        p++;
+    }
 
-    return p->base.negative;
+    return !addr_rule->positive;
 }
 
 
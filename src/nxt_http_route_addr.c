@@ -8,7 +8,16 @@
 #include <nxt_http_route_addr.h>
 
 
+static void nxt_http_route_addr_table_add(nxt_http_route_addr_table_t *table,
+    nxt_http_route_addr_pattern_t *pattern);
+static uint32_t nxt_http_route_addr_table_merge(
+    nxt_http_route_addr_span_t *span, uint32_t n);
+static int nxt_http_route_addr_span_compare(const void *one, const void *two);
 #if (NXT_INET6)
+static uint32_t nxt_http_route_addr_table_merge6(
+    nxt_http_route_in6_addr_range_t *range, uint32_t n);
+static int nxt_http_route_addr_range6_compare(const void *one,
+    const void *two);
 static nxt_bool_t nxt_valid_ipv6_blocks(u_char *c, size_t len);
 #endif
 
@@ -313,6 +322,337 @@ nxt_http_route_addr_pattern_parse(nxt_mp_t *mp,
 }
 
 
+/*
+ * Only the address matters for patterns without a port, so they can be
+ * merged into a table of address ranges looked up with a binary search.
+ */
+
+nxt_bool_t
+nxt_http_route_addr_pattern_tabular(nxt_http_route_addr_pattern_t *pattern)
+{
+    nxt_http_route_addr_base_t  *base;
+
+    base = &pattern->base;
+
+    if (base->port.start != 0 || base->port.end != 65535) {
+        return 0;
+    }
+
+#if (NXT_INET6)
+    if (base->addr_family == AF_INET6) {
+        return 1;
+    }
+#endif
+
+    return (base->addr_family == AF_INET);
+}
+
+
+nxt_http_route_addr_table_t *
+nxt_http_route_addr_table_create(nxt_mp_t *mp,
+    nxt_http_route_addr_pattern_t *pattern, nxt_uint_t n)
+{
+    uint32_t                     items;
+#if (NXT_INET6)
+    uint32_t                     items6;
+#endif
+    nxt_uint_t                   i;
+    nxt_http_route_addr_table_t  *table;
+
+    items = 0;
+#if (NXT_INET6)
+    items6 = 0;
+#endif
+
+    for (i = 0; i < n; i++) {
+        if (!nxt_http_route_addr_pattern_tabular(&pattern[i])) {
+            continue;
+        }
+
+#if (NXT_INET6)
+        if (pattern[i].base.addr_family == AF_INET6) {
+            items6++;
+            continue;
+        }
+#endif
+
+        items++;
+    }
+
+    table = nxt_mp_zget(mp, sizeof(nxt_http_route_addr_table_t));
+    if (nxt_slow_path(table == NULL)) {
+        return NULL;
+    }
+
+    if (items != 0) {
+        table->v4 = nxt_mp_nget(mp, items * sizeof(nxt_http_route_addr_span_t));
+        if (nxt_slow_path(table->v4 == NULL)) {
+            return NULL;
+        }
+    }
+
+#if (NXT_INET6)
+    if (items6 != 0) {
+        table->v6 = nxt_mp_nget(mp, items6
+                                    * sizeof(nxt_http_route_in6_addr_range_t));
+        if (nxt_slow_path(table->v6 == NULL)) {
+            return NULL;
+        }
+    }
+#endif
+
+    for (i = 0; i < n; i++) {
+        if (nxt_http_route_addr_pattern_tabular(&pattern[i])) {
+            nxt_http_route_addr_table_add(table, &pattern[i]);
+        }
+    }
+
+    table->items = nxt_http_route_addr_table_merge(table->v4, table->items);
+
+#if (NXT_INET6)
+    table->items6 = nxt_http_route_addr_table_merge6(table->v6,
+                                                     table->items6);
+#endif
+
+    return table;
+}
+
+
+static void
+nxt_http_route_addr_table_add(nxt_http_route_addr_table_t *table,
+    nxt_http_route_addr_pattern_t *pattern)
+{
+#if (NXT_INET6)
+    uint32_t                         i;
+    nxt_http_route_in6_addr_range_t  *range;
+#endif
+    nxt_http_route_addr_span_t       *span;
+
+#if (NXT_INET6)
+    if (pattern->base.addr_family == AF_INET6) {
+        range = &table->v6[table->items6++];
+
+        switch (pattern->base.match_type) {
+
+        case NXT_HTTP_ROUTE_ADDR_ANY:
+            nxt_memset(&range->start, 0x00, sizeof(struct in6_addr));
+            nxt_memset(&range->end, 0xFF, sizeof(struct in6_addr));
+            break;
+
+        case NXT_HTTP_ROUTE_ADDR_EXACT:
+            range->start = pattern->addr.v6.start;
+            range->end = pattern->addr.v6.start;
+            break;
+
+        case NXT_HTTP_ROUTE_ADDR_RANGE:
+            *range = pattern->addr.v6;
+            break;
+
+        case NXT_HTTP_ROUTE_ADDR_CIDR:
+            range->start = pattern->addr.v6.start;
+
+            for (i = 0; i < sizeof(struct in6_addr); i++) {
+                range->end.s6_addr[i] = pattern->addr.v6.start.s6_addr[i]
+                                        | ~pattern->addr.v6.end.s6_addr[i];
+            }
+
+            break;
+
+        default:
+            nxt_unreachable();
+        }
+
+        return;
+    }
+#endif
+
+    span = &table->v4[table->items++];
+
+    switch (pattern->base.match_type) {
+
+    case NXT_HTTP_ROUTE_ADDR_ANY:
+        span->start = 0;
+        span->end = 0xFFFFFFFF;
+        break;
+
+    case NXT_HTTP_ROUTE_ADDR_EXACT:
+        span->start = ntohl(pattern->addr.v4.start);
+        span->end = span->start;
+        break;
+
+    case NXT_HTTP_ROUTE_ADDR_RANGE:
+        span->start = ntohl(pattern->addr.v4.start);
+        span->end = ntohl(pattern->addr.v4.end);
+        break;
+
+    case NXT_HTTP_ROUTE_ADDR_CIDR:
+        span->start = ntohl(pattern->addr.v4.start);
+        span->end = span->start | ~ntohl(pattern->addr.v4.end);
+        break;
+
+    default:
+        nxt_unreachable();
+    }
+}
+
+
+static uint32_t
+nxt_http_route_addr_table_merge(nxt_http_route_addr_span_t *span, uint32_t n)
+{
+    uint32_t  i, k;
+
+    if (n < 2) {
+        return n;
+    }
+
+    nxt_qsort(span, n, sizeof(nxt_http_route_addr_span_t),
+              nxt_http_route_addr_span_compare);
+
+    k = 0;
+
+    for (i = 1; i < n; i++) {
+        if (span[i].start <= span[k].end) {
+            span[k].end = nxt_max(span[k].end, span[i].end);
+            continue;
+        }
+
+        span[++k] = span[i];
+    }
+
+    return k + 1;
+}
+
+
+static int
+nxt_http_route_addr_span_compare(const void *one, const void *two)
+{
+    const nxt_http_route_addr_span_t  *s1, *s2;
+
+    s1 = one;
+    s2 = two;
+
+    return (s1->start > s2->start) - (s1->start < s2->start);
+}
+
+
+#if (NXT_INET6)
+
+static uint32_t
+nxt_http_route_addr_table_merge6(nxt_http_route_in6_addr_range_t *range,
+    uint32_t n)
+{
+    uint32_t  i, k;
+
+    if (n < 2) {
+        return n;
+    }
+
+    nxt_qsort(range, n, sizeof(nxt_http_route_in6_addr_range_t),
+              nxt_http_route_addr_range6_compare);
+
+    k = 0;
+
+    for (i = 1; i < n; i++) {
+        if (memcmp(&range[i].start, &range[k].end, sizeof(struct in6_addr))
+            <= 0)
+        {
+            if (memcmp(&range[i].end, &range[k].end, sizeof(struct in6_addr))
+                > 0)
+            {
+                range[k].end = range[i].end;
+            }
+
+            continue;
+        }
+
+        range[++k] = range[i];
+    }
+
+    return k + 1;
+}
+
+
+static int
+nxt_http_route_addr_range6_compare(const void *one, const void *two)
+{
+    const nxt_http_route_in6_addr_range_t  *r1, *r2;
+
+    r1 = one;
+    r2 = two;
+
+    return memcmp(&r1->start, &r2->start, sizeof(struct in6_addr));
+}
+
+#endif
+
+
+nxt_bool_t
+nxt_http_route_addr_table_find(nxt_http_route_addr_table_t *table,
+    nxt_sockaddr_t *sa)
+{
+    uint32_t                         addr, lo, hi, mid;
+#if (NXT_INET6)
+    struct in6_addr                  *addr6;
+    nxt_http_route_in6_addr_range_t  *range;
+#endif
+    nxt_http_route_addr_span_t       *span;
+
+    /* The number of ranges starting at or before the address is searched. */
+
+    switch (sa->u.sockaddr.sa_family) {
+
+    case AF_INET:
+        addr = ntohl(sa->u.sockaddr_in.sin_addr.s_addr);
+        span = table->v4;
+
+        lo = 0;
+        hi = table->items;
+
+        while (lo < hi) {
+            mid = lo + (hi - lo) / 2;
+
+            if (span[mid].start <= addr) {
+                lo = mid + 1;
+
+            } else {
+                hi = mid;
+            }
+        }
+
+        return (lo != 0 && addr <= span[lo - 1].end);
+
+#if (NXT_INET6)
+    case AF_INET6:
+        addr6 = &sa->u.sockaddr_in6.sin6_addr;
+        range = table->v6;
+
+        lo = 0;
+        hi = table->items6;
+
+        while (lo < hi) {
+            mid = lo + (hi - lo) / 2;
+
+            if (memcmp(&range[mid].start, addr6, sizeof(struct in6_addr))
+                <= 0)
+            {
+                lo = mid + 1;
+
+            } else {
+                hi = mid;
+            }
+        }
+
+        return (lo != 0
+                && memcmp(addr6, &range[lo - 1].end, sizeof(struct in6_addr))
+                   <= 0);
+#endif
+
+    default:
+        return 0;
+    }
+}
+
+
 #if (NXT_INET6)
 
 static nxt_bool_t
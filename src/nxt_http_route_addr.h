@@ -68,7 +68,34 @@ typedef struct {
 } nxt_http_route_addr_pattern_t;
 
 
+/*
+ * The table of disjoint address ranges sorted by the start address.
+ * IPv4 ranges are kept in host byte order, IPv6 ones in network byte order.
+ */
+
+typedef struct {
+    uint32_t                             start;
+    uint32_t                             end;
+} nxt_http_route_addr_span_t;
+
+
+typedef struct {
+    uint32_t                             items;
+    nxt_http_route_addr_span_t           *v4;
+#if (NXT_INET6)
+    uint32_t                             items6;
+    nxt_http_route_in6_addr_range_t      *v6;
+#endif
+} nxt_http_route_addr_table_t;
+
+
 NXT_EXPORT nxt_int_t nxt_http_route_addr_pattern_parse(nxt_mp_t *mp,
     nxt_http_route_addr_pattern_t *pattern, nxt_conf_value_t *cv);
+NXT_EXPORT nxt_bool_t nxt_http_route_addr_pattern_tabular(
+    nxt_http_route_addr_pattern_t *pattern);
+NXT_EXPORT nxt_http_route_addr_table_t *nxt_http_route_addr_table_create(
+    nxt_mp_t *mp, nxt_http_route_addr_pattern_t *pattern, nxt_uint_t n);
+NXT_EXPORT nxt_bool_t nxt_http_route_addr_table_find(
+    nxt_http_route_addr_table_t *table, nxt_sockaddr_t *sa);
 
 #endif /* _NXT_HTTP_ROUTE_ADDR_H_INCLUDED_ */
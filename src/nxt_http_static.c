@@ -16,6 +16,20 @@ typedef struct {
 } nxt_http_static_share_t;
 
 
+/*
+ * Precompressed variants of a file are looked up by the suffix
+ * appended to its name.
+ */
+
+typedef struct {
+    nxt_str_t                   name;
+    nxt_str_t                   suffix;
+} nxt_http_static_encoding_t;
+
+
+#define NXT_HTTP_STATIC_ENCODINGS  3
+
+
 typedef struct {
     nxt_uint_t                  nshares;
     nxt_http_static_share_t     *shares;
@@ -25,6 +39,9 @@ typedef struct {
     nxt_uint_t                  resolve;
 #endif
     nxt_http_route_rule_t       *types;
+    nxt_uint_t                  nencodings;
+    const nxt_http_static_encoding_t
+                                *encodings[NXT_HTTP_STATIC_ENCODINGS];
 } nxt_http_static_conf_t;
 
 
@@ -42,6 +59,47 @@ typedef struct {
 #define NXT_HTTP_STATIC_BUF_COUNT  2
 #define NXT_HTTP_STATIC_BUF_SIZE   (128 * 1024)
 
+#define NXT_HTTP_STATIC_RANGES     16
+
+
+typedef struct {
+    nxt_off_t                   start;
+    nxt_off_t                   end;
+} nxt_http_static_range_t;
+
+
+/*
+ * Descriptors of opened regular files are cached per engine along with
+ * their information.  An entry is shared by requests; once it is expired
+ * or evicted, the descriptor is closed after the last request is done.
+ */
+
+typedef struct {
+    nxt_file_t                  file;
+    nxt_file_info_t             info;
+    nxt_queue_link_t            link;
+    nxt_msec_t                  expire;
+    uint32_t                    count;
+    uint8_t                     deleted;  /* 1 bit */
+    nxt_str_t                   key;
+} nxt_http_static_cache_file_t;
+
+
+typedef struct {
+    nxt_lvlhsh_t                hash;
+    nxt_queue_t                 lru;
+    uint32_t                    count;
+    nxt_msec_t                  valid;
+    nxt_timer_t                 timer;
+} nxt_http_static_cache_t;
+
+
+typedef struct {
+    /* The file must be the first field. */
+    nxt_file_t                  file;
+    nxt_http_static_cache_file_t  *cached;
+} nxt_http_static_file_t;
+
 
 static nxt_http_action_t *nxt_http_static(nxt_task_t *task,
     nxt_http_request_t *r, nxt_http_action_t *action);
@@ -51,15 +109,51 @@ static void nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data);
 static void nxt_http_static_send_error(nxt_task_t *task, void *obj, void *data);
 static void nxt_http_static_next(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_static_ctx_t *ctx, nxt_http_status_t status);
+static nxt_int_t nxt_http_static_open(nxt_task_t *task,
+    nxt_http_static_ctx_t *ctx, nxt_file_t *file, u_char **fname);
+static nxt_int_t nxt_http_static_variant(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_static_ctx_t *ctx, u_char *fname,
+    nxt_http_static_file_t **sfp, nxt_file_info_t *fi,
+    const nxt_str_t **encoding);
 #if (NXT_HAVE_OPENAT2)
 static u_char *nxt_http_static_chroot_match(u_char *chr, u_char *shr);
 #endif
+static nxt_bool_t nxt_http_static_not_modified(nxt_http_request_t *r,
+    nxt_file_info_t *fi, nxt_str_t *etag);
+static nxt_bool_t nxt_http_static_etag_match(nxt_http_field_t *field,
+    nxt_str_t *etag);
+static nxt_int_t nxt_http_static_range(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_file_t *f, nxt_file_info_t *fi, nxt_str_t *etag, nxt_str_t *mtype);
+static nxt_int_t nxt_http_static_range_parse(nxt_http_field_t *field,
+    nxt_off_t size, nxt_http_static_range_t *ranges);
+static nxt_buf_t *nxt_http_static_range_buf(nxt_mp_t *mp, nxt_file_t *f,
+    size_t size);
+static nxt_int_t nxt_http_static_cache_key(nxt_http_request_t *r,
+    nxt_http_static_conf_t *conf, nxt_http_static_ctx_t *ctx, u_char *fname,
+    nxt_str_t *key);
+static nxt_http_static_cache_file_t *nxt_http_static_cache_find(
+    nxt_task_t *task, nxt_str_t *key);
+static nxt_http_static_cache_file_t *nxt_http_static_cache_add(
+    nxt_task_t *task, nxt_router_conf_t *rtcf, nxt_str_t *key,
+    nxt_file_t *file, nxt_file_info_t *fi);
+static void nxt_http_static_cache_delete(nxt_task_t *task,
+    nxt_http_static_cache_t *cache, nxt_http_static_cache_file_t *cf);
+static void nxt_http_static_cache_timer_handler(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_int_t nxt_http_static_cache_hash_test(nxt_lvlhsh_query_t *lhq,
+    void *data);
+static void nxt_http_static_file_close(nxt_task_t *task, nxt_file_t *f);
 static void nxt_http_static_extract_extension(nxt_str_t *path,
     nxt_str_t *exten);
 static void nxt_http_static_body_handler(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_http_static_buf_completion(nxt_task_t *task, void *obj,
     void *data);
+static void nxt_http_static_sendfile(nxt_task_t *task, nxt_http_request_t *r);
+static void nxt_http_static_sendfile_completion(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_static_file_cleanup(nxt_task_t *task, void *obj,
+    void *data);
 
 static nxt_int_t nxt_http_static_mtypes_hash_test(nxt_lvlhsh_query_t *lhq,
     void *data);
@@ -70,11 +164,30 @@ static void nxt_http_static_mtypes_hash_free(void *data, void *p);
 static const nxt_http_request_state_t  nxt_http_static_send_state;
 
 
+static const nxt_http_static_encoding_t
+    nxt_http_static_encodings[NXT_HTTP_STATIC_ENCODINGS] =
+{
+    { nxt_string("br"),   nxt_string(".br") },
+    { nxt_string("zstd"), nxt_string(".zst") },
+    { nxt_string("gzip"), nxt_string(".gz") },
+};
+
+
+static const nxt_lvlhsh_proto_t  nxt_http_static_cache_hash_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    nxt_http_static_cache_hash_test,
+    nxt_lvlhsh_alloc,
+    nxt_lvlhsh_free,
+};
+
+
 nxt_int_t
 nxt_http_static_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     nxt_http_action_t *action, nxt_http_action_conf_t *acf)
 {
-    uint32_t                i;
+    uint32_t                i, j, n;
     nxt_mp_t                *mp;
     nxt_str_t               str, *ret;
     nxt_tstr_t              *tstr;
@@ -169,6 +282,40 @@ nxt_http_static_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         }
     }
 
+    if (acf->precompressed == NULL) {
+        n = 0;
+
+    } else if (nxt_conf_type(acf->precompressed) == NXT_CONF_BOOLEAN) {
+        n = nxt_conf_get_boolean(acf->precompressed)
+            ? NXT_HTTP_STATIC_ENCODINGS : 0;
+
+        for (i = 0; i < n; i++) {
+            conf->encodings[i] = &nxt_http_static_encodings[i];
+        }
+
+    } else {
+        n = nxt_conf_array_elements_count_or_1(acf->precompressed);
+        n = nxt_min(n, NXT_HTTP_STATIC_ENCODINGS);
+
+        for (i = 0; i < n; i++) {
+            cv = nxt_conf_get_array_element_or_itself(acf->precompressed, i);
+            nxt_conf_get_string(cv, &str);
+
+            for (j = 0; j < NXT_HTTP_STATIC_ENCODINGS; j++) {
+                if (nxt_strstr_eq(&str, &nxt_http_static_encodings[j].name)) {
+                    conf->encodings[i] = &nxt_http_static_encodings[j];
+                    break;
+                }
+            }
+
+            if (nxt_slow_path(j == NXT_HTTP_STATIC_ENCODINGS)) {
+                return NXT_ERROR;
+            }
+        }
+    }
+
+    conf->nencodings = n;
+
     if (acf->fallback != NULL) {
         action->fallback = nxt_mp_alloc(mp, sizeof(nxt_http_action_t));
         if (nxt_slow_path(action->fallback == NULL)) {
@@ -306,7 +453,7 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
     struct tm               tm;
     nxt_buf_t               *fb;
     nxt_int_t               ret;
-    nxt_str_t               *shr, *index, exten, *mtype;
+    nxt_str_t               *shr, *index, exten, *mtype, etag, key;
     nxt_uint_t              level;
     nxt_file_t              *f, file;
     nxt_file_info_t         fi;
@@ -318,6 +465,9 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
     nxt_work_handler_t      body_handler;
     nxt_http_static_ctx_t   *ctx;
     nxt_http_static_conf_t  *conf;
+    nxt_http_static_file_t  *sf;
+    const nxt_str_t         *encoding;
+    nxt_http_static_cache_file_t  *cf;
 
     r = obj;
     ctx = data;
@@ -327,6 +477,7 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 
     f = NULL;
     mtype = NULL;
+    encoding = NULL;
 
     shr = &ctx->share;
     index = &conf->index;
@@ -369,70 +520,48 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
         fname = ctx->share.start;
     }
 
-    nxt_memzero(&file, sizeof(nxt_file_t));
-
-    file.name = fname;
-
-#if (NXT_HAVE_OPENAT2)
-    if (conf->resolve != 0 || ctx->chroot.length > 0) {
-        nxt_str_t                *chr;
-        nxt_uint_t               resolve;
-        nxt_http_static_share_t  *share;
-
-        share = &conf->shares[ctx->share_idx];
+    if (conf->nencodings > 0 && r->accept_encoding != NULL) {
+        ret = nxt_http_static_variant(task, r, ctx, fname, &sf, &fi,
+                                      &encoding);
+        if (nxt_slow_path(ret == NXT_ERROR)) {
+            goto fail;
+        }
 
-        resolve = conf->resolve;
-        chr = &ctx->chroot;
+        if (ret == NXT_OK) {
+            f = &sf->file;
+            goto found;
+        }
+    }
 
-        if (chr->length > 0) {
-            resolve |= RESOLVE_IN_ROOT;
+    nxt_str_null(&key);
 
-            fname = share->is_const
-                    ? share->fname
-                    : nxt_http_static_chroot_match(chr->start, file.name);
+    if (rtcf->open_file_cache_max > 0) {
+        ret = nxt_http_static_cache_key(r, conf, ctx, fname, &key);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto fail;
+        }
 
-            if (fname != NULL) {
-                file.name = chr->start;
-                ret = nxt_file_open(task, &file, NXT_FILE_SEARCH, NXT_FILE_OPEN,
-                                    0);
+        cf = nxt_http_static_cache_find(task, &key);
 
-            } else {
-                file.error = NXT_EACCES;
-                ret = NXT_ERROR;
+        if (cf != NULL) {
+            sf = nxt_mp_get(r->mem_pool, sizeof(nxt_http_static_file_t));
+            if (nxt_slow_path(sf == NULL)) {
+                goto fail;
             }
 
-        } else if (fname[0] == '/') {
-            file.name = (u_char *) "/";
-            ret = nxt_file_open(task, &file, NXT_FILE_SEARCH, NXT_FILE_OPEN, 0);
-
-        } else {
-            file.name = (u_char *) ".";
-            file.fd = AT_FDCWD;
-            ret = NXT_OK;
-        }
-
-        if (nxt_fast_path(ret == NXT_OK)) {
-            nxt_file_t  af;
+            cf->count++;
 
-            af = file;
-            nxt_memzero(&file, sizeof(nxt_file_t));
-            file.name = fname;
+            sf->file = cf->file;
+            sf->cached = cf;
 
-            ret = nxt_file_openat2(task, &file, NXT_FILE_RDONLY,
-                                   NXT_FILE_OPEN, 0, af.fd, resolve);
+            f = &sf->file;
+            fi = cf->info;
 
-            if (af.fd != AT_FDCWD) {
-                nxt_file_close(task, &af);
-            }
+            goto found;
         }
-
-    } else {
-        ret = nxt_file_open(task, &file, NXT_FILE_RDONLY, NXT_FILE_OPEN, 0);
     }
 
-#else
-    ret = nxt_file_open(task, &file, NXT_FILE_RDONLY, NXT_FILE_OPEN, 0);
-#endif
+    ret = nxt_http_static_open(task, ctx, &file, &fname);
 
     if (nxt_slow_path(ret != NXT_OK)) {
 
@@ -497,19 +626,28 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
         goto fail;
     }
 
-    f = nxt_mp_get(r->mem_pool, sizeof(nxt_file_t));
-    if (nxt_slow_path(f == NULL)) {
+    sf = nxt_mp_get(r->mem_pool, sizeof(nxt_http_static_file_t));
+    if (nxt_slow_path(sf == NULL)) {
         nxt_file_close(task, &file);
         goto fail;
     }
 
-    *f = file;
+    sf->file = file;
+    sf->cached = NULL;
+
+    f = &sf->file;
 
     ret = nxt_file_info(f, &fi);
     if (nxt_slow_path(ret != NXT_OK)) {
         goto fail;
     }
 
+    if (key.length > 0 && nxt_is_file(&fi)) {
+        sf->cached = nxt_http_static_cache_add(task, rtcf, &key, f, &fi);
+    }
+
+found:
+
     if (nxt_fast_path(nxt_is_file(&fi))) {
         r->status = NXT_HTTP_OK;
         r->resp.content_length_n = nxt_file_size(&fi);
@@ -526,7 +664,7 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
             goto fail;
         }
 
-        nxt_localtime(nxt_file_mtime(&fi), &tm);
+        nxt_gmtime(nxt_file_mtime(&fi), &tm);
 
         field->value = p;
         field->value_length = nxt_http_date(p, &tm) - p;
@@ -551,6 +689,35 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
                                           nxt_file_size(&fi))
                               - p;
 
+        etag.start = field->value;
+        etag.length = field->value_length;
+
+        field = nxt_list_zero_add(r->resp.fields);
+        if (nxt_slow_path(field == NULL)) {
+            goto fail;
+        }
+
+        nxt_http_field_set(field, "Accept-Ranges", "bytes");
+
+        if (encoding != NULL) {
+            field = nxt_list_zero_add(r->resp.fields);
+            if (nxt_slow_path(field == NULL)) {
+                goto fail;
+            }
+
+            nxt_http_field_name_set(field, "Content-Encoding");
+
+            field->value = encoding->start;
+            field->value_length = encoding->length;
+
+            field = nxt_list_zero_add(r->resp.fields);
+            if (nxt_slow_path(field == NULL)) {
+                goto fail;
+            }
+
+            nxt_http_field_set(field, "Vary", "Accept-Encoding");
+        }
+
         if (exten.start == NULL) {
             nxt_http_static_extract_extension(shr, &exten);
         }
@@ -559,39 +726,59 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
             mtype = nxt_http_static_mtype_get(&rtcf->mtypes_hash, &exten);
         }
 
-        if (mtype->length != 0) {
-            field = nxt_list_zero_add(r->resp.fields);
-            if (nxt_slow_path(field == NULL)) {
+        if (nxt_http_static_not_modified(r, &fi, &etag)) {
+            r->status = NXT_HTTP_NOT_MODIFIED;
+            r->resp.content_length_n = -1;
+            ret = NXT_OK;
+
+        } else if (ctx->need_body && r->range != NULL) {
+            ret = nxt_http_static_range(task, r, f, &fi, &etag, mtype);
+            if (nxt_slow_path(ret == NXT_ERROR)) {
                 goto fail;
             }
 
-            nxt_http_field_name_set(field, "Content-Type");
-
-            field->value = mtype->start;
-            field->value_length = mtype->length;
+        } else {
+            ret = NXT_DECLINED;
         }
 
-        if (ctx->need_body && nxt_file_size(&fi) > 0) {
-            fb = nxt_mp_zget(r->mem_pool, NXT_BUF_FILE_SIZE);
-            if (nxt_slow_path(fb == NULL)) {
-                goto fail;
+        if (ret == NXT_DECLINED) {
+            if (mtype->length != 0) {
+                field = nxt_list_zero_add(r->resp.fields);
+                if (nxt_slow_path(field == NULL)) {
+                    goto fail;
+                }
+
+                nxt_http_field_name_set(field, "Content-Type");
+
+                field->value = mtype->start;
+                field->value_length = mtype->length;
             }
 
-            fb->file = f;
-            fb->file_end = nxt_file_size(&fi);
+            if (ctx->need_body && nxt_file_size(&fi) > 0) {
+                fb = nxt_mp_zget(r->mem_pool, NXT_BUF_FILE_SIZE);
+                if (nxt_slow_path(fb == NULL)) {
+                    goto fail;
+                }
+
+                nxt_buf_set_file(fb);
+                fb->file = f;
+                fb->file_end = nxt_file_size(&fi);
 
-            r->out = fb;
+                r->out = fb;
+            }
+        }
 
+        if (r->out != NULL) {
             body_handler = &nxt_http_static_body_handler;
 
         } else {
-            nxt_file_close(task, f);
+            nxt_http_static_file_close(task, f);
             body_handler = NULL;
         }
 
     } else {
         /* Not a file. */
-        nxt_file_close(task, f);
+        nxt_http_static_file_close(task, f);
 
         if (nxt_slow_path(!nxt_is_dir(&fi)
                           || shr->start[shr->length - 1] == '/'))
@@ -655,7 +842,7 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 fail:
 
     if (f != NULL) {
-        nxt_file_close(task, f);
+        nxt_http_static_file_close(task, f);
     }
 
     nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
@@ -704,6 +891,224 @@ nxt_http_static_next(nxt_task_t *task, nxt_http_request_t *r,
 }
 
 
+static nxt_int_t
+nxt_http_static_open(nxt_task_t *task, nxt_http_static_ctx_t *ctx,
+    nxt_file_t *file, u_char **fname)
+{
+    nxt_int_t               ret;
+#if (NXT_HAVE_OPENAT2)
+    u_char                  *name;
+    nxt_http_static_conf_t  *conf;
+#endif
+
+    nxt_memzero(file, sizeof(nxt_file_t));
+
+    file->name = *fname;
+
+#if (NXT_HAVE_OPENAT2)
+    conf = ctx->action->u.conf;
+    name = *fname;
+
+    if (conf->resolve != 0 || ctx->chroot.length > 0) {
+        nxt_str_t                *chr;
+        nxt_uint_t               resolve;
+        nxt_http_static_share_t  *share;
+
+        share = &conf->shares[ctx->share_idx];
+
+        resolve = conf->resolve;
+        chr = &ctx->chroot;
+
+        if (chr->length > 0) {
+            resolve |= RESOLVE_IN_ROOT;
+
+            name = (share->is_const && name == ctx->share.start)
+                   ? share->fname
+                   : nxt_http_static_chroot_match(chr->start, name);
+
+            *fname = name;
+
+            if (name != NULL) {
+                file->name = chr->start;
+                ret = nxt_file_open(task, file, NXT_FILE_SEARCH, NXT_FILE_OPEN,
+                                    0);
+
+            } else {
+                file->error = NXT_EACCES;
+                ret = NXT_ERROR;
+            }
+
+        } else if (name[0] == '/') {
+            file->name = (u_char *) "/";
+            ret = nxt_file_open(task, file, NXT_FILE_SEARCH, NXT_FILE_OPEN, 0);
+
+        } else {
+            file->name = (u_char *) ".";
+            file->fd = AT_FDCWD;
+            ret = NXT_OK;
+        }
+
+        if (nxt_fast_path(ret == NXT_OK)) {
+            nxt_file_t  af;
+
+            af = *file;
+            nxt_memzero(file, sizeof(nxt_file_t));
+            file->name = name;
+
+            ret = nxt_file_openat2(task, file, NXT_FILE_RDONLY,
+                                   NXT_FILE_OPEN, 0, af.fd, resolve);
+
+            if (af.fd != AT_FDCWD) {
+                nxt_file_close(task, &af);
+            }
+        }
+
+        return ret;
+    }
+#endif
+
+    return nxt_file_open(task, file, NXT_FILE_RDONLY, NXT_FILE_OPEN, 0);
+}
+
+
+/*
+ * The variants are tried in the order of their Accept-Encoding quality
+ * values, equal values are tried in the configured order.  A missing
+ * variant is not an error, the file itself is sent instead.
+ */
+
+static nxt_int_t
+nxt_http_static_variant(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_static_ctx_t *ctx, u_char *fname, nxt_http_static_file_t **sfp,
+    nxt_file_info_t *fi, const nxt_str_t **encoding)
+{
+    u_char                            *p, *vname, *name;
+    size_t                            length;
+    nxt_int_t                         ret, best;
+    nxt_str_t                         key;
+    nxt_uint_t                        i, k, n;
+    nxt_file_t                        file;
+    nxt_router_conf_t                 *rtcf;
+    nxt_http_static_conf_t            *conf;
+    nxt_http_static_file_t            *sf;
+    nxt_http_static_cache_file_t      *cf;
+    const nxt_http_static_encoding_t  *enc;
+    nxt_str_t                         names[NXT_HTTP_STATIC_ENCODINGS];
+    nxt_int_t                         quality[NXT_HTTP_STATIC_ENCODINGS];
+
+    conf = ctx->action->u.conf;
+    rtcf = r->conf->socket_conf->router_conf;
+
+    n = conf->nencodings;
+
+    for (i = 0; i < n; i++) {
+        names[i] = conf->encodings[i]->name;
+    }
+
+    nxt_http_compress_accept(r->accept_encoding, names, quality, n);
+
+    length = nxt_strlen(fname);
+
+    vname = NULL;
+
+    for ( ;; ) {
+        best = 0;
+        k = n;
+
+        for (i = 0; i < n; i++) {
+            if (quality[i] > best) {
+                best = quality[i];
+                k = i;
+            }
+        }
+
+        if (k == n) {
+            return NXT_DECLINED;
+        }
+
+        quality[k] = 0;
+        enc = conf->encodings[k];
+
+        if (vname == NULL) {
+            vname = nxt_mp_nget(r->mem_pool, length + nxt_length(".zst") + 1);
+            if (nxt_slow_path(vname == NULL)) {
+                return NXT_ERROR;
+            }
+
+            nxt_memcpy(vname, fname, length);
+        }
+
+        p = nxt_cpymem(vname + length, enc->suffix.start, enc->suffix.length);
+        *p = '\0';
+
+        nxt_str_null(&key);
+
+        if (rtcf->open_file_cache_max > 0) {
+            ret = nxt_http_static_cache_key(r, conf, ctx, vname, &key);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NXT_ERROR;
+            }
+
+            cf = nxt_http_static_cache_find(task, &key);
+
+            if (cf != NULL) {
+                sf = nxt_mp_get(r->mem_pool, sizeof(nxt_http_static_file_t));
+                if (nxt_slow_path(sf == NULL)) {
+                    return NXT_ERROR;
+                }
+
+                cf->count++;
+
+                sf->file = cf->file;
+                sf->cached = cf;
+
+                *fi = cf->info;
+
+                break;
+            }
+        }
+
+        name = vname;
+
+        ret = nxt_http_static_open(task, ctx, &file, &name);
+
+        if (ret != NXT_OK) {
+            nxt_debug(task, "http static: \"%s\" variant not found %E",
+                      vname, file.error);
+            continue;
+        }
+
+        if (nxt_slow_path(nxt_file_info(&file, fi) != NXT_OK
+                          || !nxt_is_file(fi)))
+        {
+            nxt_file_close(task, &file);
+            continue;
+        }
+
+        sf = nxt_mp_get(r->mem_pool, sizeof(nxt_http_static_file_t));
+        if (nxt_slow_path(sf == NULL)) {
+            nxt_file_close(task, &file);
+            return NXT_ERROR;
+        }
+
+        sf->file = file;
+        sf->cached = NULL;
+
+        if (key.length > 0) {
+            sf->cached = nxt_http_static_cache_add(task, rtcf, &key,
+                                                   &sf->file, fi);
+        }
+
+        break;
+    }
+
+    *sfp = sf;
+    *encoding = &enc->name;
+
+    return NXT_OK;
+}
+
+
 #if (NXT_HAVE_OPENAT2)
 
 static u_char *
@@ -761,6 +1166,719 @@ nxt_http_static_chroot_match(u_char *chr, u_char *shr)
 #endif
 
 
+static nxt_int_t
+nxt_http_static_cache_key(nxt_http_request_t *r, nxt_http_static_conf_t *conf,
+    nxt_http_static_ctx_t *ctx, u_char *fname, nxt_str_t *key)
+{
+    u_char  *p;
+    size_t  length;
+
+    length = nxt_strlen(fname);
+
+#if (NXT_HAVE_OPENAT2)
+    /* The same name may be resolved differently within other chroot. */
+    key->length = 1 + ctx->chroot.length + 1 + length;
+#else
+    key->length = length;
+#endif
+
+    key->start = nxt_mp_nget(r->mem_pool, key->length);
+    if (nxt_slow_path(key->start == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = key->start;
+
+#if (NXT_HAVE_OPENAT2)
+    *p++ = (u_char) conf->resolve;
+    p = nxt_cpymem(p, ctx->chroot.start, ctx->chroot.length);
+    *p++ = '\0';
+#endif
+
+    nxt_memcpy(p, fname, length);
+
+    return NXT_OK;
+}
+
+
+static nxt_http_static_cache_file_t *
+nxt_http_static_cache_find(nxt_task_t *task, nxt_str_t *key)
+{
+    nxt_int_t                     ret;
+    nxt_lvlhsh_query_t            lhq;
+    nxt_event_engine_t            *engine;
+    nxt_http_static_cache_t       *cache;
+    nxt_http_static_cache_file_t  *cf;
+
+    engine = task->thread->engine;
+    cache = engine->open_file_cache;
+
+    if (cache == NULL || cache->count == 0) {
+        return NULL;
+    }
+
+    lhq.key = *key;
+    lhq.key_hash = nxt_djb_hash(key->start, key->length);
+    lhq.proto = &nxt_http_static_cache_hash_proto;
+
+    ret = nxt_lvlhsh_find(&cache->hash, &lhq);
+
+    if (ret != NXT_OK) {
+        return NULL;
+    }
+
+    cf = lhq.value;
+
+    if (nxt_msec_diff(cf->expire, engine->timers.now) <= 0) {
+        nxt_http_static_cache_delete(task, cache, cf);
+        return NULL;
+    }
+
+    nxt_debug(task, "open file cache hit fd:%FD", cf->file.fd);
+
+    nxt_queue_remove(&cf->link);
+    nxt_queue_insert_head(&cache->lru, &cf->link);
+
+    return cf;
+}
+
+
+static nxt_http_static_cache_file_t *
+nxt_http_static_cache_add(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_str_t *key, nxt_file_t *file, nxt_file_info_t *fi)
+{
+    size_t                        length;
+    nxt_int_t                     ret;
+    nxt_queue_link_t              *link;
+    nxt_lvlhsh_query_t            lhq;
+    nxt_event_engine_t            *engine;
+    nxt_http_static_cache_t       *cache;
+    nxt_http_static_cache_file_t  *cf;
+
+    engine = task->thread->engine;
+    cache = engine->open_file_cache;
+
+    if (cache == NULL) {
+        cache = nxt_mp_zalloc(engine->mem_pool,
+                              sizeof(nxt_http_static_cache_t));
+        if (nxt_slow_path(cache == NULL)) {
+            return NULL;
+        }
+
+        nxt_queue_init(&cache->lru);
+
+        cache->timer.work_queue = &engine->fast_work_queue;
+        cache->timer.handler = nxt_http_static_cache_timer_handler;
+        cache->timer.task = &engine->task;
+        cache->timer.log = engine->task.log;
+
+        engine->open_file_cache = cache;
+    }
+
+    while (cache->count >= rtcf->open_file_cache_max) {
+        link = nxt_queue_last(&cache->lru);
+        cf = nxt_queue_link_data(link, nxt_http_static_cache_file_t, link);
+
+        nxt_http_static_cache_delete(task, cache, cf);
+    }
+
+    length = nxt_strlen(file->name) + 1;
+
+    cf = nxt_malloc(sizeof(nxt_http_static_cache_file_t) + key->length
+                    + length);
+    if (nxt_slow_path(cf == NULL)) {
+        return NULL;
+    }
+
+    cf->file = *file;
+    cf->info = *fi;
+    cf->expire = engine->timers.now + rtcf->open_file_cache_valid;
+    cf->count = 1;
+    cf->deleted = 0;
+
+    cf->key.length = key->length;
+    cf->key.start = (u_char *) cf + sizeof(nxt_http_static_cache_file_t);
+    nxt_memcpy(cf->key.start, key->start, key->length);
+
+    cf->file.name = cf->key.start + key->length;
+    nxt_memcpy(cf->file.name, file->name, length);
+
+    lhq.key = cf->key;
+    lhq.key_hash = nxt_djb_hash(key->start, key->length);
+    lhq.replace = 0;
+    lhq.value = cf;
+    lhq.proto = &nxt_http_static_cache_hash_proto;
+    lhq.pool = engine->mem_pool;
+
+    ret = nxt_lvlhsh_insert(&cache->hash, &lhq);
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_free(cf);
+        return NULL;
+    }
+
+    nxt_debug(task, "open file cache add fd:%FD", cf->file.fd);
+
+    nxt_queue_insert_head(&cache->lru, &cf->link);
+
+    if (cache->count++ == 0) {
+        nxt_timer_add(engine, &cache->timer, rtcf->open_file_cache_valid);
+    }
+
+    cache->valid = rtcf->open_file_cache_valid;
+
+    return cf;
+}
+
+
+static void
+nxt_http_static_cache_delete(nxt_task_t *task, nxt_http_static_cache_t *cache,
+    nxt_http_static_cache_file_t *cf)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key = cf->key;
+    lhq.key_hash = nxt_djb_hash(cf->key.start, cf->key.length);
+    lhq.proto = &nxt_http_static_cache_hash_proto;
+    lhq.pool = task->thread->engine->mem_pool;
+
+    (void) nxt_lvlhsh_delete(&cache->hash, &lhq);
+
+    nxt_queue_remove(&cf->link);
+    cache->count--;
+
+    if (cf->count != 0) {
+        /* The file is closed by the last request which uses it. */
+        cf->deleted = 1;
+        return;
+    }
+
+    nxt_file_close(task, &cf->file);
+    nxt_free(cf);
+}
+
+
+static void
+nxt_http_static_cache_timer_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_timer_t                   *timer;
+    nxt_event_engine_t            *engine;
+    nxt_http_static_cache_t       *cache;
+    nxt_http_static_cache_file_t  *cf;
+
+    timer = obj;
+
+    cache = nxt_timer_data(timer, nxt_http_static_cache_t, timer);
+    engine = task->thread->engine;
+
+    nxt_queue_each(cf, &cache->lru, nxt_http_static_cache_file_t, link) {
+
+        if (nxt_msec_diff(cf->expire, engine->timers.now) <= 0) {
+            nxt_http_static_cache_delete(task, cache, cf);
+        }
+
+    } nxt_queue_loop;
+
+    if (cache->count != 0) {
+        nxt_timer_add(engine, &cache->timer, cache->valid);
+    }
+}
+
+
+static nxt_int_t
+nxt_http_static_cache_hash_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_http_static_cache_file_t  *cf;
+
+    cf = data;
+
+    if (nxt_strstr_eq(&lhq->key, &cf->key)) {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+static void
+nxt_http_static_file_close(nxt_task_t *task, nxt_file_t *f)
+{
+    nxt_http_static_file_t        *sf;
+    nxt_http_static_cache_file_t  *cf;
+
+    sf = (nxt_http_static_file_t *) f;
+    cf = sf->cached;
+
+    if (cf == NULL) {
+        nxt_file_close(task, f);
+        return;
+    }
+
+    if (--cf->count == 0 && cf->deleted) {
+        nxt_file_close(task, &cf->file);
+        nxt_free(cf);
+    }
+}
+
+
+void
+nxt_http_static_cache_free(nxt_task_t *task, nxt_event_engine_t *engine)
+{
+    nxt_http_static_cache_t       *cache;
+    nxt_http_static_cache_file_t  *cf;
+
+    cache = engine->open_file_cache;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    nxt_queue_each(cf, &cache->lru, nxt_http_static_cache_file_t, link) {
+
+        nxt_queue_remove(&cf->link);
+
+        nxt_file_close(task, &cf->file);
+        nxt_free(cf);
+
+    } nxt_queue_loop;
+
+    engine->open_file_cache = NULL;
+}
+
+
+static nxt_bool_t
+nxt_http_static_not_modified(nxt_http_request_t *r, nxt_file_info_t *fi,
+    nxt_str_t *etag)
+{
+    nxt_time_t        date;
+    nxt_http_field_t  *field;
+
+    /* "If-Modified-Since" is ignored if "If-None-Match" is present. */
+
+    if (r->if_none_match != NULL) {
+        return nxt_http_static_etag_match(r->if_none_match, etag);
+    }
+
+    field = r->if_modified_since;
+
+    if (field != NULL) {
+        date = nxt_time_parse(field->value, field->value_length);
+
+        return (date >= 0 && nxt_file_mtime(fi) <= date);
+    }
+
+    return 0;
+}
+
+
+/* The weak comparison with an entity-tag list. */
+
+static nxt_bool_t
+nxt_http_static_etag_match(nxt_http_field_t *field, nxt_str_t *etag)
+{
+    u_char  *p, *end, *start;
+
+    p = field->value;
+    end = p + field->value_length;
+
+    for ( ;; ) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+            p++;
+        }
+
+        if (p == end) {
+            return 0;
+        }
+
+        if (*p == '*') {
+            return 1;
+        }
+
+        if (end - p > 2 && p[0] == 'W' && p[1] == '/') {
+            p += 2;
+        }
+
+        if (*p != '"') {
+            return 0;
+        }
+
+        start = p++;
+
+        p = memchr(p, '"', end - p);
+        if (p == NULL) {
+            return 0;
+        }
+
+        p++;
+
+        if ((size_t) (p - start) == etag->length
+            && memcmp(start, etag->start, etag->length) == 0)
+        {
+            return 1;
+        }
+    }
+}
+
+
+static nxt_int_t
+nxt_http_static_range(nxt_task_t *task, nxt_http_request_t *r, nxt_file_t *f,
+    nxt_file_info_t *fi, nxt_str_t *etag, nxt_str_t *mtype)
+{
+    u_char                   *p;
+    size_t                   length;
+    nxt_int_t                n, i;
+    nxt_off_t                size, total;
+    nxt_str_t                boundary;
+    nxt_buf_t                *b, *out, **next;
+    nxt_time_t               date;
+    nxt_http_field_t         *field;
+    nxt_http_static_range_t  *range, ranges[NXT_HTTP_STATIC_RANGES];
+
+    field = r->if_range;
+
+    if (field != NULL) {
+        /* Only the strong entity-tag or the exact date match. */
+
+        if (field->value_length > 0
+            && (field->value[0] == '"' || field->value[0] == 'W'))
+        {
+            if (field->value_length != etag->length
+                || memcmp(field->value, etag->start, etag->length) != 0)
+            {
+                return NXT_DECLINED;
+            }
+
+        } else {
+            date = nxt_time_parse(field->value, field->value_length);
+
+            if (date != nxt_file_mtime(fi)) {
+                return NXT_DECLINED;
+            }
+        }
+    }
+
+    size = nxt_file_size(fi);
+
+    n = nxt_http_static_range_parse(r->range, size, ranges);
+
+    if (n == NXT_DECLINED) {
+        return NXT_DECLINED;
+    }
+
+    field = nxt_list_zero_add(r->resp.fields);
+    if (nxt_slow_path(field == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_http_field_name_set(field, "Content-Range");
+
+    length = nxt_length("bytes -/") + 3 * NXT_OFF_T_LEN;
+
+    p = nxt_mp_nget(r->mem_pool, length);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    field->value = p;
+
+    if (n == 0) {
+        r->status = NXT_HTTP_RANGE_NOT_SATISFIABLE;
+        r->resp.content_length_n = 0;
+
+        field->value_length = nxt_sprintf(p, p + length, "bytes */%O", size)
+                              - p;
+        return NXT_OK;
+    }
+
+    r->status = NXT_HTTP_PARTIAL_CONTENT;
+
+    if (n == 1) {
+        range = &ranges[0];
+
+        field->value_length = nxt_sprintf(p, p + length, "bytes %O-%O/%O",
+                                          range->start, range->end - 1, size)
+                              - p;
+
+        if (mtype->length != 0) {
+            field = nxt_list_zero_add(r->resp.fields);
+            if (nxt_slow_path(field == NULL)) {
+                return NXT_ERROR;
+            }
+
+            nxt_http_field_name_set(field, "Content-Type");
+
+            field->value = mtype->start;
+            field->value_length = mtype->length;
+        }
+
+        b = nxt_http_static_range_buf(r->mem_pool, f, 0);
+        if (nxt_slow_path(b == NULL)) {
+            return NXT_ERROR;
+        }
+
+        b->file_pos = range->start;
+        b->file_end = range->end;
+
+        r->resp.content_length_n = range->end - range->start;
+        r->out = b;
+
+        return NXT_OK;
+    }
+
+    /* The "Content-Range" field is sent in each part instead. */
+    field->skip = 1;
+
+    boundary.length = 16;
+
+    boundary.start = nxt_mp_nget(r->mem_pool, boundary.length);
+    if (nxt_slow_path(boundary.start == NULL)) {
+        return NXT_ERROR;
+    }
+
+    (void) nxt_sprintf(boundary.start, boundary.start + boundary.length,
+                       "%08xD%08xD", nxt_random(&task->thread->random),
+                       nxt_random(&task->thread->random));
+
+    field = nxt_list_zero_add(r->resp.fields);
+    if (nxt_slow_path(field == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_http_field_name_set(field, "Content-Type");
+
+    length = nxt_length("multipart/byteranges; boundary=") + boundary.length;
+
+    p = nxt_mp_nget(r->mem_pool, length);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    field->value = p;
+    field->value_length = nxt_sprintf(p, p + length,
+                                      "multipart/byteranges; boundary=%V",
+                                      &boundary)
+                          - p;
+
+    out = NULL;
+    next = &out;
+    total = 0;
+
+    for (i = 0; i < n; i++) {
+        range = &ranges[i];
+
+        length = nxt_length("\r\n--\r\nContent-Range: bytes -/\r\n\r\n")
+                 + boundary.length + 3 * NXT_OFF_T_LEN;
+
+        if (mtype->length != 0) {
+            length += nxt_length("Content-Type: \r\n") + mtype->length;
+        }
+
+        b = nxt_http_static_range_buf(r->mem_pool, f, length);
+        if (nxt_slow_path(b == NULL)) {
+            return NXT_ERROR;
+        }
+
+        p = nxt_sprintf(b->mem.free, b->mem.end, "\r\n--%V\r\n", &boundary);
+
+        if (mtype->length != 0) {
+            p = nxt_sprintf(p, b->mem.end, "Content-Type: %V\r\n", mtype);
+        }
+
+        p = nxt_sprintf(p, b->mem.end, "Content-Range: bytes %O-%O/%O\r\n\r\n",
+                        range->start, range->end - 1, size);
+
+        b->mem.free = p;
+
+        *next = b;
+        next = &b->next;
+
+        total += (p - b->mem.pos) + (range->end - range->start);
+
+        b = nxt_http_static_range_buf(r->mem_pool, f, 0);
+        if (nxt_slow_path(b == NULL)) {
+            return NXT_ERROR;
+        }
+
+        b->file_pos = range->start;
+        b->file_end = range->end;
+
+        *next = b;
+        next = &b->next;
+    }
+
+    length = nxt_length("\r\n----\r\n") + boundary.length;
+
+    b = nxt_http_static_range_buf(r->mem_pool, f, length);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_ERROR;
+    }
+
+    b->mem.free = nxt_sprintf(b->mem.free, b->mem.end, "\r\n--%V--\r\n",
+                              &boundary);
+
+    total += length;
+
+    *next = b;
+
+    r->resp.content_length_n = total;
+    r->out = out;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_static_range_parse(nxt_http_field_t *field, nxt_off_t size,
+    nxt_http_static_range_t *ranges)
+{
+    u_char      *p, *end;
+    nxt_int_t   n;
+    nxt_off_t   start, last, total, cutoff;
+    nxt_uint_t  specs;
+
+    p = field->value;
+    end = p + field->value_length;
+
+    if (end - p < 6 || nxt_memcasecmp(p, "bytes=", 6) != 0) {
+        return NXT_DECLINED;
+    }
+
+    p += 6;
+
+    cutoff = NXT_OFF_T_MAX / 10;
+
+    n = 0;
+    specs = 0;
+    total = 0;
+
+    for ( ;; ) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+            p++;
+        }
+
+        if (p == end) {
+            break;
+        }
+
+        start = -1;
+
+        if (*p >= '0' && *p <= '9') {
+            start = 0;
+
+            do {
+                if (start >= cutoff) {
+                    return NXT_DECLINED;
+                }
+
+                start = start * 10 + (*p++ - '0');
+
+            } while (p < end && *p >= '0' && *p <= '9');
+        }
+
+        if (p == end || *p++ != '-') {
+            return NXT_DECLINED;
+        }
+
+        last = -1;
+
+        if (p < end && *p >= '0' && *p <= '9') {
+            last = 0;
+
+            do {
+                if (last >= cutoff) {
+                    return NXT_DECLINED;
+                }
+
+                last = last * 10 + (*p++ - '0');
+
+            } while (p < end && *p >= '0' && *p <= '9');
+        }
+
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+
+        if (p < end && *p != ',') {
+            return NXT_DECLINED;
+        }
+
+        specs++;
+
+        if (start == -1) {
+            /* The suffix range. */
+
+            if (last == -1) {
+                return NXT_DECLINED;
+            }
+
+            if (last == 0) {
+                continue;
+            }
+
+            start = (last < size) ? size - last : 0;
+            last = size;
+
+        } else {
+            if (last != -1 && last < start) {
+                return NXT_DECLINED;
+            }
+
+            if (start >= size) {
+                continue;
+            }
+
+            last = (last == -1 || last >= size) ? size : last + 1;
+        }
+
+        if (n == NXT_HTTP_STATIC_RANGES) {
+            return NXT_DECLINED;
+        }
+
+        ranges[n].start = start;
+        ranges[n].end = last;
+        n++;
+
+        total += last - start;
+    }
+
+    /*
+     * Overlapping ranges which in total exceed the file size
+     * are ignored and the whole file is sent instead.
+     */
+
+    if (specs == 0 || total > size) {
+        return NXT_DECLINED;
+    }
+
+    return n;
+}
+
+
+/*
+ * A multipart body is a chain of memory buffers with part headers and file
+ * buffers with ranges.  Each buffer refers to the file to close it once
+ * the chain is sent.
+ */
+
+static nxt_buf_t *
+nxt_http_static_range_buf(nxt_mp_t *mp, nxt_file_t *f, size_t size)
+{
+    nxt_buf_t  *b;
+
+    b = nxt_buf_file_alloc(mp, size, 0);
+    if (nxt_slow_path(b == NULL)) {
+        return NULL;
+    }
+
+    if (size != 0) {
+        nxt_buf_clear_file(b);
+    }
+
+    b->file = f;
+
+    return b;
+}
+
 static void
 nxt_http_static_extract_extension(nxt_str_t *path, nxt_str_t *exten)
 {
@@ -800,9 +1918,19 @@ nxt_http_static_body_handler(nxt_task_t *task, void *obj, void *data)
     nxt_http_request_t  *r;
 
     r = obj;
-    fb = r->out;
 
-    rest = fb->file_end - fb->file_pos;
+    if (r->sendfile && r->compress == NULL) {
+        nxt_http_static_sendfile(task, r);
+        return;
+    }
+
+    rest = 0;
+
+    for (fb = r->out; fb != NULL; fb = fb->next) {
+        rest += nxt_buf_is_file(fb) ? fb->file_end - fb->file_pos
+                                    : nxt_buf_mem_used_size(&fb->mem);
+    }
+
     out = NULL;
     next = &out;
     n = 0;
@@ -854,8 +1982,10 @@ static const nxt_http_request_state_t  nxt_http_static_send_state
 static void
 nxt_http_static_buf_completion(nxt_task_t *task, void *obj, void *data)
 {
+    u_char              *p;
     ssize_t             n, size;
     nxt_buf_t           *b, *fb, *next;
+    nxt_file_t          *file;
     nxt_off_t           rest;
     nxt_http_request_t  *r;
 
@@ -870,33 +2000,61 @@ nxt_http_static_buf_completion(nxt_task_t *task, void *obj, void *data)
         goto clean;
     }
 
-    rest = fb->file_end - fb->file_pos;
-    size = nxt_buf_mem_size(&b->mem);
+    file = fb->file;
+    p = b->mem.start;
 
-    size = nxt_min(rest, (nxt_off_t) size);
+    /* The buffer is filled from the file ranges and multipart headers. */
 
-    n = nxt_file_read(fb->file, b->mem.start, size, fb->file_pos);
+    while (fb != NULL && p < b->mem.end) {
+        size = b->mem.end - p;
 
-    if (nxt_slow_path(n == NXT_ERROR)) {
-        nxt_http_request_error_handler(task, r, r->proto.any);
-        goto clean;
+        if (nxt_buf_is_file(fb)) {
+            rest = fb->file_end - fb->file_pos;
+            size = nxt_min(rest, (nxt_off_t) size);
+
+            n = nxt_file_read(fb->file, p, size, fb->file_pos);
+
+            if (nxt_slow_path(n == NXT_ERROR)) {
+                nxt_http_request_error_handler(task, r, r->proto.any);
+                goto clean;
+            }
+
+            fb->file_pos += n;
+            p += n;
+
+            if (n != rest) {
+                break;
+            }
+
+        } else {
+            size = nxt_min(nxt_buf_mem_used_size(&fb->mem), size);
+
+            p = nxt_cpymem(p, fb->mem.pos, size);
+            fb->mem.pos += size;
+
+            if (fb->mem.pos != fb->mem.free) {
+                break;
+            }
+        }
+
+        fb = fb->next;
     }
 
+    r->out = fb;
+
     next = b->next;
 
-    if (n == rest) {
-        nxt_file_close(task, fb->file);
-        r->out = NULL;
+    if (fb == NULL) {
+        nxt_http_static_file_close(task, file);
 
         b->next = nxt_http_buf_last(r);
 
     } else {
-        fb->file_pos += n;
         b->next = NULL;
     }
 
     b->mem.pos = b->mem.start;
-    b->mem.free = b->mem.pos + n;
+    b->mem.free = p;
 
     nxt_http_request_send(task, r, b);
 
@@ -919,12 +2077,74 @@ nxt_http_static_buf_completion(nxt_task_t *task, void *obj, void *data)
     } while (b != NULL);
 
     if (fb != NULL) {
-        nxt_file_close(task, fb->file);
+        nxt_http_static_file_close(task, fb->file);
         r->out = NULL;
     }
 }
 
 
+/*
+ * The connection encrypts in the kernel, so the file ranges and multipart
+ * headers are passed to the connection as is instead of being read.
+ */
+
+static void
+nxt_http_static_sendfile(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_int_t  ret;
+    nxt_buf_t  *b, *out;
+
+    out = r->out;
+    r->out = NULL;
+
+    ret = nxt_mp_cleanup(r->mem_pool, nxt_http_static_file_cleanup, &r->task,
+                         out->file, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_http_static_file_close(task, out->file);
+        nxt_http_request_error_handler(task, r, r->proto.any);
+        return;
+    }
+
+    for (b = out; ; b = b->next) {
+        b->completion_handler = nxt_http_static_sendfile_completion;
+        b->parent = r;
+
+        nxt_mp_retain(r->mem_pool);
+
+        if (b->next == NULL) {
+            break;
+        }
+    }
+
+    b->next = nxt_http_buf_last(r);
+
+    nxt_http_request_send(task, r, out);
+}
+
+
+static void
+nxt_http_static_sendfile_completion(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t           *b;
+    nxt_http_request_t  *r;
+
+    r = data;
+
+    /* The buffers are freed along with the request memory pool. */
+
+    for (b = obj; b != NULL; b = b->next) {
+        nxt_mp_release(r->mem_pool);
+    }
+}
+
+
+static void
+nxt_http_static_file_cleanup(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_static_file_close(task, obj);
+}
+
+
 nxt_int_t
 nxt_http_static_mtypes_init(nxt_mp_t *mp, nxt_lvlhsh_t *hash)
 {
@@ -1056,6 +2276,21 @@ nxt_http_static_mtypes_hash_add(nxt_mp_t *mp, nxt_lvlhsh_t *hash,
 }
 
 
+nxt_bool_t
+nxt_http_static_precompressed(nxt_str_t *name)
+{
+    nxt_uint_t  i;
+
+    for (i = 0; i < NXT_HTTP_STATIC_ENCODINGS; i++) {
+        if (nxt_strstr_eq(name, &nxt_http_static_encodings[i].name)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
 nxt_str_t *
 nxt_http_static_mtype_get(nxt_lvlhsh_t *hash, const nxt_str_t *exten)
 {
@@ -0,0 +1,1187 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+
+
+/*
+ * The io_uring engine uses IORING_OP_POLL_ADD requests as readiness
+ * notifications, so connections are served by the ordinary nxt_unix_conn_io
+ * handlers.  Event set changes are collected during an event loop iteration
+ * and are submitted along with waiting for completions by a single
+ * io_uring_enter() call.
+ *
+ * Poll requests are oneshot and are rearmed after completion while the event
+ * stays active; this provides level-triggered semantics.  A request is
+ * identified by a descriptor and a generation number stored in user_data,
+ * so late completions of removed or replaced requests are ignored.
+ *
+ * IORING_FEAT_NODROP         Linux 5.5.
+ * IORING_FEAT_EXT_ARG        Linux 5.11.
+ * IORING_POLL_ADD_MULTI      Linux 5.13.
+ * IORING_SETUP_SUBMIT_ALL    Linux 5.18.
+ * IORING_SETUP_COOP_TASKRUN  Linux 5.19.
+ */
+
+
+#define nxt_io_uring_load_acquire(p)                                          \
+    __atomic_load_n(p, __ATOMIC_ACQUIRE)
+
+#define nxt_io_uring_store_release(p, v)                                      \
+    __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+
+static nxt_int_t nxt_io_uring_create(nxt_event_engine_t *engine,
+    nxt_uint_t mchanges, nxt_uint_t mevents);
+static nxt_int_t nxt_io_uring_setup(nxt_event_engine_t *engine,
+    uint32_t entries);
+static void nxt_io_uring_free(nxt_event_engine_t *engine);
+static void nxt_io_uring_enable(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_disable(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_delete(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static nxt_bool_t nxt_io_uring_close(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_enable_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_enable_write(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_disable_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_disable_write(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_block_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_block_write(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_oneshot_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_oneshot_write(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_enable_accept(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static nxt_bool_t nxt_io_uring_armed(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_change(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_commit_changes(nxt_event_engine_t *engine);
+static void nxt_io_uring_update(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static uint32_t nxt_io_uring_events(nxt_fd_event_t *ev);
+static nxt_io_uring_slot_t *nxt_io_uring_slot(nxt_event_engine_t *engine,
+    nxt_fd_t fd);
+static void nxt_io_uring_poll_add(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev, nxt_io_uring_slot_t *slot, uint32_t events);
+static void nxt_io_uring_poll_remove(nxt_event_engine_t *engine,
+    nxt_fd_t fd, nxt_io_uring_slot_t *slot);
+static struct io_uring_sqe *nxt_io_uring_get_sqe(nxt_event_engine_t *engine);
+static int nxt_io_uring_enter(nxt_event_engine_t *engine,
+    uint32_t min_complete, uint32_t flags, struct io_uring_getevents_arg *arg);
+static void nxt_io_uring_error_handler(nxt_task_t *task, void *obj,
+    void *data);
+#if (NXT_HAVE_SIGNALFD)
+static nxt_int_t nxt_io_uring_add_signal(nxt_event_engine_t *engine);
+static void nxt_io_uring_signalfd_handler(nxt_task_t *task, void *obj,
+    void *data);
+#endif
+#if (NXT_HAVE_EVENTFD)
+static nxt_int_t nxt_io_uring_enable_post(nxt_event_engine_t *engine,
+    nxt_work_handler_t handler);
+static void nxt_io_uring_eventfd_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_io_uring_signal(nxt_event_engine_t *engine, nxt_uint_t signo);
+#endif
+static void nxt_io_uring_poll(nxt_event_engine_t *engine, nxt_msec_t timeout);
+static void nxt_io_uring_completion(nxt_event_engine_t *engine,
+    struct io_uring_cqe *cqe);
+
+
+const nxt_event_interface_t  nxt_io_uring_engine = {
+    "io_uring",
+    nxt_io_uring_create,
+    nxt_io_uring_free,
+    nxt_io_uring_enable,
+    nxt_io_uring_disable,
+    nxt_io_uring_delete,
+    nxt_io_uring_close,
+    nxt_io_uring_enable_read,
+    nxt_io_uring_enable_write,
+    nxt_io_uring_disable_read,
+    nxt_io_uring_disable_write,
+    nxt_io_uring_block_read,
+    nxt_io_uring_block_write,
+    nxt_io_uring_oneshot_read,
+    nxt_io_uring_oneshot_write,
+    nxt_io_uring_enable_accept,
+    NULL,
+    NULL,
+#if (NXT_HAVE_EVENTFD)
+    nxt_io_uring_enable_post,
+    nxt_io_uring_signal,
+#else
+    NULL,
+    NULL,
+#endif
+    nxt_io_uring_poll,
+
+    &nxt_unix_conn_io,
+
+    NXT_NO_FILE_EVENTS,
+
+#if (NXT_HAVE_SIGNALFD)
+    NXT_SIGNAL_EVENTS,
+#else
+    NXT_NO_SIGNAL_EVENTS,
+#endif
+};
+
+
+static nxt_int_t
+nxt_io_uring_create(nxt_event_engine_t *engine, nxt_uint_t mchanges,
+    nxt_uint_t mevents)
+{
+    engine->u.io_uring.fd = -1;
+    engine->u.io_uring.mchanges = mchanges;
+#if (NXT_HAVE_SIGNALFD)
+    engine->u.io_uring.signalfd.fd = -1;
+#endif
+#if (NXT_HAVE_EVENTFD)
+    engine->u.io_uring.eventfd.fd = -1;
+#endif
+
+    engine->u.io_uring.changes = nxt_malloc(sizeof(nxt_fd_event_t *)
+                                            * mchanges);
+    if (engine->u.io_uring.changes == NULL) {
+        goto fail;
+    }
+
+    /*
+     * Committing a change may require two submission queue entries:
+     * to remove the previous poll request and to add a new one.
+     */
+
+    if (nxt_io_uring_setup(engine, 2 * mchanges) != NXT_OK) {
+        goto fail;
+    }
+
+#if (NXT_HAVE_SIGNALFD)
+
+    if (engine->signals != NULL) {
+
+        if (nxt_io_uring_add_signal(engine) != NXT_OK) {
+            goto fail;
+        }
+    }
+
+#endif
+
+    return NXT_OK;
+
+fail:
+
+    nxt_io_uring_free(engine);
+
+    return NXT_ERROR;
+}
+
+
+static nxt_int_t
+nxt_io_uring_setup(nxt_event_engine_t *engine, uint32_t entries)
+{
+    int                     fd;
+    u_char                  *sq, *cq;
+    uint32_t                i, *array;
+    nxt_err_t               err;
+    struct io_uring_params  p;
+
+    nxt_memzero(&p, sizeof(struct io_uring_params));
+
+    p.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+
+    fd = syscall(__NR_io_uring_setup, entries, &p);
+
+    if (fd == -1 && nxt_errno == NXT_EINVAL) {
+        /* The flags are not supported by Linux prior to 5.19. */
+        nxt_memzero(&p, sizeof(struct io_uring_params));
+
+        fd = syscall(__NR_io_uring_setup, entries, &p);
+    }
+
+    if (fd == -1) {
+        nxt_alert(&engine->task, "io_uring_setup(%uD) failed %E",
+                  entries, nxt_errno);
+        return NXT_ERROR;
+    }
+
+    engine->u.io_uring.fd = fd;
+
+    nxt_debug(&engine->task, "io_uring_setup(%uD): %d sq:%uD cq:%uD f:%XD",
+              entries, fd, p.sq_entries, p.cq_entries, p.features);
+
+    if ((p.features & (IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG))
+        != (IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG))
+    {
+        nxt_alert(&engine->task, "io_uring %d lacks required features: %XD",
+                  fd, p.features);
+        return NXT_ERROR;
+    }
+
+    engine->u.io_uring.sq_ring_size = p.sq_off.array
+                                      + p.sq_entries * sizeof(uint32_t);
+    engine->u.io_uring.cq_ring_size = p.cq_off.cqes
+                                      + p.cq_entries
+                                        * sizeof(struct io_uring_cqe);
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        engine->u.io_uring.sq_ring_size = nxt_max(
+                                             engine->u.io_uring.sq_ring_size,
+                                             engine->u.io_uring.cq_ring_size);
+    }
+
+    sq = mmap(NULL, engine->u.io_uring.sq_ring_size, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+    if (nxt_slow_path(sq == MAP_FAILED)) {
+        err = nxt_errno;
+        goto mmap_fail;
+    }
+
+    engine->u.io_uring.sq_ring = sq;
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        cq = sq;
+
+    } else {
+        cq = mmap(NULL, engine->u.io_uring.cq_ring_size,
+                  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                  fd, IORING_OFF_CQ_RING);
+
+        if (nxt_slow_path(cq == MAP_FAILED)) {
+            err = nxt_errno;
+            goto mmap_fail;
+        }
+
+        engine->u.io_uring.cq_ring = cq;
+    }
+
+    engine->u.io_uring.sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    engine->u.io_uring.sqes = mmap(NULL, engine->u.io_uring.sqes_size,
+                                   PROT_READ | PROT_WRITE,
+                                   MAP_SHARED | MAP_POPULATE,
+                                   fd, IORING_OFF_SQES);
+
+    if (nxt_slow_path(engine->u.io_uring.sqes == MAP_FAILED)) {
+        engine->u.io_uring.sqes = NULL;
+        err = nxt_errno;
+        goto mmap_fail;
+    }
+
+    engine->u.io_uring.sq_entries = p.sq_entries;
+    engine->u.io_uring.sq_mask = *(uint32_t *) (sq + p.sq_off.ring_mask);
+    engine->u.io_uring.sq_khead = (uint32_t *) (sq + p.sq_off.head);
+    engine->u.io_uring.sq_ktail = (uint32_t *) (sq + p.sq_off.tail);
+    engine->u.io_uring.sq_tail = *engine->u.io_uring.sq_ktail;
+
+    /* Submission queue entries are always used in order. */
+
+    array = (uint32_t *) (sq + p.sq_off.array);
+
+    for (i = 0; i < p.sq_entries; i++) {
+        array[i] = i;
+    }
+
+    engine->u.io_uring.cq_mask = *(uint32_t *) (cq + p.cq_off.ring_mask);
+    engine->u.io_uring.cq_khead = (uint32_t *) (cq + p.cq_off.head);
+    engine->u.io_uring.cq_ktail = (uint32_t *) (cq + p.cq_off.tail);
+    engine->u.io_uring.cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+
+    return NXT_OK;
+
+mmap_fail:
+
+    nxt_alert(&engine->task, "io_uring %d mmap() failed %E", fd, err);
+
+    return NXT_ERROR;
+}
+
+
+static void
+nxt_io_uring_free(nxt_event_engine_t *engine)
+{
+    int                    fd;
+    nxt_io_uring_engine_t  *iu;
+
+    iu = &engine->u.io_uring;
+
+    nxt_debug(&engine->task, "io_uring %d free", iu->fd);
+
+#if (NXT_HAVE_SIGNALFD)
+
+    fd = iu->signalfd.fd;
+
+    if (fd != -1 && close(fd) != 0) {
+        nxt_alert(&engine->task, "signalfd close(%d) failed %E", fd, nxt_errno);
+    }
+
+#endif
+
+#if (NXT_HAVE_EVENTFD)
+
+    fd = iu->eventfd.fd;
+
+    if (fd != -1 && close(fd) != 0) {
+        nxt_alert(&engine->task, "eventfd close(%d) failed %E", fd, nxt_errno);
+    }
+
+#endif
+
+    if (iu->sqes != NULL) {
+        (void) munmap(iu->sqes, iu->sqes_size);
+    }
+
+    if (iu->cq_ring != NULL) {
+        (void) munmap(iu->cq_ring, iu->cq_ring_size);
+    }
+
+    if (iu->sq_ring != NULL) {
+        (void) munmap(iu->sq_ring, iu->sq_ring_size);
+    }
+
+    fd = iu->fd;
+
+    if (fd != -1 && close(fd) != 0) {
+        nxt_alert(&engine->task, "io_uring close(%d) failed %E", fd, nxt_errno);
+    }
+
+    nxt_free(iu->slots);
+    nxt_free(iu->changes);
+
+    nxt_memzero(iu, sizeof(nxt_io_uring_engine_t));
+}
+
+
+static void
+nxt_io_uring_enable(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    ev->read = NXT_EVENT_ACTIVE;
+    ev->write = NXT_EVENT_ACTIVE;
+
+    nxt_io_uring_change(engine, ev);
+}
+
+
+static void
+nxt_io_uring_disable(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    if (ev->read > NXT_EVENT_DISABLED || ev->write > NXT_EVENT_DISABLED) {
+
+        ev->read = NXT_EVENT_INACTIVE;
+        ev->write = NXT_EVENT_INACTIVE;
+
+        nxt_io_uring_change(engine, ev);
+    }
+}
+
+
+static void
+nxt_io_uring_delete(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    if (ev->read != NXT_EVENT_INACTIVE
+        || ev->write != NXT_EVENT_INACTIVE
+        || nxt_io_uring_armed(engine, ev))
+    {
+        ev->read = NXT_EVENT_INACTIVE;
+        ev->write = NXT_EVENT_INACTIVE;
+
+        nxt_io_uring_change(engine, ev);
+    }
+}
+
+
+/*
+ * A poll request holds a reference to the file, so the request should
+ * be removed before the descriptor is closed, otherwise the socket would
+ * not be released until the request completes.
+ */
+
+static nxt_bool_t
+nxt_io_uring_close(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_delete(engine, ev);
+
+    return ev->changing;
+}
+
+
+static void
+nxt_io_uring_enable_read(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    ev->read = NXT_EVENT_ACTIVE;
+
+    nxt_io_uring_change(engine, ev);
+}
+
+
+static void
+nxt_io_uring_enable_write(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    ev->write = NXT_EVENT_ACTIVE;
+
+    nxt_io_uring_change(engine, ev);
+}
+
+
+static void
+nxt_io_uring_disable_read(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    ev->read = NXT_EVENT_INACTIVE;
+
+    if (ev->write <= NXT_EVENT_DISABLED) {
+        ev->write = NXT_EVENT_INACTIVE;
+    }
+
+    nxt_io_uring_change(engine, ev);
+}
+
+
+static void
+nxt_io_uring_disable_write(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    ev->write = NXT_EVENT_INACTIVE;
+
+    if (ev->read <= NXT_EVENT_DISABLED) {
+        ev->read = NXT_EVENT_INACTIVE;
+    }
+
+    nxt_io_uring_change(engine, ev);
+}
+
+
+/*
+ * A blocked event is not rearmed after the poll request completion,
+ * so enabling the event again always commits a change.
+ */
+
+static void
+nxt_io_uring_block_read(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    if (ev->read != NXT_EVENT_INACTIVE) {
+        ev->read = NXT_EVENT_BLOCKED;
+    }
+}
+
+
+static void
+nxt_io_uring_block_write(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    if (ev->write != NXT_EVENT_INACTIVE) {
+        ev->write = NXT_EVENT_BLOCKED;
+    }
+}
+
+
+static void
+nxt_io_uring_oneshot_read(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    ev->read = NXT_EVENT_ONESHOT;
+    ev->write = NXT_EVENT_INACTIVE;
+
+    nxt_io_uring_change(engine, ev);
+}
+
+
+static void
+nxt_io_uring_oneshot_write(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    ev->read = NXT_EVENT_INACTIVE;
+    ev->write = NXT_EVENT_ONESHOT;
+
+    nxt_io_uring_change(engine, ev);
+}
+
+
+static void
+nxt_io_uring_enable_accept(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    ev->read = NXT_EVENT_ACTIVE;
+
+    nxt_io_uring_change(engine, ev);
+}
+
+
+static nxt_bool_t
+nxt_io_uring_armed(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t  *slot;
+
+    if ((nxt_uint_t) ev->fd >= engine->u.io_uring.nslots) {
+        return 0;
+    }
+
+    slot = &engine->u.io_uring.slots[ev->fd];
+
+    return (slot->event == ev && slot->events != 0);
+}
+
+
+/*
+ * An event is queued once per event loop iteration regardless of the
+ * number of its state changes, the resulting state is committed before
+ * waiting for completions.
+ */
+
+static void
+nxt_io_uring_change(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_debug(ev->task, "io_uring %d set event: fd:%d rd:%d wr:%d",
+              engine->u.io_uring.fd, ev->fd, ev->read, ev->write);
+
+    if (ev->changing) {
+        return;
+    }
+
+    if (engine->u.io_uring.nchanges >= engine->u.io_uring.mchanges) {
+        nxt_io_uring_commit_changes(engine);
+    }
+
+    ev->changing = 1;
+
+    engine->u.io_uring.changes[engine->u.io_uring.nchanges++] = ev;
+}
+
+
+static void
+nxt_io_uring_commit_changes(nxt_event_engine_t *engine)
+{
+    nxt_fd_event_t  *ev, **change, **end;
+
+    nxt_debug(&engine->task, "io_uring %d changes:%ui",
+              engine->u.io_uring.fd, engine->u.io_uring.nchanges);
+
+    change = engine->u.io_uring.changes;
+    end = change + engine->u.io_uring.nchanges;
+
+    do {
+        ev = *change;
+        ev->changing = 0;
+
+        nxt_io_uring_update(engine, ev);
+
+        change++;
+
+    } while (change < end);
+
+    engine->u.io_uring.nchanges = 0;
+}
+
+
+static void
+nxt_io_uring_update(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    uint32_t             events;
+    nxt_io_uring_slot_t  *slot;
+
+    events = nxt_io_uring_events(ev);
+
+    slot = nxt_io_uring_slot(engine, ev->fd);
+
+    if (nxt_slow_path(slot == NULL)) {
+        nxt_work_queue_add(&engine->fast_work_queue,
+                           nxt_io_uring_error_handler, ev->task, ev, ev->data);
+
+        engine->u.io_uring.error = 1;
+        return;
+    }
+
+    if (slot->event == ev && slot->events == events) {
+        return;
+    }
+
+    if (slot->events != 0) {
+        nxt_io_uring_poll_remove(engine, ev->fd, slot);
+    }
+
+    if (events == 0) {
+        slot->event = NULL;
+        return;
+    }
+
+    nxt_io_uring_poll_add(engine, ev, slot, events);
+}
+
+
+static uint32_t
+nxt_io_uring_events(nxt_fd_event_t *ev)
+{
+    uint32_t  events;
+
+    events = 0;
+
+    if (nxt_fd_event_is_active(ev->read)) {
+        events |= POLLIN;
+    }
+
+    if (nxt_fd_event_is_active(ev->write)) {
+        events |= POLLOUT;
+    }
+
+    return events;
+}
+
+
+static nxt_io_uring_slot_t *
+nxt_io_uring_slot(nxt_event_engine_t *engine, nxt_fd_t fd)
+{
+    nxt_uint_t           n;
+    nxt_io_uring_slot_t  *slots;
+
+    n = engine->u.io_uring.nslots;
+
+    if (nxt_fast_path((nxt_uint_t) fd < n)) {
+        return &engine->u.io_uring.slots[fd];
+    }
+
+    if (nxt_slow_path(fd < 0)) {
+        nxt_alert(&engine->task, "io_uring %d invalid descriptor %d",
+                  engine->u.io_uring.fd, fd);
+        return NULL;
+    }
+
+    if (n == 0) {
+        n = 256;
+    }
+
+    while (n <= (nxt_uint_t) fd) {
+        n *= 2;
+    }
+
+    slots = nxt_realloc(engine->u.io_uring.slots,
+                        n * sizeof(nxt_io_uring_slot_t));
+    if (nxt_slow_path(slots == NULL)) {
+        return NULL;
+    }
+
+    nxt_memzero(&slots[engine->u.io_uring.nslots],
+                (n - engine->u.io_uring.nslots) * sizeof(nxt_io_uring_slot_t));
+
+    engine->u.io_uring.slots = slots;
+    engine->u.io_uring.nslots = n;
+
+    return &slots[fd];
+}
+
+
+static void
+nxt_io_uring_poll_add(nxt_event_engine_t *engine, nxt_fd_event_t *ev,
+    nxt_io_uring_slot_t *slot, uint32_t events)
+{
+    uint32_t             gen;
+    struct io_uring_sqe  *sqe;
+
+    sqe = nxt_io_uring_get_sqe(engine);
+
+    if (nxt_slow_path(sqe == NULL)) {
+        slot->event = NULL;
+
+        nxt_work_queue_add(&engine->fast_work_queue,
+                           nxt_io_uring_error_handler, ev->task, ev, ev->data);
+
+        engine->u.io_uring.error = 1;
+        return;
+    }
+
+    /* Zero generation is reserved for requests without completion events. */
+
+    gen = ++engine->u.io_uring.gen;
+
+    if (gen == 0) {
+        gen = ++engine->u.io_uring.gen;
+    }
+
+    slot->event = ev;
+    slot->gen = gen;
+    slot->events = events;
+
+    nxt_debug(ev->task, "io_uring %d poll add: fd:%d ev:%XD gen:%uD",
+              engine->u.io_uring.fd, ev->fd, events, gen);
+
+#if (NXT_HAVE_BIG_ENDIAN)
+    events = (events << 16) | (events >> 16);
+#endif
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = ev->fd;
+    sqe->poll32_events = events;
+    sqe->user_data = ((uint64_t) gen << 32) | (uint32_t) ev->fd;
+
+#if (NXT_HAVE_EVENTFD)
+
+    /*
+     * The eventfd descriptor is read only once per many notifications, so
+     * it is polled in multishot mode which reports each notification once
+     * similar to EPOLLET mode.
+     */
+
+    if (ev == &engine->u.io_uring.eventfd) {
+        sqe->len = IORING_POLL_ADD_MULTI;
+    }
+
+#endif
+}
+
+
+static void
+nxt_io_uring_poll_remove(nxt_event_engine_t *engine, nxt_fd_t fd,
+    nxt_io_uring_slot_t *slot)
+{
+    struct io_uring_sqe  *sqe;
+
+    nxt_debug(&engine->task, "io_uring %d poll remove: fd:%d gen:%uD",
+              engine->u.io_uring.fd, fd, slot->gen);
+
+    sqe = nxt_io_uring_get_sqe(engine);
+
+    if (nxt_fast_path(sqe != NULL)) {
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = ((uint64_t) slot->gen << 32) | (uint32_t) fd;
+    }
+
+    /* A completion of the removed request will be ignored anyway. */
+
+    slot->events = 0;
+}
+
+
+static struct io_uring_sqe *
+nxt_io_uring_get_sqe(nxt_event_engine_t *engine)
+{
+    uint32_t             tail;
+    struct io_uring_sqe  *sqe;
+
+    tail = engine->u.io_uring.sq_tail;
+
+    if (tail - nxt_io_uring_load_acquire(engine->u.io_uring.sq_khead)
+        >= engine->u.io_uring.sq_entries)
+    {
+        (void) nxt_io_uring_enter(engine, 0, 0, NULL);
+
+        if (tail - nxt_io_uring_load_acquire(engine->u.io_uring.sq_khead)
+            >= engine->u.io_uring.sq_entries)
+        {
+            nxt_alert(&engine->task, "io_uring %d submission queue is full",
+                      engine->u.io_uring.fd);
+            return NULL;
+        }
+    }
+
+    sqe = &engine->u.io_uring.sqes[tail & engine->u.io_uring.sq_mask];
+
+    nxt_memzero(sqe, sizeof(struct io_uring_sqe));
+
+    engine->u.io_uring.sq_tail = tail + 1;
+
+    return sqe;
+}
+
+
+static int
+nxt_io_uring_enter(nxt_event_engine_t *engine, uint32_t min_complete,
+    uint32_t flags, struct io_uring_getevents_arg *arg)
+{
+    int       n;
+    uint32_t  submit;
+
+    nxt_io_uring_store_release(engine->u.io_uring.sq_ktail,
+                               engine->u.io_uring.sq_tail);
+
+    submit = engine->u.io_uring.sq_tail
+             - nxt_io_uring_load_acquire(engine->u.io_uring.sq_khead);
+
+    nxt_debug(&engine->task, "io_uring_enter(%d) submit:%uD wait:%uD",
+              engine->u.io_uring.fd, submit, min_complete);
+
+    n = syscall(__NR_io_uring_enter, engine->u.io_uring.fd, submit,
+                min_complete, flags, arg,
+                (arg != NULL) ? sizeof(struct io_uring_getevents_arg) : 0);
+
+    return n;
+}
+
+
+static void
+nxt_io_uring_error_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_fd_event_t  *ev;
+
+    ev = obj;
+
+    ev->read = NXT_EVENT_INACTIVE;
+    ev->write = NXT_EVENT_INACTIVE;
+
+    ev->error_handler(ev->task, ev, data);
+}
+
+
+#if (NXT_HAVE_SIGNALFD)
+
+static nxt_int_t
+nxt_io_uring_add_signal(nxt_event_engine_t *engine)
+{
+    int  fd;
+
+    if (sigprocmask(SIG_BLOCK, &engine->signals->sigmask, NULL) != 0) {
+        nxt_alert(&engine->task, "sigprocmask(SIG_BLOCK) failed %E", nxt_errno);
+        return NXT_ERROR;
+    }
+
+    /* See the comment in nxt_epoll_add_signal(). */
+
+    fd = signalfd(-1, &engine->signals->sigmask, 0);
+
+    if (fd == -1) {
+        nxt_alert(&engine->task, "signalfd() failed %E", nxt_errno);
+        return NXT_ERROR;
+    }
+
+    engine->u.io_uring.signalfd.fd = fd;
+
+    if (nxt_fd_nonblocking(&engine->task, fd) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    nxt_debug(&engine->task, "signalfd(): %d", fd);
+
+    engine->u.io_uring.signalfd.data = engine->signals->handler;
+    engine->u.io_uring.signalfd.read_work_queue = &engine->fast_work_queue;
+    engine->u.io_uring.signalfd.read_handler = nxt_io_uring_signalfd_handler;
+    engine->u.io_uring.signalfd.log = engine->task.log;
+    engine->u.io_uring.signalfd.task = &engine->task;
+
+    nxt_io_uring_enable_read(engine, &engine->u.io_uring.signalfd);
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_io_uring_signalfd_handler(nxt_task_t *task, void *obj, void *data)
+{
+    int                      n;
+    nxt_fd_event_t           *ev;
+    nxt_work_handler_t       handler;
+    struct signalfd_siginfo  sfd;
+
+    ev = obj;
+    handler = data;
+
+    nxt_debug(task, "signalfd handler");
+
+    n = read(ev->fd, &sfd, sizeof(struct signalfd_siginfo));
+
+    nxt_debug(task, "read signalfd(%d): %d", ev->fd, n);
+
+    if (n != sizeof(struct signalfd_siginfo)) {
+        nxt_alert(task, "read signalfd(%d) failed %E", ev->fd, nxt_errno);
+        return;
+    }
+
+    nxt_debug(task, "signalfd(%d) signo:%d", ev->fd, sfd.ssi_signo);
+
+    handler(task, (void *) (uintptr_t) sfd.ssi_signo, NULL);
+}
+
+#endif
+
+
+#if (NXT_HAVE_EVENTFD)
+
+static nxt_int_t
+nxt_io_uring_enable_post(nxt_event_engine_t *engine,
+    nxt_work_handler_t handler)
+{
+    nxt_int_t  ret;
+
+    engine->u.io_uring.post_handler = handler;
+
+    /* See the comment in nxt_epoll_enable_post(). */
+
+    engine->u.io_uring.eventfd.fd = eventfd(0, 0);
+
+    if (engine->u.io_uring.eventfd.fd == -1) {
+        nxt_alert(&engine->task, "eventfd() failed %E", nxt_errno);
+        return NXT_ERROR;
+    }
+
+    ret = nxt_fd_nonblocking(&engine->task, engine->u.io_uring.eventfd.fd);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    nxt_debug(&engine->task, "eventfd(): %d", engine->u.io_uring.eventfd.fd);
+
+    engine->u.io_uring.eventfd.read_work_queue = &engine->fast_work_queue;
+    engine->u.io_uring.eventfd.read_handler = nxt_io_uring_eventfd_handler;
+    engine->u.io_uring.eventfd.data = engine;
+    engine->u.io_uring.eventfd.log = engine->task.log;
+    engine->u.io_uring.eventfd.task = &engine->task;
+
+    nxt_io_uring_enable_read(engine, &engine->u.io_uring.eventfd);
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_io_uring_eventfd_handler(nxt_task_t *task, void *obj, void *data)
+{
+    int                 n;
+    uint64_t            events;
+    nxt_event_engine_t  *engine;
+
+    engine = data;
+
+    nxt_debug(task, "eventfd handler, times:%ui", engine->u.io_uring.neventfd);
+
+    /* See the comment in nxt_epoll_eventfd_handler(). */
+
+    if (engine->u.io_uring.neventfd++ >= 0xFFFFFFFE) {
+        engine->u.io_uring.neventfd = 0;
+
+        n = read(engine->u.io_uring.eventfd.fd, &events, sizeof(uint64_t));
+
+        nxt_debug(task, "read(%d): %d events:%uL",
+                  engine->u.io_uring.eventfd.fd, n, events);
+
+        if (n != sizeof(uint64_t)) {
+            nxt_alert(task, "read eventfd(%d) failed %E",
+                      engine->u.io_uring.eventfd.fd, nxt_errno);
+        }
+    }
+
+    engine->u.io_uring.post_handler(task, NULL, NULL);
+}
+
+
+static void
+nxt_io_uring_signal(nxt_event_engine_t *engine, nxt_uint_t signo)
+{
+    size_t    ret;
+    uint64_t  event;
+
+    /*
+     * eventfd() presents along with signalfd(), so the function
+     * is used only to post events and the signo argument is ignored.
+     */
+
+    event = 1;
+
+    ret = write(engine->u.io_uring.eventfd.fd, &event, sizeof(uint64_t));
+
+    if (nxt_slow_path(ret != sizeof(uint64_t))) {
+        nxt_alert(&engine->task, "write(%d) to eventfd failed %E",
+                  engine->u.io_uring.eventfd.fd, nxt_errno);
+    }
+}
+
+#endif
+
+
+static void
+nxt_io_uring_poll(nxt_event_engine_t *engine, nxt_msec_t timeout)
+{
+    int                            n;
+    uint32_t                       head, tail, min_complete;
+    nxt_err_t                      err;
+    nxt_uint_t                     level;
+    struct __kernel_timespec       ts;
+    struct io_uring_getevents_arg  arg;
+
+    if (engine->u.io_uring.nchanges != 0) {
+        nxt_io_uring_commit_changes(engine);
+    }
+
+    if (engine->u.io_uring.error) {
+        engine->u.io_uring.error = 0;
+        /* Error handlers have been enqueued on failure. */
+        timeout = 0;
+    }
+
+    nxt_memzero(&arg, sizeof(struct io_uring_getevents_arg));
+
+    min_complete = 0;
+
+    if (timeout != 0) {
+        min_complete = 1;
+
+        if (timeout != NXT_INFINITE_MSEC) {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000;
+
+            arg.ts = (uintptr_t) &ts;
+        }
+    }
+
+    nxt_debug(&engine->task, "io_uring_enter(%d) timeout:%M",
+              engine->u.io_uring.fd, timeout);
+
+    /* The changes are submitted along with waiting for completions. */
+
+    n = nxt_io_uring_enter(engine, min_complete,
+                           IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                           &arg);
+
+    err = (n == -1) ? nxt_errno : 0;
+
+    nxt_thread_time_update(engine->task.thread);
+
+    nxt_debug(&engine->task, "io_uring_enter(%d): %d",
+              engine->u.io_uring.fd, n);
+
+    if (n == -1 && err != ETIME) {
+        level = (err == NXT_EINTR || err == NXT_EAGAIN || err == EBUSY)
+                ? NXT_LOG_INFO : NXT_LOG_ALERT;
+
+        nxt_log(&engine->task, level, "io_uring_enter(%d) failed %E",
+                engine->u.io_uring.fd, err);
+    }
+
+    head = *engine->u.io_uring.cq_khead;
+    tail = nxt_io_uring_load_acquire(engine->u.io_uring.cq_ktail);
+
+    while (head != tail) {
+        nxt_io_uring_completion(engine, &engine->u.io_uring.cqes[
+                                            head & engine->u.io_uring.cq_mask]);
+        head++;
+    }
+
+    nxt_io_uring_store_release(engine->u.io_uring.cq_khead, head);
+}
+
+
+static void
+nxt_io_uring_completion(nxt_event_engine_t *engine, struct io_uring_cqe *cqe)
+{
+    int                  res;
+    uint32_t             fd, events;
+    uint64_t             user_data;
+    nxt_bool_t           error;
+    nxt_fd_event_t       *ev;
+    nxt_io_uring_slot_t  *slot;
+
+    user_data = cqe->user_data;
+
+    if (user_data == 0) {
+        /* A poll remove request. */
+        return;
+    }
+
+    fd = (uint32_t) user_data;
+
+    if (fd >= engine->u.io_uring.nslots) {
+        return;
+    }
+
+    slot = &engine->u.io_uring.slots[fd];
+
+    if (slot->gen != (uint32_t) (user_data >> 32) || slot->events == 0) {
+        nxt_debug(&engine->task, "io_uring: fd:%uD stale gen:%uD res:%d",
+                  fd, (uint32_t) (user_data >> 32), cqe->res);
+        return;
+    }
+
+    ev = slot->event;
+    res = cqe->res;
+
+    if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+        slot->events = 0;
+    }
+
+    if (nxt_slow_path(res < 0)) {
+        nxt_alert(ev->task, "io_uring %d poll(%d) failed %E",
+                  engine->u.io_uring.fd, ev->fd, -res);
+
+        slot->event = NULL;
+        slot->events = 0;
+
+        nxt_work_queue_add(&engine->fast_work_queue,
+                           nxt_io_uring_error_handler, ev->task, ev, ev->data);
+        return;
+    }
+
+    events = res;
+
+    nxt_debug(ev->task, "io_uring: fd:%d ev:%04XD d:%p rd:%d wr:%d",
+              ev->fd, events, ev, ev->read, ev->write);
+
+    /*
+     * On error poll may set POLLERR and POLLHUP only without POLLIN
+     * or POLLOUT, so the "error" variable enqueues only error handler.
+     */
+    error = ((events & (POLLERR | POLLHUP)) != 0);
+
+    if (error
+        && !nxt_fd_event_is_active(ev->read)
+        && !nxt_fd_event_is_active(ev->write))
+    {
+        error = 0;
+    }
+
+    if ((events & POLLIN) != 0) {
+        ev->read_ready = 1;
+
+        if (nxt_fd_event_is_active(ev->read)) {
+
+            if (ev->read == NXT_EVENT_ONESHOT) {
+                ev->read = NXT_EVENT_DISABLED;
+            }
+
+            nxt_work_queue_add(ev->read_work_queue, ev->read_handler,
+                               ev->task, ev, ev->data);
+
+            error = 0;
+        }
+    }
+
+    if ((events & POLLOUT) != 0) {
+        ev->write_ready = 1;
+
+        if (nxt_fd_event_is_active(ev->write)) {
+
+            if (ev->write == NXT_EVENT_ONESHOT) {
+                ev->write = NXT_EVENT_DISABLED;
+            }
+
+            nxt_work_queue_add(ev->write_work_queue, ev->write_handler,
+                               ev->task, ev, ev->data);
+
+            error = 0;
+        }
+    }
+
+    if (error) {
+        ev->read_ready = 1;
+        ev->write_ready = 1;
+
+        nxt_work_queue_add(&engine->fast_work_queue, nxt_io_uring_error_handler,
+                           ev->task, ev, ev->data);
+        return;
+    }
+
+    if (slot->events != 0) {
+        return;
+    }
+
+    /* Level-triggered mode: rearm the request while the event is active. */
+
+    events = nxt_io_uring_events(ev);
+
+    if (events != 0) {
+        nxt_io_uring_poll_add(engine, ev, slot, events);
+    }
+}
@@ -62,6 +62,8 @@ static void nxt_main_process_whoami_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
 static void nxt_main_port_conf_store_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
+static nxt_int_t nxt_main_conf_snapshot_store(nxt_task_t *task,
+    nxt_runtime_t *rt, u_char *buf, size_t size);
 static nxt_int_t nxt_main_file_store(nxt_task_t *task, const char *tmp_name,
     const char *name, u_char *buf, size_t size);
 static void nxt_main_port_access_log_handler(nxt_task_t *task,
@@ -1584,7 +1586,7 @@ static void
 nxt_main_port_conf_store_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 {
     void           *p;
-    size_t         n, size;
+    size_t         n, size, sizes[2];
     nxt_int_t      ret;
     nxt_port_t     *ctl_port;
     nxt_runtime_t  *rt;
@@ -1612,13 +1614,17 @@ nxt_main_port_conf_store_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         goto error;
     }
 
-    if (nxt_buf_mem_used_size(&msg->buf->mem) != sizeof(size_t)) {
+    /* The JSON configuration is followed by its binary snapshot. */
+
+    if (nxt_buf_mem_used_size(&msg->buf->mem) != sizeof(sizes)) {
         nxt_alert(task, "conf_store_handler: unexpected buffer size (%d)",
                   (int) nxt_buf_mem_used_size(&msg->buf->mem));
         goto error;
     }
 
-    nxt_memcpy(&size, msg->buf->mem.pos, sizeof(size_t));
+    nxt_memcpy(sizes, msg->buf->mem.pos, sizeof(sizes));
+
+    size = sizes[0] + sizes[1];
 
     p = nxt_mem_mmap(NULL, size, PROT_READ, MAP_SHARED, msg->fd[0], 0);
 
@@ -1629,7 +1635,8 @@ nxt_main_port_conf_store_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         goto error;
     }
 
-    nxt_debug(task, "conf_store_handler(%uz): %*s", size, size, p);
+    nxt_debug(task, "conf_store_handler(%uz, %uz): %*s",
+              sizes[0], sizes[1], sizes[0], p);
 
     if (nxt_conf_ver != NXT_VERNUM) {
         n = nxt_sprintf(ver, ver + NXT_INT_T_LEN, "%d", NXT_VERNUM) - ver;
@@ -1642,9 +1649,20 @@ nxt_main_port_conf_store_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         nxt_conf_ver = NXT_VERNUM;
     }
 
-    ret = nxt_main_file_store(task, rt->conf_tmp, rt->conf, p, size);
+    ret = nxt_main_file_store(task, rt->conf_tmp, rt->conf, p, sizes[0]);
 
     if (nxt_fast_path(ret == NXT_OK)) {
+
+        if (sizes[1] == 0
+            || nxt_main_conf_snapshot_store(task, rt, (u_char *) p + sizes[0],
+                                            sizes[1])
+               != NXT_OK)
+        {
+            nxt_alert(task, "failed to store configuration snapshot");
+
+            (void) nxt_file_delete((nxt_file_name_t *) rt->conf_snapshot);
+        }
+
         goto cleanup;
     }
 
@@ -1665,6 +1683,77 @@ nxt_main_port_conf_store_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 }
 
 
+static nxt_int_t
+nxt_main_conf_snapshot_store(nxt_task_t *task, nxt_runtime_t *rt, u_char *buf,
+    size_t size)
+{
+    ssize_t              n;
+    nxt_int_t            ret;
+    nxt_file_t           file;
+    nxt_file_info_t      fi;
+    nxt_conf_snapshot_t  snapshot;
+
+    nxt_memzero(&file, sizeof(nxt_file_t));
+
+    file.name = (nxt_file_name_t *) rt->conf;
+
+    ret = nxt_file_open(task, &file, NXT_FILE_RDONLY, NXT_FILE_OPEN, 0);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    ret = nxt_file_info(&file, &fi);
+
+    nxt_file_close(task, &file);
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    nxt_memzero(&snapshot, sizeof(nxt_conf_snapshot_t));
+
+    snapshot.magic = NXT_CONF_SNAPSHOT_MAGIC;
+    snapshot.version = NXT_VERNUM;
+    snapshot.checksum = nxt_murmur_hash2(buf, size);
+    snapshot.size = size;
+    snapshot.conf_size = nxt_file_size(&fi);
+    snapshot.conf_ino = nxt_file_ino(&fi);
+    snapshot.conf_mtime = nxt_file_mtime(&fi);
+
+    file.name = (nxt_file_name_t *) rt->conf_snapshot_tmp;
+
+    ret = nxt_file_open(task, &file, NXT_FILE_WRONLY, NXT_FILE_TRUNCATE,
+                        NXT_FILE_OWNER_ACCESS);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    n = nxt_file_write(&file, (u_char *) &snapshot,
+                       sizeof(nxt_conf_snapshot_t), 0);
+    if (nxt_slow_path(n != sizeof(nxt_conf_snapshot_t))) {
+        goto fail;
+    }
+
+    n = nxt_file_write(&file, buf, size, sizeof(nxt_conf_snapshot_t));
+    if (nxt_slow_path(n != (ssize_t) size)) {
+        goto fail;
+    }
+
+    nxt_file_close(task, &file);
+
+    return nxt_file_rename(file.name,
+                           (nxt_file_name_t *) rt->conf_snapshot);
+
+fail:
+
+    nxt_file_close(task, &file);
+
+    (void) nxt_file_delete(file.name);
+
+    return NXT_ERROR;
+}
+
+
 static nxt_int_t
 nxt_main_file_store(nxt_task_t *task, const char *tmp_name, const char *name,
     u_char *buf, size_t size)
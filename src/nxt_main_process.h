@@ -19,6 +19,27 @@ typedef enum {
 } nxt_socket_error_t;
 
 
+#define NXT_CONF_SNAPSHOT_MAGIC  0x4e584331  /* "NXC1" */
+
+
+/*
+ * The header of the "conf.bin" snapshot.  The snapshot is valid only for
+ * the same Unit version and while "conf.json" has the same size, inode,
+ * and modification time as at the moment the snapshot was written.
+ */
+
+typedef struct {
+    uint32_t                    magic;
+    uint32_t                    version;
+    uint32_t                    checksum;
+    uint32_t                    reserved;
+    uint64_t                    size;
+    uint64_t                    conf_size;
+    uint64_t                    conf_ino;
+    int64_t                     conf_mtime;
+} nxt_conf_snapshot_t;
+
+
 nxt_int_t nxt_main_process_start(nxt_thread_t *thr, nxt_task_t *task,
     nxt_runtime_t *runtime);
 
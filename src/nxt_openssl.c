@@ -84,6 +84,11 @@ static nxt_int_t nxt_openssl_bundle_hash_test(nxt_lvlhsh_query_t *lhq,
 static nxt_int_t nxt_openssl_bundle_hash_insert(nxt_task_t *task,
     nxt_lvlhsh_t *lvlhsh, nxt_tls_bundle_hash_item_t *item, nxt_mp_t * mp);
 static nxt_int_t nxt_openssl_servername(SSL *s, int *ad, void *arg);
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+static int nxt_openssl_alpn_select(SSL *s, const unsigned char **out,
+    unsigned char *outlen, const unsigned char *in, unsigned int inlen,
+    void *arg);
+#endif
 static nxt_tls_bundle_conf_t *nxt_openssl_find_ctx(nxt_tls_conf_t *conf,
     nxt_str_t *sn);
 static void nxt_openssl_server_free(nxt_task_t *task, nxt_tls_conf_t *conf);
@@ -92,6 +97,10 @@ static void nxt_openssl_conn_init(nxt_task_t *task, nxt_tls_conf_t *conf,
 static void nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data);
 static ssize_t nxt_openssl_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b);
 static ssize_t nxt_openssl_conn_io_sendbuf(nxt_task_t *task, nxt_sendbuf_t *sb);
+#ifdef SSL_OP_ENABLE_KTLS
+static ssize_t nxt_openssl_conn_io_sendfile(nxt_task_t *task,
+    nxt_sendbuf_t *sb);
+#endif
 static ssize_t nxt_openssl_conn_io_send(nxt_task_t *task, nxt_sendbuf_t *sb,
     void *buf, size_t size);
 static void nxt_openssl_conn_io_shutdown(nxt_task_t *task, void *obj,
@@ -331,6 +340,19 @@ nxt_openssl_server_init(nxt_task_t *task, nxt_mp_t *mp,
     SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
 #endif
 
+    if (tls_init->ktls) {
+#ifdef SSL_OP_ENABLE_KTLS
+        /*
+         * Kernel TLS is used only if the kernel supports the negotiated
+         * cipher, otherwise OpenSSL silently falls back to user space.
+         */
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#else
+        nxt_log(task, NXT_LOG_NOTICE,
+                "kernel TLS is not supported by OpenSSL, \"ktls\" ignored");
+#endif
+    }
+
 #ifdef SSL_MODE_RELEASE_BUFFERS
 
     if (nxt_openssl_version >= 10001078) {
@@ -388,6 +410,12 @@ nxt_openssl_server_init(nxt_task_t *task, nxt_mp_t *mp,
 
     SSL_CTX_set_options(ctx, SSL_OP_CIPHER_SERVER_PREFERENCE);
 
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+    if (conf->http2) {
+        SSL_CTX_set_alpn_select_cb(ctx, nxt_openssl_alpn_select, NULL);
+    }
+#endif
+
     if (conf->ca_certificate != NULL) {
 
         /* TODO: verify callback */
@@ -1026,6 +1054,42 @@ nxt_openssl_bundle_hash_insert(nxt_task_t *task, nxt_lvlhsh_t *lvlhsh,
 }
 
 
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+
+static int
+nxt_openssl_alpn_select(SSL *s, const unsigned char **out,
+    unsigned char *outlen, const unsigned char *in, unsigned int inlen,
+    void *arg)
+{
+    int         ret;
+    nxt_conn_t  *c;
+
+    static const unsigned char  protocols[] = "\x02h2\x08http/1.1";
+
+    c = SSL_get_ex_data(s, nxt_openssl_connection_index);
+
+    if (nxt_slow_path(c == NULL)) {
+        nxt_thread_log_alert("SSL_get_ex_data() failed");
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+
+    ret = SSL_select_next_proto((unsigned char **) out, outlen, protocols,
+                                sizeof(protocols) - 1, in, inlen);
+
+    if (ret != OPENSSL_NPN_NEGOTIATED) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+
+    c->alpn_h2 = (*outlen == 2 && memcmp(*out, "h2", 2) == 0);
+
+    nxt_debug(c->socket.task, "TLS ALPN: \"%*s\"", (size_t) *outlen, *out);
+
+    return SSL_TLSEXT_ERR_OK;
+}
+
+#endif
+
+
 static nxt_int_t
 nxt_openssl_servername(SSL *s, int *ad, void *arg)
 {
@@ -1278,6 +1342,14 @@ nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data)
         /* ret == 1, the handshake was successfully completed. */
         tls->handshake = 1;
 
+#ifdef SSL_OP_ENABLE_KTLS
+        if (BIO_get_ktls_send(SSL_get_wbio(tls->session))) {
+            nxt_debug(task, "SSL kernel TLS send is enabled");
+
+            c->sendfile = NXT_CONN_SENDFILE_ON;
+        }
+#endif
+
         if (c->read_state != NULL) {
             if (state->io_read_handler != NULL || c->read != NULL) {
                 nxt_conn_read(task->thread->engine, c);
@@ -1375,10 +1447,77 @@ nxt_openssl_conn_io_sendbuf(nxt_task_t *task, nxt_sendbuf_t *sb)
         return 0;
     }
 
+#ifdef SSL_OP_ENABLE_KTLS
+    if (niov == 0 && sb->buf != NULL && nxt_buf_is_file(sb->buf)) {
+        return nxt_openssl_conn_io_sendfile(task, sb);
+    }
+#endif
+
     return nxt_openssl_conn_io_send(task, sb, iov.iov_base, iov.iov_len);
 }
 
 
+#ifdef SSL_OP_ENABLE_KTLS
+
+static ssize_t
+nxt_openssl_conn_io_sendfile(nxt_task_t *task, nxt_sendbuf_t *sb)
+{
+    size_t              size;
+    ssize_t             ret;
+    nxt_buf_t           *b;
+    nxt_err_t           err;
+    nxt_int_t           n;
+    nxt_conn_t          *c;
+    nxt_openssl_conn_t  *tls;
+
+    tls = sb->tls;
+    b = sb->buf;
+
+    size = b->file_end - b->file_pos;
+    size = nxt_min(size, sb->limit - sb->size);
+
+    ret = SSL_sendfile(tls->session, b->file->fd, b->file_pos, size, 0);
+
+    err = (ret <= 0) ? nxt_socket_errno : 0;
+
+    nxt_debug(task, "SSL_sendfile(%d, %FD, @%O, %uz): %z err:%d",
+              sb->socket, b->file->fd, b->file_pos, size, ret, err);
+
+    if (ret > 0) {
+        if (ret < (ssize_t) size) {
+            sb->ready = 0;
+        }
+
+        return ret;
+    }
+
+    if (nxt_slow_path(ret == 0)) {
+        nxt_alert(task, "SSL_sendfile() reported that file was truncated at %O",
+                  b->file_pos);
+
+        return NXT_ERROR;
+    }
+
+    c = tls->conn;
+    c->socket.write_ready = sb->ready;
+
+    n = nxt_openssl_conn_test_error(task, c, ret, err, NXT_OPENSSL_WRITE);
+
+    sb->ready = c->socket.write_ready;
+
+    if (n == NXT_ERROR) {
+        sb->error = c->socket.error;
+        nxt_openssl_conn_error(task, err, "SSL_sendfile(%d, %FD, @%O, %uz) "
+                               "failed", sb->socket, b->file->fd,
+                               b->file_pos, size);
+    }
+
+    return n;
+}
+
+#endif
+
+
 static ssize_t
 nxt_openssl_conn_io_send(nxt_task_t *task, nxt_sendbuf_t *sb, void *buf,
     size_t size)
@@ -26,6 +26,7 @@ typedef struct {
 
 typedef struct {
     nxt_str_t                  conf;
+    nxt_str_t                  snapshot;
 #if (NXT_TLS)
     nxt_array_t                *certs;
 #endif
@@ -15,6 +15,7 @@
 #include <nxt_script.h>
 #endif
 #include <nxt_http.h>
+#include <nxt_upstream.h>
 #include <nxt_port_memory_int.h>
 #include <nxt_unit_request.h>
 #include <nxt_unit_response.h>
@@ -40,6 +41,8 @@ typedef struct {
 typedef struct {
     nxt_str_t         pass;
     nxt_str_t         application;
+    uint8_t           http2;
+    uint32_t          limit_connections;
 } nxt_router_listener_conf_t;
 
 
@@ -149,9 +152,17 @@ static void nxt_router_listen_socket_error(nxt_task_t *task,
 #if (NXT_TLS)
 static void nxt_router_tls_rpc_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
+static nxt_int_t nxt_router_conf_tls_create(nxt_router_temp_conf_t *tmcf,
+    nxt_socket_conf_t *skcf, nxt_conf_value_t *value);
+static nxt_tls_conf_t *nxt_router_conf_tls_find(nxt_queue_t *sockets,
+    nxt_str_t *key, nxt_bool_t http2);
 static nxt_int_t nxt_router_conf_tls_insert(nxt_router_temp_conf_t *tmcf,
     nxt_conf_value_t *value, nxt_socket_conf_t *skcf, nxt_tls_init_t *tls_init,
     nxt_bool_t last);
+static void nxt_router_tls_release(nxt_task_t *task,
+    nxt_thread_spinlock_t *lock, nxt_tls_conf_t *tlscf);
+static void nxt_router_conf_tls_release(nxt_task_t *task,
+    nxt_router_t *router, nxt_queue_t *sockets);
 #endif
 #if (NXT_HAVE_NJS)
 static void nxt_router_js_module_rpc_handler(nxt_task_t *task,
@@ -806,7 +817,7 @@ nxt_router_conf_data_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         goto fail;
     }
 
-    nxt_debug(task, "conf_data_handler(%uz): %*s", size, size, p);
+    nxt_debug(task, "conf_data_handler(%uz)", size);
 
     tmcf->router_conf->router = nxt_router;
     tmcf->stream = msg->port_msg.stream;
@@ -947,15 +958,21 @@ nxt_router_app_restart_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 static void
 nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 {
-    u_char               *p;
-    size_t               alloc;
-    nxt_app_t            *app;
-    nxt_buf_t            *b;
-    nxt_uint_t           type;
-    nxt_port_t           *port;
-    nxt_status_app_t     *app_stat;
-    nxt_event_engine_t   *engine;
-    nxt_status_report_t  *report;
+    u_char                        *p;
+    size_t                        alloc;
+    uint32_t                      i, napps, nupstreams;
+    nxt_app_t                     *app;
+    nxt_buf_t                     *b;
+    nxt_uint_t                    type;
+    nxt_port_t                    *port;
+    nxt_status_app_t              *app_stat;
+    nxt_event_engine_t            *engine;
+    nxt_status_report_t           *report;
+    nxt_status_server_t           *server_stat;
+    nxt_status_upstream_t         *upstream_stat;
+    nxt_upstream_health_t         *health;
+    nxt_upstream_health_check_t   *check;
+    nxt_upstream_health_server_t  *s;
 
     port = nxt_runtime_port_find(task->thread->runtime,
                                  msg->port_msg.pid,
@@ -966,13 +983,33 @@ nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
     }
 
     alloc = sizeof(nxt_status_report_t);
+    napps = 0;
 
     nxt_queue_each(app, &nxt_router->apps, nxt_app_t, link) {
 
         alloc += sizeof(nxt_status_app_t) + app->name.length;
+        napps++;
 
     } nxt_queue_loop;
 
+    health = nxt_router->health;
+    nupstreams = 0;
+
+    if (health != NULL) {
+        nxt_queue_each(check, &health->checks, nxt_upstream_health_check_t,
+                       link)
+        {
+            alloc += sizeof(nxt_status_upstream_t) + check->name.length;
+            nupstreams++;
+
+            for (i = 0; i < check->items; i++) {
+                alloc += sizeof(nxt_status_server_t)
+                         + check->server[i].name.length;
+            }
+
+        } nxt_queue_loop;
+    }
+
     b = nxt_buf_mem_alloc(port->mem_pool, alloc, 0);
     if (nxt_slow_path(b == NULL)) {
         type = NXT_PORT_MSG_RPC_ERROR;
@@ -1014,6 +1051,48 @@ nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         app_stat++;
     } nxt_queue_loop;
 
+    /* The upstreams follow the applications, and then their servers. */
+
+    upstream_stat = (nxt_status_upstream_t *) &report->apps[napps];
+    server_stat = (nxt_status_server_t *) &upstream_stat[nupstreams];
+
+    report->upstreams_count = nupstreams;
+    report->upstreams = (nxt_status_upstream_t *)
+                            ((u_char *) upstream_stat - b->mem.pos);
+
+    if (health != NULL) {
+        nxt_queue_each(check, &health->checks, nxt_upstream_health_check_t,
+                       link)
+        {
+            p -= check->name.length;
+
+            nxt_memcpy(p, check->name.start, check->name.length);
+
+            upstream_stat->name.length = check->name.length;
+            upstream_stat->name.start = (u_char *) (p - b->mem.pos);
+
+            upstream_stat->servers_count = check->items;
+            upstream_stat->servers = (nxt_status_server_t *)
+                                     ((u_char *) server_stat - b->mem.pos);
+
+            for (i = 0; i < check->items; i++) {
+                s = &check->server[i];
+
+                p -= s->name.length;
+
+                nxt_memcpy(p, s->name.start, s->name.length);
+
+                server_stat->name.length = s->name.length;
+                server_stat->name.start = (u_char *) (p - b->mem.pos);
+                server_stat->down = s->down;
+
+                server_stat++;
+            }
+
+            upstream_stat++;
+        } nxt_queue_loop;
+    }
+
     type = NXT_PORT_MSG_RPC_READY_LAST;
 
 fail:
@@ -1252,7 +1331,7 @@ nxt_router_conf_apply(nxt_task_t *task, void *obj, void *data)
 
     rt = task->thread->runtime;
 
-    interface = nxt_service_get(rt->services, "engine", NULL);
+    interface = nxt_service_get(rt->services, "engine", rt->engine);
 
     router = rtcf->router;
 
@@ -1283,6 +1362,14 @@ nxt_router_conf_apply(nxt_task_t *task, void *obj, void *data)
         router->access_log = rtcf->access_log;
     }
 
+    if (router->health != rtcf->health) {
+        nxt_upstream_health_start(task, rtcf->health);
+
+        nxt_upstream_health_stop(task, router->health);
+
+        router->health = rtcf->health;
+    }
+
     nxt_router_conf_ready(task, tmcf);
 
     return;
@@ -1338,6 +1425,8 @@ nxt_router_conf_ready(nxt_task_t *task, nxt_router_temp_conf_t *tmcf)
 
         nxt_router_access_log_release(task, lock, rtcf->access_log);
 
+        nxt_upstream_health_release(task, rtcf->health);
+
         nxt_mp_destroy(rtcf->mem_pool);
     }
 
@@ -1390,6 +1479,14 @@ nxt_router_conf_error(nxt_task_t *task, nxt_router_temp_conf_t *tmcf)
 
     nxt_router_access_log_release(task, &router->lock, rtcf->access_log);
 
+    nxt_upstream_health_release(task, rtcf->health);
+
+#if (NXT_TLS)
+    nxt_router_conf_tls_release(task, router, &creating_sockets);
+    nxt_router_conf_tls_release(task, router, &pending_sockets);
+    nxt_router_conf_tls_release(task, router, &updating_sockets);
+#endif
+
     nxt_mp_destroy(rtcf->mem_pool);
 
     nxt_router_conf_send(task, tmcf, NXT_PORT_MSG_RPC_ERROR);
@@ -1494,6 +1591,18 @@ static nxt_conf_map_t  nxt_router_listener_conf[] = {
         NXT_CONF_MAP_STR_COPY,
         offsetof(nxt_router_listener_conf_t, application),
     },
+
+    {
+        nxt_string("http2"),
+        NXT_CONF_MAP_INT8,
+        offsetof(nxt_router_listener_conf_t, http2),
+    },
+
+    {
+        nxt_string("limit_connections"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_router_listener_conf_t, limit_connections),
+    },
 };
 
 
@@ -1600,6 +1709,21 @@ static nxt_conf_map_t  nxt_router_websocket_conf[] = {
 };
 
 
+static nxt_conf_map_t  nxt_router_open_file_cache_conf[] = {
+    {
+        nxt_string("max"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_router_conf_t, open_file_cache_max),
+    },
+
+    {
+        nxt_string("valid"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_router_conf_t, open_file_cache_valid),
+    },
+};
+
+
 static nxt_int_t
 nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     u_char *start, u_char *end)
@@ -1640,6 +1764,7 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     static const nxt_str_t  routes_path = nxt_string("/routes");
     static const nxt_str_t  access_log_path = nxt_string("/access_log");
 #if (NXT_TLS)
+    static const nxt_str_t  tls_path = nxt_string("/tls");
     static const nxt_str_t  certificate_path = nxt_string("/tls/certificate");
     static const nxt_str_t  conf_commands_path =
                                 nxt_string("/tls/conf_commands");
@@ -1648,17 +1773,20 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     static const nxt_str_t  conf_timeout_path =
                                 nxt_string("/tls/session/timeout");
     static const nxt_str_t  conf_tickets = nxt_string("/tls/session/tickets");
+    static const nxt_str_t  conf_ktls_path = nxt_string("/tls/ktls");
 #endif
 #if (NXT_HAVE_NJS)
     static const nxt_str_t  js_module_path = nxt_string("/settings/js_module");
 #endif
     static const nxt_str_t  static_path = nxt_string("/settings/http/static");
+    static const nxt_str_t  compression_path =
+                                nxt_string("/settings/http/compression");
     static const nxt_str_t  websocket_path =
                                 nxt_string("/settings/http/websocket");
     static const nxt_str_t  forwarded_path = nxt_string("/forwarded");
     static const nxt_str_t  client_ip_path = nxt_string("/client_ip");
 
-    root = nxt_conf_json_parse(tmcf->mem_pool, start, end, NULL);
+    root = nxt_conf_bin_parse(tmcf->mem_pool, start, end);
     if (root == NULL) {
         nxt_alert(task, "configuration parsing error");
         return NXT_ERROR;
@@ -1685,6 +1813,15 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         return NXT_ERROR;
     }
 
+    conf = nxt_conf_get_path(root, &compression_path);
+
+    if (conf != NULL) {
+        rtcf->compress = nxt_http_compress_conf_create(task, mp, conf);
+        if (nxt_slow_path(rtcf->compress == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
     router = rtcf->router;
 
     applications = nxt_conf_get_path(root, &applications_path);
@@ -1975,6 +2112,9 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 
             nxt_debug(task, "application: %V", &lscf.application);
 
+            skcf->http2 = lscf.http2;
+            skcf->limit_connections = lscf.limit_connections;
+
             // STUB, default values if http block is not defined.
             skcf->header_buffer_size = 2048;
             skcf->large_header_buffer_size = 8192;
@@ -2051,6 +2191,14 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
             certificate = nxt_conf_get_path(listener, &certificate_path);
 
             if (certificate != NULL) {
+                ret = nxt_router_conf_tls_create(tmcf, skcf,
+                                         nxt_conf_get_path(listener, &tls_path));
+                if (nxt_slow_path(ret == NXT_ERROR)) {
+                    goto fail;
+                }
+            }
+
+            if (certificate != NULL && ret == NXT_DECLINED) {
                 tls_init = nxt_mp_get(tmcf->mem_pool, sizeof(nxt_tls_init_t));
                 if (nxt_slow_path(tls_init == NULL)) {
                     return NXT_ERROR;
@@ -2058,6 +2206,7 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 
                 tls_init->cache_size = 0;
                 tls_init->timeout = 300;
+                tls_init->ktls = 0;
 
                 value = nxt_conf_get_path(listener, &conf_cache_path);
                 if (value != NULL) {
@@ -2075,6 +2224,11 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
                 tls_init->tickets_conf = nxt_conf_get_path(listener,
                                                            &conf_tickets);
 
+                value = nxt_conf_get_path(listener, &conf_ktls_path);
+                if (value != NULL) {
+                    tls_init->ktls = nxt_conf_get_boolean(value);
+                }
+
                 n = nxt_conf_array_elements_count_or_1(certificate);
 
                 for (i = 0; i < n; i++) {
@@ -2177,6 +2331,116 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 
 #if (NXT_TLS)
 
+/*
+ * A listener whose "tls" object is unchanged shares the TLS contexts
+ * of the current configuration, so the certificates are neither fetched
+ * nor loaded again on reconfiguration and cached sessions survive it.
+ * The certificates cannot be replaced while they are in use, hence the
+ * same object means the same contexts.
+ */
+
+static nxt_int_t
+nxt_router_conf_tls_create(nxt_router_temp_conf_t *tmcf,
+    nxt_socket_conf_t *skcf, nxt_conf_value_t *value)
+{
+    u_char          *p;
+    nxt_mp_t        *mp;
+    nxt_str_t       key;
+    nxt_router_t    *router;
+    nxt_tls_conf_t  *tlscf;
+
+    key.length = nxt_conf_json_length(value, NULL);
+
+    key.start = nxt_mp_nget(tmcf->mem_pool, key.length);
+    if (nxt_slow_path(key.start == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_conf_json_print(key.start, value, NULL);
+    key.length = p - key.start;
+
+    router = tmcf->router_conf->router;
+
+    nxt_thread_spin_lock(&router->lock);
+
+    tlscf = nxt_router_conf_tls_find(&router->sockets, &key, skcf->http2);
+
+    if (tlscf == NULL) {
+        tlscf = nxt_router_conf_tls_find(&keeping_sockets, &key, skcf->http2);
+    }
+
+    if (tlscf == NULL) {
+        tlscf = nxt_router_conf_tls_find(&updating_sockets, &key,
+                                         skcf->http2);
+    }
+
+    if (tlscf == NULL) {
+        tlscf = nxt_router_conf_tls_find(&pending_sockets, &key, skcf->http2);
+    }
+
+    if (tlscf != NULL) {
+        tlscf->count++;
+    }
+
+    nxt_thread_spin_unlock(&router->lock);
+
+    if (tlscf != NULL) {
+        skcf->tls = tlscf;
+        return NXT_OK;
+    }
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NXT_ERROR;
+    }
+
+    tlscf = nxt_mp_zget(mp, sizeof(nxt_tls_conf_t));
+    if (nxt_slow_path(tlscf == NULL)) {
+        goto fail;
+    }
+
+    if (nxt_slow_path(nxt_str_dup(mp, &tlscf->key, &key) == NULL)) {
+        goto fail;
+    }
+
+    tlscf->mem_pool = mp;
+    tlscf->count = 1;
+    tlscf->no_wait_shutdown = 1;
+    tlscf->http2 = skcf->http2;
+
+    skcf->tls = tlscf;
+
+    return NXT_DECLINED;
+
+fail:
+
+    nxt_mp_destroy(mp);
+
+    return NXT_ERROR;
+}
+
+
+static nxt_tls_conf_t *
+nxt_router_conf_tls_find(nxt_queue_t *sockets, nxt_str_t *key,
+    nxt_bool_t http2)
+{
+    nxt_socket_conf_t  *skcf;
+
+    nxt_queue_each(skcf, sockets, nxt_socket_conf_t, link) {
+
+        if (skcf->tls != NULL
+            && skcf->tls->http2 == http2
+            && nxt_strstr_eq(&skcf->tls->key, key))
+        {
+            return skcf->tls;
+        }
+
+    } nxt_queue_loop;
+
+    return NULL;
+}
+
+
 static nxt_int_t
 nxt_router_conf_tls_insert(nxt_router_temp_conf_t *tmcf,
     nxt_conf_value_t *value, nxt_socket_conf_t *skcf,
@@ -2288,6 +2552,8 @@ nxt_router_conf_process_static(nxt_task_t *task, nxt_router_conf_t *rtcf,
     nxt_conf_value_t  *mtypes_conf, *ext_conf, *value;
 
     static const nxt_str_t  mtypes_path = nxt_string("/mime_types");
+    static const nxt_str_t  open_file_cache_path =
+                                nxt_string("/open_file_cache");
 
     mp = rtcf->mem_pool;
 
@@ -2300,6 +2566,20 @@ nxt_router_conf_process_static(nxt_task_t *task, nxt_router_conf_t *rtcf,
         return NXT_OK;
     }
 
+    value = nxt_conf_get_path(conf, &open_file_cache_path);
+
+    if (value != NULL) {
+        rtcf->open_file_cache_max = 1000;
+        rtcf->open_file_cache_valid = 10 * 1000;
+
+        ret = nxt_conf_map_object(mp, value, nxt_router_open_file_cache_conf,
+                                  nxt_nitems(nxt_router_open_file_cache_conf),
+                                  rtcf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+    }
+
     mtypes_conf = nxt_conf_get_path(conf, &mtypes_path);
 
     if (mtypes_conf != NULL) {
@@ -2971,20 +3251,8 @@ nxt_router_tls_rpc_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
         goto fail;
     }
 
-    mp = tmcf->router_conf->mem_pool;
-
-    if (tls->socket_conf->tls == NULL) {
-        tlscf = nxt_mp_zget(mp, sizeof(nxt_tls_conf_t));
-        if (nxt_slow_path(tlscf == NULL)) {
-            goto fail;
-        }
-
-        tlscf->no_wait_shutdown = 1;
-        tls->socket_conf->tls = tlscf;
-
-    } else {
-        tlscf = tls->socket_conf->tls;
-    }
+    tlscf = tls->socket_conf->tls;
+    mp = tlscf->mem_pool;
 
     tls->tls_init->conf = tlscf;
 
@@ -2997,6 +3265,7 @@ nxt_router_tls_rpc_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
         goto fail;
     }
 
+    bundle->ctx = NULL;
     bundle->chain_file = msg->fd[0];
     bundle->next = tlscf->bundle;
     tlscf->bundle = bundle;
@@ -3004,6 +3273,8 @@ nxt_router_tls_rpc_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
     ret = task->thread->runtime->tls->server_init(task, mp, tls->tls_init,
                                                   tls->last);
     if (nxt_slow_path(ret != NXT_OK)) {
+        /* The context has been freed by server_init(). */
+        bundle->ctx = NULL;
         goto fail;
     }
 
@@ -3808,6 +4079,8 @@ nxt_router_worker_thread_quit(nxt_task_t *task, void *obj, void *data)
 
     engine->shutdown = 1;
 
+    nxt_router_access_log_flush(task);
+
     if (nxt_queue_is_empty(&engine->joints)) {
         nxt_thread_exit(task->thread);
     }
@@ -3946,6 +4219,9 @@ nxt_router_conf_release(nxt_task_t *task, nxt_socket_conf_joint_t *joint)
     nxt_socket_conf_t      *skcf;
     nxt_router_conf_t      *rtcf;
     nxt_thread_spinlock_t  *lock;
+#if (NXT_TLS)
+    nxt_tls_conf_t         *tlscf;
+#endif
 
     nxt_debug(task, "conf joint %p count: %D", joint, joint->count);
 
@@ -3964,18 +4240,25 @@ nxt_router_conf_release(nxt_task_t *task, nxt_socket_conf_joint_t *joint)
     rtcf = skcf->router_conf;
     lock = &rtcf->router->lock;
 
+#if (NXT_TLS)
+    tlscf = NULL;
+#endif
+
     nxt_thread_spin_lock(lock);
 
     nxt_debug(task, "conf skcf %p: %D, rtcf %p: %D", skcf, skcf->count,
               rtcf, rtcf->count);
 
     if (--skcf->count != 0) {
-        skcf = NULL;
         rtcf = NULL;
 
     } else {
         nxt_queue_remove(&skcf->link);
 
+#if (NXT_TLS)
+        tlscf = skcf->tls;
+#endif
+
         if (--rtcf->count != 0) {
             rtcf = NULL;
         }
@@ -3984,8 +4267,8 @@ nxt_router_conf_release(nxt_task_t *task, nxt_socket_conf_joint_t *joint)
     nxt_thread_spin_unlock(lock);
 
 #if (NXT_TLS)
-    if (skcf != NULL && skcf->tls != NULL) {
-        task->thread->runtime->tls->server_free(task, skcf->tls);
+    if (tlscf != NULL) {
+        nxt_router_tls_release(task, lock, tlscf);
     }
 #endif
 
@@ -3998,6 +4281,8 @@ nxt_router_conf_release(nxt_task_t *task, nxt_socket_conf_joint_t *joint)
 
         nxt_router_access_log_release(task, lock, rtcf->access_log);
 
+        nxt_upstream_health_release(task, rtcf->health);
+
         nxt_tstr_state_release(rtcf->tstr_state);
 
         nxt_mp_thread_adopt(rtcf->mem_pool);
@@ -4007,6 +4292,52 @@ nxt_router_conf_release(nxt_task_t *task, nxt_socket_conf_joint_t *joint)
 }
 
 
+#if (NXT_TLS)
+
+static void
+nxt_router_tls_release(nxt_task_t *task, nxt_thread_spinlock_t *lock,
+    nxt_tls_conf_t *tlscf)
+{
+    nxt_thread_spin_lock(lock);
+
+    if (--tlscf->count != 0) {
+        tlscf = NULL;
+    }
+
+    nxt_thread_spin_unlock(lock);
+
+    if (tlscf != NULL) {
+        nxt_debug(task, "tls conf %p is destroyed", tlscf);
+
+        if (tlscf->bundle != NULL) {
+            task->thread->runtime->tls->server_free(task, tlscf);
+        }
+
+        nxt_mp_thread_adopt(tlscf->mem_pool);
+
+        nxt_mp_destroy(tlscf->mem_pool);
+    }
+}
+
+
+static void
+nxt_router_conf_tls_release(nxt_task_t *task, nxt_router_t *router,
+    nxt_queue_t *sockets)
+{
+    nxt_socket_conf_t  *skcf;
+
+    nxt_queue_each(skcf, sockets, nxt_socket_conf_t, link) {
+
+        if (skcf->tls != NULL) {
+            nxt_router_tls_release(task, &router->lock, skcf->tls);
+        }
+
+    } nxt_queue_loop;
+}
+
+#endif
+
+
 static void
 nxt_router_thread_exit_handler(nxt_task_t *task, void *obj, void *data)
 {
@@ -4032,6 +4363,8 @@ nxt_router_thread_exit_handler(nxt_task_t *task, void *obj, void *data)
     nxt_mp_thread_adopt(port->mem_pool);
     nxt_port_use(task, port, -1);
 
+    nxt_http_static_cache_free(task, engine);
+
     nxt_mp_thread_adopt(engine->mem_pool);
     nxt_mp_destroy(engine->mem_pool);
 
@@ -21,7 +21,9 @@ typedef struct nxt_http_routes_s        nxt_http_routes_t;
 typedef struct nxt_http_forward_s       nxt_http_forward_t;
 typedef struct nxt_upstream_s           nxt_upstream_t;
 typedef struct nxt_upstreams_s          nxt_upstreams_t;
+typedef struct nxt_upstream_health_s    nxt_upstream_health_t;
 typedef struct nxt_router_access_log_s  nxt_router_access_log_t;
+typedef struct nxt_http_compress_conf_s  nxt_http_compress_conf_t;
 
 
 #define NXT_HTTP_ACTION_ERROR  ((nxt_http_action_t *) -1)
@@ -35,6 +37,7 @@ typedef struct {
     nxt_queue_t              apps;     /* of nxt_app_t */
 
     nxt_router_access_log_t  *access_log;
+    nxt_upstream_health_t    *health;
 } nxt_router_t;
 
 
@@ -48,10 +51,16 @@ typedef struct {
     nxt_router_t             *router;
     nxt_http_routes_t        *routes;
     nxt_upstreams_t          *upstreams;
+    nxt_upstream_health_t    *health;
 
     nxt_lvlhsh_t             mtypes_hash;
     nxt_lvlhsh_t             apps_hash;
 
+    uint32_t                 open_file_cache_max;
+    nxt_msec_t               open_file_cache_valid;
+
+    nxt_http_compress_conf_t  *compress;
+
     nxt_router_access_log_t  *access_log;
     nxt_tstr_t               *log_format;
     nxt_tstr_t               *log_expr;
@@ -209,6 +218,10 @@ typedef struct {
 
     uint8_t                server_version;         /* 1 bit */
 
+    uint8_t                http2;                  /* 1 bit */
+
+    uint32_t               limit_connections;
+
     nxt_http_forward_t     *forwarded;
     nxt_http_forward_t     *client_ip;
 
@@ -239,6 +252,12 @@ struct nxt_router_access_log_s {
     nxt_fd_t               fd;
     nxt_str_t              path;
     uint32_t               count;
+
+    /* The buffers are written in order by a single writer. */
+    nxt_thread_spinlock_t  lock;
+    nxt_queue_t            bufs;
+    nxt_work_t             work;
+    uint8_t                writing;  /* 1 bit */
 };
 
 
@@ -263,6 +282,7 @@ void nxt_router_access_log_release(nxt_task_t *task,
     nxt_thread_spinlock_t *lock, nxt_router_access_log_t *access_log);
 void nxt_router_access_log_reopen_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
+void nxt_router_access_log_flush(nxt_task_t *task);
 
 
 extern nxt_router_t  *nxt_router;
@@ -23,6 +23,39 @@ typedef struct {
 } nxt_router_access_log_ctx_t;
 
 
+/*
+ * Log lines are accumulated in a per-engine buffer which is handed
+ * over to the thread pool when it is full, when the flush timer
+ * expires, or when a line for another access log arrives.  The buffer
+ * holds a reference to its access log, so it can be written and freed
+ * by a thread pool thread regardless of the engine and configuration
+ * lifetime.  The write is still done through access_log->fd, so
+ * the reopened log file is used as soon as it is in place.
+ *
+ * The flushed buffers are queued in the access log and written by
+ * at most one thread at a time, so the lines of an engine are never
+ * reordered by concurrent thread pool threads.
+ */
+
+#define NXT_ROUTER_ACCESS_LOG_BUFFER  (64 * 1024)
+#define NXT_ROUTER_ACCESS_LOG_FLUSH   100
+
+
+typedef struct {
+    nxt_queue_link_t          link;
+    nxt_router_access_log_t   *access_log;
+    u_char                    *free;
+    u_char                    *end;
+    u_char                    start[];
+} nxt_router_access_log_buf_t;
+
+
+typedef struct {
+    nxt_router_access_log_buf_t  *buf;
+    nxt_timer_t                  timer;
+} nxt_router_access_log_engine_t;
+
+
 static void nxt_router_access_log_writer(nxt_task_t *task,
     nxt_http_request_t *r, nxt_router_access_log_t *access_log,
     nxt_tstr_t *format);
@@ -30,6 +63,16 @@ static void nxt_router_access_log_write_ready(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_router_access_log_write_error(nxt_task_t *task, void *obj,
     void *data);
+static void nxt_router_access_log_buffer(nxt_task_t *task,
+    nxt_router_access_log_t *access_log, nxt_str_t *text);
+static nxt_router_access_log_buf_t *nxt_router_access_log_buf_alloc(
+    nxt_router_access_log_t *access_log, size_t size);
+static void nxt_router_access_log_flush_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_router_access_log_bufs_write(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_router_access_log_buf_write(nxt_task_t *task,
+    nxt_router_access_log_buf_t *buf);
 static void nxt_router_access_log_ready(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
 static void nxt_router_access_log_error(nxt_task_t *task,
@@ -105,7 +148,7 @@ nxt_router_access_log_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
         nxt_router_access_log_use(&router->lock, access_log);
 
     } else {
-        access_log = nxt_malloc(sizeof(nxt_router_access_log_t)
+        access_log = nxt_zalloc(sizeof(nxt_router_access_log_t)
                                 + alcf.path.length);
         if (access_log == NULL) {
             nxt_alert(task, "failed to allocate access log structure");
@@ -116,6 +159,8 @@ nxt_router_access_log_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
         access_log->handler = &nxt_router_access_log_writer;
         access_log->count = 1;
 
+        nxt_queue_init(&access_log->bufs);
+
         access_log->path.length = alcf.path.length;
         access_log->path.start = (u_char *) access_log
                                  + sizeof(nxt_router_access_log_t);
@@ -208,7 +253,7 @@ nxt_router_access_log_write_ready(nxt_task_t *task, void *obj, void *data)
     r = obj;
     ctx = data;
 
-    nxt_fd_write(ctx->access_log->fd, ctx->text.start, ctx->text.length);
+    nxt_router_access_log_buffer(task, ctx->access_log, &ctx->text);
 
     nxt_http_request_close_handler(task, r, r->proto.any);
 }
@@ -221,6 +266,216 @@ nxt_router_access_log_write_error(nxt_task_t *task, void *obj, void *data)
 }
 
 
+static void
+nxt_router_access_log_buffer(nxt_task_t *task,
+    nxt_router_access_log_t *access_log, nxt_str_t *text)
+{
+    size_t                          size;
+    nxt_event_engine_t              *engine;
+    nxt_router_access_log_buf_t     *buf;
+    nxt_router_access_log_engine_t  *ale;
+
+    engine = task->thread->engine;
+    ale = engine->access_log;
+
+    if (ale == NULL) {
+        ale = nxt_mp_zget(engine->mem_pool,
+                          sizeof(nxt_router_access_log_engine_t));
+        if (nxt_slow_path(ale == NULL)) {
+            goto write;
+        }
+
+        ale->timer.work_queue = &engine->fast_work_queue;
+        ale->timer.handler = nxt_router_access_log_flush_handler;
+        ale->timer.task = &engine->task;
+        ale->timer.log = engine->task.log;
+
+        engine->access_log = ale;
+    }
+
+    buf = ale->buf;
+
+    if (buf != NULL
+        && (buf->access_log != access_log
+            || (size_t) (buf->end - buf->free) < text->length))
+    {
+        nxt_router_access_log_flush(task);
+        buf = NULL;
+    }
+
+    if (buf == NULL) {
+        size = nxt_max(text->length, NXT_ROUTER_ACCESS_LOG_BUFFER);
+
+        buf = nxt_router_access_log_buf_alloc(access_log, size);
+        if (nxt_slow_path(buf == NULL)) {
+            goto write;
+        }
+
+        ale->buf = buf;
+
+        nxt_timer_add(engine, &ale->timer, NXT_ROUTER_ACCESS_LOG_FLUSH);
+    }
+
+    buf->free = nxt_cpymem(buf->free, text->start, text->length);
+
+    if (engine->shutdown) {
+        nxt_router_access_log_flush(task);
+    }
+
+    return;
+
+write:
+
+    nxt_fd_write(access_log->fd, text->start, text->length);
+}
+
+
+static nxt_router_access_log_buf_t *
+nxt_router_access_log_buf_alloc(nxt_router_access_log_t *access_log,
+    size_t size)
+{
+    nxt_router_access_log_buf_t  *buf;
+
+    buf = nxt_malloc(sizeof(nxt_router_access_log_buf_t) + size);
+    if (nxt_slow_path(buf == NULL)) {
+        return NULL;
+    }
+
+    nxt_router_access_log_use(&nxt_router->lock, access_log);
+
+    buf->access_log = access_log;
+    buf->free = buf->start;
+    buf->end = buf->start + size;
+
+    return buf;
+}
+
+
+static void
+nxt_router_access_log_flush_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_router_access_log_flush(task);
+}
+
+
+void
+nxt_router_access_log_flush(nxt_task_t *task)
+{
+    nxt_bool_t                      writing;
+    nxt_array_t                     *pools;
+    nxt_thread_pool_t               *tp;
+    nxt_event_engine_t              *engine;
+    nxt_router_access_log_t         *access_log;
+    nxt_router_access_log_buf_t     *buf;
+    nxt_router_access_log_engine_t  *ale;
+
+    engine = task->thread->engine;
+    ale = engine->access_log;
+
+    if (ale == NULL || ale->buf == NULL) {
+        return;
+    }
+
+    buf = ale->buf;
+    ale->buf = NULL;
+
+    nxt_timer_disable(engine, &ale->timer);
+
+    nxt_debug(task, "access log flush: %uz",
+              (size_t) (buf->free - buf->start));
+
+    access_log = buf->access_log;
+
+    nxt_thread_spin_lock(&access_log->lock);
+
+    nxt_queue_insert_tail(&access_log->bufs, &buf->link);
+
+    writing = access_log->writing;
+    access_log->writing = 1;
+
+    nxt_thread_spin_unlock(&access_log->lock);
+
+    if (writing) {
+        /* The buffer is written after the ones queued earlier. */
+        return;
+    }
+
+    /* The writer holds its own reference to the access log. */
+    nxt_router_access_log_use(&nxt_router->lock, access_log);
+
+    /*
+     * The thread pool created last belongs to the router process,
+     * the others are inherited from the main process.  The thread pools
+     * are destroyed on the process exit, so the buffers are written
+     * synchronously during shutdown.
+     */
+
+    pools = task->thread->runtime->thread_pools;
+
+    if (!engine->shutdown && !nxt_array_is_empty(pools)) {
+        tp = ((nxt_thread_pool_t **) pools->elts)[pools->nelts - 1];
+
+        nxt_work_set(&access_log->work, nxt_router_access_log_bufs_write,
+                     &tp->task, access_log, NULL);
+
+        if (nxt_fast_path(nxt_thread_pool_post(tp, &access_log->work)
+                          == NXT_OK))
+        {
+            return;
+        }
+    }
+
+    nxt_router_access_log_bufs_write(task, access_log, NULL);
+}
+
+
+/* The handler may be called by a thread pool thread. */
+
+static void
+nxt_router_access_log_bufs_write(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_queue_link_t             *link;
+    nxt_router_access_log_t      *access_log;
+    nxt_router_access_log_buf_t  *buf;
+
+    access_log = obj;
+
+    for ( ;; ) {
+        nxt_thread_spin_lock(&access_log->lock);
+
+        if (nxt_queue_is_empty(&access_log->bufs)) {
+            access_log->writing = 0;
+
+            nxt_thread_spin_unlock(&access_log->lock);
+            break;
+        }
+
+        link = nxt_queue_first(&access_log->bufs);
+        nxt_queue_remove(link);
+
+        nxt_thread_spin_unlock(&access_log->lock);
+
+        buf = nxt_queue_link_data(link, nxt_router_access_log_buf_t, link);
+
+        nxt_router_access_log_buf_write(task, buf);
+    }
+
+    nxt_router_access_log_release(task, &nxt_router->lock, access_log);
+}
+
+
+static void
+nxt_router_access_log_buf_write(nxt_task_t *task,
+    nxt_router_access_log_buf_t *buf)
+{
+    nxt_fd_write(buf->access_log->fd, buf->start, buf->free - buf->start);
+
+    nxt_router_access_log_release(task, &nxt_router->lock, buf->access_log);
+
+    nxt_free(buf);
+}
+
+
 void
 nxt_router_access_log_open(nxt_task_t *task, nxt_router_temp_conf_t *tmcf)
 {
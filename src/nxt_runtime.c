@@ -889,6 +889,22 @@ nxt_runtime_conf_init(nxt_task_t *task, nxt_runtime_t *rt)
 
     rt->conf_tmp = (char *) file_name.start;
 
+    ret = nxt_file_name_create(rt->mem_pool, &file_name, "%s%sconf.bin%Z",
+                               rt->state, slash);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    rt->conf_snapshot = (char *) file_name.start;
+
+    ret = nxt_file_name_create(rt->mem_pool, &file_name, "%s.tmp%Z",
+                               rt->conf_snapshot);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    rt->conf_snapshot_tmp = (char *) file_name.start;
+
     ret = nxt_file_name_create(rt->mem_pool, &file_name, "%s%scerts/%Z",
                                rt->state, slash);
     if (nxt_slow_path(ret != NXT_OK)) {
@@ -971,6 +987,8 @@ nxt_runtime_conf_read_cmd(nxt_task_t *task, nxt_runtime_t *rt)
     static const char  no_state[] =
                        "option \"--statedir\" requires directory\n";
     static const char  no_tmp[] = "option \"--tmpdir\" requires directory\n";
+    static const char  no_engine[] =
+                       "option \"--engine\" requires event engine name\n";
 
     static const char  modules_deprecated[] =
            "option \"--modules\" is deprecated; use \"--modulesdir\" instead\n";
@@ -1012,6 +1030,9 @@ nxt_runtime_conf_read_cmd(nxt_task_t *task, nxt_runtime_t *rt)
         "  --tmpdir DIR         set tmp directory name\n"
         "                       default: \"" NXT_TMPDIR "\"\n"
         "\n"
+        "  --engine NAME        set event engine name\n"
+        "                       default: the first supported one\n"
+        "\n"
         "  --modules DIR        [deprecated] synonym for --modulesdir\n"
         "  --state DIR          [deprecated] synonym for --statedir\n"
         "  --tmp DIR            [deprecated] synonym for --tmpdir\n"
@@ -1198,6 +1219,19 @@ nxt_runtime_conf_read_cmd(nxt_task_t *task, nxt_runtime_t *rt)
             continue;
         }
 
+        if (nxt_strcmp(p, "--engine") == 0) {
+            if (*argv == NULL) {
+                write(STDERR_FILENO, no_engine, nxt_length(no_engine));
+                return NXT_ERROR;
+            }
+
+            p = *argv++;
+
+            rt->engine = p;
+
+            continue;
+        }
+
         if (nxt_strcmp(p, "--no-daemon") == 0) {
             rt->daemon = 0;
             continue;
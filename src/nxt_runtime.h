@@ -70,6 +70,8 @@ struct nxt_runtime_s {
     const char             *ver_tmp;
     const char             *conf;
     const char             *conf_tmp;
+    const char             *conf_snapshot;
+    const char             *conf_snapshot_tmp;
     const char             *tmp;
     const char             *control;
 
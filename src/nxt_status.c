@@ -11,11 +11,15 @@
 nxt_conf_value_t *
 nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
 {
-    size_t            i;
-    nxt_str_t         name;
-    nxt_int_t         ret;
-    nxt_status_app_t  *app;
-    nxt_conf_value_t  *status, *obj, *apps, *app_obj;
+    size_t                 i, j;
+    uint32_t               n;
+    nxt_str_t              name;
+    nxt_int_t              ret;
+    nxt_status_app_t       *app;
+    nxt_conf_value_t       *status, *obj, *apps, *app_obj, *upstreams;
+    nxt_conf_value_t       *servers;
+    nxt_status_server_t    *server;
+    nxt_status_upstream_t  *upstream;
 
     static nxt_str_t conns_str = nxt_string("connections");
     static nxt_str_t acc_str = nxt_string("accepted");
@@ -28,8 +32,16 @@ nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
     static nxt_str_t procs_str = nxt_string("processes");
     static nxt_str_t run_str = nxt_string("running");
     static nxt_str_t start_str = nxt_string("starting");
+    static nxt_str_t upstreams_str = nxt_string("upstreams");
+    static nxt_str_t servers_str = nxt_string("servers");
+    static nxt_str_t state_str = nxt_string("state");
+    static nxt_str_t up_str = nxt_string("up");
+    static nxt_str_t down_str = nxt_string("down");
 
-    status = nxt_conf_create_object(mp, 3);
+    /* Upstreams are reported only if they have health checks. */
+    n = (report->upstreams_count != 0) ? 4 : 3;
+
+    status = nxt_conf_create_object(mp, n);
     if (nxt_slow_path(status == NULL)) {
         return NULL;
     }
@@ -101,5 +113,63 @@ nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
         nxt_conf_set_member_integer(obj, &active_str, app->active_requests, 0);
     }
 
+    if (report->upstreams_count == 0) {
+        return status;
+    }
+
+    upstreams = nxt_conf_create_object(mp, report->upstreams_count);
+    if (nxt_slow_path(upstreams == NULL)) {
+        return NULL;
+    }
+
+    nxt_conf_set_member(status, &upstreams_str, upstreams, 3);
+
+    upstream = nxt_pointer_to(report, (uintptr_t) report->upstreams);
+
+    for (i = 0; i < report->upstreams_count; i++) {
+        obj = nxt_conf_create_object(mp, 1);
+        if (nxt_slow_path(obj == NULL)) {
+            return NULL;
+        }
+
+        name.length = upstream[i].name.length;
+        name.start = nxt_pointer_to(report,
+                                    (uintptr_t) upstream[i].name.start);
+
+        ret = nxt_conf_set_member_dup(upstreams, mp, &name, obj, i);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NULL;
+        }
+
+        servers = nxt_conf_create_object(mp, upstream[i].servers_count);
+        if (nxt_slow_path(servers == NULL)) {
+            return NULL;
+        }
+
+        nxt_conf_set_member(obj, &servers_str, servers, 0);
+
+        server = nxt_pointer_to(report, (uintptr_t) upstream[i].servers);
+
+        for (j = 0; j < upstream[i].servers_count; j++) {
+            obj = nxt_conf_create_object(mp, 1);
+            if (nxt_slow_path(obj == NULL)) {
+                return NULL;
+            }
+
+            name.length = server[j].name.length;
+            name.start = nxt_pointer_to(report,
+                                        (uintptr_t) server[j].name.start);
+
+            ret = nxt_conf_set_member_dup(servers, mp, &name, obj, j);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NULL;
+            }
+
+            nxt_conf_set_member_string(obj, &state_str,
+                                       server[j].down ? &down_str : &up_str,
+                                       0);
+        }
+    }
+
     return status;
 }
@@ -17,13 +17,29 @@ typedef struct {
 
 
 typedef struct {
-    uint64_t          accepted_conns;
-    uint64_t          idle_conns;
-    uint64_t          closed_conns;
-    uint64_t          requests;
+    nxt_str_t         name;
+    uint8_t           down;
+} nxt_status_server_t;
+
+
+typedef struct {
+    nxt_str_t            name;
+    uint32_t             servers_count;
+    nxt_status_server_t  *servers;
+} nxt_status_upstream_t;
+
+
+typedef struct {
+    uint64_t               accepted_conns;
+    uint64_t               idle_conns;
+    uint64_t               closed_conns;
+    uint64_t               requests;
+
+    size_t                 upstreams_count;
+    nxt_status_upstream_t  *upstreams;
 
-    size_t            apps_count;
-    nxt_status_app_t  apps[];
+    size_t                 apps_count;
+    nxt_status_app_t       apps[];
 } nxt_status_report_t;
 
 
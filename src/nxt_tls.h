@@ -62,6 +62,12 @@ struct nxt_tls_bundle_conf_s {
 
 
 struct nxt_tls_conf_s {
+    nxt_mp_t                      *mem_pool;
+    uint32_t                      count;
+
+    /* The listener "tls" object the contexts are built from. */
+    nxt_str_t                     key;
+
     nxt_tls_bundle_conf_t         *bundle;
     nxt_lvlhsh_t                  bundle_hash;
 
@@ -79,6 +85,7 @@ struct nxt_tls_conf_s {
     size_t                        buffer_size;
 
     uint8_t                       no_wait_shutdown;  /* 1 bit */
+    uint8_t                       http2;             /* 1 bit */
 };
 
 
@@ -89,6 +96,8 @@ struct nxt_tls_init_s {
     nxt_conf_value_t              *tickets_conf;
 
     nxt_tls_conf_t                *conf;
+
+    uint8_t                       ktls;  /* 1 bit */
 };
 
 
@@ -9,21 +9,71 @@
 #include <nxt_upstream.h>
 
 
+static nxt_int_t nxt_upstream_keepalive_create(nxt_router_temp_conf_t *tmcf,
+    nxt_conf_value_t *upstream_conf, nxt_upstream_t *upstream);
+static nxt_int_t nxt_upstream_retry_create(nxt_router_temp_conf_t *tmcf,
+    nxt_conf_value_t *upstream_conf, nxt_upstream_t *upstream);
 static nxt_http_action_t *nxt_upstream_handler(nxt_task_t *task,
     nxt_http_request_t *r, nxt_http_action_t *action);
+static nxt_int_t nxt_upstream_hash_test(nxt_lvlhsh_query_t *lhq, void *data);
+
+
+static nxt_conf_map_t  nxt_upstream_keepalive_conf[] = {
+    {
+        nxt_string("connections"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_upstream_keepalive_t, connections),
+    },
+
+    {
+        nxt_string("requests"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_upstream_keepalive_t, requests),
+    },
+
+    {
+        nxt_string("idle_timeout"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_upstream_keepalive_t, idle_timeout),
+    },
+};
+
+
+static nxt_conf_map_t  nxt_upstream_retry_conf[] = {
+    {
+        nxt_string("tries"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_upstream_retry_t, tries),
+    },
+
+    {
+        nxt_string("timeout"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_upstream_retry_t, timeout),
+    },
+};
+
+
+static const nxt_lvlhsh_proto_t  nxt_upstream_hash_proto  nxt_aligned(64) = {
+    NXT_LVLHSH_DEFAULT,
+    nxt_upstream_hash_test,
+    nxt_mp_lvlhsh_alloc,
+    nxt_mp_lvlhsh_free,
+};
 
 
 nxt_int_t
 nxt_upstreams_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     nxt_conf_value_t *conf)
 {
-    size_t            size;
-    uint32_t          i, n, next;
-    nxt_mp_t          *mp;
-    nxt_int_t         ret;
-    nxt_str_t         name, *string;
-    nxt_upstreams_t   *upstreams;
-    nxt_conf_value_t  *upstreams_conf, *upcf;
+    size_t              size;
+    uint32_t            i, n, next;
+    nxt_mp_t            *mp;
+    nxt_int_t           ret;
+    nxt_str_t           name, *string;
+    nxt_upstreams_t     *upstreams;
+    nxt_conf_value_t    *upstreams_conf, *upcf;
+    nxt_lvlhsh_query_t  lhq;
 
     static const nxt_str_t  upstreams_name = nxt_string("upstreams");
 
@@ -58,11 +108,37 @@ nxt_upstreams_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
             return NXT_ERROR;
         }
 
+        /* Routes resolve every "upstreams/..." pass by name. */
+
+        lhq.key_hash = nxt_djb_hash(string->start, string->length);
+        lhq.replace = 0;
+        lhq.key = *string;
+        lhq.value = &upstreams->upstream[i];
+        lhq.proto = &nxt_upstream_hash_proto;
+        lhq.pool = mp;
+
+        if (nxt_slow_path(nxt_lvlhsh_insert(&upstreams->hash, &lhq)
+                          == NXT_ERROR))
+        {
+            return NXT_ERROR;
+        }
+
         ret = nxt_upstream_round_robin_create(task, tmcf, upcf,
                                               &upstreams->upstream[i]);
         if (nxt_slow_path(ret != NXT_OK)) {
             return NXT_ERROR;
         }
+
+        ret = nxt_upstream_keepalive_create(tmcf, upcf,
+                                            &upstreams->upstream[i]);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        ret = nxt_upstream_retry_create(tmcf, upcf, &upstreams->upstream[i]);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
     }
 
     tmcf->router_conf->upstreams = upstreams;
@@ -71,30 +147,123 @@ nxt_upstreams_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 }
 
 
+static nxt_int_t
+nxt_upstream_keepalive_create(nxt_router_temp_conf_t *tmcf,
+    nxt_conf_value_t *upstream_conf, nxt_upstream_t *upstream)
+{
+    nxt_mp_t                  *mp;
+    nxt_int_t                 ret;
+    nxt_conf_value_t          *conf;
+    nxt_upstream_keepalive_t  *keepalive;
+
+    static const nxt_str_t  keepalive_name = nxt_string("keepalive");
+
+    conf = nxt_conf_get_object_member(upstream_conf, &keepalive_name, NULL);
+
+    if (conf == NULL) {
+        return NXT_OK;
+    }
+
+    mp = tmcf->router_conf->mem_pool;
+
+    keepalive = nxt_mp_alloc(mp, sizeof(nxt_upstream_keepalive_t));
+    if (nxt_slow_path(keepalive == NULL)) {
+        return NXT_ERROR;
+    }
+
+    keepalive->connections = 16;
+    keepalive->requests = 1000;
+    keepalive->idle_timeout = 60 * 1000;
+
+    ret = nxt_conf_map_object(mp, conf, nxt_upstream_keepalive_conf,
+                              nxt_nitems(nxt_upstream_keepalive_conf),
+                              keepalive);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    if (keepalive->connections != 0) {
+        upstream->keepalive = keepalive;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_upstream_retry_create(nxt_router_temp_conf_t *tmcf,
+    nxt_conf_value_t *upstream_conf, nxt_upstream_t *upstream)
+{
+    nxt_mp_t              *mp;
+    nxt_int_t             ret;
+    nxt_conf_value_t      *conf;
+    nxt_upstream_retry_t  *retry;
+
+    static const nxt_str_t  retry_name = nxt_string("retry");
+
+    conf = nxt_conf_get_object_member(upstream_conf, &retry_name, NULL);
+
+    if (conf == NULL) {
+        return NXT_OK;
+    }
+
+    mp = tmcf->router_conf->mem_pool;
+
+    retry = nxt_mp_zalloc(mp, sizeof(nxt_upstream_retry_t));
+    if (nxt_slow_path(retry == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ret = nxt_conf_map_object(mp, conf, nxt_upstream_retry_conf,
+                              nxt_nitems(nxt_upstream_retry_conf), retry);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    if (retry->tries != 1) {
+        upstream->retry = retry;
+    }
+
+    return NXT_OK;
+}
+
+
 nxt_int_t
 nxt_upstream_find(nxt_upstreams_t *upstreams, nxt_str_t *name,
     nxt_http_action_t *action)
 {
-    uint32_t        i, n;
-    nxt_upstream_t  *upstream;
+    nxt_upstream_t      *upstream;
+    nxt_lvlhsh_query_t  lhq;
 
     if (upstreams == NULL) {
         return NXT_DECLINED;
     }
 
-    upstream = &upstreams->upstream[0];
-    n = upstreams->items;
-
-    for (i = 0; i < n; i++) {
-        if (nxt_strstr_eq(&upstream[i].name, name)) {
-            action->u.upstream_number = i;
-            action->handler = nxt_upstream_handler;
+    lhq.key_hash = nxt_djb_hash(name->start, name->length);
+    lhq.key = *name;
+    lhq.proto = &nxt_upstream_hash_proto;
 
-            return NXT_OK;
-        }
+    if (nxt_lvlhsh_find(&upstreams->hash, &lhq) != NXT_OK) {
+        return NXT_DECLINED;
     }
 
-    return NXT_DECLINED;
+    upstream = lhq.value;
+
+    action->u.upstream_number = upstream - upstreams->upstream;
+    action->handler = nxt_upstream_handler;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_upstream_hash_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_upstream_t  *upstream;
+
+    upstream = data;
+
+    return nxt_strstr_eq(&lhq->key, &upstream->name) ? NXT_OK : NXT_DECLINED;
 }
 
 
@@ -12,6 +12,10 @@ typedef struct nxt_upstream_proxy_s            nxt_upstream_proxy_t;
 typedef struct nxt_upstream_round_robin_s      nxt_upstream_round_robin_t;
 typedef struct nxt_upstream_round_robin_server_s
     nxt_upstream_round_robin_server_t;
+typedef struct nxt_upstream_keepalive_s        nxt_upstream_keepalive_t;
+typedef struct nxt_upstream_retry_s            nxt_upstream_retry_t;
+typedef struct nxt_upstream_health_check_s     nxt_upstream_health_check_t;
+typedef struct nxt_upstream_health_server_s    nxt_upstream_health_server_t;
 
 
 typedef void (*nxt_upstream_peer_ready_t)(nxt_task_t *task,
@@ -30,14 +34,77 @@ typedef nxt_upstream_t *(*nxt_upstream_joint_create_t)(
     nxt_router_temp_conf_t *tmcf, nxt_upstream_t *upstream);
 typedef void (*nxt_upstream_server_get_t)(nxt_task_t *task,
     nxt_upstream_server_t *us);
+typedef void (*nxt_upstream_server_done_t)(nxt_task_t *task,
+    nxt_upstream_server_t *us, nxt_bool_t failed);
 
 
 typedef struct {
     nxt_upstream_joint_create_t                joint_create;
     nxt_upstream_server_get_t                  get;
+    nxt_upstream_server_done_t                 done;
 } nxt_upstream_server_proto_t;
 
 
+struct nxt_upstream_keepalive_s {
+    uint32_t                                   connections;
+    uint32_t                                   requests;
+    nxt_msec_t                                 idle_timeout;
+};
+
+
+struct nxt_upstream_retry_s {
+    /* Zero values mean no limit. */
+    uint32_t                                   tries;
+    nxt_msec_t                                 timeout;
+};
+
+
+struct nxt_upstream_health_s {
+    nxt_mp_t                                   *mem_pool;
+    nxt_thread_spinlock_t                      *lock;
+
+    nxt_queue_t                                checks;
+
+    uint32_t                                   count;
+    uint8_t                                    stopped;  /* 1 bit */
+};
+
+
+struct nxt_upstream_health_server_s {
+    nxt_sockaddr_t                             *sockaddr;
+    nxt_str_t                                  name;
+    nxt_upstream_health_check_t                *check;
+
+    /* Consecutive probe results since the last state change. */
+    uint32_t                                   fails;
+    uint32_t                                   passes;
+
+    uint8_t                                    probing;  /* 1 bit */
+    uint8_t                                    down;     /* 1 bit */
+};
+
+
+struct nxt_upstream_health_check_s {
+    nxt_queue_link_t                           link;
+    nxt_upstream_health_t                      *health;
+
+    nxt_str_t                                  name;
+    nxt_str_t                                  uri;
+    nxt_str_t                                  request;
+
+    nxt_msec_t                                 interval;
+    nxt_msec_t                                 timeout;
+    uint32_t                                   fails;
+    uint32_t                                   passes;
+
+    nxt_task_t                                 task;
+    nxt_timer_t                                timer;
+
+    uint32_t                                   items;
+    nxt_upstream_health_server_t               server[];
+};
+
+
 struct nxt_upstream_s {
     const nxt_upstream_server_proto_t          *proto;
 
@@ -46,11 +113,15 @@ struct nxt_upstream_s {
         nxt_upstream_round_robin_t             *round_robin;
     } type;
 
+    nxt_upstream_keepalive_t                   *keepalive;
+    nxt_upstream_retry_t                       *retry;
+
     nxt_str_t                                  name;
 };
 
 
 struct nxt_upstreams_s {
+    nxt_lvlhsh_t                               hash;  /* by name */
     uint32_t                                   items;
     nxt_upstream_t                             upstream[];
 };
@@ -61,6 +132,17 @@ struct nxt_upstream_server_s {
     const nxt_upstream_peer_state_t            *state;
     nxt_upstream_t                             *upstream;
 
+    /* An idle keep-alive connection to the server, if any. */
+    nxt_conn_t                                 *connection;
+
+    /* The time of the first try and the number of servers tried. */
+    nxt_msec_t                                 start;
+    uint32_t                                   tries;
+
+    /* A bitmap of the servers tried for the request. */
+    uintptr_t                                  *tried;
+    uintptr_t                                  tried_data;
+
     uint8_t                                    protocol;
 
     union {
@@ -77,5 +159,20 @@ nxt_int_t nxt_upstream_round_robin_create(nxt_task_t *task,
     nxt_router_temp_conf_t *tmcf, nxt_conf_value_t *upstream_conf,
     nxt_upstream_t *upstream);
 
+nxt_upstream_health_check_t *nxt_upstream_health_check_create(
+    nxt_router_temp_conf_t *tmcf, nxt_conf_value_t *health_conf,
+    nxt_str_t *name, uint32_t n);
+nxt_upstream_health_server_t *nxt_upstream_health_server_init(
+    nxt_upstream_health_check_t *check, uint32_t i, nxt_str_t *name);
+void nxt_upstream_health_start(nxt_task_t *task,
+    nxt_upstream_health_t *health);
+void nxt_upstream_health_stop(nxt_task_t *task, nxt_upstream_health_t *health);
+void nxt_upstream_health_release(nxt_task_t *task,
+    nxt_upstream_health_t *health);
+
+nxt_conn_t *nxt_upstream_keepalive_get(nxt_task_t *task, nxt_sockaddr_t *sa);
+nxt_int_t nxt_upstream_keepalive_put(nxt_task_t *task,
+    nxt_upstream_keepalive_t *keepalive, nxt_conn_t *c);
+
 
 #endif /* _NXT_UPSTREAM_H_INCLUDED_ */
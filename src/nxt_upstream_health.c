@@ -0,0 +1,643 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include <nxt_upstream.h>
+
+
+/*
+ * Health checks of a router configuration are run by the router main
+ * thread, while the server states are read by all engines selecting
+ * upstream servers.  The checks are allocated from their own pool that
+ * outlives the configuration until the last timer and probe are done.
+ */
+
+#define NXT_UPSTREAM_HEALTH_BUF_SIZE  256
+
+
+static void nxt_upstream_health_use(nxt_upstream_health_t *health);
+static void nxt_upstream_health_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_health_probe(nxt_task_t *task,
+    nxt_upstream_health_server_t *s);
+static void nxt_upstream_health_connected(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_health_sent(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_health_read(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_health_closed(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_health_response(nxt_task_t *task, nxt_conn_t *c,
+    nxt_bool_t last);
+static void nxt_upstream_health_error(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_health_write_timeout(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_health_read_timeout(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_msec_t nxt_upstream_health_timer_value(nxt_conn_t *c,
+    uintptr_t data);
+static void nxt_upstream_health_done(nxt_task_t *task, nxt_conn_t *c,
+    nxt_bool_t pass);
+static void nxt_upstream_health_free(nxt_task_t *task, void *obj,
+    void *data);
+
+
+static const nxt_conn_state_t  nxt_upstream_health_connect_state;
+static const nxt_conn_state_t  nxt_upstream_health_send_state;
+static const nxt_conn_state_t  nxt_upstream_health_read_state;
+static const nxt_conn_state_t  nxt_upstream_health_close_state;
+
+
+static nxt_conf_map_t  nxt_upstream_health_conf[] = {
+    {
+        nxt_string("interval"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_upstream_health_check_t, interval),
+    },
+
+    {
+        nxt_string("timeout"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_upstream_health_check_t, timeout),
+    },
+
+    {
+        nxt_string("fails"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_upstream_health_check_t, fails),
+    },
+
+    {
+        nxt_string("passes"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_upstream_health_check_t, passes),
+    },
+
+    {
+        nxt_string("uri"),
+        NXT_CONF_MAP_STR_COPY,
+        offsetof(nxt_upstream_health_check_t, uri),
+    },
+};
+
+
+nxt_upstream_health_check_t *
+nxt_upstream_health_check_create(nxt_router_temp_conf_t *tmcf,
+    nxt_conf_value_t *health_conf, nxt_str_t *name, uint32_t n)
+{
+    u_char                       *p;
+    size_t                       size;
+    nxt_mp_t                     *mp;
+    nxt_int_t                    ret;
+    nxt_router_conf_t            *rtcf;
+    nxt_upstream_health_t        *health;
+    nxt_upstream_health_check_t  *check;
+
+    static const char  request_start[] = "GET ";
+    static const char  request_end[] = " HTTP/1.0\r\n"
+                                       "Connection: close\r\n\r\n";
+
+    rtcf = tmcf->router_conf;
+    health = rtcf->health;
+
+    if (health == NULL) {
+        mp = nxt_mp_create(1024, 128, 256, 32);
+        if (nxt_slow_path(mp == NULL)) {
+            return NULL;
+        }
+
+        health = nxt_mp_zget(mp, sizeof(nxt_upstream_health_t));
+        if (nxt_slow_path(health == NULL)) {
+            nxt_mp_destroy(mp);
+            return NULL;
+        }
+
+        health->mem_pool = mp;
+        health->lock = &rtcf->router->lock;
+        health->count = 1;
+        nxt_queue_init(&health->checks);
+
+        rtcf->health = health;
+    }
+
+    mp = health->mem_pool;
+
+    size = sizeof(nxt_upstream_health_check_t)
+           + n * sizeof(nxt_upstream_health_server_t);
+
+    check = nxt_mp_zget(mp, size);
+    if (nxt_slow_path(check == NULL)) {
+        return NULL;
+    }
+
+    check->health = health;
+    check->items = n;
+
+    check->interval = 5 * 1000;
+    check->timeout = 1000;
+    check->fails = 1;
+    check->passes = 1;
+
+    ret = nxt_conf_map_object(mp, health_conf, nxt_upstream_health_conf,
+                              nxt_nitems(nxt_upstream_health_conf), check);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    if (nxt_slow_path(nxt_str_dup(mp, &check->name, name) == NULL)) {
+        return NULL;
+    }
+
+    /* Without "uri" a server passes the check once it accepts connection. */
+
+    if (check->uri.length != 0) {
+        size = nxt_length(request_start) + check->uri.length
+               + nxt_length(request_end);
+
+        p = nxt_mp_nget(mp, size);
+        if (nxt_slow_path(p == NULL)) {
+            return NULL;
+        }
+
+        check->request.start = p;
+        check->request.length = size;
+
+        p = nxt_cpymem(p, request_start, nxt_length(request_start));
+        p = nxt_cpymem(p, check->uri.start, check->uri.length);
+        nxt_memcpy(p, request_end, nxt_length(request_end));
+    }
+
+    nxt_queue_insert_tail(&health->checks, &check->link);
+
+    return check;
+}
+
+
+nxt_upstream_health_server_t *
+nxt_upstream_health_server_init(nxt_upstream_health_check_t *check,
+    uint32_t i, nxt_str_t *name)
+{
+    nxt_mp_t                      *mp;
+    nxt_upstream_health_server_t  *s;
+
+    mp = check->health->mem_pool;
+    s = &check->server[i];
+
+    if (nxt_slow_path(nxt_str_dup(mp, &s->name, name) == NULL)) {
+        return NULL;
+    }
+
+    /* The address is parsed again to be owned by the checks pool. */
+
+    s->sockaddr = nxt_sockaddr_parse(mp, &s->name);
+    if (nxt_slow_path(s->sockaddr == NULL)) {
+        return NULL;
+    }
+
+    s->sockaddr->type = SOCK_STREAM;
+    s->check = check;
+
+    return s;
+}
+
+
+void
+nxt_upstream_health_start(nxt_task_t *task, nxt_upstream_health_t *health)
+{
+    nxt_event_engine_t           *engine;
+    nxt_upstream_health_check_t  *check;
+
+    if (health == NULL) {
+        return;
+    }
+
+    engine = task->thread->engine;
+
+    nxt_queue_each(check, &health->checks, nxt_upstream_health_check_t, link) {
+
+        check->task.thread = task->thread;
+        check->task.log = task->log;
+        check->task.ident = nxt_task_next_ident();
+
+        check->timer.work_queue = &engine->fast_work_queue;
+        check->timer.handler = nxt_upstream_health_handler;
+        check->timer.task = &check->task;
+        check->timer.log = task->log;
+
+        /* The timer holds a reference until it sees the checks stopped. */
+        nxt_upstream_health_use(health);
+
+        nxt_timer_add(engine, &check->timer, 0);
+
+    } nxt_queue_loop;
+}
+
+
+void
+nxt_upstream_health_stop(nxt_task_t *task, nxt_upstream_health_t *health)
+{
+    if (health == NULL) {
+        return;
+    }
+
+    nxt_debug(task, "upstream health stop");
+
+    health->stopped = 1;
+}
+
+
+static void
+nxt_upstream_health_use(nxt_upstream_health_t *health)
+{
+    nxt_thread_spin_lock(health->lock);
+
+    health->count++;
+
+    nxt_thread_spin_unlock(health->lock);
+}
+
+
+void
+nxt_upstream_health_release(nxt_task_t *task, nxt_upstream_health_t *health)
+{
+    nxt_thread_spinlock_t  *lock;
+
+    if (health == NULL) {
+        return;
+    }
+
+    lock = health->lock;
+
+    nxt_thread_spin_lock(lock);
+
+    if (--health->count != 0) {
+        health = NULL;
+    }
+
+    nxt_thread_spin_unlock(lock);
+
+    if (health != NULL) {
+        nxt_debug(task, "upstream health is destroyed");
+
+        nxt_mp_thread_adopt(health->mem_pool);
+
+        nxt_mp_destroy(health->mem_pool);
+    }
+}
+
+
+static void
+nxt_upstream_health_handler(nxt_task_t *task, void *obj, void *data)
+{
+    uint32_t                      i;
+    nxt_timer_t                   *timer;
+    nxt_upstream_health_t         *health;
+    nxt_upstream_health_check_t   *check;
+    nxt_upstream_health_server_t  *s;
+
+    timer = obj;
+
+    check = nxt_timer_data(timer, nxt_upstream_health_check_t, timer);
+    health = check->health;
+
+    nxt_debug(task, "upstream health handler: \"%V\"", &check->name);
+
+    if (health->stopped) {
+        nxt_upstream_health_release(task, health);
+        return;
+    }
+
+    for (i = 0; i < check->items; i++) {
+        s = &check->server[i];
+
+        /* A server is not probed until the previous probe is done. */
+
+        if (!s->probing) {
+            nxt_upstream_health_probe(task, s);
+        }
+    }
+
+    nxt_timer_add(task->thread->engine, timer, check->interval);
+}
+
+
+static void
+nxt_upstream_health_probe(nxt_task_t *task, nxt_upstream_health_server_t *s)
+{
+    nxt_mp_t            *mp;
+    nxt_conn_t          *c;
+    nxt_event_engine_t  *engine;
+
+    nxt_debug(task, "upstream health probe: \"%V\"", &s->name);
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return;
+    }
+
+    c = nxt_conn_create(mp, task);
+    if (nxt_slow_path(c == NULL)) {
+        nxt_mp_destroy(mp);
+        return;
+    }
+
+    engine = task->thread->engine;
+
+    c->remote = s->sockaddr;
+    c->socket.data = s;
+    c->socket.write_ready = 1;
+
+    c->read_work_queue = &engine->fast_work_queue;
+    c->write_work_queue = &engine->fast_work_queue;
+
+    c->write_state = &nxt_upstream_health_connect_state;
+
+    s->probing = 1;
+    nxt_upstream_health_use(s->check->health);
+
+    nxt_conn_connect(engine, c);
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_health_connect_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_health_connected,
+    .close_handler = nxt_upstream_health_error,
+    .error_handler = nxt_upstream_health_error,
+
+    .timer_handler = nxt_upstream_health_write_timeout,
+    .timer_value = nxt_upstream_health_timer_value,
+};
+
+
+static void
+nxt_upstream_health_connected(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t                     *b;
+    nxt_conn_t                    *c;
+    nxt_upstream_health_check_t   *check;
+    nxt_upstream_health_server_t  *s;
+
+    c = obj;
+    s = data;
+
+    check = s->check;
+
+    nxt_debug(task, "upstream health connected fd:%d", c->socket.fd);
+
+    if (check->request.length == 0) {
+        nxt_upstream_health_done(task, c, 1);
+        return;
+    }
+
+    b = nxt_buf_mem_alloc(c->mem_pool, check->request.length, 0);
+    if (nxt_slow_path(b == NULL)) {
+        nxt_upstream_health_done(task, c, 0);
+        return;
+    }
+
+    b->mem.free = nxt_cpymem(b->mem.free, check->request.start,
+                             check->request.length);
+
+    c->write = b;
+    c->write_state = &nxt_upstream_health_send_state;
+
+    nxt_conn_write(task->thread->engine, c);
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_health_send_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_health_sent,
+    .close_handler = nxt_upstream_health_error,
+    .error_handler = nxt_upstream_health_error,
+
+    .timer_handler = nxt_upstream_health_write_timeout,
+    .timer_value = nxt_upstream_health_timer_value,
+};
+
+
+static void
+nxt_upstream_health_sent(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t   *b;
+    nxt_conn_t  *c;
+
+    c = obj;
+
+    nxt_debug(task, "upstream health sent fd:%d", c->socket.fd);
+
+    b = nxt_buf_mem_alloc(c->mem_pool, NXT_UPSTREAM_HEALTH_BUF_SIZE, 0);
+    if (nxt_slow_path(b == NULL)) {
+        nxt_upstream_health_done(task, c, 0);
+        return;
+    }
+
+    c->read = b;
+    c->read_state = &nxt_upstream_health_read_state;
+
+    nxt_conn_read(task->thread->engine, c);
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_health_read_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_health_read,
+    .close_handler = nxt_upstream_health_closed,
+    .error_handler = nxt_upstream_health_error,
+
+    .timer_handler = nxt_upstream_health_read_timeout,
+    .timer_value = nxt_upstream_health_timer_value,
+    .timer_autoreset = 1,
+};
+
+
+static void
+nxt_upstream_health_read(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_upstream_health_response(task, obj, 0);
+}
+
+
+static void
+nxt_upstream_health_closed(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_upstream_health_response(task, obj, 1);
+}
+
+
+static void
+nxt_upstream_health_response(nxt_task_t *task, nxt_conn_t *c,
+    nxt_bool_t last)
+{
+    u_char     *p;
+    size_t     size;
+    nxt_int_t  status;
+    nxt_buf_t  *b;
+
+    b = c->read;
+    p = b->mem.pos;
+    size = nxt_buf_mem_used_size(&b->mem);
+
+    /* Only the status code of "HTTP/1.x NNN" line is checked. */
+
+    if (size < nxt_length("HTTP/1.x NNN")) {
+
+        if (!last && b->mem.free != b->mem.end) {
+            nxt_conn_read(task->thread->engine, c);
+            return;
+        }
+
+        nxt_upstream_health_done(task, c, 0);
+        return;
+    }
+
+    if (nxt_slow_path(memcmp(p, "HTTP/1.", 7) != 0 || p[8] != ' ')) {
+        nxt_upstream_health_done(task, c, 0);
+        return;
+    }
+
+    status = nxt_int_parse(&p[9], 3);
+
+    nxt_debug(task, "upstream health status: %i", status);
+
+    nxt_upstream_health_done(task, c, status >= 200 && status < 400);
+}
+
+
+static void
+nxt_upstream_health_error(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_upstream_health_done(task, obj, 0);
+}
+
+
+static void
+nxt_upstream_health_write_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    nxt_debug(task, "upstream health write timeout");
+
+    c = nxt_write_timer_conn(timer);
+    c->block_write = 1;
+    c->socket.timedout = 1;
+
+    nxt_upstream_health_done(task, c, 0);
+}
+
+
+static void
+nxt_upstream_health_read_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    nxt_debug(task, "upstream health read timeout");
+
+    c = nxt_read_timer_conn(timer);
+    c->block_read = 1;
+    c->socket.timedout = 1;
+
+    nxt_upstream_health_done(task, c, 0);
+}
+
+
+static nxt_msec_t
+nxt_upstream_health_timer_value(nxt_conn_t *c, uintptr_t data)
+{
+    nxt_upstream_health_server_t  *s;
+
+    s = c->socket.data;
+
+    return s->check->timeout;
+}
+
+
+static void
+nxt_upstream_health_done(nxt_task_t *task, nxt_conn_t *c, nxt_bool_t pass)
+{
+    nxt_upstream_health_check_t   *check;
+    nxt_upstream_health_server_t  *s;
+
+    s = c->socket.data;
+    check = s->check;
+
+    nxt_debug(task, "upstream health \"%V\" server \"%V\" %s",
+              &check->name, &s->name, pass ? "passed" : "failed");
+
+    if (check->health->stopped) {
+        goto close;
+    }
+
+    if (pass) {
+        s->fails = 0;
+
+        if (s->down && ++s->passes >= check->passes) {
+            s->down = 0;
+            s->passes = 0;
+
+            nxt_log(task, NXT_LOG_NOTICE, "upstream \"%V\" server \"%V\" "
+                    "is up", &check->name, &s->name);
+        }
+
+    } else {
+        s->passes = 0;
+
+        if (!s->down && ++s->fails >= check->fails) {
+            s->down = 1;
+            s->fails = 0;
+
+            nxt_log(task, NXT_LOG_WARN, "upstream \"%V\" server \"%V\" "
+                    "is down", &check->name, &s->name);
+        }
+    }
+
+close:
+
+    c->read_state = &nxt_upstream_health_close_state;
+    c->write_state = &nxt_upstream_health_close_state;
+
+    nxt_conn_close(task->thread->engine, c);
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_health_close_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_health_free,
+};
+
+
+static void
+nxt_upstream_health_free(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t                    *c;
+    nxt_upstream_health_t         *health;
+    nxt_upstream_health_server_t  *s;
+
+    c = obj;
+    s = data;
+
+    nxt_debug(task, "upstream health free");
+
+    health = s->check->health;
+    s->probing = 0;
+
+    nxt_conn_free(task, c);
+
+    nxt_upstream_health_release(task, health);
+}
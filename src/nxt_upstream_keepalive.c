@@ -0,0 +1,295 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include <nxt_upstream.h>
+
+
+/*
+ * Idle upstream connections are kept per engine in pools keyed
+ * by the server socket address.  A pool outlives router configurations,
+ * so it owns a copy of the address and the current idle timeout.
+ */
+
+typedef struct {
+    nxt_sockaddr_t                 *sockaddr;
+    nxt_queue_t                    connections;
+    uint32_t                       count;
+    nxt_msec_t                     idle_timeout;
+} nxt_upstream_keepalive_pool_t;
+
+
+static nxt_int_t nxt_upstream_keepalive_hash_test(nxt_lvlhsh_query_t *lhq,
+    void *data);
+static nxt_upstream_keepalive_pool_t *nxt_upstream_keepalive_pool(
+    nxt_event_engine_t *engine, nxt_sockaddr_t *sa, nxt_bool_t create);
+static void nxt_upstream_keepalive_close(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_keepalive_timeout(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_msec_t nxt_upstream_keepalive_timer_value(nxt_conn_t *c,
+    uintptr_t data);
+static void nxt_upstream_keepalive_free(nxt_task_t *task, void *obj,
+    void *data);
+
+
+static const nxt_conn_state_t  nxt_upstream_keepalive_idle_state;
+static const nxt_conn_state_t  nxt_upstream_keepalive_close_state;
+
+
+static const nxt_lvlhsh_proto_t  nxt_upstream_keepalive_hash_proto
+    nxt_aligned(64) =
+{
+    NXT_LVLHSH_DEFAULT,
+    nxt_upstream_keepalive_hash_test,
+    nxt_lvlhsh_alloc,
+    nxt_lvlhsh_free,
+};
+
+
+static nxt_int_t
+nxt_upstream_keepalive_hash_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_sockaddr_t                 *sa;
+    nxt_upstream_keepalive_pool_t  *pool;
+
+    pool = data;
+    sa = pool->sockaddr;
+
+    if (lhq->key.length == sa->socklen
+        && memcmp(lhq->key.start, &sa->u.sockaddr, sa->socklen) == 0)
+    {
+        return NXT_OK;
+    }
+
+    return NXT_DECLINED;
+}
+
+
+nxt_conn_t *
+nxt_upstream_keepalive_get(nxt_task_t *task, nxt_sockaddr_t *sa)
+{
+    nxt_conn_t                     *c;
+    nxt_event_engine_t             *engine;
+    nxt_upstream_keepalive_pool_t  *pool;
+
+    engine = task->thread->engine;
+
+    pool = nxt_upstream_keepalive_pool(engine, sa, 0);
+
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    nxt_queue_each(c, &pool->connections, nxt_conn_t, link) {
+
+        /* The pending read event will close the connection. */
+        if (c->socket.read_ready) {
+            continue;
+        }
+
+        nxt_queue_remove(&c->link);
+        pool->count--;
+
+        nxt_timer_disable(engine, &c->read_timer);
+        nxt_fd_event_block_read(engine, &c->socket);
+
+        /* Disarms idle handlers which may be already queued. */
+        c->read_state = NULL;
+
+        nxt_debug(task, "upstream keepalive get fd:%d requests:%uD",
+                  c->socket.fd, c->requests);
+
+        return c;
+
+    } nxt_queue_loop;
+
+    return NULL;
+}
+
+
+nxt_int_t
+nxt_upstream_keepalive_put(nxt_task_t *task,
+    nxt_upstream_keepalive_t *keepalive, nxt_conn_t *c)
+{
+    nxt_event_engine_t             *engine;
+    nxt_upstream_keepalive_pool_t  *pool;
+
+    engine = task->thread->engine;
+
+    if (c->requests >= keepalive->requests || engine->shutdown) {
+        return NXT_DECLINED;
+    }
+
+    pool = nxt_upstream_keepalive_pool(engine, c->remote, 1);
+
+    if (pool == NULL || pool->count >= keepalive->connections) {
+        return NXT_DECLINED;
+    }
+
+    nxt_debug(task, "upstream keepalive put fd:%d requests:%uD",
+              c->socket.fd, c->requests);
+
+    nxt_queue_insert_head(&pool->connections, &c->link);
+    pool->count++;
+    pool->idle_timeout = keepalive->idle_timeout;
+
+    /* The configuration the connection was created for may go away. */
+    c->remote = pool->sockaddr;
+
+    c->socket.data = pool;
+    c->read_state = &nxt_upstream_keepalive_idle_state;
+
+    c->read_work_queue = &engine->read_work_queue;
+    c->socket.read_work_queue = &engine->read_work_queue;
+    c->read_timer.work_queue = &engine->read_work_queue;
+    c->write_work_queue = &engine->write_work_queue;
+    c->socket.write_work_queue = &engine->write_work_queue;
+    c->write_timer.work_queue = &engine->write_work_queue;
+
+    nxt_conn_wait(c);
+
+    return NXT_OK;
+}
+
+
+static nxt_upstream_keepalive_pool_t *
+nxt_upstream_keepalive_pool(nxt_event_engine_t *engine, nxt_sockaddr_t *sa,
+    nxt_bool_t create)
+{
+    nxt_int_t                      ret;
+    nxt_lvlhsh_query_t             lhq;
+    nxt_upstream_keepalive_pool_t  *pool;
+
+    lhq.key.length = sa->socklen;
+    lhq.key.start = (u_char *) &sa->u.sockaddr;
+    lhq.key_hash = nxt_djb_hash(lhq.key.start, lhq.key.length);
+    lhq.proto = &nxt_upstream_keepalive_hash_proto;
+
+    ret = nxt_lvlhsh_find(&engine->upstream_connections, &lhq);
+
+    if (ret == NXT_OK) {
+        return lhq.value;
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    pool = nxt_mp_zalloc(engine->mem_pool,
+                         sizeof(nxt_upstream_keepalive_pool_t));
+    if (nxt_slow_path(pool == NULL)) {
+        return NULL;
+    }
+
+    pool->sockaddr = nxt_sockaddr_copy(engine->mem_pool, sa);
+    if (nxt_slow_path(pool->sockaddr == NULL)) {
+        return NULL;
+    }
+
+    nxt_queue_init(&pool->connections);
+
+    lhq.replace = 0;
+    lhq.value = pool;
+    lhq.pool = engine->mem_pool;
+
+    ret = nxt_lvlhsh_insert(&engine->upstream_connections, &lhq);
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
+    return pool;
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_keepalive_idle_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_keepalive_close,
+    .close_handler = nxt_upstream_keepalive_close,
+    .error_handler = nxt_upstream_keepalive_close,
+
+    .timer_handler = nxt_upstream_keepalive_timeout,
+    .timer_value = nxt_upstream_keepalive_timer_value,
+};
+
+
+static void
+nxt_upstream_keepalive_close(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t                     *c;
+    nxt_upstream_keepalive_pool_t  *pool;
+
+    c = obj;
+    pool = data;
+
+    /*
+     * An idle connection is closed on any event: either the server
+     * has closed it, or has sent unexpected data, or an error occured.
+     */
+
+    if (c->read_state != &nxt_upstream_keepalive_idle_state) {
+        return;
+    }
+
+    nxt_debug(task, "upstream keepalive close fd:%d", c->socket.fd);
+
+    nxt_queue_remove(&c->link);
+    pool->count--;
+
+    c->read_state = &nxt_upstream_keepalive_close_state;
+    c->write_state = &nxt_upstream_keepalive_close_state;
+
+    nxt_conn_close(task->thread->engine, c);
+}
+
+
+static void
+nxt_upstream_keepalive_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    nxt_debug(task, "upstream keepalive timeout");
+
+    c = nxt_read_timer_conn(timer);
+
+    nxt_upstream_keepalive_close(task, c, c->socket.data);
+}
+
+
+static nxt_msec_t
+nxt_upstream_keepalive_timer_value(nxt_conn_t *c, uintptr_t data)
+{
+    nxt_upstream_keepalive_pool_t  *pool;
+
+    pool = c->socket.data;
+
+    return pool->idle_timeout;
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_keepalive_close_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_keepalive_free,
+};
+
+
+static void
+nxt_upstream_keepalive_free(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t  *c;
+
+    c = obj;
+
+    nxt_debug(task, "upstream keepalive free");
+
+    nxt_conn_free(task, c);
+}
@@ -12,30 +12,134 @@
 
 struct nxt_upstream_round_robin_server_s {
     nxt_sockaddr_t                     *sockaddr;
+    nxt_upstream_health_server_t       *health;
 
     int32_t                            current_weight;
     int32_t                            effective_weight;
     int32_t                            weight;
 
+    /*
+     * Passive failure accounting: after "max_fails" failed attempts
+     * the server is skipped for "fail_timeout" since the last failure
+     * or the last trial.  The state is kept per engine.
+     */
+    uint32_t                           max_fails;
+    uint32_t                           fails;
+    nxt_msec_t                         fail_timeout;
+    nxt_msec_t                         checked;
+
+    /* Requests in progress in the engine. */
+    uint32_t                           active;
+
     uint8_t                            protocol;
 };
 
 
+typedef struct {
+    uint32_t                           hash;
+    uint32_t                           server;
+} nxt_upstream_hash_point_t;
+
+
+/* A consistent hashing ring shared by all engines. */
+
+typedef struct {
+    nxt_tstr_t                         *key;
+    uint32_t                           points;
+    nxt_upstream_hash_point_t          point[];
+} nxt_upstream_hash_t;
+
+
 struct nxt_upstream_round_robin_s {
     uint32_t                           items;
+    nxt_upstream_hash_t                *hash;
     nxt_upstream_round_robin_server_t  server[];
 };
 
 
+/* The average number of ring points per server. */
+#define NXT_UPSTREAM_HASH_POINTS  160
+
+
 static nxt_upstream_t *nxt_upstream_round_robin_joint_create(
     nxt_router_temp_conf_t *tmcf, nxt_upstream_t *upstream);
 static void nxt_upstream_round_robin_server_get(nxt_task_t *task,
     nxt_upstream_server_t *us);
+static void nxt_upstream_least_requests_server_get(nxt_task_t *task,
+    nxt_upstream_server_t *us);
+static void nxt_upstream_two_choices_server_get(nxt_task_t *task,
+    nxt_upstream_server_t *us);
+static nxt_int_t nxt_upstream_hash_create(nxt_router_temp_conf_t *tmcf,
+    nxt_conf_value_t *servers_conf, nxt_conf_value_t *key_conf,
+    double total, nxt_upstream_round_robin_t *urr);
+static int nxt_upstream_hash_point_cmp(const void *one, const void *two);
+static void nxt_upstream_hash_server_get(nxt_task_t *task,
+    nxt_upstream_server_t *us);
+static nxt_int_t nxt_upstream_round_robin_tried_init(nxt_upstream_server_t *us,
+    uint32_t n);
+static nxt_bool_t nxt_upstream_round_robin_server_usable(
+    nxt_upstream_server_t *us, nxt_upstream_round_robin_server_t *s,
+    uint32_t i, nxt_msec_t now);
+static void nxt_upstream_round_robin_server_recover(
+    nxt_upstream_round_robin_server_t *s);
+static void nxt_upstream_round_robin_server_use(nxt_task_t *task,
+    nxt_upstream_server_t *us, nxt_upstream_round_robin_server_t *best,
+    nxt_msec_t now);
+static void nxt_upstream_round_robin_server_done(nxt_task_t *task,
+    nxt_upstream_server_t *us, nxt_bool_t failed);
+
+
+#define NXT_UPSTREAM_TRIED_BITS  (8 * sizeof(uintptr_t))
+
+#define nxt_upstream_tried(tried, i)                                          \
+    ((tried)[(i) / NXT_UPSTREAM_TRIED_BITS]                                   \
+     & ((uintptr_t) 1 << ((i) % NXT_UPSTREAM_TRIED_BITS)))
+
+#define nxt_upstream_tried_set(tried, i)                                      \
+    (tried)[(i) / NXT_UPSTREAM_TRIED_BITS]                                    \
+        |= ((uintptr_t) 1 << ((i) % NXT_UPSTREAM_TRIED_BITS))
+
+
+/*
+ * The "least_requests" and "two_choices" balancers share the server
+ * table with the weighted round robin one and compare the numbers
+ * of requests in progress relative to server weights.
+ */
+
+#define nxt_upstream_load_lt(s1, s2)                                          \
+    ((int64_t) (s1)->active * (s2)->weight                                    \
+     < (int64_t) (s2)->active * (s1)->weight)
+
+#define nxt_upstream_load_eq(s1, s2)                                          \
+    ((int64_t) (s1)->active * (s2)->weight                                    \
+     == (int64_t) (s2)->active * (s1)->weight)
 
 
 static const nxt_upstream_server_proto_t  nxt_upstream_round_robin_proto = {
     .joint_create = nxt_upstream_round_robin_joint_create,
     .get          = nxt_upstream_round_robin_server_get,
+    .done         = nxt_upstream_round_robin_server_done,
+};
+
+
+static const nxt_upstream_server_proto_t  nxt_upstream_least_requests_proto = {
+    .joint_create = nxt_upstream_round_robin_joint_create,
+    .get          = nxt_upstream_least_requests_server_get,
+    .done         = nxt_upstream_round_robin_server_done,
+};
+
+
+static const nxt_upstream_server_proto_t  nxt_upstream_two_choices_proto = {
+    .joint_create = nxt_upstream_round_robin_joint_create,
+    .get          = nxt_upstream_two_choices_server_get,
+    .done         = nxt_upstream_round_robin_server_done,
+};
+
+
+static const nxt_upstream_server_proto_t  nxt_upstream_hash_proto = {
+    .joint_create = nxt_upstream_round_robin_joint_create,
+    .get          = nxt_upstream_hash_server_get,
+    .done         = nxt_upstream_round_robin_server_done,
 };
 
 
@@ -43,17 +147,24 @@ nxt_int_t
 nxt_upstream_round_robin_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     nxt_conf_value_t *upstream_conf, nxt_upstream_t *upstream)
 {
-    double                      total, k, w;
-    size_t                      size;
-    uint32_t                    i, n, next, wt;
-    nxt_mp_t                    *mp;
-    nxt_str_t                   name;
-    nxt_sockaddr_t              *sa;
-    nxt_conf_value_t            *servers_conf, *srvcf, *wtcf;
-    nxt_upstream_round_robin_t  *urr;
+    double                       total, k, w;
+    size_t                       size;
+    uint32_t                     i, n, next, wt;
+    nxt_mp_t                     *mp;
+    nxt_str_t                    name;
+    nxt_sockaddr_t               *sa;
+    nxt_str_t                    str;
+    nxt_conf_value_t             *servers_conf, *srvcf, *wtcf, *hlcf, *value;
+    nxt_upstream_round_robin_t   *urr;
+    nxt_upstream_health_check_t  *check;
 
     static const nxt_str_t  servers = nxt_string("servers");
     static const nxt_str_t  weight = nxt_string("weight");
+    static const nxt_str_t  health = nxt_string("health");
+    static const nxt_str_t  max_fails = nxt_string("max_fails");
+    static const nxt_str_t  fail_timeout = nxt_string("fail_timeout");
+    static const nxt_str_t  balancer = nxt_string("balancer");
+    static const nxt_str_t  hash = nxt_string("hash");
 
     mp = tmcf->router_conf->mem_pool;
 
@@ -91,6 +202,17 @@ nxt_upstream_round_robin_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     urr->items = n;
     next = 0;
 
+    check = NULL;
+    hlcf = nxt_conf_get_object_member(upstream_conf, &health, NULL);
+
+    if (hlcf != NULL) {
+        check = nxt_upstream_health_check_create(tmcf, hlcf, &upstream->name,
+                                                 n);
+        if (nxt_slow_path(check == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
     for (i = 0; i < n; i++) {
         srvcf = nxt_conf_next_object_member(servers_conf, &name, &next);
 
@@ -110,11 +232,54 @@ nxt_upstream_round_robin_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 
         urr->server[i].weight = wt;
         urr->server[i].effective_weight = wt;
+
+        value = nxt_conf_get_object_member(srvcf, &max_fails, NULL);
+        urr->server[i].max_fails = (value != NULL)
+                                   ? nxt_conf_get_number(value) : 0;
+
+        value = nxt_conf_get_object_member(srvcf, &fail_timeout, NULL);
+        urr->server[i].fail_timeout = (value != NULL)
+                                      ? nxt_conf_get_number(value) * 1000
+                                      : 10 * 1000;
+
+        if (check != NULL) {
+            urr->server[i].health = nxt_upstream_health_server_init(check, i,
+                                                                    &name);
+            if (nxt_slow_path(urr->server[i].health == NULL)) {
+                return NXT_ERROR;
+            }
+        }
     }
 
     upstream->proto = &nxt_upstream_round_robin_proto;
     upstream->type.round_robin = urr;
 
+    value = nxt_conf_get_object_member(upstream_conf, &balancer, NULL);
+
+    if (value != NULL) {
+        nxt_conf_get_string(value, &str);
+
+        if (nxt_str_eq(&str, "least_requests", 14)) {
+            upstream->proto = &nxt_upstream_least_requests_proto;
+
+        } else if (nxt_str_eq(&str, "two_choices", 11)) {
+            upstream->proto = &nxt_upstream_two_choices_proto;
+        }
+    }
+
+    value = nxt_conf_get_object_member(upstream_conf, &hash, NULL);
+
+    if (value != NULL) {
+        if (nxt_slow_path(nxt_upstream_hash_create(tmcf, servers_conf, value,
+                                                   total, urr)
+                          != NXT_OK))
+        {
+            return NXT_ERROR;
+        }
+
+        upstream->proto = &nxt_upstream_hash_proto;
+    }
+
     return NXT_OK;
 }
 
@@ -152,6 +317,7 @@ nxt_upstream_round_robin_joint_create(nxt_router_temp_conf_t *tmcf,
 
     n = urrcf->items;
     urr->items = n;
+    urr->hash = urrcf->hash;
 
     for (i = 0; i < n; i++) {
         urr->server[i] = urrcf->server[i];
@@ -166,6 +332,7 @@ nxt_upstream_round_robin_server_get(nxt_task_t *task, nxt_upstream_server_t *us)
 {
     int32_t                            total;
     uint32_t                           i, n;
+    nxt_msec_t                         now;
     nxt_upstream_round_robin_t         *round_robin;
     nxt_upstream_round_robin_server_t  *s, *best;
 
@@ -177,15 +344,29 @@ nxt_upstream_round_robin_server_get(nxt_task_t *task, nxt_upstream_server_t *us)
     s = round_robin->server;
     n = round_robin->items;
 
+    now = task->thread->engine->timers.now;
+
+    if (nxt_slow_path(nxt_upstream_round_robin_tried_init(us, n) != NXT_OK)) {
+        us->state->error(task, us);
+        return;
+    }
+
     for (i = 0; i < n; i++) {
 
+        if (!nxt_upstream_round_robin_server_usable(us, &s[i], i, now)) {
+            continue;
+        }
+
+        /*
+         * The weight is recovered first, otherwise a server that is
+         * tried again after "fail_timeout" adds nothing to the total.
+         */
+
+        nxt_upstream_round_robin_server_recover(&s[i]);
+
         s[i].current_weight += s[i].effective_weight;
         total += s[i].effective_weight;
 
-        if (s[i].effective_weight < s[i].weight) {
-            s[i].effective_weight++;
-        }
-
         if (best == NULL || s[i].current_weight > best->current_weight) {
             best = &s[i];
         }
@@ -197,9 +378,498 @@ nxt_upstream_round_robin_server_get(nxt_task_t *task, nxt_upstream_server_t *us)
     }
 
     best->current_weight -= total;
+
+    nxt_upstream_round_robin_server_use(task, us, best, now);
+}
+
+
+static void
+nxt_upstream_least_requests_server_get(nxt_task_t *task,
+    nxt_upstream_server_t *us)
+{
+    int32_t                            total;
+    uint32_t                           i, n, first;
+    nxt_bool_t                         many;
+    nxt_msec_t                         now;
+    nxt_upstream_round_robin_t         *round_robin;
+    nxt_upstream_round_robin_server_t  *s, *best;
+
+    best = NULL;
+    many = 0;
+    first = 0;
+
+    round_robin = us->upstream->type.round_robin;
+
+    s = round_robin->server;
+    n = round_robin->items;
+
+    now = task->thread->engine->timers.now;
+
+    if (nxt_slow_path(nxt_upstream_round_robin_tried_init(us, n) != NXT_OK)) {
+        us->state->error(task, us);
+        return;
+    }
+
+    for (i = 0; i < n; i++) {
+
+        if (s[i].weight == 0
+            || !nxt_upstream_round_robin_server_usable(us, &s[i], i, now))
+        {
+            continue;
+        }
+
+        if (best == NULL || nxt_upstream_load_lt(&s[i], best)) {
+            best = &s[i];
+            first = i;
+            many = 0;
+
+        } else if (nxt_upstream_load_eq(&s[i], best)) {
+            many = 1;
+        }
+    }
+
+    if (best == NULL) {
+        us->state->error(task, us);
+        return;
+    }
+
+    if (many) {
+        /* Equally loaded servers are balanced with weighted round robin. */
+
+        total = 0;
+        best = NULL;
+
+        for (i = first; i < n; i++) {
+
+            if (s[i].weight == 0
+                || !nxt_upstream_load_eq(&s[i], &s[first])
+                || !nxt_upstream_round_robin_server_usable(us, &s[i], i, now))
+            {
+                continue;
+            }
+
+            nxt_upstream_round_robin_server_recover(&s[i]);
+
+            s[i].current_weight += s[i].effective_weight;
+            total += s[i].effective_weight;
+
+            if (best == NULL || s[i].current_weight > best->current_weight) {
+                best = &s[i];
+            }
+        }
+
+        best->current_weight -= total;
+    }
+
+    nxt_upstream_round_robin_server_use(task, us, best, now);
+}
+
+
+static void
+nxt_upstream_two_choices_server_get(nxt_task_t *task, nxt_upstream_server_t *us)
+{
+    int32_t                            total, r;
+    uint32_t                           i, n, k;
+    nxt_msec_t                         now;
+    nxt_upstream_round_robin_t         *round_robin;
+    nxt_upstream_round_robin_server_t  *s, *choice[2];
+
+    round_robin = us->upstream->type.round_robin;
+
+    s = round_robin->server;
+    n = round_robin->items;
+
+    now = task->thread->engine->timers.now;
+
+    if (nxt_slow_path(nxt_upstream_round_robin_tried_init(us, n) != NXT_OK)) {
+        us->state->error(task, us);
+        return;
+    }
+
+    /*
+     * Two distinct servers are picked at random in proportion
+     * to their weights, and the less loaded one is used.  The weights
+     * are normalized on creation, so their sum fits in int32_t.
+     * The usable servers are recovered first, as in round robin.
+     */
+
+    for (i = 0; i < n; i++) {
+        if (nxt_upstream_round_robin_server_usable(us, &s[i], i, now)) {
+            nxt_upstream_round_robin_server_recover(&s[i]);
+        }
+    }
+
+    choice[0] = NULL;
+    choice[1] = NULL;
+
+    for (k = 0; k < 2; k++) {
+        total = 0;
+
+        for (i = 0; i < n; i++) {
+            if (&s[i] != choice[0]
+                && nxt_upstream_round_robin_server_usable(us, &s[i], i, now))
+            {
+                total += s[i].effective_weight;
+            }
+        }
+
+        if (total == 0) {
+            break;
+        }
+
+        r = nxt_random(&task->thread->random) % (uint32_t) total;
+
+        for (i = 0; i < n; i++) {
+            if (&s[i] == choice[0]
+                || !nxt_upstream_round_robin_server_usable(us, &s[i], i, now))
+            {
+                continue;
+            }
+
+            r -= s[i].effective_weight;
+
+            if (r < 0) {
+                choice[k] = &s[i];
+                break;
+            }
+        }
+    }
+
+    if (choice[0] == NULL) {
+        us->state->error(task, us);
+        return;
+    }
+
+    if (choice[1] != NULL && nxt_upstream_load_lt(choice[1], choice[0])) {
+        choice[0] = choice[1];
+    }
+
+    nxt_upstream_round_robin_server_use(task, us, choice[0], now);
+}
+
+
+static nxt_int_t
+nxt_upstream_hash_create(nxt_router_temp_conf_t *tmcf,
+    nxt_conf_value_t *servers_conf, nxt_conf_value_t *key_conf, double total,
+    nxt_upstream_round_robin_t *urr)
+{
+    double               w;
+    uint32_t             i, j, n, next, points, *npoints, data[2];
+    nxt_mp_t             *mp;
+    nxt_str_t            name, str;
+    nxt_conf_value_t     *srvcf, *wtcf;
+    nxt_router_conf_t    *rtcf;
+    nxt_upstream_hash_t  *hash;
+
+    static const nxt_str_t  weight = nxt_string("weight");
+
+    rtcf = tmcf->router_conf;
+    mp = rtcf->mem_pool;
+
+    n = urr->items;
+
+    npoints = nxt_mp_alloc(tmcf->mem_pool, nxt_max(n, 1) * sizeof(uint32_t));
+    if (nxt_slow_path(npoints == NULL)) {
+        return NXT_ERROR;
+    }
+
+    /*
+     * Each server gets the number of points proportional to its weight,
+     * and at least one unless the weight is zero.
+     */
+
+    points = 0;
+    next = 0;
+
+    for (i = 0; i < n; i++) {
+        srvcf = nxt_conf_next_object_member(servers_conf, &name, &next);
+        wtcf = nxt_conf_get_object_member(srvcf, &weight, NULL);
+        w = (wtcf != NULL) ? nxt_conf_get_number(wtcf) : 1;
+
+        if (w == 0) {
+            npoints[i] = 0;
+            continue;
+        }
+
+        w = round(NXT_UPSTREAM_HASH_POINTS * n * w / total);
+        npoints[i] = nxt_max(w, 1);
+
+        points += npoints[i];
+    }
+
+    hash = nxt_mp_alloc(mp, sizeof(nxt_upstream_hash_t)
+                            + points * sizeof(nxt_upstream_hash_point_t));
+    if (nxt_slow_path(hash == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_conf_get_string(key_conf, &str);
+
+    hash->key = nxt_tstr_compile(rtcf->tstr_state, &str, 0);
+    if (nxt_slow_path(hash->key == NULL)) {
+        return NXT_ERROR;
+    }
+
+    hash->points = 0;
+    next = 0;
+
+    /*
+     * The points depend only on the server address, so adding or removing
+     * a server remaps only the keys of its own points.
+     */
+
+    for (i = 0; i < n; i++) {
+        (void) nxt_conf_next_object_member(servers_conf, &name, &next);
+
+        data[0] = nxt_murmur_hash2(name.start, name.length);
+
+        for (j = 0; j < npoints[i]; j++) {
+            data[1] = j;
+
+            hash->point[hash->points].hash = nxt_murmur_hash2(data,
+                                                              sizeof(data));
+            hash->point[hash->points].server = i;
+            hash->points++;
+        }
+    }
+
+    nxt_qsort(hash->point, hash->points, sizeof(nxt_upstream_hash_point_t),
+              nxt_upstream_hash_point_cmp);
+
+    urr->hash = hash;
+
+    return NXT_OK;
+}
+
+
+static int
+nxt_upstream_hash_point_cmp(const void *one, const void *two)
+{
+    const nxt_upstream_hash_point_t  *first, *second;
+
+    first = one;
+    second = two;
+
+    if (first->hash != second->hash) {
+        return (first->hash < second->hash) ? -1 : 1;
+    }
+
+    return (first->server < second->server) ? -1
+                                            : (first->server > second->server);
+}
+
+
+static void
+nxt_upstream_hash_server_get(nxt_task_t *task, nxt_upstream_server_t *us)
+{
+    uint32_t                           i, n, k, start, end, key;
+    nxt_str_t                          str;
+    nxt_msec_t                         now;
+    nxt_router_conf_t                  *rtcf;
+    nxt_http_request_t                 *r;
+    nxt_upstream_hash_t                *hash;
+    nxt_upstream_round_robin_t         *round_robin;
+    nxt_upstream_round_robin_server_t  *s;
+
+    round_robin = us->upstream->type.round_robin;
+
+    s = round_robin->server;
+    n = round_robin->items;
+    hash = round_robin->hash;
+
+    now = task->thread->engine->timers.now;
+
+    if (nxt_slow_path(nxt_upstream_round_robin_tried_init(us, n) != NXT_OK)) {
+        goto fail;
+    }
+
+    if (nxt_tstr_is_const(hash->key)) {
+        nxt_tstr_str(hash->key, &str);
+
+    } else {
+        r = us->peer.http->request;
+        rtcf = r->conf->socket_conf->router_conf;
+
+        if (nxt_slow_path(nxt_tstr_query_init(&r->tstr_query, rtcf->tstr_state,
+                                              &r->tstr_cache, r, r->mem_pool)
+                          != NXT_OK))
+        {
+            goto fail;
+        }
+
+        nxt_tstr_query(task, r->tstr_query, hash->key, &str);
+
+        if (nxt_slow_path(nxt_tstr_query_failed(r->tstr_query))) {
+            goto fail;
+        }
+    }
+
+    key = nxt_murmur_hash2(str.start, str.length);
+
+    nxt_debug(task, "upstream hash key: \"%V\" %08xD", &str, key);
+
+    /* Find the first point at or after the key hash on the ring. */
+
+    start = 0;
+    end = hash->points;
+
+    while (start < end) {
+        k = start + (end - start) / 2;
+
+        if (hash->point[k].hash < key) {
+            start = k + 1;
+
+        } else {
+            end = k;
+        }
+    }
+
+    /* Unusable servers are skipped by walking the ring clockwise. */
+
+    for (i = 0; i < hash->points; i++) {
+        k = hash->point[(start + i) % hash->points].server;
+
+        if (nxt_upstream_round_robin_server_usable(us, &s[k], k, now)) {
+            nxt_upstream_round_robin_server_use(task, us, &s[k], now);
+            return;
+        }
+    }
+
+fail:
+
+    us->state->error(task, us);
+}
+
+
+static nxt_int_t
+nxt_upstream_round_robin_tried_init(nxt_upstream_server_t *us, uint32_t n)
+{
+    size_t  size;
+
+    if (us->tried != NULL || us->upstream->retry == NULL) {
+        return NXT_OK;
+    }
+
+    if (n <= NXT_UPSTREAM_TRIED_BITS) {
+        us->tried = &us->tried_data;
+        return NXT_OK;
+    }
+
+    size = (n + NXT_UPSTREAM_TRIED_BITS - 1) / NXT_UPSTREAM_TRIED_BITS;
+
+    us->tried = nxt_mp_zget(us->peer.http->request->mem_pool,
+                            size * sizeof(uintptr_t));
+    if (nxt_slow_path(us->tried == NULL)) {
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_bool_t
+nxt_upstream_round_robin_server_usable(nxt_upstream_server_t *us,
+    nxt_upstream_round_robin_server_t *s, uint32_t i, nxt_msec_t now)
+{
+    if (s->health != NULL && s->health->down) {
+        return 0;
+    }
+
+    if (us->tried != NULL && nxt_upstream_tried(us->tried, i)) {
+        return 0;
+    }
+
+    return !(s->max_fails != 0
+             && s->fails >= s->max_fails
+             && nxt_msec_diff(now, s->checked)
+                <= (nxt_msec_int_t) s->fail_timeout);
+}
+
+
+static void
+nxt_upstream_round_robin_server_recover(nxt_upstream_round_robin_server_t *s)
+{
+    int32_t  step;
+
+    if (s->effective_weight < s->weight) {
+        /* A failed server regains its weight in "max_fails" rounds. */
+
+        step = s->weight / (int32_t) s->max_fails;
+        s->effective_weight += nxt_max(step, 1);
+
+        if (s->effective_weight > s->weight) {
+            s->effective_weight = s->weight;
+        }
+    }
+}
+
+
+static void
+nxt_upstream_round_robin_server_use(nxt_task_t *task,
+    nxt_upstream_server_t *us, nxt_upstream_round_robin_server_t *best,
+    nxt_msec_t now)
+{
+    /* A trial of a failed server starts the next "fail_timeout" period. */
+
+    if (nxt_msec_diff(now, best->checked)
+        > (nxt_msec_int_t) best->fail_timeout)
+    {
+        best->checked = now;
+    }
+
+    if (us->tried != NULL) {
+        nxt_upstream_tried_set(us->tried,
+                               best - us->upstream->type.round_robin->server);
+    }
+
+    us->tries++;
+    best->active++;
+
     us->sockaddr = best->sockaddr;
     us->protocol = best->protocol;
     us->server.round_robin = best;
 
+    if (us->upstream->keepalive != NULL) {
+        us->connection = nxt_upstream_keepalive_get(task, best->sockaddr);
+    }
+
     us->state->ready(task, us);
 }
+
+
+static void
+nxt_upstream_round_robin_server_done(nxt_task_t *task,
+    nxt_upstream_server_t *us, nxt_bool_t failed)
+{
+    nxt_upstream_round_robin_server_t  *s;
+
+    s = us->server.round_robin;
+
+    s->active--;
+
+    if (s->max_fails == 0) {
+        return;
+    }
+
+    if (!failed) {
+        s->fails = 0;
+        return;
+    }
+
+    s->fails++;
+    s->checked = task->thread->engine->timers.now;
+
+    s->effective_weight -= s->weight / (int32_t) s->max_fails;
+
+    if (s->effective_weight < 0) {
+        s->effective_weight = 0;
+    }
+
+    if (s->fails == s->max_fails) {
+        nxt_log(task, NXT_LOG_WARN,
+                "upstream \"%V\" server \"%*s\" failed %uD times, "
+                "disabled for %M ms", &us->upstream->name,
+                (size_t) s->sockaddr->length,
+                nxt_sockaddr_start(s->sockaddr), s->fails, s->fail_timeout);
+    }
+}
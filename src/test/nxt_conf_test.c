@@ -0,0 +1,527 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <nxt_conf.h>
+#include "nxt_tests.h"
+
+
+static nxt_int_t nxt_conf_test_index(nxt_thread_t *thr);
+static nxt_int_t nxt_conf_test_strings(nxt_thread_t *thr);
+static nxt_int_t nxt_conf_test_bench(nxt_thread_t *thr, nxt_uint_t n);
+static nxt_int_t nxt_conf_test_json(nxt_thread_t *thr, nxt_mp_t *mp,
+    nxt_conf_value_t *root, nxt_uint_t n);
+static nxt_int_t nxt_conf_test_bin(nxt_thread_t *thr, nxt_mp_t *mp,
+    nxt_conf_value_t *root, nxt_uint_t n);
+static u_char *nxt_conf_test_print(nxt_mp_t *mp, nxt_conf_value_t *value,
+    nxt_conf_json_pretty_t *pretty, size_t *length);
+static nxt_conf_value_t *nxt_conf_test_create(nxt_mp_t *mp, nxt_uint_t n);
+static nxt_conf_value_t *nxt_conf_test_linear(nxt_conf_value_t *object,
+    nxt_str_t *name);
+
+
+nxt_int_t
+nxt_conf_test(nxt_thread_t *thr)
+{
+    nxt_uint_t  i;
+
+    static const nxt_uint_t  apps[] = { 10, 100, 1000, 10000 };
+
+    if (nxt_conf_test_index(thr) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    if (nxt_conf_test_strings(thr) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < nxt_nitems(apps); i++) {
+        if (nxt_conf_test_bench(thr, apps[i]) != NXT_OK) {
+            return NXT_ERROR;
+        }
+    }
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "conf test passed");
+
+    return NXT_OK;
+}
+
+
+/* Members set after a lookup must be found by their new names. */
+
+static nxt_int_t
+nxt_conf_test_index(nxt_thread_t *thr)
+{
+    u_char            buf[32];
+    nxt_mp_t          *mp;
+    nxt_str_t         name;
+    uint32_t          index;
+    nxt_uint_t        i;
+    nxt_conf_value_t  *object, *empty, *value;
+
+    static const nxt_uint_t  count = 100;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NXT_ERROR;
+    }
+
+    object = nxt_conf_create_object(mp, count);
+    empty = nxt_conf_create_object(mp, 0);
+
+    if (nxt_slow_path(object == NULL || empty == NULL)) {
+        return NXT_ERROR;
+    }
+
+    name.start = buf;
+
+    for (i = 0; i < count; i++) {
+        name.length = nxt_sprintf(buf, buf + sizeof(buf), "member-%ui", i)
+                      - buf;
+
+        if (nxt_conf_set_member_dup(object, mp, &name, empty, i) != NXT_OK) {
+            return NXT_ERROR;
+        }
+    }
+
+    name.length = nxt_sprintf(buf, buf + sizeof(buf), "member-%ui", count / 2)
+                  - buf;
+
+    value = nxt_conf_get_object_member(object, &name, &index);
+
+    if (value == NULL || index != count / 2) {
+        nxt_log_alert(thr->log, "conf index test failed: \"%V\"", &name);
+        return NXT_ERROR;
+    }
+
+    nxt_str_set(&name, "renamed");
+
+    nxt_conf_set_member_null(object, &name, count / 2);
+
+    value = nxt_conf_get_object_member(object, &name, &index);
+
+    if (value == NULL || index != count / 2) {
+        nxt_log_alert(thr->log, "conf index test failed: \"%V\"", &name);
+        return NXT_ERROR;
+    }
+
+    name.start = buf;
+    name.length = nxt_sprintf(buf, buf + sizeof(buf), "member-%ui", count / 2)
+                  - buf;
+
+    if (nxt_conf_get_object_member(object, &name, NULL) != NULL) {
+        nxt_log_alert(thr->log, "conf index test failed: \"%V\"", &name);
+        return NXT_ERROR;
+    }
+
+    nxt_mp_destroy(mp);
+
+    return NXT_OK;
+}
+
+
+/*
+ * Strings of all byte values at all lengths and alignments up to a few
+ * words must survive printing and parsing unchanged.
+ */
+
+static nxt_int_t
+nxt_conf_test_strings(nxt_thread_t *thr)
+{
+    u_char            raw[64], *json;
+    size_t            length;
+    nxt_mp_t          *mp;
+    nxt_str_t         name, str, parsed;
+    nxt_uint_t        i, n, shift;
+    nxt_conf_value_t  *object, *root, *value;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_str_set(&name, "s");
+
+    for (shift = 0; shift < 256; shift += 7) {
+
+        for (n = 0; n <= sizeof(raw); n++) {
+
+            for (i = 0; i < n; i++) {
+                raw[i] = (u_char) (shift + i * 29);
+            }
+
+            str.start = raw;
+            str.length = n;
+
+            object = nxt_conf_create_object(mp, 1);
+            if (nxt_slow_path(object == NULL)) {
+                return NXT_ERROR;
+            }
+
+            if (nxt_conf_set_member_string_dup(object, mp, &name, &str, 0)
+                != NXT_OK)
+            {
+                return NXT_ERROR;
+            }
+
+            json = nxt_conf_test_print(mp, object, NULL, &length);
+            if (nxt_slow_path(json == NULL)) {
+                return NXT_ERROR;
+            }
+
+            root = nxt_conf_json_parse(mp, json, json + length, NULL);
+            value = (root != NULL) ? nxt_conf_get_object_member(root, &name,
+                                                                NULL)
+                                   : NULL;
+
+            if (value != NULL) {
+                nxt_conf_get_string(value, &parsed);
+            }
+
+            if (value == NULL || !nxt_strstr_eq(&parsed, &str)) {
+                nxt_log_alert(thr->log, "conf strings test failed: "
+                              "shift %ui, length %ui", shift, n);
+                return NXT_ERROR;
+            }
+        }
+    }
+
+    nxt_mp_destroy(mp);
+
+    return NXT_OK;
+}
+
+
+/*
+ * Each route passes to its application, so both the validation and
+ * the router look every application up by name.
+ */
+
+static nxt_int_t
+nxt_conf_test_bench(nxt_thread_t *thr, nxt_uint_t n)
+{
+    u_char            buf[64];
+    nxt_mp_t          *mp;
+    nxt_str_t         name;
+    nxt_uint_t        i;
+    nxt_nsec_t        start, parse, indexed, linear;
+    nxt_conf_value_t  *root, *apps, *value;
+
+    static const nxt_str_t  apps_path = nxt_string("/applications");
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    root = nxt_conf_test_create(mp, n);
+
+    nxt_thread_time_update(thr);
+    parse = nxt_thread_monotonic_time(thr) - start;
+
+    if (nxt_slow_path(root == NULL)) {
+        nxt_log_alert(thr->log, "conf bench creation failed");
+        return NXT_ERROR;
+    }
+
+    apps = nxt_conf_get_path(root, &apps_path);
+
+    name.start = buf;
+
+    for (i = 0; i < n; i++) {
+        name.length = nxt_sprintf(buf, buf + sizeof(buf), "app-%ui", i) - buf;
+
+        value = nxt_conf_get_object_member(apps, &name, NULL);
+
+        if (value == NULL || value != nxt_conf_test_linear(apps, &name)) {
+            nxt_log_alert(thr->log, "conf bench failed: \"%V\"", &name);
+            return NXT_ERROR;
+        }
+    }
+
+    nxt_str_set(&name, "app-none");
+
+    if (nxt_conf_get_object_member(apps, &name, NULL) != NULL) {
+        nxt_log_alert(thr->log, "conf bench failed: \"%V\"", &name);
+        return NXT_ERROR;
+    }
+
+    name.start = buf;
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    for (i = 0; i < n; i++) {
+        name.length = nxt_sprintf(buf, buf + sizeof(buf), "app-%ui", i) - buf;
+        (void) nxt_conf_get_object_member(apps, &name, NULL);
+    }
+
+    nxt_thread_time_update(thr);
+    indexed = nxt_thread_monotonic_time(thr) - start;
+    start = nxt_thread_monotonic_time(thr);
+
+    for (i = 0; i < n; i++) {
+        name.length = nxt_sprintf(buf, buf + sizeof(buf), "app-%ui", i) - buf;
+        (void) nxt_conf_test_linear(apps, &name);
+    }
+
+    nxt_thread_time_update(thr);
+    linear = nxt_thread_monotonic_time(thr) - start;
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "conf bench: %ui applications, parse: %uLus, "
+                  "lookup of all: %uLus, linear: %uLus",
+                  n, parse / 1000, indexed / 1000, linear / 1000);
+
+    if (nxt_conf_test_json(thr, mp, root, n) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    if (nxt_conf_test_bin(thr, mp, root, n) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    nxt_mp_destroy(mp);
+
+    return NXT_OK;
+}
+
+
+/*
+ * The configuration is printed as the controller shows it, parsed back,
+ * and must be printed back the same.
+ */
+
+static nxt_int_t
+nxt_conf_test_json(nxt_thread_t *thr, nxt_mp_t *mp, nxt_conf_value_t *root,
+    nxt_uint_t n)
+{
+    u_char                  *text, *compact, *again;
+    size_t                  length, compact_length, again_length;
+    nxt_uint_t              i, runs;
+    nxt_nsec_t              start, print, parse;
+    nxt_conf_value_t        *conf;
+    nxt_conf_json_pretty_t  pretty;
+
+    compact = nxt_conf_test_print(mp, root, NULL, &compact_length);
+
+    /* The monotonic time is coarse, so the runs are scaled to the size. */
+
+    runs = 100000 / n + 1;
+
+    text = NULL;
+    length = 0;
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    for (i = 0; i < runs; i++) {
+        nxt_memzero(&pretty, sizeof(nxt_conf_json_pretty_t));
+
+        text = nxt_conf_test_print(mp, root, &pretty, &length);
+    }
+
+    nxt_thread_time_update(thr);
+    print = nxt_thread_monotonic_time(thr) - start;
+
+    conf = NULL;
+
+    if (text != NULL) {
+        start = nxt_thread_monotonic_time(thr);
+
+        for (i = 0; i < runs; i++) {
+            conf = nxt_conf_json_parse(mp, text, text + length, NULL);
+        }
+
+        nxt_thread_time_update(thr);
+        parse = nxt_thread_monotonic_time(thr) - start;
+
+    } else {
+        parse = 0;
+    }
+
+    again = (conf != NULL) ? nxt_conf_test_print(mp, conf, NULL, &again_length)
+                           : NULL;
+
+    if (compact == NULL || again == NULL
+        || compact_length != again_length
+        || memcmp(compact, again, again_length) != 0)
+    {
+        nxt_log_alert(thr->log, "conf json test failed: %ui applications", n);
+        return NXT_ERROR;
+    }
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "conf json bench: %uz bytes, print: %uLus, parse: %uLus",
+                  length, print / runs / 1000, parse / runs / 1000);
+
+    return NXT_OK;
+}
+
+
+/*
+ * The binary form must decode to the same configuration, and any
+ * truncated form of a small configuration must be rejected.
+ */
+
+static nxt_int_t
+nxt_conf_test_bin(nxt_thread_t *thr, nxt_mp_t *mp, nxt_conf_value_t *root,
+    nxt_uint_t n)
+{
+    u_char            *bin, *end, *compact, *again;
+    size_t            length, compact_length, again_length;
+    nxt_uint_t        i, runs;
+    nxt_nsec_t        start, print, parse;
+    nxt_conf_value_t  *conf;
+
+    length = nxt_conf_bin_length(root);
+
+    bin = nxt_mp_nget(mp, length);
+    if (nxt_slow_path(bin == NULL)) {
+        return NXT_ERROR;
+    }
+
+    runs = 100000 / n + 1;
+
+    end = bin;
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    for (i = 0; i < runs; i++) {
+        end = nxt_conf_bin_print(bin, root);
+    }
+
+    nxt_thread_time_update(thr);
+    print = nxt_thread_monotonic_time(thr) - start;
+
+    conf = NULL;
+
+    if ((size_t) (end - bin) == length) {
+        start = nxt_thread_monotonic_time(thr);
+
+        for (i = 0; i < runs; i++) {
+            conf = nxt_conf_bin_parse(mp, bin, end);
+        }
+
+        nxt_thread_time_update(thr);
+        parse = nxt_thread_monotonic_time(thr) - start;
+
+    } else {
+        parse = 0;
+    }
+
+    compact = nxt_conf_test_print(mp, root, NULL, &compact_length);
+    again = (conf != NULL) ? nxt_conf_test_print(mp, conf, NULL, &again_length)
+                           : NULL;
+
+    if (compact == NULL || again == NULL
+        || compact_length != again_length
+        || memcmp(compact, again, again_length) != 0)
+    {
+        nxt_log_alert(thr->log, "conf bin test failed: %ui applications", n);
+        return NXT_ERROR;
+    }
+
+    if (n <= 10) {
+        for (i = 0; i < length; i++) {
+            if (nxt_conf_bin_parse(mp, bin, bin + i) != NULL) {
+                nxt_log_alert(thr->log, "conf bin test failed: "
+                              "truncated to %ui bytes", i);
+                return NXT_ERROR;
+            }
+        }
+    }
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "conf bin bench: %uz bytes, print: %uLus, parse: %uLus",
+                  length, print / runs / 1000, parse / runs / 1000);
+
+    return NXT_OK;
+}
+
+
+static u_char *
+nxt_conf_test_print(nxt_mp_t *mp, nxt_conf_value_t *value,
+    nxt_conf_json_pretty_t *pretty, size_t *length)
+{
+    u_char  *start;
+    size_t  size;
+
+    size = nxt_conf_json_length(value, pretty);
+
+    start = nxt_mp_nget(mp, size);
+    if (nxt_slow_path(start == NULL)) {
+        return NULL;
+    }
+
+    *length = nxt_conf_json_print(start, value, pretty) - start;
+
+    return start;
+}
+
+
+static nxt_conf_value_t *
+nxt_conf_test_create(nxt_mp_t *mp, nxt_uint_t n)
+{
+    u_char      *start, *p, *end;
+    size_t      size;
+    nxt_uint_t  i;
+
+    size = 64 + n * 320;
+
+    start = nxt_mp_nget(mp, size);
+    if (nxt_slow_path(start == NULL)) {
+        return NULL;
+    }
+
+    p = start;
+    end = start + size;
+
+    p = nxt_cpymem(p, "{\"applications\":{", 17);
+
+    for (i = 0; i < n; i++) {
+        p = nxt_sprintf(p, end, "%s\"app-%ui\":{\"type\":\"python\","
+                        "\"path\":\"/srv/app-%ui\",\"module\":\"wsgi\","
+                        "\"environment\":{\"DESCRIPTION\":\"Application "
+                        "number %ui of the generated configuration, "
+                        "\\\"quoted\\\"\\ton a tab\\n\"}}",
+                        (i == 0) ? "" : ",", i, i, i);
+    }
+
+    p = nxt_cpymem(p, "},\"routes\":[", 12);
+
+    for (i = 0; i < n; i++) {
+        p = nxt_sprintf(p, end, "%s{\"action\":"
+                        "{\"pass\":\"applications/app-%ui\"}}",
+                        (i == 0) ? "" : ",", i);
+    }
+
+    p = nxt_cpymem(p, "]}", 2);
+
+    return nxt_conf_json_parse(mp, start, p, NULL);
+}
+
+
+static nxt_conf_value_t *
+nxt_conf_test_linear(nxt_conf_value_t *object, nxt_str_t *name)
+{
+    uint32_t          next;
+    nxt_str_t         str;
+    nxt_conf_value_t  *value;
+
+    next = 0;
+
+    for ( ;; ) {
+        value = nxt_conf_next_object_member(object, &str, &next);
+
+        if (value == NULL || nxt_strstr_eq(&str, name)) {
+            return value;
+        }
+    }
+}
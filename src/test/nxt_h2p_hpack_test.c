@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_h2proto.h>
+#include "nxt_tests.h"
+
+
+static nxt_int_t nxt_h2p_hpack_test_evict_name(nxt_thread_t *thr,
+    nxt_mp_t *mp, nxt_h2p_hpack_t *hpack);
+
+
+nxt_int_t
+nxt_h2p_hpack_test(nxt_thread_t *thr)
+{
+    u_char           clear[1];
+    nxt_mp_t         *mp;
+    nxt_int_t        ret;
+    nxt_h2p_hpack_t  hpack;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_memzero(&hpack, sizeof(nxt_h2p_hpack_t));
+    hpack.max_size = 4096;
+
+    ret = nxt_h2p_hpack_test_evict_name(thr, mp, &hpack);
+
+    /* The dynamic table size update to 0 frees all entries. */
+
+    clear[0] = 0x20;
+
+    (void) nxt_h2p_hpack_decode(&hpack, mp, clear, clear + 1, NULL, 0);
+
+    nxt_mp_destroy(mp);
+
+    if (ret != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "h2p hpack test passed");
+
+    return NXT_OK;
+}
+
+
+/*
+ * A literal field with incremental indexing whose name refers to
+ * the dynamic table entry evicted to make room for the field itself,
+ * see RFC 7541, Section 4.4.
+ */
+
+static nxt_int_t
+nxt_h2p_hpack_test_evict_name(nxt_thread_t *thr, nxt_mp_t *mp,
+    nxt_h2p_hpack_t *hpack)
+{
+    nxt_uint_t             i;
+    nxt_h2p_hpack_entry_t  *entry;
+
+    static u_char  block[] =
+        /* Dynamic table size update to 100. */
+        "\x3f\x45"
+        /* "x-name: v", the entry size is 39. */
+        "\x40\x06" "x-name" "\x01" "v"
+        /* The name of the entry 62, a 40 bytes value, the size is 78. */
+        "\x7e\x28" "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb";
+
+    if (nxt_h2p_hpack_decode(hpack, mp, block, block + sizeof(block) - 1,
+                             NULL, 0)
+        != NXT_OK)
+    {
+        nxt_log_alert(thr->log, "h2p hpack evict name test: decode failed");
+        return NXT_ERROR;
+    }
+
+    if (hpack->added - hpack->deleted != 1 || hpack->size != 78) {
+        nxt_log_alert(thr->log, "h2p hpack evict name test: "
+                      "%uD entries of %uD bytes",
+                      hpack->added - hpack->deleted, hpack->size);
+        return NXT_ERROR;
+    }
+
+    entry = hpack->entries[(hpack->added - 1) % NXT_H2P_HPACK_ENTRIES];
+
+    if (entry->name_length != 6
+        || memcmp(entry->data, "x-name", 6) != 0
+        || entry->value_length != 40)
+    {
+        nxt_log_alert(thr->log, "h2p hpack evict name test: "
+                      "invalid entry \"%*s\"",
+                      (size_t) entry->name_length, entry->data);
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < 40; i++) {
+        if (entry->data[6 + i] != 'b') {
+            nxt_log_alert(thr->log, "h2p hpack evict name test: "
+                          "invalid value");
+            return NXT_ERROR;
+        }
+    }
+
+    return NXT_OK;
+}
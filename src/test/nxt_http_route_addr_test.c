@@ -0,0 +1,184 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include "nxt_tests.h"
+
+
+static nxt_int_t nxt_http_route_addr_test_bench(nxt_thread_t *thr,
+    nxt_uint_t n);
+static nxt_http_route_addr_rule_t *nxt_http_route_addr_test_create(
+    nxt_task_t *task, nxt_mp_t *mp, nxt_uint_t n, const char *port);
+static nxt_sockaddr_t *nxt_http_route_addr_test_sockaddr(nxt_mp_t *mp,
+    uint32_t addr);
+static nxt_nsec_t nxt_http_route_addr_test_run(nxt_thread_t *thr,
+    nxt_http_route_addr_rule_t *addr_rule, nxt_sockaddr_t *sa,
+    nxt_uint_t runs);
+
+
+/* The networks are spread over the address space by a multiplicative hash. */
+#define nxt_http_route_addr_test_addr(i)                                      \
+    ((uint32_t) ((i) + 1) * 2654435761U & 0xFFFFFF00)
+
+
+nxt_int_t
+nxt_http_route_addr_test(nxt_thread_t *thr)
+{
+    nxt_uint_t  i;
+
+    static const nxt_uint_t  patterns[] = { 10, 100, 1000, 10000, 50000 };
+
+    for (i = 0; i < nxt_nitems(patterns); i++) {
+        if (nxt_http_route_addr_test_bench(thr, patterns[i]) != NXT_OK) {
+            return NXT_ERROR;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * Patterns with a port are not merged into the address table, so the same
+ * addresses with a port are matched linearly to compare the cost of a miss.
+ */
+
+static nxt_int_t
+nxt_http_route_addr_test_bench(nxt_thread_t *thr, nxt_uint_t n)
+{
+    nxt_mp_t                    *mp;
+    nxt_uint_t                  runs;
+    nxt_nsec_t                  tabular, linear;
+    nxt_sockaddr_t              *hit, *miss;
+    nxt_http_route_addr_rule_t  *table_rule, *linear_rule;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NXT_ERROR;
+    }
+
+    table_rule = nxt_http_route_addr_test_create(thr->task, mp, n, "");
+    linear_rule = nxt_http_route_addr_test_create(thr->task, mp, n,
+                                                  ":1-65535");
+
+    hit = nxt_http_route_addr_test_sockaddr(mp,
+                                     nxt_http_route_addr_test_addr(n / 2) + 1);
+    miss = nxt_http_route_addr_test_sockaddr(mp, 0x7F000001);
+
+    if (nxt_slow_path(table_rule == NULL || linear_rule == NULL
+                      || hit == NULL || miss == NULL))
+    {
+        nxt_log_alert(thr->log, "http route addr bench creation failed");
+        return NXT_ERROR;
+    }
+
+    if (nxt_http_route_addr_rule(NULL, table_rule, hit) != 1
+        || nxt_http_route_addr_rule(NULL, linear_rule, hit) != 1
+        || nxt_http_route_addr_rule(NULL, table_rule, miss) != 0
+        || nxt_http_route_addr_rule(NULL, linear_rule, miss) != 0)
+    {
+        nxt_log_alert(thr->log, "http route addr bench failed: %ui patterns",
+                      n);
+        return NXT_ERROR;
+    }
+
+    /* The monotonic time is coarse, so the runs are scaled to the cost. */
+
+    runs = 10 * 1000 * 1000 / n;
+
+    linear = nxt_http_route_addr_test_run(thr, linear_rule, miss, runs);
+    tabular = nxt_http_route_addr_test_run(thr, table_rule, miss,
+                                           1000 * 1000);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "http route addr bench: %ui patterns, "
+                  "table: %uLns, linear: %uLns per lookup",
+                  n, tabular / (1000 * 1000), linear / runs);
+
+    nxt_mp_destroy(mp);
+
+    return NXT_OK;
+}
+
+
+static nxt_http_route_addr_rule_t *
+nxt_http_route_addr_test_create(nxt_task_t *task, nxt_mp_t *mp, nxt_uint_t n,
+    const char *port)
+{
+    u_char            *start, *p, *end;
+    size_t            size;
+    uint32_t          addr;
+    nxt_uint_t        i;
+    nxt_conf_value_t  *conf;
+
+    size = (n + 1) * 40;
+
+    start = nxt_mp_nget(mp, size);
+    if (nxt_slow_path(start == NULL)) {
+        return NULL;
+    }
+
+    p = start;
+    end = start + size;
+
+    *p++ = '[';
+
+    for (i = 0; i < n; i++) {
+        addr = nxt_http_route_addr_test_addr(i);
+
+        p = nxt_sprintf(p, end, "%s\"%ud.%ud.%ud.0/24%s\"",
+                        (i == 0) ? "" : ",",
+                        addr >> 24, (addr >> 16) & 0xFF, (addr >> 8) & 0xFF,
+                        port);
+    }
+
+    *p++ = ']';
+
+    conf = nxt_conf_json_parse(mp, start, p, NULL);
+    if (nxt_slow_path(conf == NULL)) {
+        return NULL;
+    }
+
+    return nxt_http_route_addr_rule_create(task, mp, conf);
+}
+
+
+static nxt_sockaddr_t *
+nxt_http_route_addr_test_sockaddr(nxt_mp_t *mp, uint32_t addr)
+{
+    u_char     buf[32];
+    nxt_str_t  str;
+
+    str.start = buf;
+    str.length = nxt_sprintf(buf, buf + sizeof(buf), "%ud.%ud.%ud.%ud:80",
+                             addr >> 24, (addr >> 16) & 0xFF,
+                             (addr >> 8) & 0xFF, addr & 0xFF)
+                 - buf;
+
+    return nxt_sockaddr_parse(mp, &str);
+}
+
+
+static nxt_nsec_t
+nxt_http_route_addr_test_run(nxt_thread_t *thr,
+    nxt_http_route_addr_rule_t *addr_rule, nxt_sockaddr_t *sa,
+    nxt_uint_t runs)
+{
+    nxt_uint_t  i;
+    nxt_nsec_t  start, end;
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    for (i = 0; nxt_fast_path(i < runs); i++) {
+        (void) nxt_http_route_addr_rule(NULL, addr_rule, sa);
+    }
+
+    nxt_thread_time_update(thr);
+    end = nxt_thread_monotonic_time(thr);
+
+    return end - start;
+}
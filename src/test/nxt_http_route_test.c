@@ -0,0 +1,195 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include "nxt_tests.h"
+
+
+static nxt_int_t nxt_http_route_test_bench(nxt_thread_t *thr, nxt_uint_t n,
+    nxt_uint_t runs);
+static nxt_http_action_t *nxt_http_route_test_create(nxt_task_t *task,
+    nxt_mp_t *mp, nxt_uint_t n);
+static nxt_nsec_t nxt_http_route_test_run(nxt_thread_t *thr,
+    nxt_http_action_t *action, nxt_http_request_t *r, nxt_uint_t runs);
+
+
+nxt_int_t
+nxt_http_route_test(nxt_thread_t *thr)
+{
+    nxt_uint_t  i;
+
+    static const nxt_uint_t  routes[] = { 10, 100, 1000, 3000 };
+
+    for (i = 0; i < nxt_nitems(routes); i++) {
+        if (nxt_http_route_test_bench(thr, routes[i], 10000) != NXT_OK) {
+            return NXT_ERROR;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * Routes logging disables the index, so the same routes are matched
+ * linearly to compare the cost of the request for the last route.
+ */
+
+static nxt_int_t
+nxt_http_route_test_bench(nxt_thread_t *thr, nxt_uint_t n, nxt_uint_t runs)
+{
+    u_char              buf[32];
+    nxt_mp_t            *mp;
+    nxt_str_t           path, method;
+    nxt_uint_t          level;
+    nxt_nsec_t          indexed, linear;
+    nxt_http_action_t   *action, *selected;
+    nxt_http_request_t  r;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NXT_ERROR;
+    }
+
+    action = nxt_http_route_test_create(thr->task, mp, n);
+    if (nxt_slow_path(action == NULL)) {
+        nxt_log_alert(thr->log, "http route bench routes creation failed");
+        return NXT_ERROR;
+    }
+
+    path.start = buf;
+    path.length = nxt_sprintf(buf, buf + sizeof(buf), "/route/%ui", n - 1)
+                  - buf;
+
+    nxt_str_set(&method, "GET");
+
+    nxt_memzero(&r, sizeof(nxt_http_request_t));
+
+    r.mem_pool = mp;
+    r.path = &path;
+    r.method = &method;
+    nxt_str_set(&r.host, "localhost");
+
+    level = thr->log->level;
+    thr->log->level = NXT_LOG_WARN;
+
+    selected = action->handler(thr->task, &r, action);
+
+    r.log_route = 1;
+
+    if (action->handler(thr->task, &r, action) != selected
+        || selected == NULL)
+    {
+        thr->log->level = level;
+
+        nxt_log_alert(thr->log, "http route bench failed: %ui routes", n);
+        return NXT_ERROR;
+    }
+
+    linear = nxt_http_route_test_run(thr, action, &r, runs);
+
+    r.log_route = 0;
+
+    /* The monotonic time is coarse, and the indexed match is fast. */
+    indexed = nxt_http_route_test_run(thr, action, &r, runs * 100);
+
+    thr->log->level = level;
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "http route bench: %ui routes, "
+                  "indexed: %uLns, linear: %uLns per request",
+                  n, indexed / (runs * 100), linear / runs);
+
+    nxt_mp_destroy(mp);
+
+    return NXT_OK;
+}
+
+
+static nxt_http_action_t *
+nxt_http_route_test_create(nxt_task_t *task, nxt_mp_t *mp, nxt_uint_t n)
+{
+    u_char                  *start, *p, *end;
+    size_t                  size;
+    nxt_str_t               pass;
+    nxt_uint_t              i;
+    nxt_conf_value_t        *conf;
+    nxt_router_conf_t       *rtcf;
+    nxt_http_action_t       *action;
+    nxt_router_temp_conf_t  *tmcf;
+
+    tmcf = nxt_mp_zget(mp, sizeof(nxt_router_temp_conf_t));
+    rtcf = nxt_mp_zget(mp, sizeof(nxt_router_conf_t));
+
+    if (nxt_slow_path(tmcf == NULL || rtcf == NULL)) {
+        return NULL;
+    }
+
+    tmcf->mem_pool = mp;
+    tmcf->router_conf = rtcf;
+    rtcf->mem_pool = mp;
+
+    rtcf->tstr_state = nxt_tstr_state_new(mp, 0);
+    if (nxt_slow_path(rtcf->tstr_state == NULL)) {
+        return NULL;
+    }
+
+    size = (n + 1) * 64;
+
+    start = nxt_mp_nget(mp, size);
+    if (nxt_slow_path(start == NULL)) {
+        return NULL;
+    }
+
+    p = start;
+    end = start + size;
+
+    *p++ = '[';
+
+    for (i = 0; i < n; i++) {
+        p = nxt_sprintf(p, end, "{\"match\":{\"uri\":\"/route/%ui\"},"
+                                "\"action\":{\"return\":200}},", i);
+    }
+
+    p = nxt_sprintf(p, end, "{\"action\":{\"return\":404}}]");
+
+    conf = nxt_conf_json_parse(mp, start, p, NULL);
+    if (nxt_slow_path(conf == NULL)) {
+        return NULL;
+    }
+
+    rtcf->routes = nxt_http_routes_create(task, tmcf, conf);
+    if (nxt_slow_path(rtcf->routes == NULL)) {
+        return NULL;
+    }
+
+    nxt_str_set(&pass, "routes");
+
+    action = nxt_http_action_create(task, tmcf, &pass);
+
+    return action;
+}
+
+
+static nxt_nsec_t
+nxt_http_route_test_run(nxt_thread_t *thr, nxt_http_action_t *action,
+    nxt_http_request_t *r, nxt_uint_t runs)
+{
+    nxt_uint_t  i;
+    nxt_nsec_t  start, end;
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    for (i = 0; nxt_fast_path(i < runs); i++) {
+        (void) action->handler(thr->task, r, action);
+    }
+
+    nxt_thread_time_update(thr);
+    end = nxt_thread_monotonic_time(thr);
+
+    return end - start;
+}
@@ -0,0 +1,212 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_conf.h>
+#include <nxt_http.h>
+#include "nxt_tests.h"
+
+
+static nxt_int_t nxt_router_conf_test_bench(nxt_thread_t *thr, nxt_uint_t n);
+static nxt_conf_value_t *nxt_router_conf_test_parse(nxt_mp_t *mp,
+    nxt_uint_t n);
+static nxt_int_t nxt_router_conf_test_build(nxt_task_t *task, nxt_mp_t *mp,
+    nxt_conf_value_t *root);
+
+
+nxt_int_t
+nxt_router_conf_test(nxt_thread_t *thr)
+{
+    nxt_uint_t  i;
+
+    static const nxt_uint_t  routes[] = { 10, 100, 1000, 10000 };
+
+    for (i = 0; i < nxt_nitems(routes); i++) {
+        if (nxt_router_conf_test_bench(thr, routes[i]) != NXT_OK) {
+            return NXT_ERROR;
+        }
+    }
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "router conf test passed");
+
+    return NXT_OK;
+}
+
+
+/*
+ * Each route passes to its own upstream.  A reconfiguration parses and
+ * validates the configuration in the controller, then parses it again
+ * and builds the routes and the upstreams in the router; the stages are
+ * timed separately to show how the latency grows with the size.
+ */
+
+static nxt_int_t
+nxt_router_conf_test_bench(nxt_thread_t *thr, nxt_uint_t n)
+{
+    nxt_mp_t               *mp;
+    nxt_int_t              ret;
+    nxt_uint_t             level;
+    nxt_nsec_t             start, parse, validate, build;
+    nxt_conf_value_t       *root;
+    nxt_conf_validation_t  vldt;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    root = nxt_router_conf_test_parse(mp, n);
+
+    nxt_thread_time_update(thr);
+    parse = nxt_thread_monotonic_time(thr) - start;
+
+    if (nxt_slow_path(root == NULL)) {
+        nxt_log_alert(thr->log, "router conf bench creation failed");
+        return NXT_ERROR;
+    }
+
+    nxt_memzero(&vldt, sizeof(nxt_conf_validation_t));
+
+    vldt.pool = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(vldt.pool == NULL)) {
+        return NXT_ERROR;
+    }
+
+    vldt.conf = root;
+    vldt.conf_pool = mp;
+    vldt.ver = NXT_VERNUM;
+
+    start = nxt_thread_monotonic_time(thr);
+
+    ret = nxt_conf_validate(&vldt);
+
+    nxt_thread_time_update(thr);
+    validate = nxt_thread_monotonic_time(thr) - start;
+
+    nxt_mp_destroy(vldt.pool);
+
+    if (ret != NXT_OK) {
+        nxt_log_alert(thr->log, "router conf bench validation failed: %V",
+                      &vldt.error);
+        return NXT_ERROR;
+    }
+
+    level = thr->log->level;
+    thr->log->level = NXT_LOG_WARN;
+
+    start = nxt_thread_monotonic_time(thr);
+
+    ret = nxt_router_conf_test_build(thr->task, mp, root);
+
+    nxt_thread_time_update(thr);
+    build = nxt_thread_monotonic_time(thr) - start;
+
+    thr->log->level = level;
+
+    if (ret != NXT_OK) {
+        nxt_log_alert(thr->log, "router conf bench failed: %ui routes", n);
+        return NXT_ERROR;
+    }
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "router conf bench: %ui routes and upstreams, "
+                  "parse: %uLus, validate: %uLus, build: %uLus, "
+                  "total: %uLus",
+                  n, parse / 1000, validate / 1000, build / 1000,
+                  (2 * parse + validate + build) / 1000);
+
+    nxt_mp_destroy(mp);
+
+    return NXT_OK;
+}
+
+
+static nxt_conf_value_t *
+nxt_router_conf_test_parse(nxt_mp_t *mp, nxt_uint_t n)
+{
+    u_char      *start, *p, *end;
+    size_t      size;
+    nxt_uint_t  i;
+
+    size = 128 + n * 160;
+
+    start = nxt_mp_nget(mp, size);
+    if (nxt_slow_path(start == NULL)) {
+        return NULL;
+    }
+
+    p = start;
+    end = start + size;
+
+    p = nxt_sprintf(p, end, "{\"listeners\":{\"*:8080\":{\"pass\":\"routes\"}},"
+                            "\"routes\":[");
+
+    for (i = 0; i < n; i++) {
+        p = nxt_sprintf(p, end, "%s{\"match\":{\"uri\":\"/route/%ui\"},"
+                        "\"action\":{\"pass\":\"upstreams/u-%ui\"}}",
+                        (i == 0) ? "" : ",", i, i);
+    }
+
+    p = nxt_sprintf(p, end, "],\"upstreams\":{");
+
+    for (i = 0; i < n; i++) {
+        p = nxt_sprintf(p, end, "%s\"u-%ui\":{\"servers\":"
+                        "{\"127.0.0.1:%ui\":{}}}",
+                        (i == 0) ? "" : ",", i, 10000 + i % 50000);
+    }
+
+    p = nxt_sprintf(p, end, "}}");
+
+    return nxt_conf_json_parse(mp, start, p, NULL);
+}
+
+
+/* The part of nxt_router_conf_create() that does not need other processes. */
+
+static nxt_int_t
+nxt_router_conf_test_build(nxt_task_t *task, nxt_mp_t *mp,
+    nxt_conf_value_t *root)
+{
+    nxt_conf_value_t        *conf;
+    nxt_router_conf_t       *rtcf;
+    nxt_router_temp_conf_t  *tmcf;
+
+    static const nxt_str_t  routes_path = nxt_string("/routes");
+
+    tmcf = nxt_mp_zget(mp, sizeof(nxt_router_temp_conf_t));
+    rtcf = nxt_mp_zget(mp, sizeof(nxt_router_conf_t));
+
+    if (nxt_slow_path(tmcf == NULL || rtcf == NULL)) {
+        return NXT_ERROR;
+    }
+
+    tmcf->mem_pool = mp;
+    tmcf->router_conf = rtcf;
+    rtcf->mem_pool = mp;
+
+    nxt_queue_init(&tmcf->apps);
+    nxt_queue_init(&tmcf->previous);
+
+    rtcf->tstr_state = nxt_tstr_state_new(mp, 0);
+    if (nxt_slow_path(rtcf->tstr_state == NULL)) {
+        return NXT_ERROR;
+    }
+
+    conf = nxt_conf_get_path(root, &routes_path);
+
+    rtcf->routes = nxt_http_routes_create(task, tmcf, conf);
+    if (nxt_slow_path(rtcf->routes == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (nxt_upstreams_create(task, tmcf, root) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    return nxt_http_routes_resolve(task, tmcf);
+}
@@ -158,6 +158,26 @@ main(int argc, char **argv)
         return 1;
     }
 
+    if (nxt_http_route_test(thr) != NXT_OK) {
+        return 1;
+    }
+
+    if (nxt_http_route_addr_test(thr) != NXT_OK) {
+        return 1;
+    }
+
+    if (nxt_h2p_hpack_test(thr) != NXT_OK) {
+        return 1;
+    }
+
+    if (nxt_conf_test(thr) != NXT_OK) {
+        return 1;
+    }
+
+    if (nxt_router_conf_test(thr) != NXT_OK) {
+        return 1;
+    }
+
     if (nxt_strverscmp_test(thr) != NXT_OK) {
         return 1;
     }
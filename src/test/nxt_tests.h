@@ -63,6 +63,11 @@ nxt_int_t nxt_sprintf_test(nxt_thread_t *thr);
 nxt_int_t nxt_malloc_test(nxt_thread_t *thr);
 nxt_int_t nxt_utf8_test(nxt_thread_t *thr);
 nxt_int_t nxt_http_parse_test(nxt_thread_t *thr);
+nxt_int_t nxt_http_route_test(nxt_thread_t *thr);
+nxt_int_t nxt_http_route_addr_test(nxt_thread_t *thr);
+nxt_int_t nxt_h2p_hpack_test(nxt_thread_t *thr);
+nxt_int_t nxt_conf_test(nxt_thread_t *thr);
+nxt_int_t nxt_router_conf_test(nxt_thread_t *thr);
 nxt_int_t nxt_strverscmp_test(nxt_thread_t *thr);
 nxt_int_t nxt_base64_test(nxt_thread_t *thr);
 nxt_int_t nxt_clone_creds_test(nxt_thread_t *thr);
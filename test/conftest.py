@@ -58,6 +58,11 @@ def pytest_addoption(parser):
         type=str,
         help="Default user for non-privileged processes of unitd",
     )
+    parser.addoption(
+        "--engine",
+        type=str,
+        help="Event engine of unitd",
+    )
     parser.addoption(
         "--fds-threshold",
         type=int,
@@ -92,6 +97,7 @@ def pytest_configure(config):
     option.config = config.option
 
     option.detailed = config.option.detailed
+    option.engine = config.option.engine
     option.fds_threshold = config.option.fds_threshold
     option.print_log = config.option.print_log
     option.save_log = config.option.save_log
@@ -261,7 +267,7 @@ def run(request):
     Log.check_alerts(log=log)
 
 
-def unit_run(state_dir=None):
+def unit_run(state_dir=None, engine=None):
     global unit_instance
 
     if not option.restart and 'unitd' in unit_instance:
@@ -308,6 +314,12 @@ def unit_run(state_dir=None):
     if option.user:
         unitd_args.extend(['--user', option.user])
 
+    if engine is None:
+        engine = option.engine
+
+    if engine:
+        unitd_args.extend(['--engine', engine])
+
     with open(f'{temporary_dir}/unit.log', 'w', encoding='utf-8') as log:
         unit_instance['process'] = subprocess.Popen(unitd_args, stderr=log)
 
@@ -0,0 +1,34 @@
+import time
+
+requests = 0
+
+
+def application(environ, start_response):
+    global requests
+    requests += 1
+
+    body = str(requests).encode()
+    body += b'.' * int(environ.get('HTTP_X_LENGTH', 0))
+
+    time.sleep(float(environ.get('HTTP_X_DELAY', 0)))
+
+    status = environ.get('HTTP_X_STATUS', '200')
+    headers = []
+
+    for name in ('Cache-Control', 'Set-Cookie', 'Vary', 'ETag'):
+        value = environ.get(f'HTTP_X_{name.upper().replace("-", "_")}')
+
+        if value is not None:
+            headers.append((name, value))
+
+    etag = environ.get('HTTP_X_ETAG')
+
+    if etag is not None and environ.get('HTTP_IF_NONE_MATCH') == etag:
+        status = '304'
+        body = b''
+
+    headers.append(('Content-Type', 'text/plain'))
+    headers.append(('Content-Length', str(len(body))))
+
+    start_response(status, headers)
+    return [body]
@@ -299,6 +299,26 @@ def test_access_log_format(wait_for_record):
     check_format('$uri $status $uri $status', '/ 200 / 200')
 
 
+def test_access_log_order(temp_dir, wait_for_record):
+    load('empty')
+
+    set_format('$uri')
+
+    # Long lines fill and flush several buffers in a row.
+
+    pad = 'x' * 8000
+
+    for i in range(40):
+        assert client.get(url=f'/{i}/{pad}')['status'] == 200
+
+    assert wait_for_record(fr'^\/39\/x+$', 'access.log') is not None, 'last'
+
+    with open(f'{temp_dir}/access.log', encoding='utf-8') as f:
+        lines = [line.split('/')[1] for line in f.read().splitlines()]
+
+    assert lines == [str(i) for i in range(40)], 'order'
+
+
 def test_access_log_variables(wait_for_record):
     load('mirror')
 
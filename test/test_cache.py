@@ -0,0 +1,381 @@
+import threading
+import time
+import zlib
+from http.server import BaseHTTPRequestHandler, HTTPServer
+from pathlib import Path
+
+import pytest
+
+from unit.applications.lang.python import ApplicationPython
+from unit.option import option
+
+prerequisites = {'modules': {'python': 'any'}}
+
+client = ApplicationPython()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    client.load('cache')
+
+    assert 'success' in client.conf(
+        [
+            {
+                "action": {
+                    "pass": "applications/cache",
+                    "cache": {"valid": 60},
+                }
+            }
+        ],
+        'routes',
+    ), 'cache routes'
+    assert 'success' in client.conf(
+        {"*:8080": {"pass": "routes"}}, 'listeners'
+    ), 'cache listeners'
+
+
+def set_cache(cache):
+    assert 'success' in client.conf(
+        cache, 'routes/0/action/cache'
+    ), 'configure cache'
+
+
+def get(url='/', headers=None, method='GET', **kwargs):
+    request_headers = {'Host': 'localhost', 'Connection': 'close'}
+
+    if headers is not None:
+        request_headers.update(headers)
+
+    return client.http(method, url=url, headers=request_headers, **kwargs)
+
+
+def get_concurrent(headers, n=3):
+    socks = []
+
+    for _ in range(n):
+        socks.append(get(headers=headers, no_recv=True))
+        time.sleep(0.1)
+
+    return [
+        client.recvall(sock).decode().split('\r\n\r\n', 1)[1]
+        for sock in socks
+    ]
+
+
+def test_cache():
+    resp = get()
+    assert resp['status'] == 200, 'miss status'
+    assert resp['body'] == '1', 'miss'
+    assert 'Age' not in resp['headers'], 'miss age'
+
+    resp = get()
+    assert resp['status'] == 200, 'hit status'
+    assert resp['body'] == '1', 'hit'
+    assert resp['headers']['Age'] == '0', 'hit age'
+    assert resp['headers']['Content-Length'] == '1', 'hit length'
+
+    assert get(url='/other')['body'] == '2', 'key'
+    assert get(url='/other')['body'] == '2', 'key hit'
+
+
+def test_cache_head():
+    resp = get(method='HEAD')
+    assert resp['status'] == 200, 'head miss'
+
+    assert get()['body'] == '2', 'head not stored'
+
+    resp = get(method='HEAD')
+    assert resp['headers']['Age'] == '0', 'head hit'
+    assert resp['body'] == '', 'head hit body'
+
+
+def test_cache_key():
+    set_cache({"key": "$header_x_key", "valid": 60})
+
+    assert get(headers={'X-Key': 'a'})['body'] == '1', 'key a'
+    assert get(headers={'X-Key': 'b'})['body'] == '2', 'key b'
+    assert get(headers={'X-Key': 'a'})['body'] == '1', 'key a hit'
+
+    assert get()['body'] == '3', 'empty key'
+    assert get()['body'] == '4', 'empty key bypass'
+
+
+def test_cache_control():
+    set_cache({})
+
+    assert get()['body'] == '1', 'no ttl'
+    assert get()['body'] == '2', 'no ttl bypass'
+
+    headers = {'X-Cache-Control': 'public, max-age=60'}
+
+    assert get(headers=headers)['body'] == '3', 'max-age'
+    assert get()['body'] == '3', 'max-age hit'
+
+    headers = {'X-Cache-Control': 'max-age=1'}
+
+    assert get('/expires', headers=headers)['body'] == '4', 'expires'
+    assert get('/expires')['body'] == '4', 'expires hit'
+
+    time.sleep(2)
+
+    assert get('/expires')['body'] == '5', 'expired'
+
+
+@pytest.mark.parametrize(
+    'headers',
+    [
+        {'X-Cache-Control': 'no-store'},
+        {'X-Cache-Control': 'private, max-age=60'},
+        {'X-Cache-Control': 's-maxage=0, max-age=60'},
+        {'X-Set-Cookie': 'a=b'},
+        {'X-Vary': 'Accept-Encoding'},
+        {'X-Status': '500'},
+        {'Authorization': 'Basic dXNlcjpwYXNz'},
+    ],
+)
+def test_cache_bypass(headers):
+    assert get(headers=headers)['body'] == '1', 'bypass'
+    assert get(headers=headers)['body'] == '2', 'bypass again'
+    assert get()['body'] == '3', 'not stored'
+
+
+def test_cache_size():
+    set_cache({"valid": 60, "size": 16})
+
+    headers = {'X-Cache-Control': 'max-age=60'}
+
+    assert get(headers=headers)['body'] == '1', 'too large'
+    assert get()['body'] == '2', 'too large not stored'
+
+
+def test_cache_reconfigure():
+    assert get()['body'] == '1', 'miss'
+    assert get()['body'] == '1', 'hit'
+
+    set_cache({"valid": 30})
+
+    assert get()['body'] == '2', 'reset'
+
+
+def test_cache_collapse():
+    set_cache({"collapse": True})
+
+    assert get_concurrent({'X-Delay': '1'}) == ['1', '1', '1'], 'collapsed'
+    assert get()['body'] == '2', 'not stored'
+
+    set_cache({"valid": 60, "collapse": True})
+
+    assert get_concurrent({'X-Delay': '1'}) == ['3', '3', '3'], 'stored'
+    assert get()['body'] == '3', 'hit'
+
+
+def test_cache_collapse_private():
+    set_cache({"collapse": True})
+
+    headers = {'X-Delay': '0.5', 'X-Cache-Control': 'private'}
+
+    assert sorted(get_concurrent(headers)) == ['1', '2', '3'], 'private'
+
+
+def test_cache_collapse_timeout():
+    set_cache({"valid": 60, "collapse": True, "collapse_timeout": 1})
+
+    headers = {'X-Delay': '2'}
+
+    assert sorted(get_concurrent(headers)) == ['1', '2', '3'], 'timeout'
+    assert get()['body'] == '1', 'leader stored'
+
+
+def test_cache_path(temp_dir):
+    set_cache({"valid": 60, "path": temp_dir})
+
+    headers = {'X-Length': '100000'}
+
+    resp = get(headers=headers)
+    assert resp['body'] == '1' + '.' * 100000, 'path miss'
+
+    resp = get()
+    assert resp['headers']['Age'] == '0', 'path hit'
+    assert resp['body'] == '1' + '.' * 100000, 'path hit body'
+
+    assert get(method='HEAD')['headers']['Content-Length'] == '100001', 'head'
+
+    assert not list(Path(temp_dir).glob('cache-*')), 'files unlinked'
+
+
+def test_cache_path_error(temp_dir, findall, skip_alert, wait_for_record):
+    skip_alert(r'mkstemp.*failed')
+    set_cache({"valid": 60, "path": f'{temp_dir}/nonexistent'})
+
+    headers = {'X-Length': '100000'}
+
+    for url in ['/a', '/b']:
+        body = get(url=url, headers=headers)['body']
+        assert get(url=url)['body'] == body, 'memory hit'
+
+    assert wait_for_record(r'cached in memory only'), 'alert'
+    assert len(findall(r'mkstemp.*failed')) == 1, 'single alert'
+
+
+def test_cache_path_compressed(temp_dir):
+    if not option.available['modules']['zlib']:
+        pytest.skip('requires zlib')
+
+    assert 'success' in client.conf(
+        {"http": {"compression": {"encodings": ["gzip"]}}}, 'settings'
+    ), 'compression'
+
+    set_cache({"valid": 60, "path": temp_dir})
+
+    headers = {'X-Length': '300000', 'Accept-Encoding': 'gzip'}
+
+    raw = get(headers=headers, raw_resp=True, encoding='latin1')
+    assert 'Content-Encoding: gzip' in raw, 'miss compressed'
+
+    raw = get(headers=headers, raw_resp=True, encoding='latin1')
+    assert 'Age: 0' in raw, 'hit'
+
+    body = raw.split('\r\n\r\n', 1)[1].encode('latin1')
+
+    if 'Transfer-Encoding: chunked' in raw:
+        chunks = b''
+
+        while body:
+            size, body = body.split(b'\r\n', 1)
+            size = int(size, 16)
+            chunks += body[:size]
+            body = body[size + 2 :]
+
+        body = chunks
+
+    assert zlib.decompress(body, 16 + zlib.MAX_WBITS) == (
+        b'1' + b'.' * 300000
+    ), 'hit body'
+
+
+def test_cache_revalidate():
+    set_cache({"valid": 1, "revalidate": True})
+
+    headers = {'X-ETag': '"a"'}
+
+    assert get(headers=headers)['body'] == '1', 'miss'
+
+    time.sleep(2)
+
+    resp = get(headers=headers)
+    assert resp['status'] == 200, 'revalidated status'
+    assert resp['body'] == '1', 'revalidated'
+    assert resp['headers']['ETag'] == '"a"', 'revalidated etag'
+
+    assert get()['body'] == '1', 'refreshed'
+
+    time.sleep(2)
+
+    headers = {'X-ETag': '"b"'}
+
+    assert get(headers=headers)['body'] == '3', 'modified'
+    assert get()['body'] == '3', 'modified hit'
+
+
+def test_cache_revalidate_conditional():
+    set_cache({"valid": 1, "revalidate": True})
+
+    assert get(headers={'X-ETag': '"a"'})['body'] == '1', 'miss'
+
+    time.sleep(2)
+
+    headers = {'X-ETag': '"a"', 'If-None-Match': '"a"'}
+
+    assert get(headers=headers)['status'] == 304, 'client conditional'
+
+
+def test_cache_stale():
+    set_cache({"valid": 1, "stale": 60})
+
+    assert get()['body'] == '1', 'miss'
+
+    time.sleep(2)
+
+    resp = get(headers={'X-Status': '503'})
+    assert resp['status'] == 200, 'stale status'
+    assert resp['body'] == '1', 'stale'
+
+    resp = get(headers={'X-Status': '404'})
+    assert resp['status'] == 404, 'not error'
+
+    set_cache({"valid": 1})
+
+    assert get()['body'] == '4', 'reset'
+
+    time.sleep(2)
+
+    assert get(headers={'X-Status': '503'})['status'] == 503, 'no stale'
+
+
+def test_cache_stale_proxy():
+    class Handler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            self.send_response(200)
+            self.send_header('Content-Length', '8')
+            self.end_headers()
+            self.wfile.write(b'upstream')
+
+        def log_message(self, *args):
+            pass
+
+    server = HTTPServer(('127.0.0.1', 8081), Handler)
+
+    assert 'success' in client.conf(
+        {
+            "proxy": "http://127.0.0.1:8081",
+            "cache": {"valid": 1, "stale": 60},
+        },
+        'routes/0/action',
+    ), 'proxy cache'
+
+    thread = threading.Thread(target=server.handle_request)
+    thread.start()
+
+    assert get()['body'] == 'upstream', 'miss'
+
+    thread.join()
+    server.server_close()
+
+    time.sleep(2)
+
+    resp = get()
+    assert resp['status'] == 200, 'stale status'
+    assert resp['body'] == 'upstream', 'stale'
+
+
+def test_cache_invalid():
+    def check_error(conf):
+        assert 'error' in client.conf(conf, 'routes/0/action/cache')
+
+    check_error({"valid": -1})
+    check_error({"size": 0})
+    check_error({"key": 1})
+    check_error({"collapse": 1})
+    check_error({"collapse_timeout": -1})
+    check_error({"stale": -1})
+    check_error({"path": 1})
+    check_error({"revalidate": 1})
+    check_error({"unknown": 1})
+
+
+def test_cache_static(temp_dir):
+    Path(f'{temp_dir}/index.html').write_text('0123456789', encoding='utf-8')
+
+    assert 'success' in client.conf(
+        {"share": f'{temp_dir}$uri', "cache": {"valid": 60}},
+        'routes/0/action',
+    ), 'static cache'
+
+    assert get('/index.html')['body'] == '0123456789', 'static miss'
+
+    Path(f'{temp_dir}/index.html').write_text('9876543210', encoding='utf-8')
+
+    resp = get('/index.html')
+    assert resp['body'] == '0123456789', 'static hit'
+    assert resp['headers']['Content-Type'] == 'text/html', 'static type'
+    assert 'ETag' in resp['headers'], 'static etag'
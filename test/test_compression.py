@@ -0,0 +1,310 @@
+import re
+import zlib
+from pathlib import Path
+
+import pytest
+
+from unit.applications.lang.python import ApplicationPython
+from unit.option import option
+
+prerequisites = {'modules': {'zlib': 'any', 'python': 'any'}}
+
+client = ApplicationPython()
+
+TEXT = 'The quick brown fox jumps over the lazy dog. ' * 6000
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(assets_dir).mkdir(parents=True)
+    Path(f'{assets_dir}/index.html').write_text(TEXT, encoding='utf-8')
+    Path(f'{assets_dir}/small.txt').write_text('0123456789', encoding='utf-8')
+    Path(f'{assets_dir}/image.png').write_bytes(TEXT.encode())
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": {"share": f'{assets_dir}$uri'}}],
+            "applications": {},
+            "settings": {
+                "http": {"compression": {"encodings": ["gzip", "deflate"]}}
+            },
+        }
+    )
+
+
+def get(url='/index.html', accept='gzip', method='GET'):
+    headers = {'Host': 'localhost', 'Connection': 'close'}
+
+    if accept is not None:
+        headers['Accept-Encoding'] = accept
+
+    raw = client.http(
+        method, url=url, headers=headers, encoding='latin1', raw_resp=True
+    )
+
+    head, body = raw.split('\r\n\r\n', 1)
+    body = body.encode('latin1')
+
+    lines = head.split('\r\n')
+    headers = {}
+
+    for line in lines[1:]:
+        name, value = line.split(': ', 1)
+        headers[name] = value
+
+    if headers.get('Transfer-Encoding') == 'chunked':
+        chunks = b''
+
+        while True:
+            size, body = body.split(b'\r\n', 1)
+            size = int(size, 16)
+
+            if size == 0:
+                break
+
+            chunks += body[:size]
+            body = body[size + 2 :]
+
+        body = chunks
+
+    return {
+        'status': int(lines[0].split(' ')[1]),
+        'headers': headers,
+        'body': body,
+    }
+
+
+def decompress(resp):
+    encoding = resp['headers'].get('Content-Encoding')
+
+    if encoding == 'gzip':
+        return zlib.decompress(resp['body'], zlib.MAX_WBITS + 16)
+
+    if encoding == 'deflate':
+        return zlib.decompress(resp['body'])
+
+    return resp['body']
+
+
+def check_compressed(resp, encoding='gzip', body=TEXT):
+    assert resp['status'] == 200, 'status'
+    assert resp['headers'].get('Content-Encoding') == encoding, 'encoding'
+    assert resp['headers'].get('Vary') == 'Accept-Encoding', 'vary'
+    assert 'Content-Length' not in resp['headers'], 'no length'
+    assert len(resp['body']) < len(body), 'compressed'
+    assert decompress(resp) == body.encode(), 'body'
+
+
+def check_not_compressed(resp, body=TEXT):
+    assert resp['status'] == 200, 'status'
+    assert 'Content-Encoding' not in resp['headers'], 'no encoding'
+    assert resp['headers']['Content-Length'] == str(len(body)), 'length'
+    assert resp['body'] == body.encode(), 'body'
+
+
+def set_compression(compression, path='settings/http/compression'):
+    assert 'success' in client.conf(compression, path)
+
+
+def test_compression_static():
+    resp = get()
+
+    check_compressed(resp)
+    assert resp['headers']['Transfer-Encoding'] == 'chunked', 'chunked'
+    assert resp['headers']['ETag'].startswith('W/"'), 'weak etag'
+    assert 'Accept-Ranges' not in resp['headers'], 'no ranges'
+
+    resp = get(accept=None)
+
+    check_not_compressed(resp)
+    assert resp['headers']['ETag'].startswith('"'), 'strong etag'
+
+    check_compressed(get(url='/index.html?0'), body=TEXT)
+
+    resp = get(method='HEAD')
+
+    assert 'Content-Encoding' not in resp['headers'], 'head'
+    assert resp['headers']['Content-Length'] == str(len(TEXT)), 'head length'
+
+
+def test_compression_accept_encoding():
+    check_compressed(get(accept='deflate'), 'deflate')
+    check_compressed(get(accept='GZip'), 'gzip')
+    check_compressed(get(accept='deflate, gzip'), 'gzip')
+    check_compressed(get(accept='gzip;q=0.5, deflate'), 'deflate')
+    check_compressed(get(accept='gzip; q=1, deflate;q=0.999'), 'gzip')
+    check_compressed(get(accept='*'), 'gzip')
+    check_compressed(get(accept='*;q=0.5, gzip;q=0.1'), 'deflate')
+    check_compressed(get(accept='identity, br, gzip'), 'gzip')
+
+    check_not_compressed(get(accept=''))
+    check_not_compressed(get(accept='identity'))
+    check_not_compressed(get(accept='gzip;q=0'))
+    check_not_compressed(get(accept='gzip;q=0.000, deflate;q=0'))
+    check_not_compressed(get(accept='*;q=0'))
+    check_not_compressed(get(accept='gzipped'))
+
+
+def test_compression_min_length():
+    check_not_compressed(get('/small.txt'), '0123456789')
+
+    set_compression({"min_length": 0})
+
+    resp = get('/small.txt')
+
+    assert resp['headers'].get('Content-Encoding') == 'gzip', 'small'
+    assert decompress(resp) == b'0123456789', 'small body'
+
+
+def test_compression_types():
+    check_not_compressed(get('/image.png'))
+
+    set_compression({"types": ["image/*", "!image/gif"]})
+
+    check_compressed(get('/image.png'))
+    check_not_compressed(get())
+
+    set_compression({"types": "text/html"})
+
+    check_compressed(get())
+
+
+def test_compression_action(temp_dir):
+    assert 'success' in client.conf(
+        [
+            {
+                "match": {"uri": "/off/*"},
+                "action": {
+                    "share": f'{temp_dir}/assets/index.html',
+                    "compression": False,
+                },
+            },
+            {
+                "match": {"uri": "/deflate/*"},
+                "action": {
+                    "share": f'{temp_dir}/assets/index.html',
+                    "compression": {"encodings": "deflate", "level": 9},
+                },
+            },
+            {"action": {"share": f'{temp_dir}/assets$uri'}},
+        ],
+        'routes',
+    )
+
+    check_not_compressed(get('/off/'))
+    check_compressed(get('/deflate/', accept='deflate'), 'deflate')
+    check_not_compressed(get('/deflate/'))
+    check_compressed(get(), 'gzip')
+
+    client.conf_delete('settings/http/compression')
+
+    check_not_compressed(get())
+    check_compressed(get('/deflate/', accept='deflate'), 'deflate')
+
+    assert 'success' in client.conf(
+        'true', 'routes/2/action/compression'
+    ), 'compression true'
+
+    check_compressed(get(), 'gzip')
+    check_not_compressed(get(accept='deflate'))
+
+
+def test_compression_application():
+    client.load('delayed')
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [
+                {
+                    "action": {
+                        "pass": "applications/delayed",
+                        "response_headers": {"Content-Type": "text/plain"},
+                    }
+                }
+            ],
+            "applications": client.conf_get('applications'),
+            "settings": {"http": {"compression": {}}},
+        }
+    )
+
+    body = TEXT[:100000]
+
+    def post(parts, accept='gzip'):
+        raw = client.post(
+            headers={
+                'Host': 'localhost',
+                'Accept-Encoding': accept,
+                'X-Parts': str(parts),
+                'Connection': 'close',
+            },
+            body=body,
+            encoding='latin1',
+            raw_resp=True,
+        )
+
+        return re.search(r'Content-Encoding: (\w+)', raw), raw
+
+    for parts in (1, 10, 100):
+        encoding, raw = post(parts)
+        assert encoding is not None and encoding.group(1) == 'gzip', parts
+
+        head, data = raw.split('\r\n\r\n', 1)
+        assert 'Content-Length' not in head, 'no length'
+
+        chunks = b''
+        data = data.encode('latin1')
+
+        while True:
+            size, data = data.split(b'\r\n', 1)
+            size = int(size, 16)
+
+            if size == 0:
+                break
+
+            chunks += data[:size]
+            data = data[size + 2 :]
+
+        assert zlib.decompress(chunks, zlib.MAX_WBITS + 16) == body.encode()
+
+    encoding, raw = post(1, accept='br')
+    assert encoding is None, 'not accepted'
+    assert f'Content-Length: {len(body)}' in raw, 'length'
+
+
+@pytest.mark.skipif(
+    not option.available['modules'].get('brotli'),
+    reason='Unit is built without brotli',
+)
+def test_compression_brotli():
+    set_compression({"encodings": ["br", "gzip"], "level": 5})
+
+    resp = get(accept='gzip, br')
+
+    assert resp['headers']['Content-Encoding'] == 'br', 'br'
+    assert len(resp['body']) < len(TEXT), 'br compressed'
+
+    check_compressed(get(), 'gzip')
+
+
+def test_compression_invalid():
+    def check_error(compression, path='settings/http/compression'):
+        assert 'error' in client.conf(compression, path), 'invalid'
+
+    check_error('true')
+    check_error({"encodings": []})
+    check_error({"encodings": ["gzip", "gzip"]})
+    check_error({"encodings": ["identity"]})
+    check_error({"encodings": [1]})
+    check_error({"encodings": "compress"})
+    check_error({"level": 0})
+    check_error({"level": 10})
+    check_error({"level": "1"})
+    check_error({"min_length": -1})
+    check_error({"types": ["text/*", 1]})
+    check_error({"blah": 1})
+    check_error('"gzip"', 'routes/0/action/compression')
+    check_error({"level": 0}, 'routes/0/action/compression')
@@ -0,0 +1,126 @@
+import json
+import struct
+import time
+from pathlib import Path
+
+from conftest import unit_run, unit_stop
+from unit.applications.tls import ApplicationTLS
+
+prerequisites = {'modules': {'openssl': 'any'}}
+
+client = ApplicationTLS()
+
+
+def restart(temp_dir):
+    unit_stop()
+    unit_run(state_dir=f'{temp_dir}/state')
+
+
+def snapshot_valid(temp_dir):
+    conf_json = Path(f'{temp_dir}/state/conf.json')
+    conf_bin = Path(f'{temp_dir}/state/conf.bin')
+
+    try:
+        header = conf_bin.read_bytes()[:48]
+        st = conf_json.stat()
+
+    except FileNotFoundError:
+        return False
+
+    if len(header) != 48:
+        return False
+
+    magic, _, _, _, _, size, ino, mtime = struct.unpack('=IIIIQQQq', header)
+
+    return (
+        magic == 0x4E584331
+        and size == st.st_size
+        and ino == st.st_ino
+        and mtime == int(st.st_mtime)
+    )
+
+
+def wait_for_store(temp_dir):
+    conf_json = Path(f'{temp_dir}/state/conf.json')
+
+    for _ in range(50):
+        try:
+            conf = json.loads(conf_json.read_text(encoding='utf-8'))
+
+        except ValueError:
+            conf = {}
+
+        if 'routes' in conf and snapshot_valid(temp_dir):
+            return
+
+        time.sleep(0.1)
+
+    assert False, 'configuration stored'
+
+
+def setup_conf(temp_dir):
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {"pass": "routes"},
+                "*:8081": {"pass": "routes", "tls": {"certificate": "default"}},
+            },
+            "routes": [{"action": {"return": 201}}],
+            "applications": {},
+        }
+    )
+
+    wait_for_store(temp_dir)
+
+
+def test_snapshot_restore(temp_dir):
+    client.certificate()
+    setup_conf(temp_dir)
+
+    conf = client.conf_get()
+    cert = client.conf_get('/certificates/default')
+
+    restart(temp_dir)
+
+    assert client.conf_get() == conf, 'configuration restored'
+    assert client.conf_get('/certificates/default') == cert, 'certificate'
+    assert client.get()['status'] == 201
+    assert client.get_ssl(port=8081)['status'] == 201
+
+
+def test_snapshot_outdated(temp_dir):
+    client.certificate()
+    setup_conf(temp_dir)
+
+    conf_json = Path(f'{temp_dir}/state/conf.json')
+
+    conf = json.loads(conf_json.read_text(encoding='utf-8'))
+    conf['routes'][0]['action']['return'] = 202
+    conf['routes'].append({"action": {"return": 203}})
+    conf_json.write_text(json.dumps(conf), encoding='utf-8')
+
+    assert not snapshot_valid(temp_dir), 'snapshot outdated'
+
+    restart(temp_dir)
+
+    assert client.conf_get('routes/0/action/return') == 202, 'source changed'
+    assert client.get()['status'] == 202
+    assert client.get_ssl(port=8081)['status'] == 202
+
+
+def test_snapshot_corrupted(temp_dir, wait_for_record):
+    client.certificate()
+    setup_conf(temp_dir)
+
+    conf_bin = Path(f'{temp_dir}/state/conf.bin')
+
+    data = bytearray(conf_bin.read_bytes())
+    data[-1] ^= 0xFF
+    conf_bin.write_bytes(data)
+
+    restart(temp_dir)
+
+    assert wait_for_record(r'configuration snapshot is corrupted')
+    assert client.conf_get('routes/0/action/return') == 201
+    assert client.get()['status'] == 201
+    assert client.get_ssl(port=8081)['status'] == 201
@@ -0,0 +1,102 @@
+import time
+
+import pytest
+
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": {"return": 200}}],
+            "applications": {},
+        }
+    )
+
+
+def stage(conf, path):
+    return client.conf(conf, f'/transaction/config/{path}')
+
+
+def test_transaction_commit():
+    assert 'success' in stage('201', 'routes/0/action/return')
+    assert 'success' in client.conf_post(
+        {"action": {"return": 202}}, '/transaction/config/routes'
+    )
+
+    return_path = '/transaction/config/routes/0/action/return'
+    assert client.conf_get(return_path) == 201
+    assert client.conf_get('/config/routes/0/action/return') == 200
+    assert client.get()['status'] == 200, 'not applied'
+
+    assert 'success' in client.conf_post({}, '/transaction/commit')
+
+    assert client.conf_get('/config/routes/0/action/return') == 201
+    assert len(client.conf_get('/config/routes')) == 2
+    assert client.get()['status'] == 201, 'applied'
+
+    assert 'error' in client.conf_post({}, '/transaction/commit'), 'no changes'
+
+
+def test_transaction_invalid():
+    assert 'success' in stage('"missing"', 'listeners/*:8080/pass')
+
+    resp = client.conf_post({}, '/transaction/commit')
+    assert resp['error'] == 'Invalid configuration.'
+
+    pass_path = '/transaction/config/listeners/*:8080/pass'
+    assert client.conf_get(pass_path) == 'missing'
+
+    assert 'success' in stage('"routes"', 'listeners/*:8080/pass')
+    assert 'success' in client.conf_post({}, '/transaction/commit')
+    assert client.get()['status'] == 200
+
+
+def test_transaction_conflict():
+    assert 'success' in stage('201', 'routes/0/action/return')
+    assert 'success' in client.conf('203', 'routes/0/action/return')
+
+    resp = client.conf_post({}, '/transaction/commit')
+    assert 'error' in resp, 'conflict'
+    assert client.get()['status'] == 203
+
+    assert 'error' in client.conf_delete('/transaction'), 'discarded'
+
+
+def test_transaction_discard():
+    assert 'success' in stage('201', 'routes/0/action/return')
+    assert 'success' in client.conf_delete('/transaction')
+
+    return_path = '/transaction/config/routes/0/action/return'
+    assert client.conf_get(return_path) == 200
+    assert 'error' in client.conf_post({}, '/transaction/commit')
+    assert client.get()['status'] == 200
+
+
+def test_transaction_debounce():
+    assert 'success' in client.conf({"control": {"debounce": 1}}, 'settings')
+
+    time.sleep(1.5)
+
+    for status in range(201, 206):
+        resp = client.conf(str(status), 'routes/0/action/return')
+        assert resp['success'] == 'Reconfiguration scheduled.'
+
+    assert client.conf_get('routes/0/action/return') == 205
+    assert client.get()['status'] == 200, 'not applied yet'
+
+    time.sleep(1.5)
+
+    assert client.get()['status'] == 205, 'applied'
+
+    assert 'success' in client.conf('0', 'settings/control/debounce')
+    assert client.get()['status'] == 205
+
+
+def test_transaction_debounce_invalid():
+    assert 'error' in client.conf({"control": {"debounce": -1}}, 'settings')
+    assert 'error' in client.conf({"control": {"debounce": 61}}, 'settings')
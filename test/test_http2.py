@@ -0,0 +1,531 @@
+import socket
+import ssl
+import struct
+from pathlib import Path
+
+import pytest
+
+from unit.applications.tls import ApplicationTLS
+from unit.option import option
+
+client = ApplicationTLS()
+
+PREFACE = b'PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n'
+
+DATA = 0x0
+HEADERS = 0x1
+RST_STREAM = 0x3
+SETTINGS = 0x4
+PING = 0x6
+GOAWAY = 0x7
+WINDOW_UPDATE = 0x8
+
+END_STREAM = 0x1
+ACK = 0x1
+END_HEADERS = 0x4
+
+STATUSES = {8: 200, 9: 204, 10: 206, 11: 304, 12: 400, 13: 404, 14: 500}
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(assets_dir).mkdir()
+    Path(f'{assets_dir}/index.html').write_text('0123456789')
+    Path(f'{assets_dir}/big').write_bytes(bytes(range(256)) * 1024)
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {"pass": "routes", "http2": True},
+                "*:8081": {"pass": "routes"},
+            },
+            "routes": [
+                {
+                    "match": {"uri": "/return"},
+                    "action": {"return": 200},
+                },
+                {"action": {"share": f'{assets_dir}$uri'}},
+            ],
+            "applications": {},
+        }
+    )
+
+
+def frame(ftype, flags, stream_id, payload=b''):
+    return (
+        struct.pack('>I', len(payload))[1:]
+        + struct.pack('>BBI', ftype, flags, stream_id)
+        + payload
+    )
+
+
+def hpack_literal(name, value):
+    name = name.encode()
+    value = value.encode()
+
+    return bytes([0, len(name)]) + name + bytes([len(value)]) + value
+
+
+def request_headers(method='GET', path='/return', headers=None):
+    block = (
+        hpack_literal(':method', method)
+        + hpack_literal(':scheme', 'http')
+        + hpack_literal(':path', path)
+        + hpack_literal(':authority', 'localhost')
+    )
+
+    for name, value in (headers or {}).items():
+        block += hpack_literal(name, value)
+
+    return block
+
+
+def hpack_int(data, pos, prefix):
+    mask = (1 << prefix) - 1
+    value = data[pos] & mask
+    pos += 1
+
+    if value == mask:
+        shift = 0
+
+        while True:
+            value += (data[pos] & 0x7F) << shift
+            shift += 7
+            pos += 1
+
+            if not data[pos - 1] & 0x80:
+                break
+
+    return value, pos
+
+
+def hpack_string(data, pos):
+    assert not data[pos] & 0x80, 'no huffman'
+
+    length, pos = hpack_int(data, pos, 7)
+
+    return data[pos : pos + length].decode(), pos + length
+
+
+def response_headers(block):
+    headers = {}
+    pos = 0
+
+    while pos < len(block):
+        if block[pos] & 0x80:
+            index, pos = hpack_int(block, pos, 7)
+            headers[':status'] = STATUSES[index]
+            continue
+
+        assert block[pos] & 0xF0 == 0, 'literal without indexing'
+
+        index, pos = hpack_int(block, pos, 4)
+
+        if index == 0:
+            name, pos = hpack_string(block, pos)
+        elif index == 8:
+            name = ':status'
+        else:
+            name = index
+
+        value, pos = hpack_string(block, pos)
+
+        headers[name] = int(value) if name == ':status' else value
+
+    return headers
+
+
+def connect(port=8080, wrapper=None):
+    sock = socket.create_connection(('127.0.0.1', port))
+
+    if wrapper is not None:
+        sock = wrapper(sock)
+
+    sock.settimeout(10)
+    sock.sendall(PREFACE + frame(SETTINGS, 0, 0))
+
+    return sock
+
+
+def recv_exact(sock, size):
+    data = b''
+
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        assert chunk, 'connection closed'
+        data += chunk
+
+    return data
+
+
+def recv_frame(sock):
+    header = recv_exact(sock, 9)
+    length = struct.unpack('>I', b'\x00' + header[:3])[0]
+    ftype, flags, stream_id = struct.unpack('>BBI', header[3:])
+
+    return ftype, flags, stream_id & 0x7FFFFFFF, recv_exact(sock, length)
+
+
+def read_responses(sock, streams=1, window_update=False):
+    responses = {}
+    done = 0
+
+    while done < streams:
+        ftype, flags, stream_id, payload = recv_frame(sock)
+
+        if ftype == SETTINGS and not flags & ACK:
+            sock.sendall(frame(SETTINGS, ACK, 0))
+            continue
+
+        if ftype == RST_STREAM:
+            resp = responses.setdefault(stream_id, {})
+            resp['reset'] = struct.unpack('>I', payload)[0]
+            done += 1
+            continue
+
+        if ftype == GOAWAY:
+            break
+
+        if ftype not in (HEADERS, DATA):
+            continue
+
+        resp = responses.setdefault(stream_id, {'body': b''})
+
+        if ftype == HEADERS:
+            assert flags & END_HEADERS, 'single headers frame'
+            resp['headers'] = response_headers(payload)
+
+        else:
+            resp['body'] += payload
+
+            if window_update and payload:
+                increment = struct.pack('>I', len(payload))
+                sock.sendall(
+                    frame(WINDOW_UPDATE, 0, 0, increment)
+                    + frame(WINDOW_UPDATE, 0, stream_id, increment)
+                )
+
+        if flags & END_STREAM:
+            done += 1
+
+    return responses
+
+
+def get(path='/return', stream_id=1, sock=None, **kwargs):
+    conn = sock or connect()
+    conn.sendall(
+        frame(
+            HEADERS,
+            END_STREAM | END_HEADERS,
+            stream_id,
+            request_headers(path=path),
+        )
+    )
+
+    resp = read_responses(conn, **kwargs)[stream_id]
+
+    if sock is None:
+        conn.close()
+
+    return resp
+
+
+def test_http2_get():
+    resp = get()
+
+    assert resp['headers'][':status'] == 200, 'status'
+    assert resp['body'] == b'', 'body'
+
+
+def test_http2_static():
+    resp = get('/index.html')
+
+    assert resp['headers'][':status'] == 200, 'status'
+    assert resp['body'] == b'0123456789', 'body'
+
+    assert get('/blah')['headers'][':status'] == 404, 'not found'
+
+
+def test_http2_static_flow_control():
+    resp = get('/big', window_update=True)
+
+    assert resp['headers'][':status'] == 200, 'status'
+    assert resp['body'] == bytes(range(256)) * 1024, 'body'
+
+
+def test_http2_huffman():
+    sock = connect()
+
+    # RFC 7541, C.4.1: GET http://www.example.com/
+    block = bytes.fromhex('828684418cf1e3c2e5f23a6ba0ab90f4ff')
+
+    sock.sendall(frame(HEADERS, END_STREAM | END_HEADERS, 1, block))
+    resp = read_responses(sock)[1]
+
+    assert resp['headers'][':status'] == 200, 'huffman'
+
+    # RFC 7541, C.4.2: the ":authority" field is from the dynamic table.
+    block = bytes.fromhex('828684be5886a8eb10649cbf')
+
+    sock.sendall(frame(HEADERS, END_STREAM | END_HEADERS, 3, block))
+    resp = read_responses(sock)[3]
+
+    assert resp['headers'][':status'] == 200, 'dynamic table'
+
+    sock.close()
+
+
+def test_http2_multiple_streams():
+    sock = connect()
+
+    sock.sendall(
+        b''.join(
+            frame(HEADERS, END_STREAM | END_HEADERS, i, request_headers())
+            for i in (1, 3, 5)
+        )
+    )
+
+    responses = read_responses(sock, streams=3)
+
+    for i in (1, 3, 5):
+        assert responses[i]['headers'][':status'] == 200, f'stream {i}'
+
+    sock.close()
+
+
+def test_http2_keepalive():
+    sock = connect()
+
+    for i in (1, 3, 5):
+        assert get(stream_id=i, sock=sock)['headers'][':status'] == 200
+
+    sock.close()
+
+
+def test_http2_reset():
+    sock = connect()
+
+    sock.sendall(
+        frame(
+            HEADERS,
+            END_STREAM | END_HEADERS,
+            1,
+            request_headers(path='/big'),
+        )
+    )
+
+    while True:
+        ftype, _, _, _ = recv_frame(sock)
+
+        if ftype == HEADERS:
+            break
+
+    sock.sendall(frame(RST_STREAM, 0, 1, struct.pack('>I', 0x8)))
+
+    assert get(stream_id=3, sock=sock)['headers'][':status'] == 200, 'next'
+
+    sock.close()
+
+
+def test_http2_close():
+    sock = connect()
+
+    sock.sendall(
+        frame(
+            HEADERS,
+            END_STREAM | END_HEADERS,
+            1,
+            request_headers(path='/big'),
+        )
+        + frame(HEADERS, END_HEADERS, 3, request_headers('POST'))
+        + frame(DATA, 0, 3, b'blah')
+    )
+
+    while True:
+        ftype, _, _, _ = recv_frame(sock)
+
+        if ftype == DATA:
+            break
+
+    sock.close()
+
+    assert get()['headers'][':status'] == 200, 'new connection'
+
+
+def test_http2_body():
+    sock = connect()
+
+    sock.sendall(
+        frame(
+            HEADERS,
+            END_HEADERS,
+            1,
+            request_headers('POST', headers={'content-length': '10'}),
+        )
+        + frame(DATA, 0, 1, b'01234')
+        + frame(DATA, END_STREAM, 1, b'56789')
+    )
+
+    assert read_responses(sock)[1]['headers'][':status'] == 200, 'body'
+
+    sock.sendall(
+        frame(
+            HEADERS,
+            END_HEADERS,
+            3,
+            request_headers('POST', headers={'content-length': '10'}),
+        )
+        + frame(DATA, END_STREAM, 3, b'01234')
+    )
+
+    assert read_responses(sock)[3]['headers'][':status'] == 400, 'short'
+
+    sock.close()
+
+
+def test_http2_application(require):
+    require({'modules': {'python': 'any'}})
+
+    assert 'success' in client.conf(
+        {
+            "mirror": {
+                "type": "python",
+                "processes": {"spare": 0},
+                "path": f'{option.test_dir}/python/mirror',
+                "working_directory": f'{option.test_dir}/python/mirror',
+                "module": "wsgi",
+            }
+        },
+        'applications',
+    )
+    assert 'success' in client.conf(
+        {"pass": "applications/mirror"}, 'routes/0/action'
+    )
+
+    body = bytes(range(256)) * 200
+
+    data = b''.join(
+        frame(DATA, 0, 1, body[i : i + 16384])
+        for i in range(0, len(body), 16384)
+    )
+
+    sock = connect()
+
+    sock.sendall(
+        frame(HEADERS, END_HEADERS, 1, request_headers('POST'))
+        + data
+        + frame(DATA, END_STREAM, 1)
+    )
+
+    resp = read_responses(sock)[1]
+
+    assert resp['headers'][':status'] == 200, 'status'
+    assert resp['body'] == body, 'body'
+
+    sock.sendall(
+        frame(HEADERS, END_STREAM | END_HEADERS, 3, request_headers())
+        + frame(RST_STREAM, 0, 3, struct.pack('>I', 0x8))
+    )
+
+    assert get(stream_id=5, sock=sock)['headers'][':status'] == 200, 'reset'
+
+    sock.close()
+
+
+def test_http2_bad_request():
+    sock = connect()
+
+    block = hpack_literal(':method', 'GET') + hpack_literal(':scheme', 'http')
+
+    sock.sendall(frame(HEADERS, END_STREAM | END_HEADERS, 1, block))
+
+    assert read_responses(sock)[1]['headers'][':status'] == 400, 'no path'
+
+    block = request_headers(headers={'X-Upper': 'blah'})
+
+    sock.sendall(frame(HEADERS, END_STREAM | END_HEADERS, 3, block))
+
+    assert read_responses(sock)[3]['headers'][':status'] == 400, 'uppercase'
+
+    sock.close()
+
+
+def test_http2_ping():
+    sock = connect()
+
+    sock.sendall(frame(PING, 0, 0, b'12345678'))
+
+    while True:
+        ftype, flags, _, payload = recv_frame(sock)
+
+        if ftype == PING:
+            break
+
+    assert flags & ACK, 'ack'
+    assert payload == b'12345678', 'payload'
+
+    sock.close()
+
+
+def test_http2_protocol_error():
+    sock = connect()
+
+    sock.sendall(frame(HEADERS, END_STREAM | END_HEADERS, 2, b''))
+
+    while True:
+        ftype, _, _, payload = recv_frame(sock)
+
+        if ftype == GOAWAY:
+            break
+
+    assert struct.unpack('>I', payload[4:8])[0] == 0x1, 'protocol error'
+
+    sock.close()
+
+
+def test_http2_disabled():
+    sock = connect(port=8081)
+
+    assert sock.recv(1024).startswith(b'HTTP/1.1 400'), 'disabled'
+
+    sock.close()
+
+
+def test_http2_http1():
+    assert client.get(url='/return')['status'] == 200, 'HTTP/1.1'
+
+
+def test_http2_tls(require):
+    require({'modules': {'openssl': 'any'}})
+
+    client.certificate()
+
+    assert 'success' in client.conf(
+        {"pass": "routes", "http2": True, "tls": {"certificate": "default"}},
+        'listeners/*:8080',
+    )
+
+    context = ssl.create_default_context()
+    context.check_hostname = False
+    context.verify_mode = ssl.CERT_NONE
+    context.set_alpn_protocols(['h2', 'http/1.1'])
+
+    sock = connect(wrapper=context.wrap_socket)
+
+    assert sock.selected_alpn_protocol() == 'h2', 'alpn'
+
+    resp = get('/index.html', sock=sock)
+
+    assert resp['headers'][':status'] == 200, 'status'
+    assert resp['body'] == b'0123456789', 'body'
+
+    sock.close()
+
+
+def test_http2_configuration():
+    assert 'error' in client.conf('"yes"', 'listeners/*:8080/http2')
+    assert 'success' in client.conf('false', 'listeners/*:8080/http2')
+
+    assert client.get(url='/return')['status'] == 200, 'HTTP/1.1'
@@ -0,0 +1,106 @@
+import os
+from pathlib import Path
+
+import pytest
+
+from conftest import pid_by_name, unit_run, unit_stop
+from unit.applications.lang.python import ApplicationPython
+from unit.option import option
+
+prerequisites = {
+    'modules': {'python': 'any'},
+    'features': {'io_uring': True},
+}
+
+client = ApplicationPython()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    if not option.restart:
+        pytest.skip('no restart mode')
+
+    unit_stop()
+    unit_run(engine='io_uring')
+
+    python_dir = f'{option.test_dir}/python'
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {"pass": "applications/mirror"},
+                "*:8081": {"pass": "routes"},
+            },
+            "routes": [{"action": {"proxy": "http://127.0.0.1:8080"}}],
+            "applications": {
+                "mirror": {
+                    "type": client.get_application_type(),
+                    "processes": {"spare": 0},
+                    "path": f'{python_dir}/mirror',
+                    "working_directory": f'{python_dir}/mirror',
+                    "module": "wsgi",
+                }
+            },
+        }
+    ), 'io_uring configuration'
+
+
+def post(body, port=8080, **kwargs):
+    return client.post(
+        headers={
+            'Host': 'localhost',
+            'Content-Type': 'text/html',
+            'Connection': 'close',
+        },
+        port=port,
+        body=body,
+        **kwargs,
+    )
+
+
+def test_io_uring_engine():
+    router = pid_by_name('unit: router')
+
+    fds = [os.readlink(fd) for fd in Path(f'/proc/{router}/fd').iterdir()]
+
+    assert 'anon_inode:[io_uring]' in fds, 'router engine'
+
+
+def test_io_uring_http():
+    assert client.get()['status'] == 200, 'get'
+    assert post('0123456789')['body'] == '0123456789', 'post'
+
+    body = '0123456789' * 100000
+
+    assert post(body, read_buffer_size=1048576)['body'] == body, 'large body'
+
+    kwargs = {}
+
+    for i in range(3):
+        (resp, kwargs['sock']) = client.post(
+            headers={'Host': 'localhost', 'Content-Type': 'text/html'},
+            body=f'keepalive {i}',
+            start=True,
+            read_timeout=1,
+            **kwargs,
+        )
+
+        assert resp['body'] == f'keepalive {i}', 'keepalive'
+
+    kwargs['sock'].close()
+
+
+def test_io_uring_proxy():
+    assert post('0123456789', port=8081)['body'] == '0123456789', 'proxy'
+
+    body = '0123456789' * 100000
+
+    resp = post(body, port=8081, read_buffer_size=1048576)
+    assert resp['body'] == body, 'proxy large body'
+
+    socks = [post(f'{i}', port=8081, no_recv=True) for i in range(10)]
+
+    for i, sock in enumerate(socks):
+        resp = client.recvall(sock).decode()
+        sock.close()
+
+        assert resp.endswith(f'\r\n\r\n{i}'), 'proxy parallel'
@@ -0,0 +1,157 @@
+import socket
+import time
+
+import pytest
+
+from unit.applications.lang.python import ApplicationPython
+
+prerequisites = {'modules': {'python': 'any'}}
+
+client = ApplicationPython()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    client.load('delayed')
+
+    assert 'success' in client.conf(
+        [
+            {
+                "action": {
+                    "pass": "applications/delayed",
+                    "limit_concurrency": {
+                        "key": "$remote_addr",
+                        "requests": 1,
+                    },
+                }
+            }
+        ],
+        'routes',
+    ), 'routes'
+
+    assert 'success' in client.conf(
+        {
+            "*:8080": {"pass": "routes"},
+            "*:8081": {"pass": "routes", "limit_connections": 2},
+        },
+        'listeners',
+    ), 'listeners'
+
+
+def connect(port=8081):
+    sock = socket.create_connection(('127.0.0.1', port))
+    sock.settimeout(1)
+
+    # The listen socket defers accept until the first data.
+    sock.sendall(b'GET / HTTP/1.1\r\n')
+
+    return sock
+
+
+def is_closed(sock):
+    try:
+        return sock.recv(1) == b''
+
+    except TimeoutError:
+        return False
+
+    except ConnectionResetError:
+        return True
+
+
+def get_delayed(delay=2):
+    (_, sock) = client.get(
+        headers={
+            'Host': 'localhost',
+            'X-Delay': str(delay),
+            'Connection': 'close',
+        },
+        start=True,
+        read_timeout=0.5,
+    )
+
+    return sock
+
+
+def test_limit_connections():
+    socks = [connect(), connect()]
+
+    assert not is_closed(socks[0]), 'first'
+    assert not is_closed(socks[1]), 'second'
+
+    sock = connect()
+    assert is_closed(sock), 'limited'
+    sock.close()
+
+    assert client.get(port=8080)['status'] == 200, 'other listener'
+
+    socks.pop().close()
+    time.sleep(0.2)
+
+    socks.append(connect())
+    assert not is_closed(socks[-1]), 'released'
+
+    for sock in socks:
+        sock.close()
+
+
+def test_limit_connections_keepalive():
+    socks = [connect(), connect()]
+
+    for sock in socks:
+        sock.close()
+
+    time.sleep(0.2)
+
+    assert client.get(port=8081)['status'] == 200, 'closed released'
+
+
+def test_limit_concurrency():
+    sock = get_delayed()
+
+    assert client.get()['status'] == 429, 'limited'
+
+    sock.close()
+    time.sleep(2)
+
+    assert client.get()['status'] == 200, 'released'
+    assert client.get()['status'] == 200, 'sequential'
+
+
+def test_limit_concurrency_key():
+    assert 'success' in client.conf(
+        {"key": "$arg_id", "requests": 1, "status": 503},
+        'routes/0/action/limit_concurrency',
+    )
+
+    (_, sock) = client.get(
+        url='/?id=1',
+        headers={'Host': 'localhost', 'X-Delay': '2', 'Connection': 'close'},
+        start=True,
+        read_timeout=0.5,
+    )
+
+    assert client.get(url='/?id=1')['status'] == 503, 'same key'
+    assert client.get(url='/?id=2')['status'] == 200, 'other key'
+    assert client.get()['status'] == 200, 'empty key'
+
+    sock.close()
+    time.sleep(2)
+
+
+def test_limit_connections_invalid():
+    def check_error(conf, path):
+        assert 'error' in client.conf(conf, path)
+
+    check_error('0', 'listeners/*:8081/limit_connections')
+    check_error('-1', 'listeners/*:8081/limit_connections')
+    check_error('1.5', 'listeners/*:8081/limit_connections')
+    check_error('"1"', 'listeners/*:8081/limit_connections')
+
+    path = 'routes/0/action/limit_concurrency'
+
+    check_error({"requests": 1}, path)
+    check_error({"key": "$remote_addr"}, path)
+    check_error({"key": "$remote_addr", "requests": 0}, path)
+    check_error({"key": "$remote_addr", "requests": 1, "status": 200}, path)
+    check_error({"key": "$remote_addr", "requests": 1, "rate": 1}, path)
@@ -0,0 +1,111 @@
+import time
+
+import pytest
+
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [
+                {
+                    "action": {
+                        "return": 200,
+                        "limit_requests": {
+                            "key": "$remote_addr",
+                            "rate": 1,
+                        },
+                    }
+                }
+            ],
+            "applications": {},
+        }
+    ), 'limit requests configuration'
+
+
+def set_limit(limit):
+    assert 'success' in client.conf(
+        limit, 'routes/0/action/limit_requests'
+    ), 'configure limit'
+
+
+def get_statuses(req=5, url='/'):
+    return [client.get(url=url)['status'] for _ in range(req)]
+
+
+def test_limit_requests():
+    assert get_statuses(3) == [200, 429, 429], 'limited'
+
+
+def test_limit_requests_burst():
+    set_limit({"key": "$remote_addr", "rate": 1, "burst": 2})
+
+    assert get_statuses() == [200, 200, 200, 429, 429], 'burst'
+
+
+def test_limit_requests_rate():
+    set_limit({"key": "$remote_addr", "rate": 5})
+
+    assert get_statuses(2) == [200, 429], 'limited'
+
+    time.sleep(0.3)
+
+    assert get_statuses(2) == [200, 429], 'recovered'
+
+
+def test_limit_requests_key():
+    set_limit({"key": "$arg_id", "rate": 1})
+
+    assert get_statuses(2, url='/?id=1') == [200, 429], 'first key'
+    assert get_statuses(2, url='/?id=2') == [200, 429], 'second key'
+
+    assert get_statuses(3) == [200, 200, 200], 'empty key'
+
+
+def test_limit_requests_status():
+    set_limit({"key": "$remote_addr", "rate": 1, "status": 503})
+
+    assert get_statuses(2) == [200, 503], 'status'
+
+
+def test_limit_requests_delay():
+    set_limit({"key": "$remote_addr", "rate": 5, "burst": 5, "delay": True})
+
+    start = time.monotonic()
+
+    assert get_statuses(4) == [200, 200, 200, 200], 'delayed'
+
+    assert time.monotonic() - start > 0.5, 'delay'
+
+
+def test_limit_requests_reconfigure():
+    assert get_statuses(2) == [200, 429], 'limited'
+
+    set_limit({"key": "$remote_addr", "rate": 1, "burst": 1})
+
+    assert get_statuses(3) == [200, 200, 429], 'new configuration'
+
+
+def test_limit_requests_invalid():
+    def check_limit(limit):
+        assert 'error' in client.conf(
+            limit, 'routes/0/action/limit_requests'
+        ), 'invalid limit'
+
+    check_limit({"rate": 1})
+    check_limit({"key": "$remote_addr"})
+    check_limit({"key": "$blah", "rate": 1})
+    check_limit({"key": "$remote_addr", "rate": 0})
+    check_limit({"key": "$remote_addr", "rate": -1})
+    check_limit({"key": "$remote_addr", "rate": "1r/s"})
+    check_limit({"key": "$remote_addr", "rate": 1, "burst": -1})
+    check_limit({"key": "$remote_addr", "rate": 1, "burst": 1.5})
+    check_limit({"key": "$remote_addr", "rate": 1, "status": 200})
+    check_limit({"key": "$remote_addr", "rate": 1, "delay": 1})
+    check_limit({"key": "$remote_addr", "rate": 1, "blah": 1})
+    check_limit('"$remote_addr"')
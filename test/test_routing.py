@@ -138,6 +138,78 @@ def test_routes_match_empty_exact():
     assert client.get(url='/blah')['status'] == 404
 
 
+def test_routes_match_many():
+    routes = [
+        {"match": {"uri": "/a", "method": "POST"}, "action": {"return": 201}},
+        {"match": {"uri": ["/b*", "!/bb"]}, "action": {"return": 202}},
+        {"match": {"uri": "/a"}, "action": {"return": 203}},
+        {
+            "match": {"uri": "/c", "host": "example.com"},
+            "action": {"return": 204},
+        },
+        {"match": {"uri": "*.jpg"}, "action": {"return": 205}},
+        {"match": {"method": "PUT"}, "action": {"return": 206}},
+    ]
+
+    for i in range(20):
+        routes.append(
+            {"match": {"uri": f'/route/{i}'}, "action": {"return": 220 + i}}
+        )
+
+    routes.append({"action": {"return": 299}})
+
+    assert 'success' in client.conf(routes, 'routes')
+
+    def check(url, status, method='GET', host_header='localhost'):
+        assert (
+            client.http(
+                method,
+                url=url,
+                headers={'Host': host_header, 'Connection': 'close'},
+            )['status']
+            == status
+        ), f'{method} {url}'
+
+    check('/a', 203)
+    check('/a', 201, method='POST')
+    check('/b', 202)
+    check('/bcd', 202)
+    check('/bb', 299)
+    check('/c', 299)
+    check('/c', 204, host_header='example.com')
+    check('/x.jpg', 205)
+    check('/route/3.jpg', 205)
+    check('/route/7', 206, method='PUT')
+    check('/route/7', 227)
+    check('/route/19', 239)
+    check('/route/77', 299)
+
+
+def test_routes_match_many_prefixes():
+    def check_prefixes(count):
+        routes = []
+
+        for i in range(count):
+            routes.append(
+                {
+                    "match": {"uri": f'/{"x" * (count - i)}*'},
+                    "action": {"return": 200 + i},
+                }
+            )
+
+        routes.append({"action": {"return": 299}})
+
+        assert 'success' in client.conf(routes, 'routes')
+
+        assert client.get(url=f'/{"x" * 25}')['status'] == 200
+        assert client.get(url='/xxxxx')['status'] == 200 + count - 5
+        assert client.get(url='/xxxxxy')['status'] == 200 + count - 5
+        assert client.get(url='/y')['status'] == 299
+
+    check_prefixes(10)
+    check_prefixes(20)
+
+
 def test_routes_match_negative():
     route_match({"uri": "!"})
     assert client.get()['status'] == 200
@@ -1824,6 +1896,44 @@ def test_routes_source_cidr_ipv6():
     assert client.get(port=8081)['status'] == 404, '0 ipv4'
 
 
+def test_routes_source_list():
+    assert 'success' in client.conf(
+        {
+            "*:8080": {"pass": "routes"},
+            "[::1]:8081": {"pass": "routes"},
+        },
+        'listeners',
+    ), 'source listeners configure'
+
+    def get_ipv6():
+        return client.get(sock_type='ipv6', port=8081)
+
+    addrs = [f'10.{i >> 8}.{i & 255}.0/24' for i in range(10000)]
+    addrs6 = [f'2001:{i:x}::/32' for i in range(10000)]
+
+    route_match({"source": addrs + addrs6})
+    assert client.get()['status'] == 404, 'list'
+    assert get_ipv6()['status'] == 404, 'list ipv6'
+
+    route_match({"source": addrs + addrs6 + ["127.0.0.0/8", "::1"]})
+    assert client.get()['status'] == 200, 'list match'
+    assert get_ipv6()['status'] == 200, 'list match ipv6'
+
+    route_match({"source": addrs + ["127.0.0.0-127.0.0.2", "!127.0.0.1"]})
+    assert client.get()['status'] == 404, 'list neg'
+    assert get_ipv6()['status'] == 404, 'list neg ipv6'
+
+    route_match({"source": [f'!{a}' for a in addrs] + ["!::1"]})
+    assert client.get()['status'] == 200, 'list neg only'
+    assert get_ipv6()['status'] == 404, 'list neg only ipv6'
+
+    route_match({"source": addrs + ["!127.0.0.1:1-65535", "127.0.0.1"]})
+    assert client.get()['status'] == 404, 'list neg port'
+
+    route_match({"source": addrs + ["127.0.0.1:1-65535"]})
+    assert client.get()['status'] == 200, 'list port'
+
+
 def test_routes_source_unix(temp_dir):
     addr = f'{temp_dir}/sock'
 
@@ -1,5 +1,6 @@
 import os
 import socket
+import time
 from pathlib import Path
 
 import pytest
@@ -106,6 +107,218 @@ def test_static_etag(temp_dir):
     assert etag != client.get(url='/')['headers']['ETag'], 'new ETag'
 
 
+def test_static_not_modified():
+    resp = client.get()
+    etag = resp['headers']['ETag']
+    last_modified = resp['headers']['Last-Modified']
+
+    def check_status(headers, status):
+        headers.update({'Host': 'localhost', 'Connection': 'close'})
+
+        resp = client.get(headers=headers)
+        assert resp['status'] == status, 'status'
+
+        if status == 304:
+            assert resp['body'] == '', 'not modified body'
+            assert resp['headers']['ETag'] == etag, 'not modified ETag'
+            assert 'Content-Length' not in resp['headers'], 'no length'
+
+    check_status({'If-None-Match': etag}, 304)
+    check_status({'If-None-Match': f'"blah", W/{etag}'}, 304)
+    check_status({'If-None-Match': '*'}, 304)
+    check_status({'If-None-Match': '"blah"'}, 200)
+    check_status({'If-Modified-Since': last_modified}, 304)
+    check_status({'If-Modified-Since': 'Mon, 28 Sep 1970 06:00:00 GMT'}, 200)
+    check_status({'If-Modified-Since': 'blah'}, 200)
+    check_status(
+        {'If-None-Match': '"blah"', 'If-Modified-Since': last_modified}, 200
+    )
+
+    resp = client.head(
+        headers={
+            'Host': 'localhost',
+            'If-None-Match': etag,
+            'Connection': 'close',
+        }
+    )
+    assert resp['status'] == 304, 'HEAD not modified'
+
+
+def test_static_range():
+    def get_range(value, headers=None):
+        headers = headers or {}
+        headers.update(
+            {'Host': 'localhost', 'Range': value, 'Connection': 'close'}
+        )
+
+        return client.get(headers=headers)
+
+    resp = get_range('bytes=2-5')
+    assert resp['status'] == 206, 'range status'
+    assert resp['body'] == '2345', 'range body'
+    assert resp['headers']['Content-Range'] == 'bytes 2-5/10', 'range'
+    assert resp['headers']['Content-Type'] == 'text/html', 'range type'
+    assert resp['headers']['Accept-Ranges'] == 'bytes', 'accept ranges'
+
+    assert get_range('bytes=7-')['body'] == '789', 'range open'
+    assert get_range('bytes=-3')['body'] == '789', 'range suffix'
+    assert get_range('bytes=-30')['body'] == '0123456789', 'range large'
+    assert get_range('bytes=8-100')['body'] == '89', 'range end'
+
+    assert get_range('bytes=5-2')['status'] == 200, 'range invalid'
+    assert get_range('items=0-1')['status'] == 200, 'range unit'
+    assert get_range('bytes=0-9,0-9')['status'] == 200, 'range overlap'
+
+    resp = get_range('bytes=10-')
+    assert resp['status'] == 416, 'not satisfiable'
+    assert resp['headers']['Content-Range'] == 'bytes */10', 'unsatisfiable'
+
+    resp = client.head(
+        headers={
+            'Host': 'localhost',
+            'Range': 'bytes=0-1',
+            'Connection': 'close',
+        }
+    )
+    assert resp['status'] == 200, 'range HEAD'
+
+
+def test_static_range_multipart():
+    resp = client.get(
+        headers={
+            'Host': 'localhost',
+            'Range': 'bytes=0-1,-2',
+            'Connection': 'close',
+        }
+    )
+    assert resp['status'] == 206, 'multipart status'
+    assert 'Content-Range' not in resp['headers'], 'multipart Content-Range'
+
+    boundary = resp['headers']['Content-Type'].split('boundary=')[1]
+    assert resp['headers']['Content-Type'].startswith(
+        'multipart/byteranges; boundary='
+    ), 'multipart Content-Type'
+    assert resp['body'] == (
+        f'\r\n--{boundary}\r\n'
+        'Content-Type: text/html\r\n'
+        'Content-Range: bytes 0-1/10\r\n\r\n01'
+        f'\r\n--{boundary}\r\n'
+        'Content-Type: text/html\r\n'
+        'Content-Range: bytes 8-9/10\r\n\r\n89'
+        f'\r\n--{boundary}--\r\n'
+    ), 'multipart body'
+    assert int(resp['headers']['Content-Length']) == len(resp['body'])
+
+
+def test_static_range_if_range():
+    resp = client.get()
+    etag = resp['headers']['ETag']
+    last_modified = resp['headers']['Last-Modified']
+
+    def get_if_range(value):
+        return client.get(
+            headers={
+                'Host': 'localhost',
+                'Range': 'bytes=0-1',
+                'If-Range': value,
+                'Connection': 'close',
+            }
+        )['status']
+
+    assert get_if_range(etag) == 206, 'If-Range ETag'
+    assert get_if_range(last_modified) == 206, 'If-Range date'
+    assert get_if_range(f'W/{etag}') == 200, 'If-Range weak'
+    assert get_if_range('"blah"') == 200, 'If-Range mismatch'
+    assert get_if_range('Mon, 28 Sep 1970 06:00:00 GMT') == 200, 'old date'
+
+
+def test_static_range_large_file(temp_dir):
+    file_size = 1024 * 1024
+    with open(f'{temp_dir}/assets/large', 'wb') as f:
+        f.write(os.urandom(file_size))
+
+    with open(f'{temp_dir}/assets/large', 'rb') as f:
+        data = f.read()
+
+    resp = client.get(
+        url='/large',
+        headers={
+            'Host': 'localhost',
+            'Range': 'bytes=1000-300000,-200000',
+            'Connection': 'close',
+        },
+        read_buffer_size=1024 * 1024,
+        encoding='latin1',
+    )
+    assert resp['status'] == 206, 'large status'
+
+    body = resp['body'].encode('latin1')
+    assert data[1000:300001] in body, 'large range 1'
+    assert data[-200000:] in body, 'large range 2'
+    assert int(resp['headers']['Content-Length']) == len(body)
+
+
+def test_static_open_file_cache(temp_dir):
+    assert 'success' in client.conf(
+        {"max": 2, "valid": 5}, 'settings/http/static/open_file_cache'
+    ), 'open_file_cache'
+
+    def get(sock):
+        return client.get(
+            url='/README',
+            headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+            start=True,
+            sock=sock,
+            read_timeout=1,
+        )
+
+    resp, sock = client.get(
+        url='/README',
+        headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+        start=True,
+        read_timeout=1,
+    )
+    assert resp['body'] == 'readme', 'cache miss'
+
+    Path(f'{temp_dir}/assets/new').write_text('new', encoding='utf-8')
+    os.rename(f'{temp_dir}/assets/new', f'{temp_dir}/assets/README')
+
+    resp, sock = get(sock)
+    assert resp['body'] == 'readme', 'cache hit'
+
+    time.sleep(4)
+
+    resp, sock = get(sock)
+    assert resp['body'] == 'new', 'cache expired'
+
+    sock.close()
+
+    assert client.get(url='/index.html')['body'] == '0123456789', 'evict'
+    assert client.get(url='/log.log')['body'] == '[debug]', 'evict 2'
+    assert client.get(url='/README')['body'] == 'new', 'evict 3'
+    assert client.get(url='/dir')['status'] == 301, 'directory'
+    assert client.get(url='/blah')['status'] == 404, 'not found'
+
+    assert 'success' in client.conf(
+        {"max": 0}, 'settings/http/static/open_file_cache'
+    ), 'open_file_cache disabled'
+    assert client.get(url='/README')['body'] == 'new', 'disabled'
+
+
+def test_static_open_file_cache_invalid():
+    def check_cache(cache):
+        assert 'error' in client.conf(
+            cache, 'settings/http/static/open_file_cache'
+        ), 'invalid open_file_cache'
+
+    check_cache('1')
+    check_cache({"max": -1})
+    check_cache({"max": "1"})
+    check_cache({"valid": 0})
+    check_cache({"valid": 1.5})
+    check_cache({"size": 1})
+
+
 def test_static_redirect():
     resp = client.get(url='/dir')
     assert resp['status'] == 301, 'redirect status'
@@ -0,0 +1,229 @@
+from pathlib import Path
+
+import pytest
+
+from unit.applications.proto import ApplicationProto
+from unit.option import option
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(f'{assets_dir}/dir').mkdir(parents=True)
+
+    for name, body in (
+        ('app.js', 'identity'),
+        ('app.js.gz', 'gzip variant'),
+        ('app.js.br', 'br variant'),
+        ('style.css', 'css'),
+        ('style.css.gz', 'css gzip'),
+        ('dir/index.html', 'index'),
+        ('dir/index.html.zst', 'index zstd'),
+    ):
+        Path(f'{assets_dir}/{name}').write_text(body, encoding='utf-8')
+
+    Path(f'{assets_dir}/blob.gz').mkdir()
+    Path(f'{assets_dir}/blob').write_text('blob', encoding='utf-8')
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [
+                {
+                    "action": {
+                        "share": f'{assets_dir}$uri',
+                        "precompressed": True,
+                    }
+                }
+            ],
+            "applications": {},
+        }
+    )
+
+
+def action_update(conf):
+    assert 'success' in client.conf(conf, 'routes/0/action')
+
+
+def get(url='/app.js', accept='gzip', headers=None):
+    hdrs = {'Host': 'localhost', 'Connection': 'close'}
+
+    if accept is not None:
+        hdrs['Accept-Encoding'] = accept
+
+    if headers is not None:
+        hdrs.update(headers)
+
+    return client.get(url=url, headers=hdrs)
+
+
+def check_variant(resp, encoding, body):
+    assert resp['status'] == 200, 'status'
+    assert resp['headers']['Content-Encoding'] == encoding, 'encoding'
+    assert resp['headers']['Vary'] == 'Accept-Encoding', 'vary'
+    assert resp['headers']['Content-Length'] == str(len(body)), 'length'
+    assert resp['body'] == body, 'body'
+
+
+def check_identity(resp, body='identity'):
+    assert resp['status'] == 200, 'status'
+    assert 'Content-Encoding' not in resp['headers'], 'no encoding'
+    assert 'Vary' not in resp['headers'], 'no vary'
+    assert resp['body'] == body, 'body'
+
+
+def test_static_precompressed():
+    resp = get()
+
+    check_variant(resp, 'gzip', 'gzip variant')
+    assert (
+        resp['headers']['Content-Type'] == 'application/javascript'
+    ), 'type'
+
+    check_variant(get(accept='br'), 'br', 'br variant')
+    check_variant(get(accept='gzip, br'), 'br', 'br variant')
+    check_variant(get(accept='gzip, br;q=0.5'), 'gzip', 'gzip variant')
+    check_variant(get(accept='*'), 'br', 'br variant')
+    check_variant(get(accept='br;q=0, *'), 'gzip', 'gzip variant')
+
+    check_identity(get(accept=None))
+    check_identity(get(accept='identity'))
+    check_identity(get(accept='gzip;q=0, br;q=0'))
+    check_identity(get(accept='zstd'))
+
+
+def test_static_precompressed_missing():
+    check_variant(get('/style.css', accept='br, gzip'), 'gzip', 'css gzip')
+    check_identity(get('/style.css', accept='br'), 'css')
+
+    check_identity(get('/blob', accept='gzip'), 'blob')
+
+    check_variant(get('/dir/', accept='zstd'), 'zstd', 'index zstd')
+    check_identity(get('/dir/', accept='gzip'), 'index')
+
+    assert get('/none.js')['status'] == 404, 'not found'
+
+
+def test_static_precompressed_encodings(temp_dir):
+    action_update(
+        {"share": f'{temp_dir}/assets$uri', "precompressed": ["gzip", "br"]}
+    )
+
+    check_variant(get(accept='br, gzip'), 'gzip', 'gzip variant')
+    check_variant(get(accept='br'), 'br', 'br variant')
+
+    action_update({"share": f'{temp_dir}/assets$uri', "precompressed": "br"})
+
+    check_identity(get(accept='gzip'))
+    check_variant(get(accept='gzip, br'), 'br', 'br variant')
+
+    action_update({"share": f'{temp_dir}/assets$uri', "precompressed": False})
+
+    check_identity(get(accept='gzip, br'))
+
+
+def test_static_precompressed_conditional():
+    resp = get()
+    etag = resp['headers']['ETag']
+
+    assert etag != get(accept=None)['headers']['ETag'], 'variant etag'
+
+    resp = get(headers={'If-None-Match': etag})
+    assert resp['status'] == 304, 'not modified'
+
+    resp = get(headers={'Range': 'bytes=0-3'})
+    assert resp['status'] == 206, 'partial'
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'partial encoding'
+    assert resp['body'] == 'gzip', 'partial body'
+
+    resp = client.head(
+        url='/app.js',
+        headers={
+            'Host': 'localhost',
+            'Accept-Encoding': 'gzip',
+            'Connection': 'close',
+        },
+    )
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'head encoding'
+    assert resp['headers']['Content-Length'] == '12', 'head length'
+    assert resp['body'] == '', 'head body'
+
+
+def test_static_precompressed_open_file_cache():
+    assert 'success' in client.conf(
+        {"http": {"static": {"open_file_cache": {"max": 8, "valid": 1}}}},
+        'settings',
+    )
+
+    for _ in range(3):
+        check_variant(get(), 'gzip', 'gzip variant')
+        check_variant(get(accept='br'), 'br', 'br variant')
+        check_identity(get(accept=None))
+
+
+def test_static_precompressed_chroot(require, temp_dir):
+    require({'features': {'chroot': True}})
+
+    action_update(
+        {
+            "share": f'{temp_dir}/assets$uri',
+            "chroot": f'{temp_dir}/assets',
+            "precompressed": True,
+        }
+    )
+
+    check_variant(get(), 'gzip', 'gzip variant')
+    check_variant(get('/dir/', accept='zstd'), 'zstd', 'index zstd')
+
+    action_update(
+        {
+            "share": f'{temp_dir}/assets/app.js',
+            "chroot": f'{temp_dir}/assets',
+            "precompressed": True,
+        }
+    )
+
+    check_variant(get(accept='br'), 'br', 'br variant')
+
+
+def test_static_precompressed_invalid(temp_dir):
+    def check_error(precompressed):
+        assert 'error' in client.conf(
+            {"share": f'{temp_dir}/assets$uri', "precompressed": precompressed},
+            'routes/0/action',
+        ), 'invalid'
+
+    check_error([])
+    check_error("compress")
+    check_error(["gzip", "gzip"])
+    check_error(["gzip", 1])
+    check_error(1)
+
+
+@pytest.mark.skipif(
+    not option.available['modules'].get('zlib'),
+    reason='Unit is built without zlib',
+)
+def test_static_precompressed_compression(temp_dir):
+    assert 'success' in client.conf(
+        {
+            "http": {
+                "compression": {
+                    "types": "application/javascript",
+                    "min_length": 0,
+                }
+            }
+        },
+        'settings',
+    )
+
+    check_variant(get(), 'gzip', 'gzip variant')
+
+    action_update({"share": f'{temp_dir}/assets$uri'})
+
+    resp = get()
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'compressed'
+    assert resp['body'] != 'gzip variant', 'not variant'
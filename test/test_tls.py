@@ -701,3 +701,54 @@ def test_tls_multi_listener():
     assert client.get_ssl()['status'] == 200, 'listener #1'
 
     assert client.get_ssl(port=8081)['status'] == 200, 'listener #2'
+
+
+def test_tls_ktls(temp_dir):
+    client.certificate()
+
+    file_size = 4 * 1024 * 1024
+    Path(f'{temp_dir}/assets').mkdir()
+    Path(f'{temp_dir}/assets/index.html').write_text(
+        '0123456789', encoding='utf-8'
+    )
+    with open(f'{temp_dir}/assets/large', 'wb') as f:
+        f.seek(file_size - 1)
+        f.write(b'\0')
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {
+                    "pass": "routes",
+                    "tls": {"certificate": "default", "ktls": True},
+                }
+            },
+            "routes": [{"action": {"share": f'{temp_dir}/assets$uri'}}],
+            "applications": {},
+        }
+    ), 'load ktls configuration'
+
+    # The kernel may lack TLS support, the response is the same anyway.
+
+    assert client.get_ssl(url='/index.html')['body'] == '0123456789', 'file'
+
+    resp = client.get_ssl(
+        url='/index.html',
+        headers={
+            'Host': 'localhost',
+            'Range': 'bytes=2-3,6-',
+            'Connection': 'close',
+        },
+    )
+    assert resp['status'] == 206, 'multipart status'
+    assert '23' in resp['body'] and '6789' in resp['body'], 'multipart'
+
+    assert (
+        len(client.get_ssl(url='/large', read_buffer_size=1024 * 1024)['body'])
+        == file_size
+    ), 'large file'
+
+    assert 'error' in client.conf('"on"', 'listeners/*:8080/tls/ktls')
+    assert 'success' in client.conf('false', 'listeners/*:8080/tls/ktls')
+
+    assert client.get_ssl(url='/index.html')['body'] == '0123456789', 'off'
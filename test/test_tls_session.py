@@ -133,6 +133,30 @@ def test_tls_session_timeout():
     assert not reused, 'timeout'
 
 
+@pytest.mark.skipif(
+    not hasattr(_lib, 'SSL_session_reused'),
+    reason='session reuse is not supported',
+)
+def test_tls_session_reconfigure():
+    assert 'success' in add_session(cache_size=5)
+
+    _, sess, ctx, reused = connect()
+    assert not reused, 'new connection'
+
+    assert 'success' in client.conf([{"action": {"return": 204}}], 'routes')
+    assert 'success' in client.conf(
+        {"pass": "routes"}, 'listeners/*:8081'
+    ), 'unrelated listener'
+
+    _, _, _, reused = connect(ctx, sess)
+    assert reused, 'reconfigure'
+
+    assert 'success' in client.conf('10', 'listeners/*:8080/tls/session/timeout')
+
+    _, _, _, reused = connect(ctx, sess)
+    assert not reused, 'tls reconfigure'
+
+
 def test_tls_session_invalid():
     assert 'error' in add_session(cache_size=-1)
     assert 'error' in add_session(cache_size={})
@@ -0,0 +1,178 @@
+import os
+import re
+import socket
+
+import pytest
+
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {"pass": "upstreams/one"},
+                "*:8081": {"pass": "routes/one"},
+                "*:8082": {"pass": "routes/two"},
+            },
+            "upstreams": {
+                "one": {
+                    "servers": {
+                        "127.0.0.1:8081": {},
+                        "127.0.0.1:8082": {},
+                    },
+                },
+            },
+            "routes": {
+                "one": [{"action": {"return": 200}}],
+                "two": [{"action": {"return": 201}}],
+            },
+            "applications": {},
+        },
+    ), 'upstreams initial configuration'
+
+    client.cpu_count = os.cpu_count()
+
+
+@pytest.fixture
+def stalled_server():
+    # The connections are established by the kernel, but never served.
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(('127.0.0.1', 8084))
+    sock.listen(100)
+
+    yield '127.0.0.1:8084'
+
+    sock.close()
+
+
+def set_balancer(balancer):
+    assert 'success' in client.conf(
+        f'"{balancer}"', 'upstreams/one/balancer'
+    ), 'configure balancer'
+
+
+def get_resps_sc(req=100):
+    to_send = b"""GET / HTTP/1.1
+Host: localhost
+
+""" * (
+        req - 1
+    )
+
+    to_send += b"""GET / HTTP/1.1
+Host: localhost
+Connection: close
+
+"""
+
+    resp = client.http(to_send, raw_resp=True, raw=True)
+    status = re.findall(r'HTTP\/\d\.\d\s(\d\d\d)', resp)
+    ups = list(map(lambda x: int(x[-1]), status))
+
+    resps = [0, 0]
+    for up in ups:
+        resps[up] += 1
+
+    return resps
+
+
+def get_stalled(req=10):
+    stalled = 0
+    socks = []
+
+    for _ in range(req):
+        sock = client.get(no_recv=True)
+        socks.append(sock)
+
+        resp = client.recvall(sock, read_timeout=0.5).decode()
+
+        if resp == '':
+            stalled += 1
+
+        else:
+            assert re.search(r'HTTP/1.1 201', resp), 'status'
+
+    for sock in socks:
+        sock.close()
+
+    return stalled
+
+
+def test_upstreams_balancer_round_robin():
+    set_balancer('round_robin')
+
+    assert get_resps_sc(req=30) == [15, 15], 'round robin'
+
+
+def test_upstreams_balancer_least_requests():
+    set_balancer('least_requests')
+
+    assert get_resps_sc(req=30) == [15, 15], 'idle servers'
+
+    assert 'success' in client.conf(
+        '3', 'upstreams/one/servers/127.0.0.1:8081/weight'
+    ), 'configure weight'
+
+    assert get_resps_sc() == [75, 25], 'idle servers weight'
+
+
+def test_upstreams_balancer_least_requests_stalled(stalled_server):
+    assert 'success' in client.conf(
+        {"127.0.0.1:8082": {}, stalled_server: {}},
+        'upstreams/one/servers',
+    ), 'configure stalled server'
+
+    set_balancer('least_requests')
+
+    # Each router thread sends at most one request to the stalled server.
+
+    assert get_stalled() <= client.cpu_count, 'least requests'
+
+
+def test_upstreams_balancer_two_choices():
+    set_balancer('two_choices')
+
+    resps = get_resps_sc()
+    assert sum(resps) == 100, 'two choices sum'
+    assert resps[0] > 0 and resps[1] > 0, 'two choices'
+
+    assert 'success' in client.conf(
+        '0', 'upstreams/one/servers/127.0.0.1:8081/weight'
+    ), 'configure weight zero'
+
+    assert get_resps_sc(req=20) == [0, 20], 'two choices weight zero'
+
+    assert 'success' in client.conf_delete(
+        'upstreams/one/servers/127.0.0.1:8081'
+    ), 'remove server'
+
+    assert get_resps_sc(req=20) == [0, 20], 'two choices single'
+
+
+def test_upstreams_balancer_two_choices_stalled(stalled_server):
+    set_balancer('two_choices')
+
+    assert 'success' in client.conf(
+        {"127.0.0.1:8082": {}, stalled_server: {}},
+        'upstreams/one/servers',
+    ), 'configure stalled server'
+
+    assert get_stalled() <= client.cpu_count, 'two choices'
+
+
+def test_upstreams_balancer_invalid():
+    def check_balancer(balancer):
+        assert 'error' in client.conf(
+            balancer, 'upstreams/one/balancer'
+        ), 'invalid balancer'
+
+    check_balancer('"random"')
+    check_balancer('""')
+    check_balancer('1')
+    check_balancer('["least_requests"]')
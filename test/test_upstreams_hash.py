@@ -0,0 +1,133 @@
+import pytest
+
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {"pass": "upstreams/one"},
+                "*:8081": {"pass": "routes/one"},
+                "*:8082": {"pass": "routes/two"},
+                "*:8083": {"pass": "routes/three"},
+            },
+            "upstreams": {
+                "one": {
+                    "servers": {
+                        "127.0.0.1:8081": {},
+                        "127.0.0.1:8082": {},
+                        "127.0.0.1:8083": {},
+                    },
+                    "hash": "$uri",
+                },
+            },
+            "routes": {
+                "one": [{"action": {"return": 200}}],
+                "two": [{"action": {"return": 201}}],
+                "three": [{"action": {"return": 202}}],
+            },
+            "applications": {},
+        },
+    ), 'upstreams initial configuration'
+
+
+def get_map(keys=100, url='/key_{}'):
+    return [client.get(url=url.format(k))['status'] for k in range(keys)]
+
+
+def test_upstreams_hash():
+    statuses = get_map()
+
+    assert statuses == get_map(), 'stable'
+
+    for status in (200, 201, 202):
+        assert statuses.count(status) > 10, f'distribution {status}'
+
+
+def test_upstreams_hash_remap():
+    before = get_map()
+
+    assert 'success' in client.conf_delete(
+        'upstreams/one/servers/127.0.0.1:8083'
+    ), 'remove server'
+
+    after = get_map()
+
+    assert 202 not in after, 'removed server'
+
+    for old, new in zip(before, after):
+        if old != 202:
+            assert old == new, 'remaining keys'
+
+    assert 'success' in client.conf(
+        {}, 'upstreams/one/servers/127.0.0.1:8083'
+    ), 'restore server'
+
+    assert get_map() == before, 'restored'
+
+
+def test_upstreams_hash_weight():
+    assert 'success' in client.conf(
+        '0', 'upstreams/one/servers/127.0.0.1:8083/weight'
+    ), 'configure weight zero'
+
+    assert 202 not in get_map(), 'weight zero'
+
+    assert 'success' in client.conf(
+        '8', 'upstreams/one/servers/127.0.0.1:8083/weight'
+    ), 'configure weight'
+
+    assert get_map().count(202) > 50, 'weight'
+
+
+def test_upstreams_hash_key():
+    assert 'success' in client.conf('"$arg_id"', 'upstreams/one/hash')
+
+    statuses = get_map(url='/?id={}')
+    assert len(set(statuses)) == 3, 'distribution'
+
+    for k in range(20):
+        assert (
+            client.get(url=f'/other?id={k}')['status'] == statuses[k]
+        ), 'argument key'
+
+    assert 'success' in client.conf('"fixed"', 'upstreams/one/hash')
+
+    assert len(set(get_map())) == 1, 'constant key'
+
+
+def test_upstreams_hash_retry():
+    assert 'success' in client.conf(
+        {
+            "servers": {
+                "127.0.0.1:8081": {},
+                "127.0.0.1:8082": {},
+                "127.0.0.1:8084": {},
+            },
+            "hash": "$uri",
+            "retry": {},
+        },
+        'upstreams/one',
+    ), 'configure bad server'
+
+    statuses = get_map()
+
+    assert 502 not in statuses, 'next server'
+    assert statuses == get_map(), 'next server stable'
+
+
+def test_upstreams_hash_invalid():
+    def check_error(conf):
+        assert 'error' in client.conf(conf, 'upstreams/one')
+
+    servers = {"127.0.0.1:8081": {}}
+
+    check_error({"servers": servers, "hash": 1})
+    check_error({"servers": servers, "hash": "$blah"})
+    check_error(
+        {"servers": servers, "hash": "$uri", "balancer": "round_robin"}
+    )
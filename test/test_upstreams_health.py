@@ -0,0 +1,144 @@
+import time
+
+import pytest
+
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {"pass": "upstreams/one"},
+                "*:8081": {"pass": "routes/one"},
+                "*:8082": {"pass": "routes/two"},
+            },
+            "upstreams": {
+                "one": {
+                    "servers": {
+                        "127.0.0.1:8081": {},
+                        "127.0.0.1:8082": {},
+                    },
+                    "health": {"interval": 1, "timeout": 1, "uri": "/"},
+                },
+            },
+            "routes": {
+                "one": [{"action": {"return": 200}}],
+                "two": [{"action": {"return": 201}}],
+            },
+            "applications": {},
+        },
+    ), 'upstreams initial configuration'
+
+
+def get_resps(req=20):
+    resps = [0, 0]
+
+    for _ in range(req):
+        status = client.get()['status']
+        assert status in (200, 201), 'status'
+
+        resps[status % 10] += 1
+
+    return resps
+
+
+def state(server, upstream='one'):
+    return client.conf_get(
+        f'/status/upstreams/{upstream}/servers/{server}/state'
+    )
+
+
+def wait_state(server, expect, upstream='one'):
+    for _ in range(50):
+        if state(server, upstream) == expect:
+            return True
+
+        time.sleep(0.1)
+
+    return False
+
+
+def test_upstreams_health():
+    assert wait_state('127.0.0.1:8081', 'up'), 'first up'
+    assert wait_state('127.0.0.1:8082', 'up'), 'second up'
+
+    resps = get_resps()
+    assert resps[0] > 0 and resps[1] > 0, 'both servers'
+
+
+def test_upstreams_health_down():
+    assert 'success' in client.conf_delete('listeners/*:8082')
+
+    assert wait_state('127.0.0.1:8082', 'down'), 'server down'
+    assert state('127.0.0.1:8081') == 'up', 'server up'
+
+    assert get_resps() == [20, 0], 'healthy server only'
+
+    assert 'success' in client.conf(
+        {"pass": "routes/two"}, 'listeners/*:8082'
+    )
+
+    assert wait_state('127.0.0.1:8082', 'up'), 'server recovered'
+
+    resps = get_resps()
+    assert resps[0] > 0 and resps[1] > 0, 'both servers again'
+
+
+def test_upstreams_health_status():
+    assert 'success' in client.conf(
+        [{"action": {"return": 503}}], 'routes/two'
+    )
+
+    assert wait_state('127.0.0.1:8082', 'down'), 'bad status'
+    assert get_resps() == [20, 0], 'bad status server skipped'
+
+    assert 'success' in client.conf(
+        [{"action": {"return": 302, "location": "/"}}], 'routes/two'
+    )
+
+    assert wait_state('127.0.0.1:8082', 'up'), 'redirect is healthy'
+
+
+def test_upstreams_health_tcp():
+    assert 'success' in client.conf(
+        {"interval": 1, "fails": 2, "passes": 2}, 'upstreams/one/health'
+    )
+
+    assert 'success' in client.conf(
+        [{"action": {"return": 503}}], 'routes/two'
+    )
+
+    time.sleep(3)
+
+    assert state('127.0.0.1:8082') == 'up', 'connect only'
+
+    assert 'success' in client.conf_delete('listeners/*:8082')
+
+    assert wait_state('127.0.0.1:8082', 'down'), 'connect failed'
+
+
+def test_upstreams_health_no_check():
+    assert 'success' in client.conf_delete('upstreams/one/health')
+
+    assert 'upstreams' not in client.conf_get('/status'), 'no upstreams'
+
+
+def test_upstreams_health_invalid():
+    def check_health(health):
+        assert 'error' in client.conf(health, 'upstreams/one/health')
+
+    check_health({"interval": 0})
+    check_health({"interval": -1})
+    check_health({"interval": "1s"})
+    check_health({"timeout": 0})
+    check_health({"fails": 0})
+    check_health({"passes": 0})
+    check_health({"uri": "health"})
+    check_health({"uri": "/a b"})
+    check_health({"uri": ""})
+    check_health({"unknown": 1})
+    check_health([])
@@ -0,0 +1,290 @@
+import re
+import socket
+import threading
+import time
+
+import pytest
+
+from conftest import run_process
+from unit.applications.proto import ApplicationProto
+from unit.utils import waitforsocket
+
+client = ApplicationProto()
+SERVER_PORT = 7998
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    run_process(run_server, SERVER_PORT)
+    waitforsocket(SERVER_PORT)
+
+    conf_upstream({})
+
+
+def run_server(server_port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+
+    sock.bind(('', server_port))
+    sock.listen(10)
+
+    def serve(connection, number):
+        data = b''
+        served = 0
+
+        while True:
+            while b'\r\n\r\n' not in data:
+                part = connection.recv(4096)
+                if not part:
+                    connection.close()
+                    return
+
+                data += part
+
+            head, data = data.split(b'\r\n\r\n', 1)
+            head = head.decode()
+
+            m = re.search(r'Content-Length: (\d+)', head)
+            if m:
+                length = int(m.group(1))
+
+                while len(data) < length:
+                    data += connection.recv(4096)
+
+                data = data[length:]
+
+            method, uri = head.split(' ')[:2]
+
+            if uri == '/once' and served > 0:
+                connection.close()
+                return
+
+            served += 1
+
+            body = f'{number}:{served}'.encode()
+            header = 'HTTP/1.1 200 OK\r\n'
+
+            if 'Connection: close' in head:
+                header += 'X-Connection: close\r\n'
+
+            if uri == '/chunked':
+                header += 'Transfer-Encoding: chunked\r\n\r\n'
+                body = b'%x\r\n%s\r\n0\r\n\r\n' % (len(body), body)
+
+            elif uri == '/no_content':
+                header = 'HTTP/1.1 204 No Content\r\n\r\n'
+                body = b''
+
+            else:
+                if uri == '/close':
+                    header += 'Connection: close\r\n'
+
+                header += f'Content-Length: {len(body)}\r\n\r\n'
+
+            if method == 'HEAD':
+                body = b''
+
+            connection.sendall(header.encode() + body)
+
+            if uri in ('/close', '/drop') or 'Connection: close' in head:
+                connection.close()
+                return
+
+    number = 0
+
+    while True:
+        connection, _ = sock.accept()
+
+        number += 1
+
+        threading.Thread(
+            target=serve, args=(connection, number), daemon=True
+        ).start()
+
+
+def conf_upstream(keepalive):
+    upstream = {"servers": {f'127.0.0.1:{SERVER_PORT}': {}}}
+
+    if keepalive is not None:
+        upstream['keepalive'] = keepalive
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "upstreams/backend"}},
+            "upstreams": {"backend": upstream},
+            "routes": [],
+            "applications": {},
+        }
+    ), 'upstream configuration'
+
+
+def get_keepalive(url='/', method='GET', count=5):
+    (resp, sock) = client.http(
+        method,
+        url=url,
+        headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+        start=True,
+        read_timeout=1,
+    )
+
+    resps = [resp]
+
+    for _ in range(count - 1):
+        (resp, sock) = client.http(
+            method,
+            url=url,
+            headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+            start=True,
+            sock=sock,
+            read_timeout=1,
+        )
+
+        resps.append(resp)
+
+    sock.close()
+
+    for resp in resps:
+        assert resp['status'] in (200, 204), 'status'
+
+    return resps
+
+
+def connections(resps):
+    return [resp['body'].split(':')[0] for resp in resps]
+
+
+def test_upstreams_keepalive():
+    resps = get_keepalive()
+
+    assert len(set(connections(resps))) == 1, 'connection reused'
+    assert [resp['body'].split(':')[1] for resp in resps] == [
+        '1',
+        '2',
+        '3',
+        '4',
+        '5',
+    ], 'requests'
+    assert 'X-Connection' not in resps[0]['headers'], 'no connection close'
+
+
+def test_upstreams_keepalive_disabled():
+    conf_upstream(None)
+
+    resps = get_keepalive()
+
+    assert len(set(connections(resps))) == 5, 'new connections'
+    assert resps[0]['headers']['X-Connection'] == 'close', 'connection close'
+
+    conf_upstream({"connections": 0})
+
+    resps = get_keepalive()
+
+    assert len(set(connections(resps))) == 5, 'connections 0'
+
+
+def test_upstreams_keepalive_requests():
+    conf_upstream({"requests": 2})
+
+    conns = connections(get_keepalive(count=6))
+
+    assert conns[0] == conns[1], 'requests 1'
+    assert conns[2] == conns[3], 'requests 2'
+    assert conns[4] == conns[5], 'requests 3'
+    assert len(set(conns)) == 3, 'requests'
+
+
+def test_upstreams_keepalive_idle_timeout():
+    conf_upstream({"idle_timeout": 3})
+
+    first = connections(get_keepalive(count=2))
+    assert len(set(first)) == 1, 'reused'
+
+    time.sleep(4)
+
+    second = connections(get_keepalive(count=1))
+    assert second[0] != first[0], 'idle timeout'
+
+
+def test_upstreams_keepalive_chunked():
+    resps = get_keepalive('/chunked')
+
+    assert len(set(connections(resps))) == 1, 'chunked reused'
+    assert resps[4]['body'].endswith(':5'), 'chunked body'
+
+
+def test_upstreams_keepalive_no_body():
+    resps = get_keepalive(method='HEAD')
+
+    assert [resp['body'] for resp in resps] == [''] * 5, 'head body'
+    assert get_keepalive(count=1)[0]['body'].endswith(':6'), 'head reused'
+
+    resps = get_keepalive('/no_content')
+
+    assert [resp['status'] for resp in resps] == [204] * 5, 'no content'
+    assert get_keepalive(count=1)[0]['body'].endswith(':12'), 'no content'
+
+
+def test_upstreams_keepalive_close():
+    resps = get_keepalive('/close')
+
+    assert len(set(connections(resps))) == 5, 'close'
+
+
+def test_upstreams_keepalive_drop():
+    resps = get_keepalive('/drop')
+
+    assert len(set(connections(resps))) == 5, 'drop'
+
+
+def test_upstreams_keepalive_retry():
+    (resp, sock) = client.post(
+        url='/once',
+        headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+        start=True,
+        body='0123456789',
+        read_timeout=1,
+    )
+
+    resp2 = client.post(sock=sock, url='/once')
+
+    assert resp['status'] == 200, 'post'
+    assert resp2['status'] == 502, 'post no retry'
+
+    resps = get_keepalive('/once', count=3)
+
+    assert len(set(connections(resps))) == 3, 'retry'
+
+
+def test_upstreams_keepalive_post():
+    (resp, sock) = client.post(
+        headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+        start=True,
+        body='0123456789',
+        read_timeout=1,
+    )
+
+    resp2 = client.post(sock=sock, body='0123456789')
+
+    assert resp['status'] == 200, 'post'
+    assert resp2['status'] == 200, 'post 2'
+    assert resp2['body'] == resp['body'].split(':')[0] + ':2', 'post reused'
+
+
+def test_upstreams_keepalive_invalid():
+    def check_keepalive(keepalive):
+        assert 'error' in client.conf(
+            keepalive, 'upstreams/backend/keepalive'
+        ), 'invalid keepalive'
+
+    check_keepalive('1')
+    check_keepalive({"connections": -1})
+    check_keepalive({"connections": "1"})
+    check_keepalive({"requests": 0})
+    check_keepalive({"idle_timeout": 0})
+    check_keepalive({"idle_timeout": 1.5})
+    check_keepalive({"timeout": 1})
+
+    assert 'success' in client.conf(
+        {"connections": 4, "requests": 10, "idle_timeout": 5},
+        'upstreams/backend/keepalive',
+    ), 'valid keepalive'
@@ -1,10 +1,14 @@
 import os
 import re
+import socket
+import time
 
 import pytest
 
+from conftest import run_process
 from unit.applications.lang.python import ApplicationPython
 from unit.option import option
+from unit.utils import waitforsocket
 
 prerequisites = {'modules': {'python': 'any'}}
 
@@ -387,6 +391,130 @@ def test_upstreams_rr_bad_server():
     assert sum(resps) == 20, 'bad server sum'
 
 
+def test_upstreams_rr_max_fails():
+    assert 'success' in client.conf(
+        {"max_fails": 1, "fail_timeout": 1},
+        'upstreams/one/servers/127.0.0.1:8084',
+    ), 'configure bad server'
+
+    # Failures are accounted per router thread; a single connection
+    # is served by one thread.
+
+    resps = get_resps_sc(req=60)
+    assert sum(resps) == 59, 'max fails'
+
+    time.sleep(1.1)
+
+    resps = get_resps_sc(req=60)
+    assert sum(resps) == 59, 'max fails timeout'
+
+    assert 'success' in client.conf(
+        {"max_fails": 0}, 'upstreams/one/servers/127.0.0.1:8084'
+    ), 'configure max fails zero'
+
+    resps = get_resps_sc(req=30)
+    assert sum(resps) == 20, 'max fails zero'
+
+
+def run_server(server_port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.bind(('127.0.0.1', server_port))
+    sock.listen(5)
+
+    while True:
+        connection, _ = sock.accept()
+        connection.recv(4096)
+        connection.sendall(
+            b'HTTP/1.1 200 OK\r\nContent-Length: 0\r\n'
+            b'Connection: close\r\n\r\n'
+        )
+        connection.close()
+
+
+@pytest.mark.parametrize(
+    'balancer', ['round_robin', 'least_requests', 'two_choices']
+)
+def test_upstreams_rr_max_fails_recover(balancer):
+    assert 'success' in client.conf(
+        {
+            "balancer": balancer,
+            "servers": {
+                "127.0.0.1:8084": {"max_fails": 1, "fail_timeout": 1},
+            },
+        },
+        'upstreams/one',
+    ), 'configure single server'
+
+    # Failures are accounted per router thread, so all the requests
+    # are sent over one connection.
+
+    def get(sock=None):
+        kwargs = {} if sock is None else {'sock': sock}
+
+        return client.get(
+            headers={'Host': 'localhost'},
+            start=True,
+            read_timeout=1,
+            **kwargs,
+        )
+
+    resp, sock = get()
+    assert resp['status'] == 502, 'fail'
+
+    resp, sock = get(sock)
+    assert resp['status'] == 502, 'disabled'
+
+    run_process(run_server, 8084)
+    waitforsocket(8084)
+
+    time.sleep(1.1)
+
+    resp, sock = get(sock)
+    assert resp['status'] == 200, 'trial'
+
+    resp, sock = get(sock)
+    assert resp['status'] == 200, 'recovered'
+
+    sock.close()
+
+
+def test_upstreams_rr_retry():
+    assert 'success' in client.conf(
+        {"weight": 1}, 'upstreams/one/servers/127.0.0.1:8084'
+    ), 'configure bad server'
+    assert 'success' in client.conf({}, 'upstreams/one/retry')
+
+    resps = get_resps_sc(req=30)
+    assert sum(resps) == 30, 'retry'
+    assert abs(resps[0] - resps[1]) <= 1, 'retry distribution'
+
+    statuses = [client.post(body='0123456789')['status'] for _ in range(30)]
+    assert statuses.count(502) > 0, 'retry post'
+
+    assert 'success' in client.conf({"tries": 1}, 'upstreams/one/retry')
+
+    resps = get_resps_sc(req=30)
+    assert sum(resps) == 20, 'retry tries 1'
+
+    assert 'success' in client.conf(
+        {"tries": 2, "timeout": 10}, 'upstreams/one/retry'
+    )
+
+    resps = get_resps_sc(req=30)
+    assert sum(resps) == 30, 'retry tries 2'
+
+
+def test_upstreams_rr_retry_all_bad():
+    assert 'success' in client.conf(
+        {"127.0.0.1:8084": {}, "127.0.0.1:8085": {}},
+        'upstreams/one/servers',
+    ), 'configure bad servers'
+    assert 'success' in client.conf({}, 'upstreams/one/retry')
+
+    assert client.get()['status'] == 502, 'retry all bad'
+
+
 def test_upstreams_rr_pipeline():
     resps = get_resps_sc()
 
@@ -491,3 +619,24 @@ def test_upstreams_rr_invalid():
     check_weight('.01234567890123')
     check_weight('1000001')
     check_weight('2e6')
+
+    def check_server(option, value):
+        assert 'error' in client.conf(
+            value, f'upstreams/one/servers/127.0.0.1:8081/{option}'
+        ), f'invalid {option} option'
+
+    check_server('max_fails', '-1')
+    check_server('max_fails', '1.5')
+    check_server('max_fails', '"1"')
+    check_server('fail_timeout', '0')
+    check_server('fail_timeout', '-1')
+
+    def check_retry(retry):
+        assert 'error' in client.conf(
+            retry, 'upstreams/one/retry'
+        ), 'invalid retry option'
+
+    check_retry([])
+    check_retry({"tries": 0})
+    check_retry({"timeout": 0})
+    check_retry({"blah": 1})
@@ -0,0 +1,5 @@
+import re
+
+
+def check_compression(output_version, library):
+    return re.search(f'--{library}', output_version)
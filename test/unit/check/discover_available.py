@@ -2,7 +2,9 @@ import subprocess
 import sys
 
 from unit.check.chroot import check_chroot
+from unit.check.compression import check_compression
 from unit.check.go import check_go
+from unit.check.io_uring import check_io_uring
 from unit.check.isolation import check_isolation
 from unit.check.njs import check_njs
 from unit.check.node import check_node
@@ -41,9 +43,15 @@ def discover_available(unit):
     option.available['modules']['openssl'] = check_openssl(output_version)
     option.available['modules']['regex'] = check_regex(output_version)
 
+    for library in ('zlib', 'zstd', 'brotli'):
+        option.available['modules'][library] = check_compression(
+            output_version, library
+        )
+
     # Discover features using check. Features should be discovered after
     # modules since some features can require modules.
 
     option.available['features']['chroot'] = check_chroot()
+    option.available['features']['io_uring'] = check_io_uring()
     option.available['features']['isolation'] = check_isolation()
     option.available['features']['unix_abstract'] = check_unix_abstract()
@@ -0,0 +1,41 @@
+import ctypes
+import os
+import sys
+from pathlib import Path
+
+from unit.option import option
+
+IORING_FEAT_NODROP = 1 << 1
+IORING_FEAT_EXT_ARG = 1 << 8
+NR_IO_URING_SETUP = 425
+
+
+def check_io_uring():
+    if option.system != 'Linux':
+        return False
+
+    config = Path(f'{option.current_dir}/build/include/nxt_auto_config.h')
+
+    try:
+        if 'NXT_HAVE_IO_URING' not in config.read_text(encoding='utf-8'):
+            return False
+
+    except FileNotFoundError:
+        return False
+
+    # struct io_uring_params, the features field is at offset 20.
+
+    params = ctypes.create_string_buffer(120)
+
+    libc = ctypes.CDLL(None, use_errno=True)
+    fd = libc.syscall(NR_IO_URING_SETUP, 1, params)
+
+    if fd < 0:
+        return False
+
+    os.close(fd)
+
+    features = int.from_bytes(params.raw[20:24], sys.byteorder)
+    required = IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG
+
+    return features & required == required